@@ -0,0 +1,104 @@
+#ifndef HANA_IORING_H
+#define HANA_IORING_H
+
+/* HanaCore I/O rings: batched file I/O through shared memory.
+ *
+ * HANA_SYSCALL_IORING_SETUP(entries, params) creates a submission queue (SQ)
+ * and a completion queue (CQ), returns a ring fd, and fills params->sq and
+ * params->cq with the addresses of the shared ring headers.
+ *
+ * Submitting: write an SQE at sqes[sq->tail & sq->mask], then publish it by
+ * storing tail + 1 with release ordering. Then call
+ * HANA_SYSCALL_IORING_ENTER(fd, to_submit, min_complete, flags). In SQPOLL
+ * mode a kernel thread consumes the SQ on its own; it only needs the enter
+ * syscall (with HANA_IORING_ENTER_SQ_WAKEUP) once sq->flags has
+ * HANA_IORING_SQ_NEED_WAKEUP set.
+ *
+ * Reaping: while cq->head != cq->tail (load tail with acquire ordering),
+ * consume cqes[cq->head & cq->mask] and then store head + 1.
+ *
+ * Requests are served by a pool of kernel worker threads. Requests for the
+ * same fd run in submission order; requests for different fds may complete
+ * in any order. Closing the ring fd waits for in-flight requests.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HANA_IORING_MAX_ENTRIES 4096
+
+/* SQE opcodes */
+#define HANA_IORING_OP_NOP   0
+#define HANA_IORING_OP_READ  1  /* fd, addr, len, off */
+#define HANA_IORING_OP_WRITE 2  /* fd, addr, len, off */
+#define HANA_IORING_OP_OPEN  3  /* addr = path, open_flags; res = new fd */
+#define HANA_IORING_OP_CLOSE 4  /* fd */
+#define HANA_IORING_OP_FSYNC 5  /* fd */
+
+/* off value meaning "use and advance the descriptor's file position" */
+#define HANA_IORING_OFF_CURRENT ((uint64_t)-1)
+
+/* setup flags */
+#define HANA_IORING_SETUP_SQPOLL 0x1
+
+/* sq->flags, written by the kernel */
+#define HANA_IORING_SQ_NEED_WAKEUP 0x1
+
+/* enter flags */
+#define HANA_IORING_ENTER_GETEVENTS 0x1
+#define HANA_IORING_ENTER_SQ_WAKEUP 0x2
+
+struct hana_io_sqe {
+    uint8_t opcode;
+    uint8_t flags;
+    uint16_t reserved;
+    int32_t fd;
+    uint64_t off;
+    uint64_t addr;
+    uint32_t len;
+    uint32_t open_flags;
+    uint64_t user_data;
+};
+
+struct hana_io_cqe {
+    uint64_t user_data;
+    int64_t res;        /* result or -errno */
+};
+
+struct hana_io_sq {
+    volatile uint32_t head;     /* kernel advances */
+    volatile uint32_t tail;     /* user advances */
+    uint32_t mask;
+    uint32_t entries;
+    volatile uint32_t flags;    /* HANA_IORING_SQ_* */
+    uint32_t reserved;
+    struct hana_io_sqe *sqes;
+};
+
+struct hana_io_cq {
+    volatile uint32_t head;     /* user advances */
+    volatile uint32_t tail;     /* kernel advances */
+    uint32_t mask;
+    uint32_t entries;
+    uint32_t overflow;          /* completions dropped on a full CQ */
+    uint32_t reserved;
+    struct hana_io_cqe *cqes;
+};
+
+struct hana_ioring_params {
+    uint32_t sq_entries;        /* out: rounded up to a power of two */
+    uint32_t cq_entries;        /* out: twice sq_entries */
+    uint32_t flags;             /* in: HANA_IORING_SETUP_* */
+    uint32_t sq_thread_idle_ms; /* in: SQPOLL idle time before sleeping */
+    struct hana_io_sq *sq;      /* out */
+    struct hana_io_cq *cq;      /* out */
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HANA_IORING_H */
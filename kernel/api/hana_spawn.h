@@ -0,0 +1,54 @@
+#ifndef HANA_SPAWN_H
+#define HANA_SPAWN_H
+
+/* HanaCore process spawn: start a program directly from a path, without a
+ * fork + exec round trip.
+ *
+ * HANA_SYSCALL_SPAWN(path, argv, envp, actions, nactions, flags) loads the
+ * ELF at `path` into a new task and returns its pid. The child starts with
+ * the System V initial stack: argc, the argv pointers, NULL, the envp
+ * pointers, NULL and the auxiliary vector. argv and envp are NULL-terminated
+ * arrays and may be NULL (empty).
+ *
+ * The child inherits every open descriptor of the caller, sharing its open
+ * file description (offset and status flags), except those marked
+ * FD_CLOEXEC and io rings. The file actions are then applied in order,
+ * as with posix_spawn_file_actions_*; if one fails the child is discarded
+ * and the call returns its -errno.
+ *
+ * The auxiliary vector carries AT_PHDR, AT_PHENT, AT_PHNUM, AT_PAGESZ,
+ * AT_ENTRY, AT_RANDOM and HANA_AT_VDSO (the address of struct hana_vdso,
+ * see hana_vdso.h).
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* File action types */
+#define HANA_SPAWN_FA_CLOSE 1   /* close(fd) */
+#define HANA_SPAWN_FA_DUP2  2   /* dup2(fd, newfd) */
+#define HANA_SPAWN_FA_OPEN  3   /* open(path, oflag) must land on fd */
+
+struct hana_spawn_file_action {
+    uint32_t type;
+    int32_t fd;
+    int32_t newfd;          /* DUP2 */
+    int32_t oflag;          /* OPEN */
+    const char *path;       /* OPEN */
+};
+
+/* Most file actions one spawn call may carry. */
+#define HANA_SPAWN_MAX_ACTIONS 64
+
+/* Auxiliary vector entry with the vDSO data page. Not AT_SYSINFO_EHDR:
+ * the page is not an ELF image. */
+#define HANA_AT_VDSO 0x4856
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HANA_SPAWN_H */
@@ -0,0 +1,61 @@
+#ifndef HANA_VDSO_H
+#define HANA_VDSO_H
+
+/* HanaCore vDSO layout.
+ *
+ * The kernel exports one read-only data page and a small code page to user
+ * space. HANA_SYSCALL_VDSO returns the address of the struct hana_vdso at
+ * the start of the data page; its function pointers serve clock_gettime,
+ * gettimeofday, getpid and getcpu without entering the kernel. The data is
+ * guarded by a sequence counter: readers retry while it is odd or changed.
+ *
+ * Shared by the kernel (kernel/userland/vdso.cpp) and the user runtime
+ * (musl_shim); bump HANA_VDSO_VERSION on incompatible changes.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HANA_VDSO_MAGIC   0x4f5344564e414e48ULL /* "HNANVDSO" */
+#define HANA_VDSO_VERSION 1
+
+struct hana_timespec {
+    int64_t tv_sec;
+    int64_t tv_nsec;
+};
+
+struct hana_timeval {
+    int64_t tv_sec;
+    int64_t tv_usec;
+};
+
+struct hana_vdso_data {
+    volatile uint32_t seq;      /* odd while the kernel is writing */
+    uint32_t reserved;
+    uint64_t tsc_base;          /* TSC at CLOCK_MONOTONIC == 0 */
+    uint64_t tsc_mult;          /* ns = ((tsc - tsc_base) * tsc_mult) >> 32 */
+    int64_t realtime_offset_ns; /* CLOCK_REALTIME - CLOCK_MONOTONIC */
+    int32_t pid;                /* pid of the task running on this CPU */
+    uint32_t cpu;
+};
+
+struct hana_vdso {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t size;              /* sizeof(struct hana_vdso) */
+    const struct hana_vdso_data *data;
+    /* Return 0 or a negative errno, like the raw syscalls they replace. */
+    long (*clock_gettime)(int clk, struct hana_timespec *ts);
+    long (*gettimeofday)(struct hana_timeval *tv, void *tz);
+    long (*getpid)(void);
+    long (*getcpu)(unsigned *cpu, unsigned *node, void *cache);
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HANA_VDSO_H */
@@ -32,6 +32,7 @@ const char *hana_strerror(int err);
 
 /* Exit and process control */
 void hana_exit(int status) __attribute__((noreturn));
+/* Start a new process from a path (HANA_SYSCALL_SPAWN, see hana_spawn.h) */
 hana_pid_t hana_spawn(const char *path, const char *const argv[], const char *const envp[]);
 /* Replace current image */
 int hana_exec(const char *path, const char *const argv[], const char *const envp[]);
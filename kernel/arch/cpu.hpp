@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+
+// Small CPU helpers shared by the locking code, the scheduler and anything
+// that needs cheap timestamps. Everything here is inline so it can be used
+// from interrupt context without pulling in other subsystems.
+
+namespace hanacore { namespace arch {
+
+    static constexpr uint64_t RFLAGS_IF = 1ULL << 9;
+
+    // Read the time-stamp counter. Used for lock hold/wait accounting; the
+    // value is in raw cycles and is not calibrated.
+    static inline uint64_t rdtsc() {
+        uint32_t lo, hi;
+        asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+        return ((uint64_t)hi << 32) | lo;
+    }
+
+    static inline uint64_t read_rflags() {
+        uint64_t flags;
+        asm volatile("pushfq; popq %0" : "=r"(flags) :: "memory");
+        return flags;
+    }
+
+    static inline bool irqs_enabled() {
+        return (read_rflags() & RFLAGS_IF) != 0;
+    }
+
+    // Disable interrupts and return the previous RFLAGS so the caller can
+    // restore the exact state it was entered with (nesting-safe).
+    static inline uint64_t irq_save() {
+        uint64_t flags = read_rflags();
+        asm volatile("cli" ::: "memory");
+        return flags;
+    }
+
+    static inline void irq_restore(uint64_t flags) {
+        if (flags & RFLAGS_IF) asm volatile("sti" ::: "memory");
+    }
+
+    // Spin-wait hint for busy loops.
+    static inline void cpu_relax() {
+        asm volatile("pause" ::: "memory");
+    }
+
+}} // namespace hanacore::arch
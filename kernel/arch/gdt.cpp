@@ -20,9 +20,26 @@ struct __attribute__((packed)) gdt_ptr {
     uint64_t base;
 };
 
-// Entries: null, kernel code, kernel data, user code, user data
-static gdt_entry gdt[6];
+// 64-bit Task State Segment. Only rsp0 (the stack the CPU switches to when
+// an interrupt arrives in ring 3) is used; no IST stacks, no I/O bitmap.
+struct __attribute__((packed)) tss64 {
+    uint32_t reserved0;
+    uint64_t rsp0;
+    uint64_t rsp1;
+    uint64_t rsp2;
+    uint64_t reserved1;
+    uint64_t ist[7];
+    uint64_t reserved2;
+    uint16_t reserved3;
+    uint16_t iomap_base;
+};
+
+// Entries: null, kernel code, kernel data, user data, user code, TSS (the
+// TSS descriptor is 16 bytes and occupies two slots). User data sits below
+// user code because SYSRET derives SS = STAR.base + 8 and CS = STAR.base + 16.
+static gdt_entry gdt[7];
 static gdt_ptr gp;
+static tss64 tss;
 
 extern "C" void gdt_reload_segments(); // implemented in assembly
 // Implement the segment reload helper in C using inline asm to avoid
@@ -63,13 +80,22 @@ extern "C" void gdt_install() {
     // Kernel data segment: access 0x92
     set_gdt_entry(2, 0, 0, 0x92, 0x00);
 
-    // User code segment: DPL=3, executable/readable, long mode
+    // User data segment: DPL=3, read/write (selector 0x1B)
+    // Access byte: 0xF2 (P=1, DPL=3, S=1, Type=0010)
+    set_gdt_entry(3, 0, 0, 0xF2, 0x00);
+
+    // User code segment: DPL=3, executable/readable, long mode (selector 0x23)
     // Access byte: 0xFA (P=1, DPL=3, S=1, Type=1010)
-    set_gdt_entry(3, 0, 0, 0xFA, 0x20);
+    set_gdt_entry(4, 0, 0, 0xFA, 0x20);
 
-    // User data segment: DPL=3, read/write
-    // Access byte: 0xF2 (P=1, DPL=3, S=1, Type=0010)
-    set_gdt_entry(4, 0, 0, 0xF2, 0x00);
+    // TSS descriptor: available 64-bit TSS (type 0x9), present. The upper
+    // 32 bits of the base live in the following slot.
+    uint64_t tss_base = (uint64_t)&tss;
+    tss.iomap_base = sizeof(tss); // no I/O permission bitmap
+    set_gdt_entry(5, (uint32_t)tss_base, sizeof(tss) - 1, 0x89, 0x00);
+    uint32_t* hi = (uint32_t*)&gdt[6];
+    hi[0] = (uint32_t)(tss_base >> 32);
+    hi[1] = 0;
 
     gp.limit = sizeof(gdt) - 1;
     gp.base = (uint64_t)&gdt;
@@ -79,4 +105,11 @@ extern "C" void gdt_install() {
 
     // Reload segment registers (far jump) via assembly helper
     gdt_reload_segments();
+
+    // Load the task register
+    asm volatile ("ltr %w0" : : "r" ((uint16_t)GDT_TSS_SEL));
+}
+
+extern "C" void gdt_set_tss_rsp0(uint64_t rsp0) {
+    tss.rsp0 = rsp0;
 }
@@ -1,4 +1,15 @@
 #pragma once
 #include <stdint.h>
 
+// Segment selectors. User data precedes user code so that SYSRET (which
+// loads SS = STAR[63:48] + 8 and CS = STAR[63:48] + 16) lands on them.
+#define GDT_KERNEL_CS 0x08
+#define GDT_KERNEL_DS 0x10
+#define GDT_USER_DS   0x1B
+#define GDT_USER_CS   0x23
+#define GDT_TSS_SEL   0x28
+
 extern "C" void gdt_install();
+
+// Set the stack the CPU loads on a ring 3 -> ring 0 interrupt.
+extern "C" void gdt_set_tss_rsp0(uint64_t rsp0);
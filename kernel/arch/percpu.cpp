@@ -0,0 +1,42 @@
+#include "percpu.hpp"
+#include "gdt.hpp"
+
+static inline void write_msr(uint32_t msr, uint64_t val) {
+    uint32_t lo = (uint32_t)(val & 0xFFFFFFFFULL);
+    uint32_t hi = (uint32_t)(val >> 32);
+    asm volatile ("wrmsr" : : "c"(msr), "a"(lo), "d"(hi));
+}
+
+enum {
+    MSR_GS_BASE        = 0xC0000101,
+    MSR_KERNEL_GS_BASE = 0xC0000102,
+};
+
+namespace hanacore { namespace arch {
+
+    // Single CPU for now; an SMP bring-up would allocate one block per CPU.
+    static PerCpu bsp_percpu;
+
+    void percpu_init() {
+        bsp_percpu.self = &bsp_percpu;
+        bsp_percpu.cpu_id = 0;
+        // We are in the kernel: GS_BASE is ours, the user value (0) waits
+        // in KERNEL_GS_BASE for the first swapgs on the way out.
+        write_msr(MSR_GS_BASE, (uint64_t)&bsp_percpu);
+        write_msr(MSR_KERNEL_GS_BASE, 0);
+    }
+
+    PerCpu* this_cpu() {
+        return &bsp_percpu;
+    }
+
+    void set_kernel_stack(uint64_t top) {
+        bsp_percpu.kernel_rsp = top;
+        gdt_set_tss_rsp0(top);
+    }
+
+}} // namespace hanacore::arch
+
+extern "C" void percpu_init() {
+    hanacore::arch::percpu_init();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Per-CPU data, reached from assembly through the GS segment. While the CPU
+// runs kernel code IA32_GS_BASE points at this CPU's PerCpu block; in user
+// mode it holds the user's GS base and the kernel pointer is parked in
+// IA32_KERNEL_GS_BASE. Every kernel entry from ring 3 (syscall, interrupts)
+// does `swapgs` first and every exit does it last, so the invariant holds
+// across context switches.
+
+namespace hanacore { namespace arch {
+
+    struct PerCpu {
+        PerCpu* self;          // linear address of this block
+        uint64_t kernel_rsp;   // top of the current task's kernel stack
+        uint64_t user_rsp;     // scratch: user RSP during syscall entry
+        uint32_t cpu_id;
+        uint32_t reserved;
+    };
+
+    // Offsets used by syscall.S; keep in sync.
+    static_assert(offsetof(PerCpu, kernel_rsp) == 8, "PerCpu.kernel_rsp offset");
+    static_assert(offsetof(PerCpu, user_rsp) == 16, "PerCpu.user_rsp offset");
+
+    // Initialise the boot CPU's block and program the GS base MSRs.
+    void percpu_init();
+    PerCpu* this_cpu();
+
+    // Publish `top` as the stack used for syscalls (PerCpu.kernel_rsp) and
+    // for interrupts taken in ring 3 (TSS.rsp0). Called on every switch.
+    void set_kernel_stack(uint64_t top);
+
+}} // namespace hanacore::arch
+
+extern "C" void percpu_init();
@@ -54,6 +54,20 @@ void send_eoi(uint8_t irq) {
     outb(PIC1_CMD, 0x20);
 }
 
+void mask_all() {
+    outb(PIC1_DATA, 0xFF);
+    outb(PIC2_DATA, 0xFF);
+}
+
+void unmask_irq(uint8_t irq) {
+    if (irq >= 16) return;
+    if (irq >= 8) {
+        outb(PIC2_DATA, inb(PIC2_DATA) & (unsigned char)~(1u << (irq - 8)));
+        irq = 2; // the slave is cascaded on IRQ2
+    }
+    outb(PIC1_DATA, inb(PIC1_DATA) & (unsigned char)~(1u << irq));
+}
+
 }}}
 
 // C ABI wrappers
@@ -64,3 +78,11 @@ extern "C" void pic_remap() {
 extern "C" void pic_send_eoi(uint8_t irq) {
     hanacore::arch::pic::send_eoi(irq);
 }
+
+extern "C" void pic_mask_all() {
+    hanacore::arch::pic::mask_all();
+}
+
+extern "C" void pic_unmask_irq(uint8_t irq) {
+    hanacore::arch::pic::unmask_irq(irq);
+}
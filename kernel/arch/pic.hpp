@@ -9,8 +9,14 @@ namespace hanacore { namespace arch { namespace pic {
 
 	// Send End-Of-Interrupt for the given IRQ number (0-15)
 	void send_eoi(uint8_t irq);
+
+	// Mask every IRQ line / unmask a single line (0-15).
+	void mask_all();
+	void unmask_irq(uint8_t irq);
 }}}
 
 // C ABI wrappers kept for existing call-sites (kernel_main, ISRs, etc.)
 extern "C" void pic_remap();
 extern "C" void pic_send_eoi(uint8_t irq);
+extern "C" void pic_mask_all();
+extern "C" void pic_unmask_irq(uint8_t irq);
@@ -2,6 +2,7 @@
 #include "pic.hpp"
 #include "idt.hpp"
 #include "../scheduler/scheduler.hpp"
+#include "tsc.hpp"
 
 // Assembly ISR wrapper declared with C linkage
 extern "C" void pit_entry();
@@ -29,7 +30,7 @@ static const int PIT_VECTOR = 0x20;
 
 namespace hanacore { namespace arch { namespace pit {
 
-void isr() {
+void isr(uint64_t interrupted_cs) {
     // Acknowledge PIC for IRQ0
     pic_send_eoi(0);
     // For now, do not perform a context switch inside the interrupt handler.
@@ -41,6 +42,16 @@ void isr() {
     static volatile uint64_t ticks = 0;
     (void)ticks; // keep unused when optimizations remove it
     ++ticks;
+    // Wake timed sleepers whose deadline has passed.
+    hanacore::scheduler::sched_expire_timeouts(hanacore::arch::clock_monotonic_ns());
+    // Time-slice accounting; may raise need_resched for the next
+    // preemption point.
+    hanacore::scheduler::sched_tick();
+    // Ring 3 holds no kernel locks, so a tick that interrupted user code is
+    // itself a safe preemption point. The interrupted frame stays on this
+    // task's kernel stack until it is switched back in.
+    if ((interrupted_cs & 3) == 3)
+        hanacore::scheduler::sched_preempt_check();
 }
 
 void init(uint32_t freq) {
@@ -59,13 +70,14 @@ void init(uint32_t freq) {
     // Register ISR into IDT. Use the assembly wrapper `pit_entry` (defined
     // in pit_entry.S) which calls the C handler and then performs an iretq.
     idt_set_handler(PIT_VECTOR, pit_entry);
+    pic_unmask_irq(0);
 }
 
 }}}
 
 // C ABI wrappers that forward to namespaced implementations
-extern "C" void pit_isr() {
-    hanacore::arch::pit::isr();
+extern "C" void pit_isr(uint64_t interrupted_cs) {
+    hanacore::arch::pit::isr(interrupted_cs);
 }
 
 extern "C" void pit_init(uint32_t freq) {
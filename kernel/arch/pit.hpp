@@ -6,10 +6,11 @@ namespace hanacore { namespace arch { namespace pit {
 	// Initialize PIT channel 0 to `freq` Hz (simple, legacy PIT 8253/8254)
 	void init(uint32_t freq);
 
-	// C++ ISR handler called on each PIT tick
-	void isr();
+	// C++ ISR handler called on each PIT tick. `interrupted_cs` is the code
+	// selector of the interrupted context (RPL 3 = user mode).
+	void isr(uint64_t interrupted_cs);
 }}}
 
 // Exposed C ABI wrappers for existing call-sites / IDT
 extern "C" void pit_init(uint32_t freq);
-extern "C" void pit_isr();
+extern "C" void pit_isr(uint64_t interrupted_cs);
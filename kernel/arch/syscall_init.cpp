@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include "gdt.hpp"
 
 extern "C" void syscall_entry();
 
@@ -9,14 +10,17 @@ static inline void write_msr(uint32_t msr, uint64_t val) {
 }
 
 extern "C" void init_syscall() {
-    // IA32_STAR (0xC0000081): set kernel/user cs selectors
-    // Kernel CS = 0x08, User CS = 0x1B
-    uint64_t star = ((uint64_t)0x08 << 32) | ((uint64_t)0x1B << 48);
+    // IA32_STAR (0xC0000081): segment bases for SYSCALL/SYSRET.
+    // SYSCALL: CS = STAR[47:32] (0x08), SS = +8 (0x10).
+    // SYSRET:  SS = STAR[63:48] + 8 (0x1B), CS = STAR[63:48] + 16 (0x23).
+    uint64_t star = ((uint64_t)GDT_KERNEL_CS << 32) | ((uint64_t)(GDT_USER_DS - 8) << 48);
     write_msr(0xC0000081, star);
 
     // IA32_LSTAR (0xC0000082): pointer to syscall entry point
     write_msr(0xC0000082, (uint64_t)(uintptr_t)syscall_entry);
 
-    // IA32_FMASK (0xC0000084): mask flags during syscall entry (clear TF, IF as desired)
-    write_msr(0xC0000084, 0);
+    // IA32_FMASK (0xC0000084): RFLAGS bits cleared on entry. IF must be off
+    // until syscall_entry has switched to the kernel stack; also clear TF,
+    // DF, IOPL, NT and AC like Linux does.
+    write_msr(0xC0000084, 0x47700);
 }
@@ -0,0 +1,86 @@
+#include "tsc.hpp"
+#include "cpu.hpp"
+#include "../utils/logger.hpp"
+
+// I/O helpers
+static inline unsigned char inb(unsigned short port) {
+    unsigned char ret;
+    asm volatile ("inb %1, %0" : "=a" (ret) : "Nd" (port));
+    return ret;
+}
+
+static inline void outb(unsigned short port, unsigned char val) {
+    asm volatile ("outb %0, %1" : : "a" (val), "Nd" (port));
+}
+
+enum {
+    PIT_CHANNEL2 = 0x42,
+    PIT_COMMAND = 0x43,
+    PIT_GATE_PORT = 0x61,     // bit 0: channel 2 gate, bit 1: speaker, bit 5: ch2 output
+    PIT_INPUT_FREQ = 1193182,
+    CALIBRATE_MS = 10,
+};
+
+namespace hanacore { namespace arch {
+
+    static uint64_t hz;
+    static uint64_t base;
+    static uint64_t mult;
+    static int64_t realtime_offset;
+
+    // Count TSC cycles across a CALIBRATE_MS one-shot on PIT channel 2.
+    // Returns 0 if the channel's output never went high.
+    static uint64_t calibrate_pit() {
+        const uint32_t latch = PIT_INPUT_FREQ / (1000 / CALIBRATE_MS);
+
+        uint64_t flags = irq_save();
+        // Gate channel 2 on, keep the speaker disconnected.
+        outb(PIT_GATE_PORT, (inb(PIT_GATE_PORT) & ~0x02) | 0x01);
+        // Channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count).
+        outb(PIT_COMMAND, 0xB0);
+        outb(PIT_CHANNEL2, latch & 0xFF);
+        outb(PIT_CHANNEL2, (latch >> 8) & 0xFF);
+
+        uint64_t start = rdtsc();
+        uint64_t spins = 0;
+        while (!(inb(PIT_GATE_PORT) & 0x20)) {
+            if (++spins > 100000000ULL) { irq_restore(flags); return 0; }
+        }
+        uint64_t end = rdtsc();
+        irq_restore(flags);
+        return (end - start) * (1000 / CALIBRATE_MS);
+    }
+
+    void tsc_init() {
+        hz = calibrate_pit();
+        if (hz == 0) {
+            hz = 1000000000ULL;
+            log_fail("tsc: PIT calibration failed, assuming 1 GHz");
+        }
+        // 1e9 << 32 still fits in 64 bits, so no 128-bit division is needed.
+        mult = (1000000000ULL << 32) / hz;
+        base = rdtsc();
+        log_info("tsc: %u MHz", (unsigned)(hz / 1000000ULL));
+    }
+
+    uint64_t tsc_hz() { return hz; }
+    uint64_t tsc_base() { return base; }
+    uint64_t tsc_mult() { return mult; }
+
+    uint64_t clock_monotonic_ns() {
+        return tsc_delta_to_ns(rdtsc() - base, mult);
+    }
+
+    uint64_t clock_realtime_ns() {
+        return clock_monotonic_ns() + (uint64_t)realtime_offset;
+    }
+
+    int64_t clock_realtime_offset_ns() {
+        return realtime_offset;
+    }
+
+    void clock_set_realtime_ns(uint64_t unix_ns) {
+        realtime_offset = (int64_t)(unix_ns - clock_monotonic_ns());
+    }
+
+}} // namespace hanacore::arch
@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+
+// Calibrated TSC clock source. The TSC is assumed invariant (constant rate,
+// not stopped in C-states); it is calibrated once at boot against PIT
+// channel 2. Cycles convert to nanoseconds with a 32.32 fixed-point
+// multiplier so the same arithmetic can run in the vDSO without a division.
+
+namespace hanacore { namespace arch {
+
+    // Calibrate the TSC and start CLOCK_MONOTONIC at zero. Must run before
+    // anything reads the clocks; falls back to 1 GHz if the PIT never fires.
+    void tsc_init();
+
+    uint64_t tsc_hz();
+    uint64_t tsc_base();   // TSC value at monotonic time zero
+    uint64_t tsc_mult();   // ns = ((tsc - tsc_base) * tsc_mult) >> 32
+
+    static inline uint64_t tsc_delta_to_ns(uint64_t delta, uint64_t mult) {
+        return (uint64_t)(((unsigned __int128)delta * mult) >> 32);
+    }
+
+    // Nanoseconds since tsc_init().
+    uint64_t clock_monotonic_ns();
+
+    // Wall clock: monotonic time plus the offset set from the RTC.
+    uint64_t clock_realtime_ns();
+    int64_t clock_realtime_offset_ns();
+    void clock_set_realtime_ns(uint64_t unix_ns);
+
+}} // namespace hanacore::arch
@@ -1,6 +1,9 @@
-// Simple polled PS/2 keyboard driver
+// Simple PS/2 keyboard driver
 // Provides keyboard_init() and keyboard_poll_char() (returns 0 if no char)
 // and keyboard_poll_and_log() which will print characters when available.
+// Once keyboard_enable_irq() has run, IRQ1 moves scancodes into a small ring
+// and wakes TTY readers; keyboard_poll_char() then translates from the ring
+// instead of polling the controller.
 
 #include <stdint.h>
 #include <stddef.h>
@@ -10,6 +13,13 @@
 extern "C" void print(const char*);
 // TTY switch hook (Alt+Fn)
 #include "../tty/tty.hpp"
+#include "../arch/pic.hpp"
+#include "../arch/idt.hpp"
+#include "../sync/spinlock.hpp"
+#include "../scheduler/scheduler.hpp"
+
+// Assembly ISR wrapper (arch/kbd_entry.S)
+extern "C" void kbd_entry();
 
 static inline uint8_t inb(uint16_t port) {
     uint8_t ret;
@@ -30,8 +40,37 @@ static inline void io_wait(void) {
 enum {
     PS2_DATA = 0x60,
     PS2_STATUS = 0x64,
+    PS2_STATUS_FULL = 0x01,
+    PS2_STATUS_AUX = 0x20,  // byte in the output buffer came from the mouse
 };
 
+// IRQ1 after the PIC remap
+static const int KBD_VECTOR = 0x21;
+
+// Scancodes received by the IRQ handler, not yet translated. Translation
+// (modifier state, VT switching, debug prints) stays in the consumer's task
+// context.
+static uint8_t sc_ring[128];
+static unsigned sc_read = 0;
+static unsigned sc_write = 0;
+static bool irq_mode = false;
+
+HANA_LOCK_CLASS(kbd_ring_class, "kbd_ring");
+static hanacore::sync::Spinlock sc_lock = { 0, &kbd_ring_class, 0 };
+
+// Next raw scancode, or -1 if none is pending.
+static int next_scancode(void) {
+    if (!irq_mode) {
+        if (!(inb(PS2_STATUS) & PS2_STATUS_FULL)) return -1;
+        return inb(PS2_DATA);
+    }
+    hanacore::sync::SpinGuard g(&sc_lock);
+    if (sc_read == sc_write) return -1;
+    uint8_t sc = sc_ring[sc_read & (sizeof(sc_ring) - 1)];
+    ++sc_read;
+    return sc;
+}
+
 // Minimal US set 1 scancode -> ASCII map (no AltGr, minimal symbols)
 static const char scancode_map[] = {
     0,  0x1B, '1','2','3','4','5','6','7','8','9','0','-','=', '\b', '\t',
@@ -71,18 +110,60 @@ extern "C" void keyboard_init(void) {
     }
 }
 
+extern "C" void keyboard_enable_irq(void) {
+    idt_set_handler(KBD_VECTOR, kbd_entry);
+    irq_mode = true;
+    pic_unmask_irq(1);
+}
+
+extern "C" int keyboard_pending(void) {
+    if (!irq_mode) return (inb(PS2_STATUS) & PS2_STATUS_FULL) != 0;
+    return __atomic_load_n(&sc_write, __ATOMIC_ACQUIRE) != __atomic_load_n(&sc_read, __ATOMIC_RELAXED);
+}
+
+extern "C" void keyboard_isr(uint64_t interrupted_cs) {
+    bool got = false;
+    {
+        hanacore::sync::SpinGuard g(&sc_lock);
+        for (;;) {
+            uint8_t st = inb(PS2_STATUS);
+            // Leave mouse bytes for the mouse driver.
+            if (!(st & PS2_STATUS_FULL) || (st & PS2_STATUS_AUX)) break;
+            uint8_t sc = inb(PS2_DATA);
+            // Drop scancodes rather than overwrite untranslated ones
+            if (sc_write - sc_read >= sizeof(sc_ring)) continue;
+            sc_ring[sc_write & (sizeof(sc_ring) - 1)] = sc;
+            ++sc_write;
+            got = true;
+        }
+    }
+    pic_send_eoi(1);
+    if (got) tty_input_notify();
+    // Same preemption point as the timer: a reader woken from ring 3 runs
+    // right away instead of at the next tick.
+    if ((interrupted_cs & 3) == 3)
+        hanacore::scheduler::sched_preempt_check();
+}
+
+// Set once an E0 prefix has been read and its second byte is still pending
+static bool e0_pending = false;
+
 // Return ASCII char or 0 if none available
 extern "C" char keyboard_poll_char(void) {
-    // Check output buffer full
-    if (!(inb(PS2_STATUS) & 1)) return 0;
-
-    uint8_t sc = inb(PS2_DATA);
+    int raw = next_scancode();
+    if (raw < 0) return 0;
+    uint8_t sc = (uint8_t)raw;
 
     // Handle extended prefix (E0). Read the following byte if available
-    if (sc == 0xE0) {
-        // If next byte hasn't arrived yet, bail (will be handled next poll)
-        if (!(inb(PS2_STATUS) & 1)) return 0;
-        uint8_t next = inb(PS2_DATA);
+    if (sc == 0xE0 || e0_pending) {
+        if (sc == 0xE0) {
+            // If next byte hasn't arrived yet, bail (will be handled next poll)
+            raw = next_scancode();
+            if (raw < 0) { e0_pending = true; return 0; }
+            sc = (uint8_t)raw;
+        }
+        e0_pending = false;
+        uint8_t next = sc;
         // Map common extended keys (arrow keys, home/end, insert/delete)
         // into ANSI sequences by enqueueing the remainder and returning ESC
         // so the TTY layer receives a standard escape sequence stream.
@@ -1,4 +1,4 @@
-// Simple keyboard driver API (polled PS/2)
+// Simple keyboard driver API (PS/2, polled or IRQ driven)
 #pragma once
 
 #include <stdint.h>
@@ -13,6 +13,13 @@ void keyboard_init(void);
 // Poll for a character. Returns ASCII character, or 0 if none available.
 char keyboard_poll_char(void);
 
+// Route IRQ1 to the driver. From then on scancodes are queued by the
+// interrupt handler, which wakes TTY readers (tty_input_notify).
+void keyboard_enable_irq(void);
+
+// Non-zero if a scancode is waiting to be translated.
+int keyboard_pending(void);
+
 // Convenience: poll once and print any character via kernel print().
 void keyboard_poll_and_log(void);
 
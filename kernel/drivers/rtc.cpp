@@ -0,0 +1,102 @@
+#include "rtc.hpp"
+#include <stdint.h>
+
+static inline void outb(uint16_t port, uint8_t val) {
+    __asm__ volatile ("outb %0, %1" : : "a"(val), "Nd"(port));
+}
+static inline uint8_t inb(uint16_t port) {
+    uint8_t val;
+    __asm__ volatile ("inb %1, %0" : "=a"(val) : "Nd"(port));
+    return val;
+}
+
+enum {
+    CMOS_ADDR = 0x70,
+    CMOS_DATA = 0x71,
+    RTC_SECONDS = 0x00,
+    RTC_MINUTES = 0x02,
+    RTC_HOURS = 0x04,
+    RTC_DAY = 0x07,
+    RTC_MONTH = 0x08,
+    RTC_YEAR = 0x09,
+    RTC_STATUS_A = 0x0A,
+    RTC_STATUS_B = 0x0B,
+};
+
+struct RtcTime {
+    uint8_t sec, min, hour, day, month, year;
+};
+
+static uint8_t cmos_read(uint8_t reg) {
+    // Bit 7 of the index port keeps NMIs disabled while we poke the CMOS.
+    outb(CMOS_ADDR, 0x80 | reg);
+    return inb(CMOS_DATA);
+}
+
+static bool update_in_progress() {
+    return (cmos_read(RTC_STATUS_A) & 0x80) != 0;
+}
+
+static void read_raw(RtcTime* t) {
+    t->sec = cmos_read(RTC_SECONDS);
+    t->min = cmos_read(RTC_MINUTES);
+    t->hour = cmos_read(RTC_HOURS);
+    t->day = cmos_read(RTC_DAY);
+    t->month = cmos_read(RTC_MONTH);
+    t->year = cmos_read(RTC_YEAR);
+}
+
+static bool same_time(const RtcTime& a, const RtcTime& b) {
+    return a.sec == b.sec && a.min == b.min && a.hour == b.hour &&
+           a.day == b.day && a.month == b.month && a.year == b.year;
+}
+
+static uint8_t bcd_to_bin(uint8_t v) {
+    return (uint8_t)((v & 0x0F) + (v >> 4) * 10);
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's
+// days_from_civil).
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+extern "C" uint64_t rtc_read_unix_seconds() {
+    // The registers change under us while an update is in flight; read until
+    // two consecutive snapshots agree.
+    RtcTime a, b;
+    int tries = 0;
+    do {
+        while (update_in_progress()) {}
+        read_raw(&a);
+        while (update_in_progress()) {}
+        read_raw(&b);
+        if (++tries > 16) return 0;
+    } while (!same_time(a, b));
+
+    uint8_t status_b = cmos_read(RTC_STATUS_B);
+    bool pm = (b.hour & 0x80) != 0;
+    b.hour &= 0x7F;
+    if (!(status_b & 0x04)) {
+        b.sec = bcd_to_bin(b.sec);
+        b.min = bcd_to_bin(b.min);
+        b.hour = bcd_to_bin(b.hour);
+        b.day = bcd_to_bin(b.day);
+        b.month = bcd_to_bin(b.month);
+        b.year = bcd_to_bin(b.year);
+    }
+    if (!(status_b & 0x02)) {
+        // 12-hour mode: 12 AM is hour 0, 12 PM stays 12.
+        if (b.hour == 12) b.hour = 0;
+        if (pm) b.hour += 12;
+    }
+    if (b.month < 1 || b.month > 12 || b.day < 1 || b.day > 31) return 0;
+
+    int64_t days = days_from_civil(2000 + b.year, b.month, b.day);
+    return (uint64_t)(days * 86400 + b.hour * 3600 + b.min * 60 + b.sec);
+}
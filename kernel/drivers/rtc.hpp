@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+
+extern "C" {
+// Read the CMOS real-time clock and return the current time as seconds since
+// the Unix epoch (the RTC is assumed to run in UTC). Returns 0 if the clock
+// could not be read consistently.
+uint64_t rtc_read_unix_seconds();
+}
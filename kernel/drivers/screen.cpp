@@ -191,6 +191,19 @@ namespace hanacore::drivers::screen {
         }
         flanterm_write(term, str, string_len(str));
     }
+
+    void print_n(const char* str, size_t len) {
+        if (!str || len == 0) return;
+        if (!term) {
+            for (size_t i = 0; i < len; ++i) debug_putchar(str[i]);
+            return;
+        }
+        flanterm_write(term, str, len);
+    }
+}
+
+extern "C" void print_n(const char* str, size_t len) {
+    hanacore::drivers::screen::print_n(str, len);
 }
 
 // Simple pixel write (assumes 32-bit native framebuffer)
@@ -25,6 +25,8 @@ extern "C" {
 // --- Terminal / screen functions ---
 void clear_screen();
 void print(const char* str);
+// Print exactly `len` bytes; `str` need not be NUL-terminated.
+void print_n(const char* str, size_t len);
 void print_fmt(const char* fmt, ...);
 
 // --- Simple framebuffer / GUI helpers ---
@@ -42,6 +44,7 @@ namespace hanacore { namespace drivers { namespace screen {
 	// C++ namespace wrappers (same signatures as C API)
 	void clear_screen();
 	void print(const char* str);
+	void print_n(const char* str, size_t len);
 	void print_fmt(const char* fmt, ...);
 } } }
 #endif
@@ -0,0 +1,215 @@
+// kernel/filesystem/dcache.cpp
+#include "dcache.hpp"
+#include "../libs/libc.h"
+#include "../mem/heap.hpp"
+
+namespace hanacore { namespace fs {
+
+    static constexpr int DCACHE_MAX = 1024;
+    static constexpr int DCACHE_HASH_SIZE = 256;
+    static constexpr size_t DCACHE_NAME_MAX = 64;
+    static constexpr size_t DCACHE_PATH_MAX = 512;
+
+    static constexpr int DENTRY_NEGATIVE = -1;
+    static constexpr int DENTRY_UNPROBED = -2;   // only leads to other entries
+
+    struct dentry {
+        dentry* parent;
+        dentry* hash_next;
+        dentry* lru_prev;       // towards the most recently used
+        dentry* lru_next;
+        int type;               // VFS_TYPE_*, DENTRY_NEGATIVE or DENTRY_UNPROBED
+        int nchildren;
+        uint32_t gen;           // negative entries: dcache_gen when probed
+        bool dying;             // marked by dcache_invalidate
+        char name[DCACHE_NAME_MAX];
+    };
+
+    static dentry root_dentry = { nullptr, nullptr, nullptr, nullptr, DENTRY_UNPROBED, 0, 0, false, "" };
+    static dentry* dentry_hash[DCACHE_HASH_SIZE];
+    static dentry* lru_head = nullptr;      // most recently used
+    static dentry* lru_tail = nullptr;
+    static int dentry_count = 0;
+    // Negative entries from an older generation count as unprobed.
+    static uint32_t dcache_gen = 0;
+
+    static unsigned dentry_hash_of(const dentry* parent, const char* name, size_t len) {
+        uint32_t h = 2166136261u ^ (uint32_t)((uintptr_t)parent >> 4);
+        for (size_t i = 0; i < len; ++i) {
+            h ^= (uint8_t)name[i];
+            h *= 16777619u;
+        }
+        return h & (DCACHE_HASH_SIZE - 1);
+    }
+
+    static const char* next_component(const char** p, size_t* len) {
+        const char* s = *p;
+        while (*s == '/') ++s;
+        const char* e = s;
+        while (*e && *e != '/') ++e;
+        *len = (size_t)(e - s);
+        *p = e;
+        return s;
+    }
+
+    static void lru_unlink(dentry* d) {
+        if (d->lru_prev) d->lru_prev->lru_next = d->lru_next; else lru_head = d->lru_next;
+        if (d->lru_next) d->lru_next->lru_prev = d->lru_prev; else lru_tail = d->lru_prev;
+        d->lru_prev = d->lru_next = nullptr;
+    }
+
+    static void lru_push(dentry* d) {
+        d->lru_prev = nullptr;
+        d->lru_next = lru_head;
+        if (lru_head) lru_head->lru_prev = d; else lru_tail = d;
+        lru_head = d;
+    }
+
+    static void lru_touch(dentry* d) {
+        if (lru_head == d) return;
+        lru_unlink(d);
+        lru_push(d);
+    }
+
+    static dentry* d_child(const dentry* parent, const char* name, size_t len) {
+        if (!parent->nchildren) return nullptr;
+        for (dentry* d = dentry_hash[dentry_hash_of(parent, name, len)]; d; d = d->hash_next)
+            if (d->parent == parent && strncmp(d->name, name, len) == 0 && d->name[len] == '\0') return d;
+        return nullptr;
+    }
+
+    static void d_free(dentry* d) {
+        unsigned h = dentry_hash_of(d->parent, d->name, strlen(d->name));
+        for (dentry** pp = &dentry_hash[h]; *pp; pp = &(*pp)->hash_next) {
+            if (*pp == d) { *pp = d->hash_next; break; }
+        }
+        lru_unlink(d);
+        --d->parent->nchildren;
+        --dentry_count;
+        hanacore::mem::kfree(d);
+    }
+
+    // Drop the least recently used childless entry other than `keep`.
+    static void d_evict(const dentry* keep) {
+        for (dentry* d = lru_tail; d; d = d->lru_prev) {
+            if (d != keep && !d->nchildren) {
+                d_free(d);
+                return;
+            }
+        }
+    }
+
+    static dentry* d_alloc(dentry* parent, const char* name, size_t len) {
+        if (dentry_count >= DCACHE_MAX) d_evict(parent);
+        dentry* d = (dentry*)hanacore::mem::kmalloc(sizeof(dentry));
+        if (!d) return nullptr;
+        memset(d, 0, sizeof(*d));
+        d->parent = parent;
+        d->type = DENTRY_UNPROBED;
+        memcpy(d->name, name, len);
+        d->name[len] = '\0';
+        unsigned h = dentry_hash_of(parent, name, len);
+        d->hash_next = dentry_hash[h];
+        dentry_hash[h] = d;
+        lru_push(d);
+        ++parent->nchildren;
+        ++dentry_count;
+        return d;
+    }
+
+    int dcache_lookup(const char* path, dcache_probe_t probe) {
+        if (!path || !probe) return -1;
+        if (path[0] != '/') return probe(path);
+
+        // The probe gets the path as cached: "//bin/ls/" is "/bin/ls".
+        char norm[DCACHE_PATH_MAX];
+        size_t nlen = 0;
+        dentry* d = &root_dentry;
+        const char* p = path;
+        size_t len;
+        for (const char* c = next_component(&p, &len); len; c = next_component(&p, &len)) {
+            if (len >= DCACHE_NAME_MAX || nlen + 1 + len >= sizeof(norm)) return probe(path);
+            norm[nlen++] = '/';
+            memcpy(norm + nlen, c, len);
+            nlen += len;
+            dentry* child = d_child(d, c, len);
+            if (!child) child = d_alloc(d, c, len);
+            if (!child) return probe(path);
+            lru_touch(child);
+            d = child;
+        }
+        if (nlen == 0) norm[nlen++] = '/';
+        norm[nlen] = '\0';
+
+        if (d->type == DENTRY_UNPROBED || (d->type == DENTRY_NEGATIVE && d->gen != dcache_gen)) {
+            int type = probe(norm);
+            d->type = type < 0 ? DENTRY_NEGATIVE : type;
+            d->gen = dcache_gen;
+        }
+        return d->type;
+    }
+
+    static bool d_under(const dentry* d, const dentry* top) {
+        for (; d; d = d->parent)
+            if (d == top) return true;
+        return false;
+    }
+
+    void dcache_invalidate(const char* path) {
+        if (!path) return;
+        dentry* d = &root_dentry;
+        const char* p = path;
+        size_t len;
+        for (const char* c = next_component(&p, &len); len; c = next_component(&p, &len)) {
+            d = d_child(d, c, len);
+            if (!d) return;
+        }
+        if (d == &root_dentry) {
+            dcache_flush();
+            return;
+        }
+        d->type = DENTRY_UNPROBED;
+        if (!d->nchildren) {
+            d_free(d);
+            return;
+        }
+        // Mark the whole subtree first: freeing as we go would break the
+        // parent chains the marking walks.
+        for (int h = 0; h < DCACHE_HASH_SIZE; ++h)
+            for (dentry* e = dentry_hash[h]; e; e = e->hash_next)
+                if (d_under(e, d)) e->dying = true;
+        for (dentry* e = lru_tail; e; ) {
+            dentry* prev = e->lru_prev;
+            if (e->dying && !e->nchildren) {
+                dentry* parent = e->parent;
+                d_free(e);
+                // Parents become childless as their subtree goes.
+                while (parent != &root_dentry && parent->dying && !parent->nchildren) {
+                    dentry* up = parent->parent;
+                    if (prev == parent) prev = parent->lru_prev;
+                    d_free(parent);
+                    parent = up;
+                }
+            }
+            e = prev;
+        }
+    }
+
+    void dcache_forget_misses(void) {
+        ++dcache_gen;
+    }
+
+    void dcache_flush(void) {
+        for (int h = 0; h < DCACHE_HASH_SIZE; ++h) {
+            while (dentry* d = dentry_hash[h]) {
+                dentry_hash[h] = d->hash_next;
+                hanacore::mem::kfree(d);
+            }
+        }
+        lru_head = lru_tail = nullptr;
+        dentry_count = 0;
+        root_dentry.nchildren = 0;
+        root_dentry.type = DENTRY_UNPROBED;
+    }
+
+} }
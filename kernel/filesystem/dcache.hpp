@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+
+// Dentry cache: remembers what the VFS found at a path, including that
+// nothing is there. Entries hang off their parent directory's entry and
+// are found through a hash on (parent, name), so a cached lookup costs one
+// probe per path component and never reaches a filesystem.
+//
+// Only the last component of a looked-up path is asked about; the
+// components leading to it are kept as unprobed entries. Filesystems
+// answer for whole paths (HanaFS files can exist without their parent
+// directory), so a cached result is exactly what a direct lookup of the
+// same path would have returned.
+//
+// Once DCACHE_MAX entries exist the least recently used entry without
+// children is evicted. Anything that changes a namespace must invalidate
+// the paths it touched; mounting and unmounting flush the whole cache.
+// A filesystem that gains files it cannot name (a volume coming online)
+// drops just the misses by starting a new generation.
+
+namespace hanacore { namespace fs {
+
+    // Looks up an uncached path: VFS_TYPE_* or -1 if it does not exist.
+    typedef int (*dcache_probe_t)(const char* path);
+
+    // VFS_TYPE_* of the absolute `path`, or -1 if it does not exist. Calls
+    // `probe` on a miss and caches its answer. Paths that are not absolute,
+    // or too long to cache, always go to `probe`.
+    int dcache_lookup(const char* path, dcache_probe_t probe);
+
+    // Forget `path` and everything cached below it.
+    void dcache_invalidate(const char* path);
+
+    // Forget every negative entry, in O(1): each remembers the generation
+    // it was probed in and is believed only while that is current. For
+    // changes that can only add paths, where the positive entries stay
+    // true.
+    void dcache_forget_misses(void);
+
+    // Forget everything.
+    void dcache_flush(void);
+
+} }
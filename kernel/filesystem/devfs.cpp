@@ -6,8 +6,44 @@
 
 namespace hanacore { namespace fs {
 
+    static const char* const devfs_nodes[] = { "console", "null", "tty0", "hda", "sda" };
+
+    static int devfs_fs_lookup(super_block*, const char* path) {
+        while (*path == '/') ++path;
+        if (*path == '\0') return VFS_TYPE_DIR;
+        for (const char* n : devfs_nodes)
+            if (strcmp(path, n) == 0) return VFS_TYPE_OTHER;
+        return -1;
+    }
+
+    static void* devfs_fs_read(super_block*, const char* path, size_t* out_len) {
+        return devfs_get_file_alloc(path, out_len);
+    }
+
+    static int devfs_fs_readdir(super_block*, const char* path, vfs_dir_cb_t cb) {
+        return devfs_list_dir(path, cb);
+    }
+
+    // The cookie is an index into devfs_nodes.
+    static int devfs_fs_iterate(super_block*, const char* path, uint64_t cookie, vfs_filldir_t fill, void* ctx) {
+        while (*path == '/') ++path;
+        if (*path != '\0') return -1;
+        const uint64_t n = sizeof(devfs_nodes) / sizeof(devfs_nodes[0]);
+        for (uint64_t i = cookie; i < n; ++i)
+            if (fill(ctx, devfs_nodes[i], i + 1, VFS_DT_CHR, i + 1)) break;
+        return 0;
+    }
+
+    static const fs_ops devfs_ops = {
+        devfs_fs_lookup, devfs_fs_read, nullptr, devfs_fs_readdir, devfs_fs_iterate,
+        nullptr, nullptr, nullptr, nullptr, nullptr,
+    };
+
+    static filesystem_type devfs_type = { "devfs", &devfs_ops, nullptr };
+
     void devfs_init(void) {
         // Register devfs mount
+        register_filesystem(&devfs_type);
         vfs_register_mount("devfs", "/dev");
         hanacore::utils::log_info_cpp("[devfs] initialized and mounted at /dev");
     }
@@ -29,11 +65,7 @@ namespace hanacore { namespace fs {
         }
         if (strcmp(norm, "/dev") != 0 && strcmp(norm, "/dev/") != 0) return -1;
         // Provide a few standard device nodes
-        cb("console");
-        cb("null");
-        cb("tty0");
-        cb("hda");
-        cb("sda");
+        for (const char* n : devfs_nodes) cb(n);
         return 0;
     }
 
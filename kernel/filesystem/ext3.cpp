@@ -4,6 +4,7 @@
 
 #include "../libs/libc.h"
 #include "../mem/heap.hpp"
+#include "vfs.hpp"
 
 extern "C" void __attribute__((weak)) fat32_progress_update(int percent) {}
 
@@ -55,9 +56,15 @@ namespace ext3 {
         return 0;
     }
 
+    static void register_vfs();
+
     int mount(int drive, const char* mount_point) {
         // For now, just check superblock and return success if valid
         if (init() == 0) {
+            if (mount_point) {
+                register_vfs();
+                vfs_register_mount("ext3", mount_point);
+            }
             hanacore::utils::log_ok_cpp("[EXT3] Mounted ext3 image at %s", mount_point ? mount_point : "/");
             return 0;
         }
@@ -189,4 +196,121 @@ namespace ext3 {
         return 0;
     }
 
+    // Block number holding block `index` of the file: the direct blocks
+    // and the single indirect block. 0 for a hole or anything further.
+    static uint32_t file_block(const ext3_inode* inode, uint32_t index) {
+        if (index < 12) return inode->i_block[index];
+        index -= 12;
+        if (index >= block_size / 4 || inode->i_block[12] == 0) return 0;
+        uint32_t* ind = (uint32_t*)ext3_read_block(inode->i_block[12]);
+        return ind ? ind[index] : 0;
+    }
+
+    // Open files: the handle is a copy of the inode, and reads copy only
+    // the blocks they cover out of the image. Read-only.
+    void* open(const char* path) {
+        ext3_inode inode;
+        if (find_inode_by_path(path, &inode) != 0) return nullptr;
+        if ((inode.i_mode & 0xF000) == 0x4000) return nullptr;
+        ext3_inode* h = (ext3_inode*)hanacore::mem::kmalloc(sizeof(ext3_inode));
+        if (h) memcpy(h, &inode, sizeof(inode));
+        return h;
+    }
+
+    int64_t read_at(void* h, uint64_t off, void* buf, size_t len) {
+        const ext3_inode* inode = (const ext3_inode*)h;
+        if (!inode) return -1;
+        if (off >= inode->i_size) return 0;
+        if (len > inode->i_size - off) len = (size_t)(inode->i_size - off);
+        uint8_t* dst = (uint8_t*)buf;
+        size_t done = 0;
+        while (done < len) {
+            uint64_t pos = off + done;
+            uint32_t boff = (uint32_t)(pos % block_size);
+            size_t n = block_size - boff < len - done ? block_size - boff : len - done;
+            uint32_t bn = file_block(inode, (uint32_t)(pos / block_size));
+            uint8_t* block = bn ? (uint8_t*)ext3_read_block(bn) : nullptr;
+            if (block) memcpy(dst + done, block + boff, n);
+            else if (bn == 0) memset(dst + done, 0, n);
+            else return done ? (int64_t)done : -1;
+            done += n;
+        }
+        return (int64_t)done;
+    }
+
+    // The cookie is the byte offset of the next record in the directory.
+    int iterate_dir(const char* path, uint64_t cookie,
+                    int (*fill)(void* ctx, const char* name, uint64_t ino, unsigned type, uint64_t next),
+                    void* ctx) {
+        ext3_inode inode;
+        if (!fill || find_inode_by_path(path, &inode) != 0) return -1;
+        if ((inode.i_mode & 0xF000) != 0x4000) return -1;
+        uint64_t pos = cookie;
+        while (pos < inode.i_size) {
+            uint32_t boff = (uint32_t)(pos % block_size);
+            uint32_t bn = file_block(&inode, (uint32_t)(pos / block_size));
+            uint8_t* block = bn ? (uint8_t*)ext3_read_block(bn) : nullptr;
+            if (!block) return -1;
+            ext3_dir_entry* entry = (ext3_dir_entry*)(block + boff);
+            if (entry->rec_len < 8 || boff + entry->rec_len > block_size) return -1;
+            uint64_t next = pos + entry->rec_len;
+            bool dot = entry->name[0] == '.' &&
+                       (entry->name_len == 1 || (entry->name_len == 2 && entry->name[1] == '.'));
+            if (entry->inode && entry->name_len > 0 && !dot) {
+                char name[256];
+                memcpy(name, entry->name, entry->name_len);
+                name[entry->name_len] = 0;
+                unsigned type = VFS_DT_UNKNOWN;
+                switch (entry->file_type) {
+                case 1: type = VFS_DT_REG; break;
+                case 2: type = VFS_DT_DIR; break;
+                case 3: type = VFS_DT_CHR; break;
+                }
+                if (fill(ctx, name, entry->inode, type, next)) return 0;
+            }
+            pos = next;
+        }
+        return 0;
+    }
+
+    uint64_t size(void* h) {
+        return h ? ((const ext3_inode*)h)->i_size : 0;
+    }
+
+    void close(void* h) {
+        hanacore::mem::kfree(h);
+    }
+
+    using hanacore::fs::super_block;
+
+    static int ext3_fs_lookup(super_block*, const char* path) {
+        ext3_inode inode;
+        if (find_inode_by_path(path, &inode) != 0) return -1;
+        return (inode.i_mode & 0xF000) == 0x4000 ? VFS_TYPE_DIR : VFS_TYPE_FILE;
+    }
+
+    static void* ext3_fs_read(super_block*, const char* path, size_t* out_len) { return get_file_alloc(path, out_len); }
+    static int ext3_fs_readdir(super_block*, const char* path, vfs_dir_cb_t cb) { return list_dir(path, cb); }
+    static int ext3_fs_iterate(super_block*, const char* path, uint64_t cookie, vfs_filldir_t fill, void* ctx) {
+        return iterate_dir(path, cookie, fill, ctx);
+    }
+    static void* ext3_fs_open(super_block*, const char* path, int) { return open(path); }
+    static int64_t ext3_fs_read_at(super_block*, void* h, uint64_t off, void* buf, size_t len) { return read_at(h, off, buf, len); }
+    static uint64_t ext3_fs_size(super_block*, void* h) { return size(h); }
+    static void ext3_fs_close(super_block*, void* h) { close(h); }
+
+    // Read-only: no write, create or metadata ops.
+    static const hanacore::fs::fs_ops ext3_fs_ops = {
+        ext3_fs_lookup, ext3_fs_read, nullptr, ext3_fs_readdir, ext3_fs_iterate,
+        nullptr, nullptr, nullptr, nullptr, nullptr,
+        ext3_fs_open, ext3_fs_read_at, nullptr, nullptr,
+        ext3_fs_size, nullptr, ext3_fs_close,
+    };
+
+    static hanacore::fs::filesystem_type ext3_fs_type = { "ext3", &ext3_fs_ops, nullptr };
+
+    static void register_vfs() {
+        hanacore::fs::register_filesystem(&ext3_fs_type);
+    }
+
 }
@@ -14,6 +14,17 @@ namespace ext3 {
     int mount(int drive, const char* mount_point);
     void* get_file_alloc(const char* path, size_t* out_len);
     int list_dir(const char* path, void (*cb)(const char* name));
+    // Resumable listing with inode numbers and entry types, skipping "."
+    // and ".." (see vfs_filldir_t).
+    int iterate_dir(const char* path, uint64_t cookie,
+                    int (*fill)(void* ctx, const char* name, uint64_t ino, unsigned type, uint64_t next),
+                    void* ctx);
+    // Open files (read-only): `open` returns a handle for a regular file
+    // or NULL; `read_at` returns the byte count or -1.
+    void* open(const char* path);
+    int64_t read_at(void* h, uint64_t off, void* buf, size_t len);
+    uint64_t size(void* h);
+    void close(void* h);
     // Internal helpers for inode and directory reading
     // (not exposed outside ext3.cpp)
 
@@ -27,6 +27,7 @@ static inline char fat_toupper(char c) {
 #include "../libs/libc.h"
 #include "../mem/heap.hpp"
 #include "vfs.hpp"
+#include "pagecache.hpp"
 
 // Include IDE driver header so filesystem code can call ata_write_sector and
 // ata_get_sector_count when formatting or probing devices.
@@ -319,6 +320,153 @@ static uint32_t alloc_cluster() {
     return c;
 }
 
+// =================== Page Cache ===================
+
+// Cached file data. FAT32 has no inode numbers, so a file is known by
+// where its directory entry lives; removing the entry (unlink, or a
+// rewrite through fat32_write_file) drops the cached pages.
+struct Fat32File {
+    uint32_t ent_lba;           // sector holding the directory entry
+    uint32_t ent_off;           // byte offset of the entry in that sector
+    uint32_t cluster;           // first cluster, 0 while the file is empty
+    uint32_t nclusters;         // chain length, 0 until counted
+    uint32_t last_cluster;      // valid while nclusters != 0
+    // Chain position of the last page read or written, so sequential
+    // access does not walk the FAT from the start for every page.
+    uint32_t cursor_index;
+    uint32_t cursor_cluster;
+    int refs;                   // open handles
+    bool dead;                  // entry removed while open
+    address_space data;
+    Fat32File* next;
+};
+
+static constexpr int FAT32_FILE_HASH = 64;
+static Fat32File* fat32_files[FAT32_FILE_HASH];
+
+static unsigned fat32_file_hash(uint32_t ent_lba, uint32_t ent_off) {
+    return (ent_lba * 16 + ent_off / 32) % FAT32_FILE_HASH;
+}
+
+static uint32_t cluster_bytes_of() { return sectors_per_cluster * bytes_per_sector; }
+
+// Cluster holding byte `pos` of `f`, or 0 past the end of its chain.
+static uint32_t fat32_file_cluster(Fat32File* f, uint64_t pos) {
+    uint32_t want = (uint32_t)(pos / cluster_bytes_of());
+    if (want < f->cursor_index || f->cursor_cluster < 2) {
+        f->cursor_index = 0;
+        f->cursor_cluster = f->cluster;
+    }
+    if (f->cursor_cluster < 2) return 0;
+    while (f->cursor_index < want) {
+        uint32_t next = read_fat_entry(f->cursor_cluster);
+        if (next < 2 || next >= 0x0FFFFFF7 || next == f->cursor_cluster) return 0;
+        f->cursor_cluster = next;
+        ++f->cursor_index;
+    }
+    return f->cursor_cluster;
+}
+
+static int fat32_readpage(address_space* as, uint64_t index, uint8_t* page) {
+    Fat32File* f = (Fat32File*)as->host;
+    uint64_t start = index * PCACHE_PAGE_SIZE;
+    uint64_t end = start + PCACHE_PAGE_SIZE;
+    if (end > as->size) end = as->size;
+    uint32_t cb = cluster_bytes_of();
+    // Sector sizes divide the page size, so every sector lands whole.
+    for (uint64_t pos = start; pos < end; pos += bytes_per_sector) {
+        uint32_t c = fat32_file_cluster(f, pos);
+        if (c < 2) return -1;
+        uint32_t lba = cluster_to_lba(c) + (uint32_t)((pos % cb) / bytes_per_sector);
+        if (fat32_read_sector(lba, page + (pos - start)) != 0) return -1;
+    }
+    if (end - start < PCACHE_PAGE_SIZE) memset(page + (end - start), 0, PCACHE_PAGE_SIZE - (size_t)(end - start));
+    return 0;
+}
+
+// Writes stay inside the clusters the file already has.
+static int fat32_writepage(address_space* as, uint64_t index, const uint8_t* page, size_t len) {
+    Fat32File* f = (Fat32File*)as->host;
+    uint64_t start = index * PCACHE_PAGE_SIZE;
+    uint32_t cb = cluster_bytes_of();
+    uint8_t sector[4096];
+    for (size_t off = 0; off < len; off += bytes_per_sector) {
+        uint32_t c = fat32_file_cluster(f, start + off);
+        if (c < 2) return -1;
+        uint32_t lba = cluster_to_lba(c) + (uint32_t)(((start + off) % cb) / bytes_per_sector);
+        const uint8_t* src = page + off;
+        if (len - off < bytes_per_sector) {
+            if (fat32_read_sector(lba, sector) != 0) return -1;
+            memcpy(sector, page + off, len - off);
+            src = sector;
+        }
+        if (ata_write_sector(lba, src) != 0) return -1;
+    }
+    return 0;
+}
+
+static const address_space_ops fat32_aops = { fat32_readpage, fat32_writepage };
+
+// The cached file for the directory entry at (ent_lba, ent_off), which
+// currently says `cluster` and `size`.
+static Fat32File* fat32_file_get(uint32_t ent_lba, uint32_t ent_off, uint32_t cluster, uint32_t size) {
+    Fat32File** bucket = &fat32_files[fat32_file_hash(ent_lba, ent_off)];
+    for (Fat32File* f = *bucket; f; f = f->next) {
+        if (f->ent_lba != ent_lba || f->ent_off != ent_off) continue;
+        // The directory entry is the authority on the file.
+        if (f->cluster != cluster) {
+            pcache_release(&f->data);
+            f->cluster = cluster;
+            f->nclusters = 0;
+            f->cursor_index = f->cursor_cluster = 0;
+        }
+        if (f->data.size != size) pcache_truncate(&f->data, size);
+        return f;
+    }
+    Fat32File* f = (Fat32File*)kmalloc(sizeof(Fat32File));
+    if (!f) return nullptr;
+    memset(f, 0, sizeof(*f));
+    f->ent_lba = ent_lba;
+    f->ent_off = ent_off;
+    f->cluster = cluster;
+    pcache_init_mapping(&f->data, &fat32_aops, f, size);
+    f->next = *bucket;
+    *bucket = f;
+    return f;
+}
+
+// Unhash `f` and drop its pages; open handles keep it until they close.
+static void fat32_file_kill(Fat32File* f) {
+    pcache_release(&f->data);
+    if (f->refs) f->dead = true;
+    else kfree(f);
+}
+
+// The directory entry at (ent_lba, ent_off) is going away.
+static void fat32_file_forget(uint32_t ent_lba, uint32_t ent_off) {
+    for (Fat32File** pp = &fat32_files[fat32_file_hash(ent_lba, ent_off)]; *pp; pp = &(*pp)->next) {
+        Fat32File* f = *pp;
+        if (f->ent_lba != ent_lba || f->ent_off != ent_off) continue;
+        *pp = f->next;
+        fat32_file_kill(f);
+        return;
+    }
+}
+
+// A different volume: nothing cached applies any more. The VFS may have
+// cached lookups that the fallback answered from FAT32: the first volume
+// only adds paths, so only misses go; replacing one can remove paths too.
+static void fat32_files_forget_all() {
+    for (int i = 0; i < FAT32_FILE_HASH; ++i) {
+        while (Fat32File* f = fat32_files[i]) {
+            fat32_files[i] = f->next;
+            fat32_file_kill(f);
+        }
+    }
+    if (fat32_ready) vfs_invalidate("/");
+    else vfs_forget_misses();
+}
+
 // Free cluster chain starting at `start` (set FAT entries to 0).
 static void free_cluster_chain(uint32_t start) {
     if (start < 2) return;
@@ -507,6 +655,7 @@ static int remove_dir_entry_by_path(const char* path, bool remove_clusters) {
                 uint32_t start = (high << 16) | low;
                 uint32_t size = (uint32_t)sector[off + 28] | ((uint32_t)sector[off + 29] << 8) | ((uint32_t)sector[off + 30] << 16) | ((uint32_t)sector[off + 31] << 24);
 
+                fat32_file_forget(lba, off);
                 if (remove_clusters && start >= 2) {
                     free_cluster_chain(start);
                 }
@@ -816,6 +965,7 @@ int fat32_init_from_ata() {
         return -1;
     }
 
+    fat32_files_forget_all();
     fat32_ready = true;
 
     // Mark as mounted from ATA device (drive 0)
@@ -830,6 +980,36 @@ int fat32_init_from_ata() {
     return 0;
 }
 
+// =================== VFS Interface ===================
+
+static int fat32_fs_lookup(super_block*, const char* path) { return fat32_lookup(path); }
+static void* fat32_fs_read(super_block*, const char* path, size_t* out_len) { return fat32_get_file_alloc(path, out_len); }
+static int fat32_fs_write(super_block*, const char* path, const void* buf, size_t len) { return fat32_write_file(path, buf, len); }
+static int fat32_fs_readdir(super_block*, const char* path, vfs_dir_cb_t cb) { return fat32_list_dir(path, cb); }
+static int fat32_fs_iterate(super_block*, const char* path, uint64_t cookie, vfs_filldir_t fill, void* ctx) { return fat32_iterate_dir(path, cookie, fill, ctx); }
+static int fat32_fs_create(super_block*, const char* path) { return fat32_create_file(path); }
+static int fat32_fs_mkdir(super_block*, const char* path) { return fat32_make_dir(path); }
+static int fat32_fs_rmdir(super_block*, const char* path) { return fat32_remove_dir(path); }
+static int fat32_fs_unlink(super_block*, const char* path) { return fat32_unlink(path); }
+static void* fat32_fs_open(super_block*, const char* path, int flags) { return fat32_open(path, (flags & VFS_O_CREAT) != 0); }
+static int64_t fat32_fs_read_at(super_block*, void* h, uint64_t off, void* buf, size_t len) { return fat32_read_at((Fat32File*)h, off, buf, len); }
+static int64_t fat32_fs_write_at(super_block*, void* h, uint64_t off, const void* buf, size_t len) { return fat32_write_at((Fat32File*)h, off, buf, len); }
+static int fat32_fs_truncate(super_block*, void* h, uint64_t size) { return fat32_truncate((Fat32File*)h, size); }
+static uint64_t fat32_fs_size(super_block*, void* h) { return fat32_size((Fat32File*)h); }
+static int fat32_fs_fsync(super_block*, void* h) { return fat32_fsync((Fat32File*)h); }
+static void fat32_fs_close(super_block*, void* h) { fat32_close((Fat32File*)h); }
+static int fat32_fs_readahead(super_block*, void* h, uint64_t off, size_t len) { return fat32_readahead((Fat32File*)h, off, len); }
+
+// No stat: FAT32 files have no identity the exec cache could key on.
+static const fs_ops fat32_fs_ops = {
+    fat32_fs_lookup, fat32_fs_read, fat32_fs_write, fat32_fs_readdir, fat32_fs_iterate,
+    nullptr, fat32_fs_create, fat32_fs_mkdir, fat32_fs_rmdir, fat32_fs_unlink,
+    fat32_fs_open, fat32_fs_read_at, fat32_fs_write_at, fat32_fs_truncate,
+    fat32_fs_size, fat32_fs_fsync, fat32_fs_close, fat32_fs_readahead,
+};
+
+static filesystem_type fat32_fs_type = { "fat32", &fat32_fs_ops, nullptr };
+
 int fat32_init_from_memory(const void* data, size_t size) {
     if (!data || size < 512) return -1;
     const uint8_t* d = (const uint8_t*)data;
@@ -882,6 +1062,7 @@ int fat32_init_from_memory(const void* data, size_t size) {
         return -1;
     }
 
+    fat32_files_forget_all();
     fat32_ready = true;
     hanacore::utils::log_ok_cpp("[FAT32] Initialized from memory module");
     // Mark that this filesystem came from a module and should be exposed as drive 1:/
@@ -898,7 +1079,8 @@ int fat32_init_from_memory(const void* data, size_t size) {
         hanacore::utils::log_info_cpp(tmp);
     }
     // Mount FAT32 at /core for core files
-    vfs_register_mount("fat32", "/core/");
+    register_filesystem(&fat32_fs_type);
+    vfs_register_mount("fat32", "/core");
 
     return 0;
 }
@@ -1221,25 +1403,35 @@ int64_t fat32_read_file(const char* path, void* buf, size_t len) {
 }
 
 
-void* fat32_get_file_alloc(const char* path, size_t* out_len) {
-    if (!fat32_ready || !path || !out_len) {
+// Walk `path` from the root directory. On success stores the first cluster,
+// size and directory flag of the entry it names and returns 0.
+// Find `path`. Unless it is the root directory, *out_ent_lba/*out_ent_off
+// (if given) say where its directory entry is.
+static int fat32_resolve(const char* path, uint32_t* out_cluster, uint32_t* out_size, bool* out_is_dir,
+                         uint32_t* out_ent_lba = nullptr, uint32_t* out_ent_off = nullptr) {
+    if (!fat32_ready || !path) {
         char tmp[192];
-        snprintf(tmp, sizeof(tmp), "[FAT32] get_file_alloc early return: fat32_ready=%d path=%p out_len=%p", (int)fat32_ready, (void*)path, (void*)out_len);
+        snprintf(tmp, sizeof(tmp), "[FAT32] resolve early return: fat32_ready=%d path=%p", (int)fat32_ready, (void*)path);
         hanacore::utils::log_info_cpp(tmp);
-        return nullptr;
+        return -1;
     }
 
     // Diagnostic logging to help debug missing files (e.g. /bin/hcsh)
     {
         char tmp[192];
-        snprintf(tmp, sizeof(tmp), "[FAT32] get_file_alloc: path=%s mounted_drive=%d root_cluster=%u module_image=%p module_image_size=%u", path, mounted_drive, root_dir_cluster, (void*)module_image, (unsigned)module_image_size);
+        snprintf(tmp, sizeof(tmp), "[FAT32] resolve: path=%s mounted_drive=%d root_cluster=%u module_image=%p module_image_size=%u", path, mounted_drive, root_dir_cluster, (void*)module_image, (unsigned)module_image_size);
         hanacore::utils::log_info_cpp(tmp);
     }
 
     // Expect absolute path like "/bin/foo" (no drive letter)
     const char* p = path;
     if (*p == '/') ++p; // skip leading slash
-    if (*p == '\0') return nullptr;
+    if (*p == '\0') {
+        *out_cluster = root_dir_cluster;
+        *out_size = 0;
+        *out_is_dir = true;
+        return 0;
+    }
 
     uint32_t current_cluster = root_dir_cluster;
 
@@ -1276,6 +1468,8 @@ void* fat32_get_file_alloc(const char* path, size_t* out_len) {
         bool is_dir = false;
         uint32_t found_cluster = 0;
         uint32_t found_size = 0;
+        uint32_t found_lba = 0;
+        uint32_t found_off = 0;
 
         // iterate directory clusters
         uint32_t cluster = current_cluster;
@@ -1284,15 +1478,15 @@ void* fat32_get_file_alloc(const char* path, size_t* out_len) {
                 uint32_t lba = cluster_to_lba(cluster) + s;
                 {
                     char dbg[128];
-                    snprintf(dbg, sizeof(dbg), "[FAT32] get_file_alloc: reading lba=%u (cluster=%u sec=%u) module_image=%p", lba, cluster, s, (void*)module_image);
+                    snprintf(dbg, sizeof(dbg), "[FAT32] resolve: reading lba=%u (cluster=%u sec=%u) module_image=%p", lba, cluster, s, (void*)module_image);
                     hanacore::utils::log_info_cpp(dbg);
                 }
                 int read_rc = fat32_read_sector(lba, sector);
                 if (read_rc != 0) {
                     char errmsg[128];
-                    snprintf(errmsg, sizeof(errmsg), "[FAT32] get_file_alloc: fat32_read_sector failed (rc=%d, lba=%u)", read_rc, lba);
+                    snprintf(errmsg, sizeof(errmsg), "[FAT32] resolve: fat32_read_sector failed (rc=%d, lba=%u)", read_rc, lba);
                     hanacore::utils::log_info_cpp(errmsg);
-                    return nullptr;
+                    return -1;
                 }
 
                 // Debug: show first few directory entries
@@ -1356,6 +1550,8 @@ void* fat32_get_file_alloc(const char* path, size_t* out_len) {
                     uint32_t low = (uint32_t)sector[off + 26] | ((uint32_t)sector[off + 27] << 8);
                     found_cluster = (high << 16) | low;
                     found_size = (uint32_t)sector[off + 28] | ((uint32_t)sector[off + 29] << 8) | ((uint32_t)sector[off + 30] << 16) | ((uint32_t)sector[off + 31] << 24);
+                    found_lba = lba;
+                    found_off = (uint32_t)off;
                     {
                         char df[160];
                         snprintf(df, sizeof(df), "[FAT32] matched entry name=%s is_dir=%d cluster=%u size=%u", name, (int)is_dir, found_cluster, found_size);
@@ -1376,34 +1572,21 @@ void* fat32_get_file_alloc(const char* path, size_t* out_len) {
             char tmp[128];
             snprintf(tmp, sizeof(tmp), "[FAT32] component not found in directory: %s", comp);
             hanacore::utils::log_info_cpp(tmp);
-            return nullptr;
+            return -1;
         }
 
-        // If this is the last component, and it's a file, read it
+        // Last component: report what it is
         if (*p == '\0') {
-            if (is_dir) return nullptr;
-            // allocate buffer and read file
-            void* buf = kmalloc(found_size ? found_size : 1);
-            if (!buf) return nullptr;
-            // use fat32_read_file which accepts cluster number as decimal string
-            char clstr[32];
-            // convert found_cluster to decimal string
-            uint32_t tmpc = found_cluster; int idx = 0;
-            if (tmpc == 0) { clstr[idx++] = '0'; }
-            else {
-                char rev[32]; int ri = 0;
-                while (tmpc > 0) { rev[ri++] = '0' + (tmpc % 10); tmpc /= 10; }
-                while (ri--) clstr[idx++] = rev[ri];
-            }
-            clstr[idx] = '\0';
-            int64_t r = fat32_read_file(clstr, buf, found_size ? found_size : 1);
-            if (r < 0) { kfree(buf); return nullptr; }
-            *out_len = (size_t)r;
-            return buf;
+            *out_cluster = found_cluster;
+            *out_size = found_size;
+            *out_is_dir = is_dir;
+            if (out_ent_lba) *out_ent_lba = found_lba;
+            if (out_ent_off) *out_ent_off = found_off;
+            return 0;
         }
 
         // Otherwise, traverse into directory
-        if (!is_dir) return nullptr;
+        if (!is_dir) return -1;
         current_cluster = found_cluster;
         {
             char tmp[128];
@@ -1412,7 +1595,222 @@ void* fat32_get_file_alloc(const char* path, size_t* out_len) {
         }
     }
 
-    return nullptr;
+    return -1;
+}
+
+void* fat32_get_file_alloc(const char* path, size_t* out_len) {
+    if (!out_len) return nullptr;
+    uint32_t cluster = 0, size = 0, ent_lba = 0, ent_off = 0;
+    bool is_dir = false;
+    if (fat32_resolve(path, &cluster, &size, &is_dir, &ent_lba, &ent_off) != 0 || is_dir) return nullptr;
+
+    void* buf = kmalloc(size ? size : 1);
+    if (!buf) return nullptr;
+    if (cluster < 2 || size == 0) {
+        *out_len = 0;
+        return buf;
+    }
+    Fat32File* f = fat32_file_get(ent_lba, ent_off, cluster, size);
+    if (!f) { kfree(buf); return nullptr; }
+    int64_t r = pcache_read(&f->data, 0, buf, size);
+    if (r < 0) { kfree(buf); return nullptr; }
+    *out_len = (size_t)r;
+    return buf;
+}
+
+int fat32_lookup(const char* path) {
+    uint32_t cluster = 0, size = 0;
+    bool is_dir = false;
+    if (fat32_resolve(path, &cluster, &size, &is_dir) != 0) return -1;
+    return is_dir ? VFS_TYPE_DIR : VFS_TYPE_FILE;
+}
+
+// Feed the entries of directory `path` to `fill`. The cookie is the index
+// of the next 32-byte slot in the directory, so resuming skips whole
+// clusters without reading them; d_ino is the slot's position on disk.
+// Subdirectories are listed too, but "." and ".." are not.
+int fat32_iterate_dir(const char* path, uint64_t cookie, vfs_filldir_t fill, void* ctx) {
+    if (!fill) return -1;
+    uint32_t cluster = 0, size = 0;
+    bool is_dir = false;
+    if (fat32_resolve(path, &cluster, &size, &is_dir) != 0 || !is_dir) return -1;
+    uint8_t sector[4096];
+    if (bytes_per_sector == 0 || bytes_per_sector > sizeof(sector) || cluster < 2) return -1;
+
+    const uint64_t slots_per_sector = bytes_per_sector / 32;
+    const uint64_t slots_per_cluster = slots_per_sector * sectors_per_cluster;
+    for (uint64_t skip = cookie / slots_per_cluster; skip; --skip) {
+        cluster = read_fat_entry(cluster);
+        if (cluster < 2 || cluster >= 0x0FFFFFF7) return 0;
+    }
+    uint64_t slot = cookie - cookie % slots_per_cluster;
+
+    while (cluster >= 2 && cluster < 0x0FFFFFF7) {
+        for (uint32_t s = 0; s < sectors_per_cluster; ++s, slot += slots_per_sector) {
+            if (slot + slots_per_sector <= cookie) continue;
+            uint32_t lba = cluster_to_lba(cluster) + s;
+            if (fat32_read_sector(lba, sector) != 0) return -1;
+            for (uint32_t off = 0; off < bytes_per_sector; off += 32) {
+                uint64_t here = slot + off / 32;
+                if (here < cookie) continue;
+                const uint8_t* ent = sector + off;
+                if (ent[0] == 0x00) return 0;
+                if (ent[0] == 0xE5 || ent[0] == '.') continue;
+                if ((ent[11] & 0x0F) == 0x0F) continue;     // long name
+                if (ent[11] & 0x08) continue;               // volume label
+
+                char name[13];
+                size_t n = 0;
+                for (int j = 0; j < 8 && ent[j] != ' '; ++j) name[n++] = (char)ent[j];
+                if (ent[8] != ' ') {
+                    name[n++] = '.';
+                    for (int j = 8; j < 11 && ent[j] != ' '; ++j) name[n++] = (char)ent[j];
+                }
+                name[n] = '\0';
+                unsigned type = (ent[11] & 0x10) ? VFS_DT_DIR : VFS_DT_REG;
+                uint64_t ino = (uint64_t)lba * slots_per_sector + off / 32;
+                if (fill(ctx, name, ino, type, here + 1)) return 0;
+            }
+        }
+        uint32_t next = read_fat_entry(cluster);
+        if (next == cluster) return -1;     // FAT chain loop
+        cluster = next;
+    }
+    return 0;
+}
+
+// =================== Open Files ===================
+
+// Write the file's first cluster and size back into its directory entry.
+static int fat32_file_update_entry(Fat32File* f) {
+    uint8_t sector[4096];
+    if (fat32_read_sector(f->ent_lba, sector) != 0) return -1;
+    uint8_t* e = sector + f->ent_off;
+    uint32_t size = (uint32_t)f->data.size;
+    e[20] = (uint8_t)((f->cluster >> 16) & 0xFF);
+    e[21] = (uint8_t)((f->cluster >> 24) & 0xFF);
+    e[26] = (uint8_t)(f->cluster & 0xFF);
+    e[27] = (uint8_t)((f->cluster >> 8) & 0xFF);
+    e[28] = (uint8_t)(size & 0xFF);
+    e[29] = (uint8_t)((size >> 8) & 0xFF);
+    e[30] = (uint8_t)((size >> 16) & 0xFF);
+    e[31] = (uint8_t)((size >> 24) & 0xFF);
+    return ata_write_sector(f->ent_lba, sector);
+}
+
+// Grow the cluster chain so it covers `size` bytes.
+static int fat32_file_reserve(Fat32File* f, uint64_t size) {
+    uint32_t cb = cluster_bytes_of();
+    uint32_t need = (uint32_t)((size + cb - 1) / cb);
+    if (f->cluster >= 2 && f->nclusters == 0) {
+        uint32_t c = f->cluster, n = 1;
+        for (uint32_t next = read_fat_entry(c); next >= 2 && next < 0x0FFFFFF7 && next != c; next = read_fat_entry(c)) {
+            c = next;
+            ++n;
+        }
+        f->nclusters = n;
+        f->last_cluster = c;
+    }
+    while (f->nclusters < need) {
+        uint32_t c = alloc_cluster();
+        if (c == 0) return -1;
+        if (f->nclusters == 0) f->cluster = c;
+        else if (write_fat_entry(f->last_cluster, c) != 0) { write_fat_entry(c, 0); return -1; }
+        f->last_cluster = c;
+        ++f->nclusters;
+    }
+    return 0;
+}
+
+// Zero [from, to) through the page cache, so stale sector contents in
+// newly covered clusters never show through.
+static int fat32_file_zero(Fat32File* f, uint64_t from, uint64_t to) {
+    static const uint8_t zeros[PCACHE_PAGE_SIZE] = {};
+    while (from < to) {
+        size_t n = to - from < sizeof(zeros) ? (size_t)(to - from) : sizeof(zeros);
+        if (pcache_write(&f->data, from, zeros, n) < 0) return -1;
+        from += n;
+    }
+    return 0;
+}
+
+Fat32File* fat32_open(const char* path, bool create) {
+    uint32_t cluster = 0, size = 0, ent_lba = 0, ent_off = 0;
+    bool is_dir = false;
+    if (fat32_resolve(path, &cluster, &size, &is_dir, &ent_lba, &ent_off) != 0) {
+        if (!create || fat32_create_file(path) != 0) return nullptr;
+        if (fat32_resolve(path, &cluster, &size, &is_dir, &ent_lba, &ent_off) != 0) return nullptr;
+    }
+    if (is_dir || ent_lba == 0) return nullptr;
+    Fat32File* f = fat32_file_get(ent_lba, ent_off, cluster < 2 ? 0 : cluster, size);
+    if (f) ++f->refs;
+    return f;
+}
+
+int64_t fat32_read_at(Fat32File* f, uint64_t off, void* buf, size_t len) {
+    if (!f || f->dead) return -1;
+    return pcache_read(&f->data, off, buf, len);
+}
+
+int64_t fat32_write_at(Fat32File* f, uint64_t off, const void* buf, size_t len) {
+    if (!f || f->dead) return -1;
+    if (len == 0) return 0;
+    uint64_t end = off + len;
+    if (end < off || end > 0xFFFFFFFFull) return -1;
+    uint64_t old_size = f->data.size;
+    uint32_t old_cluster = f->cluster;
+    if (end > old_size && fat32_file_reserve(f, end) != 0) return -1;
+    if (off > old_size && fat32_file_zero(f, old_size, off) != 0) return -1;
+    if (pcache_write(&f->data, off, buf, len) < 0) return -1;
+    if ((f->data.size != old_size || f->cluster != old_cluster) && fat32_file_update_entry(f) != 0) return -1;
+    return (int64_t)len;
+}
+
+int fat32_truncate(Fat32File* f, uint64_t size) {
+    if (!f || f->dead || size > 0xFFFFFFFFull) return -1;
+    uint64_t old_size = f->data.size;
+    if (size > old_size) {
+        if (fat32_file_reserve(f, size) != 0 || fat32_file_zero(f, old_size, size) != 0) return -1;
+        return fat32_file_update_entry(f);
+    }
+    pcache_truncate(&f->data, size);
+    uint32_t cb = cluster_bytes_of();
+    uint32_t keep = (uint32_t)((size + cb - 1) / cb);
+    if (keep == 0) {
+        free_cluster_chain(f->cluster);
+        f->cluster = 0;
+        f->nclusters = 0;
+    } else if (uint32_t last = fat32_file_cluster(f, (uint64_t)(keep - 1) * cb)) {
+        uint32_t next = read_fat_entry(last);
+        if (next >= 2 && next < 0x0FFFFFF7) {
+            write_fat_entry(last, 0x0FFFFFFF);
+            free_cluster_chain(next);
+        }
+        f->nclusters = keep;
+        f->last_cluster = last;
+    }
+    f->cursor_index = f->cursor_cluster = 0;
+    return fat32_file_update_entry(f);
+}
+
+uint64_t fat32_size(Fat32File* f) {
+    return f ? f->data.size : 0;
+}
+
+int fat32_fsync(Fat32File* f) {
+    if (!f || f->dead) return -1;
+    return pcache_writeback(&f->data);
+}
+
+int fat32_readahead(Fat32File* f, uint64_t off, size_t len) {
+    if (!f || f->dead) return -1;
+    pcache_readahead(&f->data, off, len);
+    return 0;
+}
+
+void fat32_close(Fat32File* f) {
+    if (!f || f->refs <= 0) return;
+    if (--f->refs == 0 && f->dead) kfree(f);
 }
 
 // =================== Mount Info ===================
@@ -26,6 +26,28 @@ namespace hanacore {
         int64_t fat32_read_file(const char* path, void* buf, size_t len);
         void* fat32_get_file_alloc(const char* path, size_t* out_len);
         int fat32_list_dir(const char* path, void (*cb)(const char* name));
+        // Resumable listing of `path` with d_ino and d_type; the cookie is
+        // a directory slot index (see vfs_filldir_t).
+        int fat32_iterate_dir(const char* path, uint64_t cookie,
+                              int (*fill)(void* ctx, const char* name, uint64_t ino, unsigned type, uint64_t next),
+                              void* ctx);
+        // VFS_TYPE_DIR or VFS_TYPE_FILE for `path`, -1 if it does not exist.
+        int fat32_lookup(const char* path);
+        // Open files: offset-based access through the page cache. A handle
+        // follows its file until the file is removed or rewritten, after
+        // which every call on it fails. Writes stay cached until
+        // fat32_fsync; fat32_close does no I/O.
+        struct Fat32File;
+        Fat32File* fat32_open(const char* path, bool create);
+        int64_t fat32_read_at(Fat32File* f, uint64_t off, void* buf, size_t len);
+        int64_t fat32_write_at(Fat32File* f, uint64_t off, const void* buf, size_t len);
+        int fat32_truncate(Fat32File* f, uint64_t size);
+        uint64_t fat32_size(Fat32File* f);
+        int fat32_fsync(Fat32File* f);
+        // Read [off, off + len) into the page cache ahead of the reader.
+        // Returns 0, or -1 if the handle is dead.
+        int fat32_readahead(Fat32File* f, uint64_t off, size_t len);
+        void fat32_close(Fat32File* f);
         // Optional progress callback (C linkage). Called periodically during
         // long operations. Implement a weak symbol in C if you want updates.
         // The callback receives current progress (0..100) or -1 for indeterminate.
@@ -12,6 +12,29 @@ namespace hanacore {
         static uint8_t* floppy_data = nullptr;
         static size_t floppy_size = 0;
 
+        static int floppy_fs_lookup(super_block*, const char* path) {
+            return strcmp(path, "/") == 0 ? VFS_TYPE_DIR : -1;
+        }
+
+        static void* floppy_fs_read(super_block*, const char* path, size_t* out_len) {
+            return floppy_get_file_alloc(path, out_len);
+        }
+
+        static int floppy_fs_readdir(super_block*, const char* path, vfs_dir_cb_t cb) {
+            return floppy_list_dir(path, cb);
+        }
+
+        static int floppy_fs_iterate(super_block*, const char* path, uint64_t cookie, vfs_filldir_t fill, void* ctx) {
+            return floppy_iterate_dir(path, cookie, fill, ctx);
+        }
+
+        static const fs_ops floppy_ops = {
+            floppy_fs_lookup, floppy_fs_read, nullptr, floppy_fs_readdir, floppy_fs_iterate,
+            nullptr, nullptr, nullptr, nullptr, nullptr,
+        };
+
+        static filesystem_type floppy_type = { "floppy", &floppy_ops, nullptr };
+
         int floppy_init_from_memory(const void* data, size_t size) {
             if (!data || size == 0) {
                 hanacore::utils::log_info_cpp("[Floppy] Invalid floppy image");
@@ -36,6 +59,7 @@ namespace hanacore {
             hanacore::utils::log_ok_cpp("[Floppy] Initialized floppy filesystem from memory");
             
             // Register with VFS as root filesystem
+            register_filesystem(&floppy_type);
             vfs_register_mount("floppy", "/");
             
             return 0;
@@ -43,8 +67,9 @@ namespace hanacore {
 
         // Directory listing for floppy - reads from a raw FAT12 boot sector
         // For now, minimal implementation that at least allows /bin access
-        int floppy_list_dir(const char* path, void (*cb)(const char* name)) {
-            if (!cb || !floppy_data) return -1;
+        // The cookie is the index of the next root directory entry.
+        int floppy_iterate_dir(const char* path, uint64_t cookie, vfs_filldir_t fill, void* ctx) {
+            if (!fill || !floppy_data) return -1;
 
             // Only support root directory listing for now
             if (!path || strcmp(path, "/") != 0) {
@@ -78,7 +103,7 @@ namespace hanacore {
             const uint8_t* root_dir = floppy_data + root_dir_offset;
 
             // Iterate through root directory entries
-            for (uint16_t i = 0; i < root_entries; ++i) {
+            for (uint64_t i = cookie; i < root_entries; ++i) {
                 const uint8_t* entry = root_dir + (i * 32);
                 
                 // Check if entry is empty (first byte = 0)
@@ -118,15 +143,26 @@ namespace hanacore {
 
                 filename[name_pos] = '\0';
 
-                // Call callback with filename
+                // Hand the entry over; its slot is its inode number
                 if (name_pos > 0) {
-                    cb(filename);
+                    uint64_t ino = root_dir_offset / 32 + i;
+                    if (fill(ctx, filename, ino, is_dir ? VFS_DT_DIR : VFS_DT_REG, i + 1)) break;
                 }
             }
 
             return 0;
         }
 
+        static int floppy_list_fill(void* ctx, const char* name, uint64_t, unsigned, uint64_t) {
+            ((void (*)(const char*))ctx)(name);
+            return 0;
+        }
+
+        int floppy_list_dir(const char* path, void (*cb)(const char* name)) {
+            if (!cb) return -1;
+            return floppy_iterate_dir(path, 0, floppy_list_fill, (void*)cb);
+        }
+
         // File reading from floppy - simplified
         void* floppy_get_file_alloc(const char* path, size_t* out_len) {
             if (!path || !floppy_data) return nullptr;
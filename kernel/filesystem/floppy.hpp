@@ -1,12 +1,18 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 namespace hanacore {
     namespace fs {
         // Initialize floppy filesystem from memory image (FAT12/FAT16)
         int floppy_init_from_memory(const void* data, size_t size);
         int floppy_list_dir(const char* path, void (*cb)(const char* name));
+        // Resumable root directory listing (see vfs_filldir_t)
+        int floppy_iterate_dir(const char* path, uint64_t cookie,
+                               int (*fill)(void* ctx, const char* name, uint64_t ino, unsigned type, uint64_t next),
+                               void* ctx);
+        void* floppy_get_file_alloc(const char* path, size_t* out_len);
     }
 }
 
@@ -1,11 +1,14 @@
 // (hanafs implementation follows)
 #include "hanafs.hpp"
+#include "vfs.hpp"
+#include "pagecache.hpp"
 #include "../api/hanaapi.h"
 #include "../mem/heap.hpp"
 #include "../drivers/ide.hpp"
 #include <string.h>
 #include "../utils/logger.hpp"
 #include "../libs/libc.h"
+#include "../arch/tsc.hpp"
 #include <stdint.h>
 // ATA helpers (provided by IDE driver). These are weak symbols defined in
 // filesystem/fat32.cpp as fallbacks; declare them here for use.
@@ -20,12 +23,27 @@ extern "C" int32_t ata_get_sector_count_drive(int drive);
 struct HanaEntry {
     char* path; // normalized absolute path (NUL-terminated)
     int is_dir;
-    uint8_t* data;
-    size_t len;
+    // File data, held in the page cache with nothing behind it: the
+    // cached pages are the file and are never evicted.
+    hanacore::fs::address_space data;
+    uint64_t ino;      // unique per entry; a rewrite creates a new entry
+    uint64_t mtime_ns; // wall clock at creation or last write
+    int refs;          // open inode handles
+    int unlinked;      // removed from the namespace, freed on the last put
+    int dirty;         // written through a handle since the last persist
     HanaEntry* next;
 };
 
 static HanaEntry* g_head = NULL;
+static uint64_t g_next_ino = 1;
+
+// Give a freshly created entry its identity. Rewriting a file replaces its
+// entry, so (ino, mtime_ns) changes on every write and callers can use it
+// as a file version.
+static void stamp_entry(HanaEntry* e) {
+    e->ino = g_next_ino++;
+    e->mtime_ns = hanacore::arch::clock_realtime_ns();
+}
 // Whether HanaFS was successfully loaded from ATA at init time.
 static int g_loaded_from_ata = 0;
 
@@ -38,6 +56,28 @@ static char* strdup_k(const char* s) {
     return p;
 }
 
+static void entry_free_data(HanaEntry* e) {
+    hanacore::fs::pcache_release(&e->data);
+    e->data.size = 0;
+}
+
+static size_t entry_read(HanaEntry* e, size_t off, void* buf, size_t n) {
+    int64_t r = hanacore::fs::pcache_read(&e->data, off, buf, n);
+    return r > 0 ? (size_t)r : 0;
+}
+
+// Write at `off`, extending the file. A gap between the old end and `off`
+// stays unallocated (reads as zeros).
+static int entry_write(HanaEntry* e, size_t off, const void* buf, size_t n) {
+    if (n == 0) return 0;
+    return hanacore::fs::pcache_write(&e->data, off, buf, n) < 0 ? -1 : 0;
+}
+
+// Shrink (dropping whole pages past the end) or extend with zeros.
+static void entry_truncate(HanaEntry* e, size_t size) {
+    hanacore::fs::pcache_truncate(&e->data, size);
+}
+
 static HanaEntry* find_entry(const char* path) {
     if (!path) return NULL;
     for (HanaEntry* e = g_head; e; e = e->next) {
@@ -46,12 +86,20 @@ static HanaEntry* find_entry(const char* path) {
     return NULL;
 }
 
+static void free_entry(HanaEntry* e) {
+    if (e->path) hanacore::mem::kfree(e->path);
+    entry_free_data(e);
+    hanacore::mem::kfree(e);
+}
+
+// Unlink from the namespace. An entry that is still open lives on
+// (anonymous) until its last handle goes away.
 static void remove_entry_node(HanaEntry* prev, HanaEntry* cur) {
     if (!cur) return;
     if (prev) prev->next = cur->next; else g_head = cur->next;
-    if (cur->path) hanacore::mem::kfree(cur->path);
-    if (cur->data) hanacore::mem::kfree(cur->data);
-    hanacore::mem::kfree(cur);
+    cur->next = NULL;
+    if (cur->refs > 0) { cur->unlinked = 1; return; }
+    free_entry(cur);
 }
 
 static void normalize_path_inplace(char* buf, size_t sz) {
@@ -147,6 +195,7 @@ extern "C" int hanafs_init(void) {
     HanaEntry* root = (HanaEntry*)hanacore::mem::kmalloc(sizeof(HanaEntry));
     if (!root) return -1;
     memset(root, 0, sizeof(HanaEntry));
+    stamp_entry(root);
     root->path = strdup_k("/");
     if (!root->path) { hanacore::mem::kfree(root); return -1; }
     root->is_dir = 1;
@@ -164,6 +213,22 @@ extern "C" int hanafs_init(void) {
     return 0;
 }
 
+// Attempt to persist to ATA for most files; however small, frequently
+// updated files (like interactive history) should not force a disk
+// write on every change. Additionally, callers can disable persistence
+// temporarily (e.g., when bulk-mounting an ISO) via
+// `hanafs_set_persist_enabled(0)`.
+static void persist_file_change(const char* ipath) {
+    extern int g_hanafs_persist_enabled;
+    if (strcmp(ipath, "/hcsh_history") != 0 && g_hanafs_persist_enabled) {
+        if (hanafs_persist_to_ata() == 0) {
+            hanacore::utils::log_info_cpp("[HanaFS] persisted file %s to ATA", ipath);
+        } else {
+            hanacore::utils::log_info_cpp("[HanaFS] failed to persist file %s to ATA", ipath);
+        }
+    }
+}
+
 extern "C" int hanafs_write_file(const char* path, const void* buf, size_t len) {
     if (!path) return -1;
     // copy path into temp buffer to normalize
@@ -190,27 +255,14 @@ extern "C" int hanafs_write_file(const char* path, const void* buf, size_t len)
     HanaEntry* e = (HanaEntry*)hanacore::mem::kmalloc(sizeof(HanaEntry));
     if (!e) { hanacore::mem::kfree(pbuf); return -1; }
     memset(e, 0, sizeof(HanaEntry));
-    e->path = strdup_k(ipath); e->is_dir = 0; e->len = len; e->next = g_head; g_head = e;
+    stamp_entry(e);
+    e->path = strdup_k(ipath); e->is_dir = 0; e->next = g_head; g_head = e;
+    // Callers outside the VFS (fileio, initrd) create files here directly.
+    vfs_invalidate(ipath);
     if (len > 0 && buf) {
-        e->data = (uint8_t*)hanacore::mem::kmalloc(len);
-        if (!e->data) { remove_entry_node(NULL, e); return -1; }
-        for (size_t i = 0; i < len; ++i) e->data[i] = ((const uint8_t*)buf)[i];
-    } else {
-        e->data = NULL; e->len = 0;
-    }
-    // Attempt to persist to ATA for most files; however small, frequently
-    // updated files (like interactive history) should not force a disk
-    // write on every change. Additionally, callers can disable persistence
-    // temporarily (e.g., when bulk-mounting an ISO) via
-    // `hanafs_set_persist_enabled(0)`.
-    extern int g_hanafs_persist_enabled;
-    if (strcmp(ipath, "/hcsh_history") != 0 && g_hanafs_persist_enabled) {
-        if (hanafs_persist_to_ata() == 0) {
-            hanacore::utils::log_info_cpp("[HanaFS] persisted file %s to ATA", ipath);
-        } else {
-            hanacore::utils::log_info_cpp("[HanaFS] failed to persist file %s to ATA", ipath);
-        }
+        if (entry_write(e, 0, buf, len) != 0) { remove_entry_node(NULL, e); return -1; }
     }
+    persist_file_change(ipath);
     return 0;
 }
 
@@ -229,7 +281,7 @@ extern "C" int hanafs_persist_to_ata(void) {
     for (HanaEntry* e = g_head; e; e = e->next) {
         ++entry_count;
         size_t plen = strlen(e->path);
-        payload_len += 2 + 1 + 4 + plen + (e->is_dir ? 0 : e->len);
+        payload_len += 2 + 1 + 4 + plen + (e->is_dir ? 0 : e->data.size);
     }
 
     const uint32_t hdr_sz = 4 + 4 + 4 + 4; // magic + ver + count + total
@@ -252,13 +304,14 @@ extern "C" int hanafs_persist_to_ata(void) {
         uint16_t plen = (uint16_t)strlen(e->path);
         buf[off++] = (uint8_t)(plen & 0xFF); buf[off++] = (uint8_t)((plen >> 8) & 0xFF);
         buf[off++] = (uint8_t)(e->is_dir ? 1 : 0);
-        uint32_t dlen = (uint32_t)(e->is_dir ? 0 : (uint32_t)e->len);
+        uint32_t dlen = (uint32_t)(e->is_dir ? 0 : (uint32_t)e->data.size);
         memcpy(buf + off, &dlen, 4); off += 4;
         // path bytes (no NUL)
         for (size_t i = 0; i < plen; ++i) buf[off++] = (uint8_t)e->path[i];
         // data bytes
         if (!e->is_dir && dlen) {
-            for (uint32_t i = 0; i < dlen; ++i) buf[off++] = e->data[i];
+            entry_read(e, 0, buf + off, dlen);
+            off += dlen;
         }
     }
 
@@ -283,6 +336,7 @@ extern "C" int hanafs_persist_to_ata(void) {
     }
     hanacore::mem::kfree(buf);
     g_loaded_from_ata = 1;
+    for (HanaEntry* e = g_head; e; e = e->next) e->dirty = 0;
     return 0;
 }
 
@@ -297,10 +351,12 @@ extern "C" int hanafs_format_ata_master(int drive_number) {
     (void)drive_number;
     // clear any existing entries
     while (g_head) { HanaEntry* n = g_head->next; remove_entry_node(NULL, g_head); g_head = n; }
+    vfs_invalidate("/");
     // create fresh root
     HanaEntry* root = (HanaEntry*)hanacore::mem::kmalloc(sizeof(HanaEntry));
     if (!root) return -1;
     memset(root, 0, sizeof(HanaEntry));
+    stamp_entry(root);
     root->path = strdup_k("/"); if (!root->path) { hanacore::mem::kfree(root); return -1; }
     root->is_dir = 1; root->next = NULL; g_head = root;
 
@@ -348,10 +404,11 @@ extern "C" int hanafs_load_from_ata(void) {
     pos += 4 + 4 + 4 + 4;
     // clear any existing entries
     while (g_head) { HanaEntry* n = g_head->next; remove_entry_node(NULL, g_head); g_head = n; }
+    vfs_invalidate("/");
     // create root
     HanaEntry* root = (HanaEntry*)hanacore::mem::kmalloc(sizeof(HanaEntry));
     if (!root) { hanacore::mem::kfree(buf); return -1; }
-    memset(root,0,sizeof(HanaEntry)); root->path = strdup_k("/"); root->is_dir = 1; root->next = NULL; g_head = root;
+    memset(root,0,sizeof(HanaEntry)); stamp_entry(root); root->path = strdup_k("/"); root->is_dir = 1; root->next = NULL; g_head = root;
 
     for (uint32_t ei = 0; ei < entry_count; ++ei) {
         if (pos + 2 + 1 + 4 > total) break;
@@ -365,12 +422,11 @@ extern "C" int hanafs_load_from_ata(void) {
         // create entry
         HanaEntry* e = (HanaEntry*)hanacore::mem::kmalloc(sizeof(HanaEntry));
         if (!e) { hanacore::mem::kfree(path); break; }
-        memset(e,0,sizeof(HanaEntry));
-        e->path = path; e->is_dir = is_dir ? 1 : 0; e->len = dlen; e->next = g_head; g_head = e;
+        memset(e,0,sizeof(HanaEntry)); stamp_entry(e);
+        e->path = path; e->is_dir = is_dir ? 1 : 0; e->next = g_head; g_head = e;
         if (!e->is_dir && dlen > 0) {
-            e->data = (uint8_t*)hanacore::mem::kmalloc(dlen);
-            if (!e->data) { remove_entry_node(NULL, e); break; }
-            for (uint32_t i = 0; i < dlen; ++i) e->data[i] = buf[pos++];
+            if (pos + dlen > total || entry_write(e, 0, buf + pos, dlen) != 0) { remove_entry_node(NULL, e); break; }
+            pos += dlen;
         }
     }
 
@@ -437,11 +493,11 @@ extern "C" void* hanafs_get_file_alloc(const char* path, size_t* out_len) {
     // should explicitly reference `0:/` when they want ATA-backed
     // drive contents. This keeps mount points distinct.
     if (!e || e->is_dir) return NULL;
-    size_t n = e->len ? e->len : 0;
+    size_t n = e->data.size ? e->data.size : 0;
     void* buf = hanacore::mem::kmalloc(n ? n : 1);
     if (!buf) return NULL;
     if (n) {
-        for (size_t i = 0; i < n; ++i) ((uint8_t*)buf)[i] = e->data[i];
+        entry_read(e, 0, buf, n);
     } else {
         ((uint8_t*)buf)[0] = 0;
     }
@@ -450,49 +506,81 @@ extern "C" void* hanafs_get_file_alloc(const char* path, size_t* out_len) {
     return buf;
 }
 
-extern "C" int hanafs_list_dir(const char* path, void (*cb)(const char* name)) {
-    if (!path || !cb) return -1;
+// A directory being listed, in both the internal namespace and, when the
+// caller gave no drive prefix, the legacy one.
+struct ListScope {
+    char* pbuf;
+    size_t plen;
+    int drv;
+    char ipath[512];
+    size_t iplen;
+};
+
+static int list_scope_init(ListScope* ls, const char* path) {
     // normalize path
     size_t psz = strlen(path) + 2;
-    char* pbuf = (char*)hanacore::mem::kmalloc(psz);
-    if (!pbuf) return -1;
-    for (size_t i = 0; i < psz-1; ++i) pbuf[i] = path[i]; pbuf[psz-1] = '\0';
-    int drv = -1;
-    drv = parse_drive_prefix_inplace(pbuf, psz);
-    normalize_path_inplace(pbuf, psz);
-    size_t plen = strlen(pbuf);
-    char ipath[512]; build_internal_path(pbuf, drv, ipath, sizeof(ipath));
-    size_t iplen = strlen(ipath);
-    // iterate entries and find immediate children for either internal namespace
-    // or legacy (no-drive) namespace when appropriate.
-    for (HanaEntry* e = g_head; e; e = e->next) {
-        const char* candidate = NULL;
-        size_t cand_len = 0;
-        if (strncmp(e->path, ipath, iplen) == 0) {
-            // internal match
-            candidate = e->path + iplen;
-            cand_len = strlen(e->path) - iplen;
-        }
-        else if (drv < 0 && strncmp(e->path, pbuf, plen) == 0) {
-            // legacy (no-drive) match when the caller did not specify a
-            // drive prefix.
-            candidate = e->path + plen;
-            cand_len = strlen(e->path) - plen;
-        } else {
-            continue;
-        }
-    if (!candidate) continue;
+    ls->pbuf = (char*)hanacore::mem::kmalloc(psz);
+    if (!ls->pbuf) return -1;
+    for (size_t i = 0; i < psz-1; ++i) ls->pbuf[i] = path[i];
+    ls->pbuf[psz-1] = '\0';
+    ls->drv = parse_drive_prefix_inplace(ls->pbuf, psz);
+    normalize_path_inplace(ls->pbuf, psz);
+    ls->plen = strlen(ls->pbuf);
+    build_internal_path(ls->pbuf, ls->drv, ls->ipath, sizeof(ls->ipath));
+    ls->iplen = strlen(ls->ipath);
+    return 0;
+}
+
+// Name of `e` if it is an immediate child of the listed directory, else NULL.
+static const char* list_scope_child(const ListScope* ls, const HanaEntry* e) {
+    const char* candidate;
+    if (strncmp(e->path, ls->ipath, ls->iplen) == 0) {
+        // internal match
+        candidate = e->path + ls->iplen;
+    } else if (ls->drv < 0 && strncmp(e->path, ls->pbuf, ls->plen) == 0) {
+        // legacy (no-drive) match when the caller did not specify a
+        // drive prefix.
+        candidate = e->path + ls->plen;
+    } else {
+        return NULL;
+    }
     // Skip the entry that corresponds exactly to the directory itself
     // (candidate can be an empty string in that case). This prevented
     // callers like `ls` from receiving an empty name and incorrectly
     // treating the directory as non-empty.
-    if (candidate[0] == '\0') continue;
+    if (candidate[0] == '\0') return NULL;
     if (candidate[0] == '/') ++candidate;
-    const char* slash = strchr(candidate, '/');
-    if (slash) continue;
-    cb(candidate);
+    if (strchr(candidate, '/')) return NULL;
+    return candidate;
+}
+
+extern "C" int hanafs_list_dir(const char* path, void (*cb)(const char* name)) {
+    if (!path || !cb) return -1;
+    ListScope ls;
+    if (list_scope_init(&ls, path) != 0) return -1;
+    for (HanaEntry* e = g_head; e; e = e->next) {
+        const char* name = list_scope_child(&ls, e);
+        if (name) cb(name);
     }
-    hanacore::mem::kfree(pbuf);
+    hanacore::mem::kfree(ls.pbuf);
+    return 0;
+}
+
+// New entries go to the head of the list with a higher ino, so the list is
+// in descending ino order and the cookie is the ino of the last entry
+// taken: resuming skips everything at or above it. Entries created since
+// the listing started are not reported.
+extern "C" int hanafs_iterate_dir(const char* path, uint64_t cookie, vfs_filldir_t fill, void* ctx) {
+    if (!path || !fill) return -1;
+    ListScope ls;
+    if (list_scope_init(&ls, path) != 0) return -1;
+    for (HanaEntry* e = g_head; e; e = e->next) {
+        if (cookie && e->ino >= cookie) continue;
+        const char* name = list_scope_child(&ls, e);
+        if (!name) continue;
+        if (fill(ctx, name, e->ino, e->is_dir ? VFS_DT_DIR : VFS_DT_REG, e->ino)) break;
+    }
+    hanacore::mem::kfree(ls.pbuf);
     return 0;
 }
 
@@ -556,6 +644,7 @@ extern "C" int hanafs_unlink(const char* path) {
     while (cur) {
         if (strcmp(cur->path, ipath) == 0 || (drv < 0 && strcmp(cur->path, pbuf) == 0)) {
             remove_entry_node(prev, cur);
+            vfs_invalidate(ipath);
             // persist updated state
             if (hanafs_persist_to_ata() == 0) {
                 hanacore::utils::log_info_cpp("[HanaFS] persisted unlink %s to ATA", ipath);
@@ -585,7 +674,9 @@ extern "C" int hanafs_make_dir(const char* path) {
     HanaEntry* e = (HanaEntry*)hanacore::mem::kmalloc(sizeof(HanaEntry));
     if (!e) { hanacore::mem::kfree(pbuf); return -1; }
     memset(e, 0, sizeof(HanaEntry));
-    e->path = strdup_k(ipath); e->is_dir = 1; e->data = NULL; e->len = 0; e->next = g_head; g_head = e;
+    stamp_entry(e);
+    e->path = strdup_k(ipath); e->is_dir = 1; e->next = g_head; g_head = e;
+    vfs_invalidate(ipath);
     // persist new directory to ATA
     if (hanafs_persist_to_ata() == 0) {
         // ok
@@ -632,13 +723,85 @@ extern "C" int hanafs_stat(const char* path, struct hana_stat* st) {
     if (!e) { hanacore::mem::kfree(pbuf); return -1; }
     // Fill a minimal hana_stat
     memset(st, 0, sizeof(*st));
-    st->st_size = (uint64_t)e->len;
+    st->st_size = (uint64_t)e->data.size;
     st->st_nlink = 1;
     st->st_uid = 0; st->st_gid = 0;
     // minimal mode: S_IFDIR (0x4000) or S_IFREG (0x8000)
     st->st_mode = e->is_dir ? 0x4000 : 0x8000;
-    st->st_mtime_ns = 0; st->st_atime_ns = 0; st->st_ctime_ns = 0;
+    st->st_ino = e->ino;
+    st->st_mtime_ns = e->mtime_ns; st->st_atime_ns = e->mtime_ns; st->st_ctime_ns = e->mtime_ns;
+    hanacore::mem::kfree(pbuf);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Open inodes: a handle pins an entry, and reads/writes go straight to its
+// pages at an offset instead of through whole-file copies.
+
+extern "C" hanafs_inode_t* hanafs_inode_open(const char* path, int create) {
+    if (!path) return NULL;
+    size_t psz = strlen(path) + 2;
+    char* pbuf = (char*)hanacore::mem::kmalloc(psz);
+    if (!pbuf) return NULL;
+    for (size_t i = 0; i < psz-1; ++i) pbuf[i] = path[i]; pbuf[psz-1] = '\0';
+    int drv = parse_drive_prefix_inplace(pbuf, psz);
+    normalize_path_inplace(pbuf, psz);
+    char ipath[512]; build_internal_path(pbuf, drv, ipath, sizeof(ipath));
+    HanaEntry* e = find_entry(ipath);
+    if (!e && drv < 0) e = find_entry(pbuf);
+    if (!e && create) {
+        if (hanafs_write_file(ipath, NULL, 0) == 0) e = find_entry(ipath);
+    }
     hanacore::mem::kfree(pbuf);
+    if (!e) return NULL;
+    ++e->refs;
+    return e;
+}
+
+extern "C" void hanafs_inode_get(hanafs_inode_t* ino) {
+    if (ino) ++ino->refs;
+}
+
+extern "C" void hanafs_inode_put(hanafs_inode_t* ino) {
+    if (!ino || ino->refs <= 0) return;
+    if (--ino->refs == 0 && ino->unlinked) free_entry(ino);
+}
+
+extern "C" int hanafs_inode_is_dir(hanafs_inode_t* ino) {
+    return ino && ino->is_dir;
+}
+
+extern "C" uint64_t hanafs_inode_size(hanafs_inode_t* ino) {
+    return ino ? (uint64_t)ino->data.size : 0;
+}
+
+extern "C" long hanafs_inode_read(hanafs_inode_t* ino, uint64_t off, void* buf, size_t len) {
+    if (!ino || ino->is_dir) return -1;
+    return (long)entry_read(ino, (size_t)off, buf, len);
+}
+
+extern "C" long hanafs_inode_write(hanafs_inode_t* ino, uint64_t off, const void* buf, size_t len) {
+    if (!ino || ino->is_dir) return -1;
+    if (len == 0) return 0;
+    if (entry_write(ino, (size_t)off, buf, len) != 0) return -1;
+    ino->mtime_ns = hanacore::arch::clock_realtime_ns();
+    ino->dirty = 1;
+    return (long)len;
+}
+
+extern "C" int hanafs_inode_truncate(hanafs_inode_t* ino, uint64_t size) {
+    if (!ino || ino->is_dir) return -1;
+    entry_truncate(ino, (size_t)size);
+    ino->mtime_ns = hanacore::arch::clock_realtime_ns();
+    ino->dirty = 1;
+    return 0;
+}
+
+extern "C" int hanafs_inode_sync(hanafs_inode_t* ino) {
+    if (!ino) return -1;
+    if (!ino->dirty || ino->unlinked) return 0;
+    persist_file_change(ino->path);
+    ino->dirty = 0;
     return 0;
 }
 
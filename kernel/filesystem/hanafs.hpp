@@ -116,6 +116,12 @@ extern "C" {
     int hanafs_write_file(const char* path, const void* buf, size_t len);
     void* hanafs_get_file_alloc(const char* path, size_t* out_len);
     int hanafs_list_dir(const char* path, void (*cb)(const char* name));
+    // Feed the children of `path` after `cookie` (0 = from the start) to
+    // `fill` until it returns nonzero; `type` is DT_DIR or DT_REG and
+    // `next` resumes after the entry. Returns 0 or -1.
+    int hanafs_iterate_dir(const char* path, uint64_t cookie,
+                           int (*fill)(void* ctx, const char* name, uint64_t ino, unsigned type, uint64_t next),
+                           void* ctx);
     int hanafs_create_file(const char* path);
     int hanafs_unlink(const char* path);
     int hanafs_make_dir(const char* path);
@@ -133,3 +139,23 @@ extern "C" {
     hana_dirent* hanafs_readdir(hana_dir_t* dir);
     int hanafs_closedir(hana_dir_t* dir);
 }
+
+// Open inodes (streaming file access). A handle keeps the file's data alive
+// even if the path is unlinked or rewritten; reads and writes act on the
+// file's pages at an offset. Writes are persisted by hanafs_inode_sync.
+typedef struct HanaEntry hanafs_inode_t;
+extern "C" {
+    // Look up `path` (creating an empty file if `create`); returns a
+    // referenced handle or NULL.
+    hanafs_inode_t* hanafs_inode_open(const char* path, int create);
+    void hanafs_inode_get(hanafs_inode_t* ino);
+    void hanafs_inode_put(hanafs_inode_t* ino);
+    int hanafs_inode_is_dir(hanafs_inode_t* ino);
+    uint64_t hanafs_inode_size(hanafs_inode_t* ino);
+    // Return the byte count (short at end of file) or -1.
+    long hanafs_inode_read(hanafs_inode_t* ino, uint64_t off, void* buf, size_t len);
+    long hanafs_inode_write(hanafs_inode_t* ino, uint64_t off, const void* buf, size_t len);
+    int hanafs_inode_truncate(hanafs_inode_t* ino, uint64_t size);
+    // Persist the filesystem if this file changed since the last sync.
+    int hanafs_inode_sync(hanafs_inode_t* ino);
+}
@@ -0,0 +1,449 @@
+// kernel/filesystem/pagecache.cpp
+#include "pagecache.hpp"
+#include "../libs/libc.h"
+#include "../mem/heap.hpp"
+#include "../sync/mutex.hpp"
+#include "../scheduler/scheduler.hpp"
+
+namespace hanacore { namespace fs {
+
+    static constexpr size_t PCACHE_MAX_PAGES = 2048;       // 8 MiB of evictable pages
+    static constexpr size_t PCACHE_RECLAIM_BATCH = 16;
+    static constexpr uint64_t PCACHE_READAHEAD = 4;        // pages read past a miss
+
+    static constexpr int RADIX_SHIFT = 6;
+    static constexpr int RADIX_SLOTS = 1 << RADIX_SHIFT;
+    static constexpr uint64_t RADIX_MASK = RADIX_SLOTS - 1;
+
+    struct pcache_node {
+        void* slots[RADIX_SLOTS];   // child nodes, or cached_page at the bottom level
+        int count;
+    };
+
+    struct cached_page {
+        address_space* as;
+        uint64_t index;
+        uint8_t* data;
+        bool dirty;
+        cached_page* lru_prev;      // towards the most recently used
+        cached_page* lru_next;
+    };
+
+    static cached_page* lru_head = nullptr;
+    static cached_page* lru_tail = nullptr;
+    static size_t total_pages = 0;
+    static size_t lru_pages = 0;
+    static size_t dirty_pages = 0;
+    static uint64_t stat_hits = 0, stat_misses = 0, stat_evictions = 0;
+    static uint64_t stat_readahead = 0;
+
+    // Serialises every public entry point. Held across readpage, so a page
+    // is never visible to another task before it has been filled.
+    HANA_LOCK_CLASS(pcache_class, "pcache");
+    static hanacore::sync::Mutex pcache_lock = { 0, nullptr, { { 0, &pcache_class, 0 }, nullptr, nullptr }, &pcache_class, 0 };
+    using hanacore::sync::MutexGuard;
+
+    static size_t reclaim(size_t nr);
+
+    // ------------------------------------------------------------------
+    // Radix tree
+    // ------------------------------------------------------------------
+
+    static uint64_t radix_max_index(int height) {
+        if (height <= 0) return 0;
+        if (height * RADIX_SHIFT >= 64) return ~0ULL;
+        return (1ULL << (height * RADIX_SHIFT)) - 1;
+    }
+
+    static pcache_node* node_alloc() {
+        pcache_node* n = (pcache_node*)hanacore::mem::kmalloc(sizeof(pcache_node));
+        if (n) memset(n, 0, sizeof(*n));
+        return n;
+    }
+
+    static cached_page* radix_lookup(const address_space* as, uint64_t index) {
+        if (!as->root || index > radix_max_index(as->height)) return nullptr;
+        pcache_node* n = as->root;
+        for (int h = as->height; h > 1; --h) {
+            n = (pcache_node*)n->slots[(index >> (RADIX_SHIFT * (h - 1))) & RADIX_MASK];
+            if (!n) return nullptr;
+        }
+        return (cached_page*)n->slots[index & RADIX_MASK];
+    }
+
+    static int radix_insert(address_space* as, uint64_t index, cached_page* pg) {
+        if (!as->root) {
+            as->root = node_alloc();
+            if (!as->root) return -1;
+            as->height = 1;
+        }
+        while (index > radix_max_index(as->height)) {
+            pcache_node* top = node_alloc();
+            if (!top) return -1;
+            top->slots[0] = as->root;
+            top->count = 1;
+            as->root = top;
+            ++as->height;
+        }
+        pcache_node* n = as->root;
+        for (int h = as->height; h > 1; --h) {
+            uint64_t slot = (index >> (RADIX_SHIFT * (h - 1))) & RADIX_MASK;
+            if (!n->slots[slot]) {
+                pcache_node* child = node_alloc();
+                if (!child) return -1;
+                n->slots[slot] = child;
+                ++n->count;
+            }
+            n = (pcache_node*)n->slots[slot];
+        }
+        n->slots[index & RADIX_MASK] = pg;
+        ++n->count;
+        return 0;
+    }
+
+    // Returns whether `n` is left empty (and so can be freed by its parent).
+    static bool radix_delete(pcache_node* n, int h, uint64_t index) {
+        uint64_t slot = (index >> (RADIX_SHIFT * (h - 1))) & RADIX_MASK;
+        if (h == 1) {
+            if (n->slots[slot]) { n->slots[slot] = nullptr; --n->count; }
+        } else {
+            pcache_node* child = (pcache_node*)n->slots[slot];
+            if (child && radix_delete(child, h - 1, index)) {
+                hanacore::mem::kfree(child);
+                n->slots[slot] = nullptr;
+                --n->count;
+            }
+        }
+        return n->count == 0;
+    }
+
+    // ------------------------------------------------------------------
+    // Pages
+    // ------------------------------------------------------------------
+
+    static void lru_unlink(cached_page* pg) {
+        if (pg->lru_prev) pg->lru_prev->lru_next = pg->lru_next; else lru_head = pg->lru_next;
+        if (pg->lru_next) pg->lru_next->lru_prev = pg->lru_prev; else lru_tail = pg->lru_prev;
+        pg->lru_prev = pg->lru_next = nullptr;
+    }
+
+    static void lru_push(cached_page* pg) {
+        pg->lru_prev = nullptr;
+        pg->lru_next = lru_head;
+        if (lru_head) lru_head->lru_prev = pg; else lru_tail = pg;
+        lru_head = pg;
+    }
+
+    static bool evictable(const address_space* as) { return as->ops != nullptr; }
+
+    static void lru_touch(cached_page* pg) {
+        if (!evictable(pg->as) || lru_head == pg) return;
+        lru_unlink(pg);
+        lru_push(pg);
+    }
+
+    static void set_clean(cached_page* pg) {
+        if (!pg->dirty) return;
+        pg->dirty = false;
+        --pg->as->ndirty;
+        --dirty_pages;
+    }
+
+    static void set_dirty(cached_page* pg) {
+        // Without a backing store there is nothing to write back to.
+        if (pg->dirty || !evictable(pg->as)) return;
+        pg->dirty = true;
+        ++pg->as->ndirty;
+        ++dirty_pages;
+    }
+
+    // Free a page that is already out of its tree.
+    static void page_free(cached_page* pg) {
+        set_clean(pg);
+        if (evictable(pg->as)) {
+            lru_unlink(pg);
+            --lru_pages;
+        }
+        --pg->as->nrpages;
+        --total_pages;
+        hanacore::mem::kfree(pg->data);
+        hanacore::mem::kfree(pg);
+    }
+
+    static void page_remove(cached_page* pg) {
+        address_space* as = pg->as;
+        if (radix_delete(as->root, as->height, pg->index)) {
+            hanacore::mem::kfree(as->root);
+            as->root = nullptr;
+            as->height = 0;
+        }
+        page_free(pg);
+    }
+
+    // A zeroed page at `index`, already in the tree.
+    static cached_page* page_add(address_space* as, uint64_t index) {
+        if (evictable(as) && lru_pages >= PCACHE_MAX_PAGES) reclaim(PCACHE_RECLAIM_BATCH);
+        cached_page* pg = (cached_page*)hanacore::mem::kmalloc(sizeof(cached_page));
+        uint8_t* data = (uint8_t*)hanacore::mem::kmalloc(PCACHE_PAGE_SIZE);
+        if (!pg || !data) {
+            hanacore::mem::kfree(pg);
+            hanacore::mem::kfree(data);
+            return nullptr;
+        }
+        memset(pg, 0, sizeof(*pg));
+        memset(data, 0, PCACHE_PAGE_SIZE);
+        pg->as = as;
+        pg->index = index;
+        pg->data = data;
+        if (radix_insert(as, index, pg) != 0) {
+            hanacore::mem::kfree(data);
+            hanacore::mem::kfree(pg);
+            return nullptr;
+        }
+        ++as->nrpages;
+        ++total_pages;
+        if (evictable(as)) {
+            lru_push(pg);
+            ++lru_pages;
+        }
+        return pg;
+    }
+
+    static cached_page* page_read_in(address_space* as, uint64_t index) {
+        cached_page* pg = page_add(as, index);
+        if (!pg) return nullptr;
+        if (as->ops->readpage && as->ops->readpage(as, index, pg->data) != 0) {
+            page_remove(pg);
+            return nullptr;
+        }
+        return pg;
+    }
+
+    // The cached page at `index`, read in (with the few after it) on a
+    // miss. NULL for a hole in a mapping without ops, or on failure.
+    static cached_page* page_get(address_space* as, uint64_t index) {
+        cached_page* pg = radix_lookup(as, index);
+        if (pg) {
+            ++stat_hits;
+            lru_touch(pg);
+            return pg;
+        }
+        if (!evictable(as)) return nullptr;
+        ++stat_misses;
+        pg = page_read_in(as, index);
+        if (!pg) return nullptr;
+        uint64_t last = as->size ? (as->size - 1) / PCACHE_PAGE_SIZE : 0;
+        for (uint64_t i = index + 1; i <= index + PCACHE_READAHEAD && i <= last; ++i) {
+            if (radix_lookup(as, i)) continue;
+            if (!page_read_in(as, i)) break;
+        }
+        // Read-ahead went to the head of the LRU; the page asked for is
+        // the one in use.
+        lru_touch(pg);
+        return pg;
+    }
+
+    // ------------------------------------------------------------------
+    // Mappings
+    // ------------------------------------------------------------------
+
+    void pcache_init_mapping(address_space* as, const address_space_ops* ops, void* host, uint64_t size) {
+        memset(as, 0, sizeof(*as));
+        as->ops = ops;
+        as->host = host;
+        as->size = size;
+    }
+
+    int64_t pcache_read(address_space* as, uint64_t off, void* buf, size_t len) {
+        if (!as || (!buf && len)) return -1;
+        MutexGuard g(&pcache_lock);
+        if (off >= as->size) return 0;
+        if (len > as->size - off) len = (size_t)(as->size - off);
+        uint8_t* dst = (uint8_t*)buf;
+        size_t done = 0;
+        while (done < len) {
+            uint64_t pos = off + done;
+            size_t in_page = (size_t)(pos % PCACHE_PAGE_SIZE);
+            size_t chunk = PCACHE_PAGE_SIZE - in_page;
+            if (chunk > len - done) chunk = len - done;
+            cached_page* pg = page_get(as, pos / PCACHE_PAGE_SIZE);
+            if (pg) {
+                memcpy(dst + done, pg->data + in_page, chunk);
+            } else if (!evictable(as)) {
+                memset(dst + done, 0, chunk);
+            } else {
+                return done ? (int64_t)done : -1;
+            }
+            done += chunk;
+        }
+        return (int64_t)done;
+    }
+
+    int64_t pcache_write(address_space* as, uint64_t off, const void* buf, size_t len) {
+        if (!as || (!buf && len)) return -1;
+        if (off + len < off) return -1;
+        MutexGuard g(&pcache_lock);
+        const uint8_t* src = (const uint8_t*)buf;
+        size_t done = 0;
+        while (done < len) {
+            uint64_t pos = off + done;
+            uint64_t index = pos / PCACHE_PAGE_SIZE;
+            size_t in_page = (size_t)(pos % PCACHE_PAGE_SIZE);
+            size_t chunk = PCACHE_PAGE_SIZE - in_page;
+            if (chunk > len - done) chunk = len - done;
+            cached_page* pg = radix_lookup(as, index);
+            if (!pg) {
+                // A partial write over existing data needs the rest of the page.
+                bool partial = chunk < PCACHE_PAGE_SIZE && index * PCACHE_PAGE_SIZE < as->size;
+                pg = (partial && evictable(as)) ? page_get(as, index) : page_add(as, index);
+                if (!pg) return -1;
+            }
+            lru_touch(pg);
+            memcpy(pg->data + in_page, src + done, chunk);
+            set_dirty(pg);
+            done += chunk;
+            if (pos + chunk > as->size) as->size = pos + chunk;
+        }
+        return (int64_t)len;
+    }
+
+    // Free the pages of `n` (a level-`h` node covering from `base`) at
+    // index `from` and above. Returns whether `n` is left empty.
+    static bool truncate_node(pcache_node* n, int h, uint64_t base, uint64_t from) {
+        uint64_t span = 1ULL << (RADIX_SHIFT * (h - 1));
+        for (int i = 0; i < RADIX_SLOTS; ++i) {
+            void* slot = n->slots[i];
+            if (!slot) continue;
+            uint64_t first = base + (uint64_t)i * span;
+            if (h == 1) {
+                if (first < from) continue;
+                page_free((cached_page*)slot);
+            } else {
+                if (first + span <= from) continue;
+                if (!truncate_node((pcache_node*)slot, h - 1, first, from)) continue;
+                hanacore::mem::kfree(slot);
+            }
+            n->slots[i] = nullptr;
+            --n->count;
+        }
+        return n->count == 0;
+    }
+
+    static void drop_from(address_space* as, uint64_t from) {
+        if (!as->root) return;
+        if (truncate_node(as->root, as->height, 0, from)) {
+            hanacore::mem::kfree(as->root);
+            as->root = nullptr;
+            as->height = 0;
+        }
+    }
+
+    size_t pcache_readahead(address_space* as, uint64_t off, size_t len) {
+        if (!as || !evictable(as) || off >= as->size) return 0;
+        uint64_t end = off + len < as->size ? off + len : as->size;
+        size_t nr = 0;
+        for (uint64_t i = off / PCACHE_PAGE_SIZE; i * PCACHE_PAGE_SIZE < end; ++i) {
+            {
+                // One page per hold, so readers get in between.
+                MutexGuard g(&pcache_lock);
+                if (i * PCACHE_PAGE_SIZE >= as->size) break;
+                if (radix_lookup(as, i)) continue;
+                if (!page_read_in(as, i)) break;
+                ++nr;
+                ++stat_readahead;
+            }
+            // Reading a page is a polled burst nothing else overlaps, and
+            // ring 0 is never preempted: give the CPU up between pages so
+            // RT tasks keep their latency while read-ahead runs.
+            hanacore::scheduler::sched_yield();
+        }
+        return nr;
+    }
+
+    void pcache_truncate(address_space* as, uint64_t size) {
+        if (!as) return;
+        MutexGuard g(&pcache_lock);
+        if (size < as->size) {
+            drop_from(as, (size + PCACHE_PAGE_SIZE - 1) / PCACHE_PAGE_SIZE);
+            size_t tail = (size_t)(size % PCACHE_PAGE_SIZE);
+            cached_page* last = tail ? radix_lookup(as, size / PCACHE_PAGE_SIZE) : nullptr;
+            if (last) {
+                memset(last->data + tail, 0, PCACHE_PAGE_SIZE - tail);
+                set_dirty(last);
+            }
+        }
+        as->size = size;
+    }
+
+    static int page_writeback(cached_page* pg) {
+        address_space* as = pg->as;
+        if (!pg->dirty) return 0;
+        uint64_t start = pg->index * PCACHE_PAGE_SIZE;
+        if (start >= as->size) {
+            set_clean(pg);
+            return 0;
+        }
+        size_t len = as->size - start < PCACHE_PAGE_SIZE ? (size_t)(as->size - start) : PCACHE_PAGE_SIZE;
+        if (!as->ops->writepage || as->ops->writepage(as, pg->index, pg->data, len) != 0) return -1;
+        set_clean(pg);
+        return 0;
+    }
+
+    static int writeback_node(pcache_node* n, int h) {
+        int rc = 0;
+        for (int i = 0; i < RADIX_SLOTS; ++i) {
+            if (!n->slots[i]) continue;
+            if (h == 1) {
+                if (page_writeback((cached_page*)n->slots[i]) != 0) rc = -1;
+            } else if (writeback_node((pcache_node*)n->slots[i], h - 1) != 0) {
+                rc = -1;
+            }
+        }
+        return rc;
+    }
+
+    int pcache_writeback(address_space* as) {
+        if (!as) return 0;
+        MutexGuard g(&pcache_lock);
+        if (!as->root || !as->ndirty) return 0;
+        return writeback_node(as->root, as->height);
+    }
+
+    void pcache_release(address_space* as) {
+        if (!as) return;
+        MutexGuard g(&pcache_lock);
+        drop_from(as, 0);
+    }
+
+    static size_t reclaim(size_t nr) {
+        size_t freed = 0;
+        cached_page* pg = lru_tail;
+        while (pg && freed < nr) {
+            cached_page* prev = pg->lru_prev;
+            if (page_writeback(pg) == 0) {
+                page_remove(pg);
+                ++freed;
+                ++stat_evictions;
+            }
+            pg = prev;
+        }
+        return freed;
+    }
+
+    size_t pcache_reclaim(size_t nr) {
+        MutexGuard g(&pcache_lock);
+        return reclaim(nr);
+    }
+
+    void pcache_get_stats(pcache_stats* out) {
+        if (!out) return;
+        out->pages = total_pages;
+        out->lru_pages = lru_pages;
+        out->dirty = dirty_pages;
+        out->hits = stat_hits;
+        out->misses = stat_misses;
+        out->evictions = stat_evictions;
+        out->readahead = stat_readahead;
+    }
+
+} }
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Page cache shared by all filesystems. Each file's data is an
+// address_space: a radix tree of PCACHE_PAGE_SIZE pages indexed by page
+// number, filled from the filesystem on demand and written back through it.
+//
+// A mapping without ops has nothing behind it (HanaFS): its pages are the
+// file, holes read as zeros and nothing is ever evicted. Pages of other
+// mappings are kept on a global LRU list and reclaimed, oldest first and
+// after writing back any that are dirty, once more than PCACHE_MAX_PAGES
+// of them are cached.
+//
+// The cache serialises its own calls, so background read-ahead can fill
+// it while other tasks read. Must not be used from IRQ context.
+
+#define PCACHE_PAGE_SIZE 4096
+
+namespace hanacore { namespace fs {
+
+    struct address_space;
+    struct pcache_node;
+
+    struct address_space_ops {
+        // Fill `page` with page `index` of the file, zeroing whatever lies
+        // past its end. Returns 0 or -1.
+        int (*readpage)(address_space* as, uint64_t index, uint8_t* page);
+        // Store the first `len` bytes of page `index`. NULL for read-only
+        // filesystems. Returns 0 or -1.
+        int (*writepage)(address_space* as, uint64_t index, const uint8_t* page, size_t len);
+    };
+
+    struct address_space {
+        const address_space_ops* ops;
+        void* host;             // filesystem's object for this file
+        uint64_t size;          // file size in bytes
+        pcache_node* root;
+        int height;             // radix tree levels; 0 while empty
+        size_t nrpages;
+        size_t ndirty;
+    };
+
+    // Set up an empty mapping. A zero-filled address_space is a valid
+    // empty mapping without ops.
+    void pcache_init_mapping(address_space* as, const address_space_ops* ops, void* host, uint64_t size);
+
+    // Copy up to `len` bytes at `off` out of the file. Returns the bytes
+    // read (0 at or past the end) or -1 if the first page cannot be read.
+    int64_t pcache_read(address_space* as, uint64_t off, void* buf, size_t len);
+
+    // Copy `len` bytes into the file at `off`, extending it. The touched
+    // pages stay dirty until written back. Returns `len` or -1.
+    int64_t pcache_write(address_space* as, uint64_t off, const void* buf, size_t len);
+
+    // Read the uncached pages covering [off, off + len) without copying
+    // anything out, stopping at the end of the file or the first page that
+    // fails. Returns how many pages were read. Mappings without ops have
+    // nothing to read. Yields the CPU after every page read; call it only
+    // from task context without the caller holding locks.
+    size_t pcache_readahead(address_space* as, uint64_t off, size_t len);
+
+    // Set the file size, dropping whole pages past the new end.
+    void pcache_truncate(address_space* as, uint64_t size);
+
+    // Write every dirty page back. Returns 0, or -1 if any page failed
+    // (it stays dirty).
+    int pcache_writeback(address_space* as);
+
+    // Drop every page, dirty ones included. The mapping stays usable.
+    void pcache_release(address_space* as);
+
+    // Evict up to `nr` least recently used pages. Returns how many went.
+    size_t pcache_reclaim(size_t nr);
+
+    struct pcache_stats {
+        size_t pages;           // all cached pages
+        size_t lru_pages;       // of those, evictable
+        size_t dirty;
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t readahead;     // pages read by pcache_readahead
+    };
+    void pcache_get_stats(pcache_stats* out);
+
+} }
@@ -4,14 +4,58 @@
 #include "../libs/libc.h"
 #include "../utils/logger.hpp"
 #include "../mem/heap.hpp"
+#include "../sync/lockstat.hpp"
+#include "../userland/syscalls.hpp"
 
 // Minimal procfs initialiser. Registers /proc with the VFS so users/tools
 // can see it listed. Full read handlers are not implemented in this stub.
 
 namespace hanacore { namespace fs {
 
+    static const char* const procfs_entries[] = { "cpuinfo", "meminfo", "self", "lock_stat", "syscalls" };
+
+    // The VFS hands over paths relative to /proc ("/cpuinfo").
+    static const char* procfs_name(const char* path) {
+        while (*path == '/') ++path;
+        return path;
+    }
+
+    static int procfs_fs_lookup(super_block*, const char* path) {
+        const char* name = procfs_name(path);
+        if (*name == '\0') return VFS_TYPE_DIR;
+        for (const char* e : procfs_entries)
+            if (strcmp(name, e) == 0) return VFS_TYPE_FILE;
+        return -1;
+    }
+
+    static void* procfs_fs_read(super_block*, const char* path, size_t* out_len) {
+        return procfs_get_file_alloc(procfs_name(path), out_len);
+    }
+
+    static int procfs_fs_readdir(super_block*, const char* path, vfs_dir_cb_t cb) {
+        return procfs_list_dir(path, cb);
+    }
+
+    // The cookie is an index into procfs_entries.
+    static int procfs_fs_iterate(super_block*, const char* path, uint64_t cookie, vfs_filldir_t fill, void* ctx) {
+        while (*path == '/') ++path;
+        if (*path != '\0') return -1;
+        const uint64_t n = sizeof(procfs_entries) / sizeof(procfs_entries[0]);
+        for (uint64_t i = cookie; i < n; ++i)
+            if (fill(ctx, procfs_entries[i], i + 1, VFS_DT_REG, i + 1)) break;
+        return 0;
+    }
+
+    static const fs_ops procfs_ops = {
+        procfs_fs_lookup, procfs_fs_read, nullptr, procfs_fs_readdir, procfs_fs_iterate,
+        nullptr, nullptr, nullptr, nullptr, nullptr,
+    };
+
+    static filesystem_type procfs_type = { "procfs", &procfs_ops, nullptr };
+
     void procfs_init(void) {
         // Register procfs mount point
+        register_filesystem(&procfs_type);
         vfs_register_mount("procfs", "/proc");
         hanacore::utils::log_info_cpp("[procfs] initialized and mounted at /proc");
     }
@@ -23,9 +67,7 @@ namespace hanacore { namespace fs {
         // normalize accepted path roots
         if (strcmp(path, "/") == 0) path = "/proc"; // unlikely, but safe
         if (strcmp(path, "/proc") != 0 && strcmp(path, "/proc/") != 0) return -1;
-        cb("cpuinfo");
-        cb("meminfo");
-        cb("self");
+        for (const char* e : procfs_entries) cb(e);
         return 0;
     }
 
@@ -59,6 +101,20 @@ namespace hanacore { namespace fs {
             *out_len = n;
             return b;
         }
+        if (strcmp(path, "/proc/lock_stat") == 0 || strcmp(path, "lock_stat") == 0) {
+            const size_t cap = 8192;
+            char* b = (char*)hanacore::mem::kmalloc(cap);
+            if (!b) return NULL;
+            *out_len = hanacore::sync::lockstat_format(b, cap);
+            return b;
+        }
+        if (strcmp(path, "/proc/syscalls") == 0 || strcmp(path, "syscalls") == 0) {
+            const size_t cap = 16384;
+            char* b = (char*)hanacore::mem::kmalloc(cap);
+            if (!b) return NULL;
+            *out_len = hanacore::userland::syscall_stats_format(b, cap);
+            return b;
+        }
         return NULL;
     }
 
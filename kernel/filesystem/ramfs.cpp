@@ -1,5 +1,6 @@
 #include "ramfs.hpp"
 #include "hanafs.hpp"
+#include "vfs.hpp"
 
 namespace hanacore { namespace fs {
 
@@ -21,6 +22,62 @@ namespace hanacore { namespace fs {
     hana_dirent* ramfs_readdir(hana_dir_t* dir) { return ::hanafs_readdir(dir); }
     int ramfs_closedir(hana_dir_t* dir) { return ::hanafs_closedir(dir); }
 
+    static int ramfs_fs_lookup(super_block*, const char* path) {
+        struct hana_stat st;
+        if (::hanafs_stat(path, &st) != 0) return -1;
+        return (st.st_mode & 0x4000) ? VFS_TYPE_DIR : VFS_TYPE_FILE;
+    }
+
+    static void* ramfs_fs_read(super_block*, const char* path, size_t* out_len) { return ::hanafs_get_file_alloc(path, out_len); }
+    static int ramfs_fs_write(super_block*, const char* path, const void* buf, size_t len) { return ::hanafs_write_file(path, buf, len); }
+    static int ramfs_fs_readdir(super_block*, const char* path, vfs_dir_cb_t cb) { return ::hanafs_list_dir(path, cb); }
+    static int ramfs_fs_iterate(super_block*, const char* path, uint64_t cookie, vfs_filldir_t fill, void* ctx) {
+        return ::hanafs_iterate_dir(path, cookie, fill, ctx);
+    }
+    static int ramfs_fs_stat(super_block*, const char* path, struct hana_stat* st) { return ::hanafs_stat(path, st); }
+    static int ramfs_fs_create(super_block*, const char* path) { return ::hanafs_create_file(path); }
+    static int ramfs_fs_mkdir(super_block*, const char* path) { return ::hanafs_make_dir(path); }
+    static int ramfs_fs_rmdir(super_block*, const char* path) { return ::hanafs_remove_dir(path); }
+    static int ramfs_fs_unlink(super_block*, const char* path) { return ::hanafs_unlink(path); }
+
+    static void* ramfs_fs_open(super_block*, const char* path, int flags) {
+        hanafs_inode_t* ino = ::hanafs_inode_open(path, (flags & VFS_O_CREAT) != 0);
+        if (ino && ::hanafs_inode_is_dir(ino)) {
+            ::hanafs_inode_put(ino);
+            return nullptr;
+        }
+        return ino;
+    }
+
+    static int64_t ramfs_fs_read_at(super_block*, void* h, uint64_t off, void* buf, size_t len) {
+        return ::hanafs_inode_read((hanafs_inode_t*)h, off, buf, len);
+    }
+
+    static int64_t ramfs_fs_write_at(super_block*, void* h, uint64_t off, const void* buf, size_t len) {
+        return ::hanafs_inode_write((hanafs_inode_t*)h, off, buf, len);
+    }
+
+    static int ramfs_fs_truncate(super_block*, void* h, uint64_t size) { return ::hanafs_inode_truncate((hanafs_inode_t*)h, size); }
+    static uint64_t ramfs_fs_size(super_block*, void* h) { return ::hanafs_inode_size((hanafs_inode_t*)h); }
+    static int ramfs_fs_fsync(super_block*, void* h) { return ::hanafs_inode_sync((hanafs_inode_t*)h); }
+    static void ramfs_fs_close(super_block*, void* h) { ::hanafs_inode_put((hanafs_inode_t*)h); }
+
+    static const fs_ops ramfs_ops = {
+        ramfs_fs_lookup, ramfs_fs_read, ramfs_fs_write, ramfs_fs_readdir, ramfs_fs_iterate,
+        ramfs_fs_stat, ramfs_fs_create, ramfs_fs_mkdir, ramfs_fs_rmdir, ramfs_fs_unlink,
+        ramfs_fs_open, ramfs_fs_read_at, ramfs_fs_write_at, ramfs_fs_truncate,
+        ramfs_fs_size, ramfs_fs_fsync, ramfs_fs_close,
+    };
+
+    // Both names mount the same HanaFS tree.
+    static filesystem_type ramfs_type = { "ramfs", &ramfs_ops, nullptr };
+    static filesystem_type hanafs_type = { "hanafs", &ramfs_ops, nullptr };
+
+    void ramfs_register_filesystems(void) {
+        register_filesystem(&ramfs_type);
+        register_filesystem(&hanafs_type);
+    }
+
 } }
 
 extern "C" {
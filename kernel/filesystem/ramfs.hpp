@@ -27,6 +27,8 @@ namespace hanacore { namespace fs {
     hana_dir_t* ramfs_opendir(const char* path);
     hana_dirent* ramfs_readdir(hana_dir_t* dir);
     int ramfs_closedir(hana_dir_t* dir);
+    // Register the "ramfs" and "hanafs" filesystem types with the VFS.
+    void ramfs_register_filesystems(void);
 } }
 #endif
 
@@ -0,0 +1,71 @@
+// kernel/filesystem/readahead.cpp
+#include "readahead.hpp"
+#include "../scheduler/scheduler.hpp"
+#include "../sync/spinlock.hpp"
+#include "../sync/waitqueue.hpp"
+#include "../utils/logger.hpp"
+
+namespace hanacore { namespace fs {
+
+    using hanacore::sync::SpinGuard;
+
+    static constexpr uint32_t READAHEAD_QUEUE = 32;
+
+    struct ra_request {
+        readahead_fn_t fn;
+        void* arg;
+        uint64_t off;
+        size_t len;
+    };
+
+    HANA_LOCK_CLASS(readahead_class, "readahead");
+    static hanacore::sync::Spinlock ra_lock = { 0, &readahead_class, 0 };
+    static hanacore::sync::WaitQueue ra_wait;
+    static ra_request ra_queue[READAHEAD_QUEUE];
+    static uint32_t ra_head = 0, ra_tail = 0;     // free-running; tail - head queued
+    static int ra_state = 0;                       // 0 stopped, 1 starting, 2 running, -1 failed
+
+    static void readahead_main(void*) {
+        for (;;) {
+            hanacore::sync::wait_event(&ra_wait, [] {
+                return __atomic_load_n(&ra_tail, __ATOMIC_ACQUIRE) != ra_head;
+            });
+            ra_request req;
+            {
+                SpinGuard g(&ra_lock);
+                if (ra_tail == ra_head) continue;
+                req = ra_queue[ra_head % READAHEAD_QUEUE];
+                ++ra_head;
+            }
+            req.fn(req.arg, req.off, req.len);
+        }
+    }
+
+    static bool start_thread() {
+        int state = __atomic_load_n(&ra_state, __ATOMIC_ACQUIRE);
+        if (state != 0) return state == 2;
+        if (!__atomic_compare_exchange_n(&ra_state, &state, 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return state == 2;
+        hanacore::sync::wait_queue_init(&ra_wait, &readahead_class);
+        if (!hanacore::scheduler::create_task_with_arg(readahead_main, nullptr)) {
+            log_fail("readahead: could not start worker");
+            __atomic_store_n(&ra_state, -1, __ATOMIC_RELEASE);
+            return false;
+        }
+        __atomic_store_n(&ra_state, 2, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    bool readahead_submit(readahead_fn_t fn, void* arg, uint64_t off, size_t len) {
+        if (!fn || !start_thread()) return false;
+        {
+            SpinGuard g(&ra_lock);
+            if (ra_tail - ra_head >= READAHEAD_QUEUE) return false;
+            ra_queue[ra_tail % READAHEAD_QUEUE] = { fn, arg, off, len };
+            __atomic_store_n(&ra_tail, ra_tail + 1, __ATOMIC_RELEASE);
+        }
+        hanacore::sync::wake_up_one(&ra_wait);
+        return true;
+    }
+
+} }
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Background read-ahead. One kernel thread, started on first use, runs
+// queued requests in order so a reader never waits for pages it has not
+// asked for yet. The queue is bounded: when it is full a request is
+// refused and the reader falls back to reading on demand.
+
+namespace hanacore { namespace fs {
+
+    typedef void (*readahead_fn_t)(void* arg, uint64_t off, size_t len);
+
+    // Queue fn(arg, off, len) for the read-ahead thread. Returns false if
+    // it could not be queued, in which case fn is never called and the
+    // caller still owns `arg`.
+    bool readahead_submit(readahead_fn_t fn, void* arg, uint64_t off, size_t len);
+
+} }
@@ -1,332 +1,719 @@
 // kernel/filesystem/vfs.cpp
 #include "vfs.hpp"
 #include "../libs/libc.h"
-#include "hanafs.hpp"
 #include "ramfs.hpp"
-#include "fat32.hpp"
-#include "floppy.hpp"
+#include "dcache.hpp"
+#include "readahead.hpp"
 #include "../mem/heap.hpp"
-#include "procfs.hpp"
-#include "devfs.hpp"
+
+// An open file: the filesystem's own handle, or for filesystems without
+// an open op a snapshot of the whole file.
+struct vfs_file {
+    hanacore::fs::super_block* sb;      // NULL outside every mount
+    const hanacore::fs::fs_ops* ops;
+    void* h;                            // ops->open's handle
+    char* path;                         // snapshot: where to write it back
+    uint8_t* data;                      // snapshot contents
+    size_t len;
+    bool dirty;
+    // Queued read-ahead holds a reference, so a closed file lives on
+    // until its requests have run.
+    int refs;
+    bool closed;
+    uint64_t ra_next;                   // where a sequential read would start
+    uint64_t ra_end;                    // end of the read-ahead asked for
+    size_t ra_window;                   // 0 until reads look sequential
+};
+
+// An open directory: where it is and how far a listing has got.
+struct vfs_dir {
+    hanacore::fs::super_block* sb;
+    char* path;                         // relative to sb's root
+    uint64_t pos;                       // cookie of the next entry
+    vfs_dirent ent;                     // vfs_readdir's result
+};
 
 namespace hanacore {
 namespace fs {
 
-struct MountEntry {
-    const char* fsname;
-    const char* mountpoint;
-};
+static filesystem_type* fs_types = nullptr;
 
-static MountEntry mounts[16];
-static int mount_count = 0;
+void register_filesystem(filesystem_type* fs) {
+    if (!fs || !fs->name || !fs->ops) return;
+    for (filesystem_type* t = fs_types; t; t = t->next)
+        if (t == fs) return;
+    fs->next = fs_types;
+    fs_types = fs;
+}
 
-void vfs_init(void) {
-    mount_count = 0;
-    for (int i = 0; i < 16; ++i) {
-        if (mounts[i].mountpoint) {
-            hanacore::mem::kfree((void*)mounts[i].mountpoint);
+filesystem_type* find_filesystem(const char* name) {
+    if (!name) return nullptr;
+    for (filesystem_type* t = fs_types; t; t = t->next)
+        if (strcmp(t->name, name) == 0) return t;
+    return nullptr;
+}
+
+// ------------------------------------------------------------------
+// Paths outside every mount: the built-in filesystems in turn (HanaFS
+// first, then devfs and the FAT32 image).
+// ------------------------------------------------------------------
+
+static const char* const fallback_read_order[] = { "ramfs", "devfs", "fat32" };
+static const char* const fallback_list_order[] = { "ramfs", "fat32" };
+
+static int rootfs_lookup(super_block*, const char* path) {
+    for (const char* name : fallback_read_order) {
+        filesystem_type* t = find_filesystem(name);
+        if (!t || !t->ops->lookup) continue;
+        int type = t->ops->lookup(nullptr, path);
+        if (type >= 0) return type;
+    }
+    return -1;
+}
+
+static void* rootfs_read(super_block*, const char* path, size_t* out_len) {
+    for (const char* name : fallback_read_order) {
+        filesystem_type* t = find_filesystem(name);
+        if (!t || !t->ops->read) continue;
+        size_t len = 0;
+        void* data = t->ops->read(nullptr, path, &len);
+        if (data && len > 0) {
+            *out_len = len;
+            return data;
         }
-        mounts[i].fsname = nullptr;
-        mounts[i].mountpoint = nullptr;
+        if (data) hanacore::mem::kfree(data);
     }
+    return nullptr;
 }
 
-void vfs_register_mount(const char* fsname, const char* mountpoint) {
-    if (!fsname || !mountpoint) return;
-    if (mount_count >= 16) return;
-    size_t mlen = strlen(mountpoint) + 1;
-    char* mcopy = (char*)hanacore::mem::kmalloc(mlen);
-    if (!mcopy) return;
-    memcpy(mcopy, mountpoint, mlen);
-    mounts[mount_count].fsname = fsname;
-    mounts[mount_count].mountpoint = mcopy;
-    mount_count++;
+static int rootfs_readdir(super_block*, const char* path, vfs_dir_cb_t cb) {
+    for (const char* name : fallback_list_order) {
+        filesystem_type* t = find_filesystem(name);
+        if (t && t->ops->readdir && t->ops->readdir(nullptr, path, cb) == 0) return 0;
+    }
+    return -1;
 }
 
-int vfs_list_mounts(void (*cb)(const char* line)) {
-    if (!cb) return -1;
-    char buf[128];
-    for (int i = 0; i < mount_count; ++i) {
-        const char* f = mounts[i].fsname ? mounts[i].fsname : "";
-        const char* m = mounts[i].mountpoint ? mounts[i].mountpoint : "";
-        snprintf(buf, sizeof(buf), "VFS mount: [%s -> %s]", f, m);
-        cb(buf);
+static int rootfs_iterate(super_block*, const char* path, uint64_t cookie, vfs_filldir_t fill, void* ctx) {
+    // Same choice as rootfs_readdir, so cookies always go back to the
+    // filesystem that issued them.
+    for (const char* name : fallback_list_order) {
+        filesystem_type* t = find_filesystem(name);
+        if (t && t->ops->iterate && t->ops->iterate(nullptr, path, cookie, fill, ctx) == 0) return 0;
     }
-    return 0;
+    return -1;
 }
 
-int vfs_list_dir(const char* path, void (*cb)(const char* name)) {
-    if (!path || !cb) return -1;
+// Everything else goes to HanaFS.
+static const fs_ops* hanafs_ops() {
+    filesystem_type* t = find_filesystem("ramfs");
+    return t ? t->ops : nullptr;
+}
 
-    // Find matching mount entry
-    for (int i = 0; i < mount_count; ++i) {
-        const char* mpoint = mounts[i].mountpoint;
-        const char* fsname = mounts[i].fsname;
-        if (!mpoint || !fsname) continue;
-
-        size_t mlen = strlen(mpoint);
-        // Either exact mountpoint, or path starts with mountpoint + '/'
-        if ( (strcmp(path, mpoint) == 0) ||
-             (strncmp(path, mpoint, mlen) == 0 && path[mlen] == '/') ) {
-
-            // compute relative path for backend
-            const char* rel = path;
-            if (!(strcmp(mpoint, "/") == 0)) {
-                if (strlen(path) == mlen) {
-                    rel = "/";
-                } else {
-                    rel = path + mlen;
-                }
-            }
+static int rootfs_write(super_block*, const char* path, const void* buf, size_t len) {
+    const fs_ops* ops = hanafs_ops();
+    return ops && ops->write ? ops->write(nullptr, path, buf, len) : -1;
+}
 
-            // Dispatch to correct backend
-            if (strcmp(fsname, "fat32") == 0) {
-                return fat32_list_dir(rel, cb);
-            }
-            if ((strcmp(fsname, "hanafs") == 0) || (strcmp(fsname, "ramfs") == 0)) {
-                return ramfs_list_dir(rel, cb);
-            }
-            if (strcmp(fsname, "procfs") == 0) {
-                return procfs_list_dir(rel, cb);
-            }
-            if (strcmp(fsname, "devfs") == 0) {
-                return devfs_list_dir(rel, cb);
-            }
-            if (strcmp(fsname, "floppy") == 0) {
-                return hanacore::fs::floppy_list_dir(rel, cb);
-            }
-            // Unknown fsname, break out and fallback
-            break;
-        }
-    }
+static int rootfs_stat(super_block*, const char* path, struct hana_stat* st) {
+    const fs_ops* ops = hanafs_ops();
+    return ops && ops->stat ? ops->stat(nullptr, path, st) : -1;
+}
 
-    // No mounted filesystem matched — fallback to built-ins
-    int rc = ramfs_list_dir(path, cb);
-    if (rc == 0) return 0;
-    rc = fat32_list_dir(path, cb);
-    if (rc == 0) return 0;
-    return -1;
+static int rootfs_create(super_block*, const char* path) {
+    const fs_ops* ops = hanafs_ops();
+    return ops && ops->create ? ops->create(nullptr, path) : -1;
 }
 
-int vfs_remove_dir(const char* path) {
-    if (!path) return -1;
+static int rootfs_mkdir(super_block*, const char* path) {
+    const fs_ops* ops = hanafs_ops();
+    return ops && ops->mkdir ? ops->mkdir(nullptr, path) : -1;
+}
+
+static int rootfs_rmdir(super_block*, const char* path) {
+    const fs_ops* ops = hanafs_ops();
+    return ops && ops->rmdir ? ops->rmdir(nullptr, path) : -1;
+}
+
+static int rootfs_unlink(super_block*, const char* path) {
+    const fs_ops* ops = hanafs_ops();
+    return ops && ops->unlink ? ops->unlink(nullptr, path) : -1;
+}
+
+static const fs_ops rootfs_ops = {
+    rootfs_lookup, rootfs_read, rootfs_write, rootfs_readdir, rootfs_iterate, rootfs_stat,
+    rootfs_create, rootfs_mkdir, rootfs_rmdir, rootfs_unlink,
+};
+
+static filesystem_type rootfs_type = { "rootfs", &rootfs_ops, nullptr };
+static char rootfs_mountpoint[] = "/";
+static super_block rootfs_sb = { &rootfs_type, &rootfs_ops, rootfs_mountpoint, nullptr, nullptr };
+
+// ------------------------------------------------------------------
+// Mount tree
+//
+// One node per path component that is, or leads to, a mount point. A
+// node's children are found through a hash on (parent, name), so
+// resolving a path costs one probe per component however many mounts
+// exist. Mounts on the same node stack: the newest one is visible and
+// covers the ones below it until it is unmounted.
+// ------------------------------------------------------------------
+
+struct mount_node {
+    mount_node* parent;
+    char* name;                 // component; "" for the root
+    super_block* top;           // visible mount here, or NULL
+    int nchildren;
+    mount_node* hash_next;
+};
 
-    for (int i = 0; i < mount_count; ++i) {
-        const char* mpoint = mounts[i].mountpoint;
-        const char* fsname = mounts[i].fsname;
-        if (!mpoint || !fsname) continue;
+static constexpr int MOUNT_HASH_SIZE = 64;
+static constexpr size_t MOUNT_NAME_MAX = 64;
 
-        size_t mlen = strlen(mpoint);
-        if ((strcmp(path, mpoint) == 0) ||
-            (strncmp(path, mpoint, mlen) == 0 && path[mlen] == '/')) {
+static char root_name[] = "";
+static mount_node root_node = { nullptr, root_name, nullptr, 0, nullptr };
+static mount_node* mount_hash[MOUNT_HASH_SIZE];
+static int mount_count = 0;
+
+static unsigned mount_hash_of(const mount_node* parent, const char* name, size_t len) {
+    uint32_t h = 2166136261u ^ (uint32_t)((uintptr_t)parent >> 4);
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (uint8_t)name[i];
+        h *= 16777619u;
+    }
+    return h & (MOUNT_HASH_SIZE - 1);
+}
 
-            if ((strcmp(fsname, "hanafs") == 0) || (strcmp(fsname, "ramfs") == 0)) {
-                return ramfs_remove_dir(path);
+static mount_node* mount_child(const mount_node* parent, const char* name, size_t len) {
+    if (!parent->nchildren) return nullptr;
+    for (mount_node* n = mount_hash[mount_hash_of(parent, name, len)]; n; n = n->hash_next)
+        if (n->parent == parent && strncmp(n->name, name, len) == 0 && n->name[len] == '\0') return n;
+    return nullptr;
+}
+
+// Next component of *p (slashes skipped); advances *p past it.
+static const char* next_component(const char** p, size_t* len) {
+    const char* s = *p;
+    while (*s == '/') ++s;
+    const char* e = s;
+    while (*e && *e != '/') ++e;
+    *len = (size_t)(e - s);
+    *p = e;
+    return s;
+}
+
+static mount_node* mount_node_get(const char* path) {
+    mount_node* node = &root_node;
+    const char* p = path;
+    size_t len;
+    for (const char* c = next_component(&p, &len); len; c = next_component(&p, &len)) {
+        if (len >= MOUNT_NAME_MAX) return nullptr;
+        mount_node* child = mount_child(node, c, len);
+        if (!child) {
+            child = (mount_node*)hanacore::mem::kmalloc(sizeof(mount_node));
+            char* name = (char*)hanacore::mem::kmalloc(len + 1);
+            if (!child || !name) {
+                hanacore::mem::kfree(child);
+                hanacore::mem::kfree(name);
+                return nullptr;
             }
-            // Other FS remove_dir may not be implemented
-            return -1;
+            memcpy(name, c, len);
+            name[len] = '\0';
+            unsigned h = mount_hash_of(node, c, len);
+            *child = mount_node{ node, name, nullptr, 0, mount_hash[h] };
+            mount_hash[h] = child;
+            ++node->nchildren;
         }
+        node = child;
     }
-
-    return ramfs_remove_dir(path);
+    return node;
 }
 
-int vfs_create_file(const char* path) {
-    if (!path) return -1;
+// Drop nodes that hold no mount and lead to none, from `node` upwards.
+static void mount_node_prune(mount_node* node) {
+    while (node != &root_node && !node->top && !node->nchildren) {
+        mount_node* parent = node->parent;
+        unsigned h = mount_hash_of(parent, node->name, strlen(node->name));
+        for (mount_node** pp = &mount_hash[h]; *pp; pp = &(*pp)->hash_next) {
+            if (*pp == node) { *pp = node->hash_next; break; }
+        }
+        --parent->nchildren;
+        hanacore::mem::kfree(node->name);
+        hanacore::mem::kfree(node);
+        node = parent;
+    }
+}
 
-    for (int i = 0; i < mount_count; ++i) {
-        const char* mpoint = mounts[i].mountpoint;
-        const char* fsname = mounts[i].fsname;
-        if (!mpoint || !fsname) continue;
+static void free_super(super_block* sb) {
+    hanacore::mem::kfree(sb->mountpoint);
+    hanacore::mem::kfree(sb);
+}
 
-        size_t mlen = strlen(mpoint);
-        if ((strcmp(path, mpoint) == 0) ||
-            (strncmp(path, mpoint, mlen) == 0 && path[mlen] == '/')) {
+static void drop_stack(mount_node* node) {
+    while (node->top) {
+        super_block* sb = node->top;
+        node->top = sb->covered;
+        free_super(sb);
+        --mount_count;
+    }
+}
 
-            if ((strcmp(fsname, "hanafs") == 0) || (strcmp(fsname, "ramfs") == 0)) {
-                return ramfs_create_file(path);
-            }
-            if (strcmp(fsname, "fat32") == 0) {
-                return fat32_create_file(path);
-            }
-            return -1;
+void vfs_init(void) {
+    // Registered types survive a re-init; only the mounts are dropped.
+    ramfs_register_filesystems();
+    for (int h = 0; h < MOUNT_HASH_SIZE; ++h) {
+        while (mount_node* n = mount_hash[h]) {
+            mount_hash[h] = n->hash_next;
+            drop_stack(n);
+            hanacore::mem::kfree(n->name);
+            hanacore::mem::kfree(n);
         }
     }
+    drop_stack(&root_node);
+    root_node.nchildren = 0;
+    dcache_flush();
+}
 
-    return ramfs_create_file(path);
+void vfs_register_mount(const char* fsname, const char* mountpoint) {
+    if (!fsname || !mountpoint || mountpoint[0] != '/') return;
+    filesystem_type* type = find_filesystem(fsname);
+    if (!type) return;
+    size_t mlen = strlen(mountpoint);
+    while (mlen > 1 && mountpoint[mlen - 1] == '/') --mlen;
+    super_block* sb = (super_block*)hanacore::mem::kmalloc(sizeof(super_block));
+    char* mcopy = (char*)hanacore::mem::kmalloc(mlen + 1);
+    mount_node* node = (sb && mcopy) ? mount_node_get(mountpoint) : nullptr;
+    if (!node) {
+        hanacore::mem::kfree(sb);
+        hanacore::mem::kfree(mcopy);
+        return;
+    }
+    memcpy(mcopy, mountpoint, mlen);
+    mcopy[mlen] = '\0';
+    sb->type = type;
+    sb->ops = type->ops;
+    sb->mountpoint = mcopy;
+    sb->fs_info = nullptr;
+    sb->covered = node->top;
+    node->top = sb;
+    ++mount_count;
+    dcache_flush();
 }
 
-int vfs_unlink(const char* path) {
-    if (!path) return -1;
+int vfs_unmount(const char* mountpoint) {
+    if (!mountpoint || mountpoint[0] != '/') return -1;
+    mount_node* node = &root_node;
+    const char* p = mountpoint;
+    size_t len;
+    for (const char* c = next_component(&p, &len); len && node; c = next_component(&p, &len))
+        node = mount_child(node, c, len);
+    if (!node || !node->top) return -1;
+    super_block* sb = node->top;
+    node->top = sb->covered;
+    free_super(sb);
+    --mount_count;
+    mount_node_prune(node);
+    dcache_flush();
+    return 0;
+}
 
-    for (int i = 0; i < mount_count; ++i) {
-        const char* mpoint = mounts[i].mountpoint;
-        const char* fsname = mounts[i].fsname;
-        if (!mpoint || !fsname) continue;
+static void list_stack(const super_block* sb, void (*cb)(const char* line)) {
+    if (!sb) return;
+    list_stack(sb->covered, cb);
+    char buf[128];
+    snprintf(buf, sizeof(buf), "VFS mount: [%s -> %s]%s", sb->type->name, sb->mountpoint,
+             sb->covered ? " (stacked)" : "");
+    cb(buf);
+}
 
-        size_t mlen = strlen(mpoint);
-        if ((strcmp(path, mpoint) == 0) ||
-            (strncmp(path, mpoint, mlen) == 0 && path[mlen] == '/')) {
+static void list_node(const mount_node* node, void (*cb)(const char* line)) {
+    list_stack(node->top, cb);
+    for (int h = 0; h < MOUNT_HASH_SIZE && node->nchildren; ++h)
+        for (const mount_node* n = mount_hash[h]; n; n = n->hash_next)
+            if (n->parent == node) list_node(n, cb);
+}
 
-            if ((strcmp(fsname, "hanafs") == 0) || (strcmp(fsname, "ramfs") == 0)) {
-                return ramfs_unlink(path);
-            }
-            if (strcmp(fsname, "fat32") == 0) {
-                return fat32_unlink(path);
-            }
-            return -1;
+int vfs_list_mounts(void (*cb)(const char* line)) {
+    if (!cb) return -1;
+    list_node(&root_node, cb);
+    return 0;
+}
+
+// The deepest mount `path` falls under and the path relative to its
+// root. Paths under no mount go to the built-in fallback unchanged.
+static super_block* resolve(const char* path, const char** rel) {
+    super_block* sb = root_node.top ? root_node.top : &rootfs_sb;
+    *rel = path;
+    if (!mount_count) return sb;
+    const mount_node* node = &root_node;
+    const char* p = path;
+    size_t len;
+    for (const char* c = next_component(&p, &len); len; c = next_component(&p, &len)) {
+        node = mount_child(node, c, len);
+        if (!node) break;
+        if (node->top) {
+            sb = node->top;
+            *rel = *p ? p : "/";
         }
     }
+    return sb;
+}
 
-    return ramfs_unlink(path);
+// Uncached lookup. Filesystems without a lookup op are taken at their
+// word by the other ops, so their paths are never reported missing here.
+static int lookup_uncached(const char* path) {
+    const char* rel;
+    super_block* sb = resolve(path, &rel);
+    return sb->ops->lookup ? sb->ops->lookup(sb, rel) : VFS_TYPE_OTHER;
 }
 
-int vfs_make_dir(const char* path) {
+int vfs_lookup(const char* path) {
     if (!path) return -1;
+    return dcache_lookup(path, lookup_uncached);
+}
 
-    for (int i = 0; i < mount_count; ++i) {
-        const char* mpoint = mounts[i].mountpoint;
-        const char* fsname = mounts[i].fsname;
-        if (!mpoint || !fsname) continue;
-
-        size_t mlen = strlen(mpoint);
-        if ((strcmp(path, mpoint) == 0) ||
-            (strncmp(path, mpoint, mlen) == 0 && path[mlen] == '/')) {
+void vfs_invalidate(const char* path) {
+    dcache_invalidate(path);
+}
 
-            if ((strcmp(fsname, "hanafs") == 0) || (strcmp(fsname, "ramfs") == 0)) {
-                return ramfs_make_dir(path);
-            }
-            if (strcmp(fsname, "fat32") == 0) {
-                return fat32_make_dir(path);
-            }
-            return -1;
-        }
-    }
+void vfs_forget_misses(void) {
+    dcache_forget_misses();
+}
 
-    return ramfs_make_dir(path);
+int vfs_list_dir(const char* path, void (*cb)(const char* name)) {
+    if (!path || !cb) return -1;
+    const char* rel;
+    super_block* sb = resolve(path, &rel);
+    return sb->ops->readdir ? sb->ops->readdir(sb, rel, cb) : -1;
 }
 
-int vfs_write_file(const char* path, const void* buf, size_t len) {
+int vfs_remove_dir(const char* path) {
     if (!path) return -1;
+    const char* rel;
+    super_block* sb = resolve(path, &rel);
+    int rc = sb->ops->rmdir ? sb->ops->rmdir(sb, rel) : -1;
+    dcache_invalidate(path);
+    return rc;
+}
 
-    for (int i = 0; i < mount_count; ++i) {
-        const char* mpoint = mounts[i].mountpoint;
-        const char* fsname = mounts[i].fsname;
-        if (!mpoint || !fsname) continue;
+int vfs_create_file(const char* path) {
+    if (!path) return -1;
+    const char* rel;
+    super_block* sb = resolve(path, &rel);
+    int rc = sb->ops->create ? sb->ops->create(sb, rel) : -1;
+    dcache_invalidate(path);
+    return rc;
+}
 
-        size_t mlen = strlen(mpoint);
-        if ((strcmp(path, mpoint) == 0) ||
-            (strncmp(path, mpoint, mlen) == 0 && path[mlen] == '/')) {
+int vfs_unlink(const char* path) {
+    if (!path) return -1;
+    const char* rel;
+    super_block* sb = resolve(path, &rel);
+    int rc = sb->ops->unlink ? sb->ops->unlink(sb, rel) : -1;
+    dcache_invalidate(path);
+    return rc;
+}
 
-            if ((strcmp(fsname, "hanafs") == 0) || (strcmp(fsname, "ramfs") == 0)) {
-                return ramfs_write_file(path, buf, len);
-            }
-            if (strcmp(fsname, "fat32") == 0) {
-                return fat32_write_file(path, buf, len);
-            }
-            return -1;
-        }
-    }
+int vfs_make_dir(const char* path) {
+    if (!path) return -1;
+    const char* rel;
+    super_block* sb = resolve(path, &rel);
+    int rc = sb->ops->mkdir ? sb->ops->mkdir(sb, rel) : -1;
+    dcache_invalidate(path);
+    return rc;
+}
 
-    return ramfs_write_file(path, buf, len);
+int vfs_write_file(const char* path, const void* buf, size_t len) {
+    if (!path) return -1;
+    const char* rel;
+    super_block* sb = resolve(path, &rel);
+    int rc = sb->ops->write ? sb->ops->write(sb, rel, buf, len) : -1;
+    dcache_invalidate(path);
+    return rc;
 }
 
 void* vfs_get_file_alloc(const char* path, size_t* out_len) {
     if (!path || !out_len) return nullptr;
+    *out_len = 0;
+    if (vfs_lookup(path) < 0) return nullptr;
+    const char* rel;
+    super_block* sb = resolve(path, &rel);
+    if (!sb->ops->read) return nullptr;
+    size_t len = 0;
+    void* data = sb->ops->read(sb, rel, &len);
+    if (data && len == 0) {
+        hanacore::mem::kfree(data);
+        data = nullptr;
+    }
+    if (data) *out_len = len;
+    return data;
+}
 
-    for (int i = 0; i < mount_count; ++i) {
-        const char* mpoint = mounts[i].mountpoint;
-        const char* fsname = mounts[i].fsname;
-        if (!mpoint || !fsname) continue;
-
-        size_t mlen = strlen(mpoint);
-        if ((strcmp(path, mpoint) == 0) ||
-            (strncmp(path, mpoint, mlen) == 0 && path[mlen] == '/')) {
-
-            const char* rel = path;
-            if (!(strcmp(mpoint, "/") == 0)) {
-                if (strlen(path) == mlen) {
-                    rel = "/";
-                } else {
-                    rel = path + mlen;
-                }
-            }
+int vfs_stat(const char* path, struct hana_stat* st) {
+    if (!path || !st) return -1;
+    if (vfs_lookup(path) < 0) return -1;
+    const char* rel;
+    super_block* sb = resolve(path, &rel);
+    return sb->ops->stat ? sb->ops->stat(sb, rel, st) : -1;
+}
 
-            if (strcmp(fsname, "fat32") == 0) {
-                size_t len = 0;
-                void* data = fat32_get_file_alloc(rel, &len);
-                if (data && len > 0) {
-                    *out_len = len;
-                    return data;
-                }
-                if (data) {
-                    hanacore::mem::kfree(data);
-                }
-                return nullptr;
-            }
-            if ((strcmp(fsname, "hanafs") == 0) || (strcmp(fsname, "ramfs") == 0)) {
-                size_t len = 0;
-                void* data = ramfs_get_file_alloc(rel, &len);
-                if (data && len > 0) {
-                    *out_len = len;
-                    return data;
-                }
-                if (data) {
-                    hanacore::mem::kfree(data);
-                }
-                return nullptr;
-            }
-            if (strcmp(fsname, "procfs") == 0) {
-                return procfs_get_file_alloc(rel, out_len);
-            }
-            if (strcmp(fsname, "devfs") == 0) {
-                return devfs_get_file_alloc(rel, out_len);
-            }
-            // Unknown FS
-            return nullptr;
-        }
-    }
+// ------------------------------------------------------------------
+// Open files
+// ------------------------------------------------------------------
 
-    // fallback
-    size_t len = 0;
-    void* data = ramfs_get_file_alloc(path, &len);
-    if (data && len > 0) {
-        *out_len = len;
-        return data;
+// Which built-in filesystem serves `path` under no mount: the first that
+// has it, or HanaFS for a file about to be created.
+static const fs_ops* rootfs_pick(const char* path) {
+    for (const char* name : fallback_read_order) {
+        filesystem_type* t = find_filesystem(name);
+        if (t && t->ops->lookup && t->ops->lookup(nullptr, path) >= 0) return t->ops;
     }
-    if (data) {
-        hanacore::mem::kfree(data);
+    return hanafs_ops();
+}
+
+vfs_file* vfs_open(const char* path, int flags) {
+    if (!path) return nullptr;
+    int type = vfs_lookup(path);
+    if (type == VFS_TYPE_DIR) return nullptr;
+    if (type < 0 && !(flags & VFS_O_CREAT)) return nullptr;
+    const char* rel;
+    super_block* sb = resolve(path, &rel);
+    const fs_ops* ops = sb->ops;
+    if (sb == &rootfs_sb) {
+        // Talk to the chosen filesystem directly, as the fallback does. A
+        // cached miss already says no fallback filesystem has the path.
+        ops = type < 0 ? hanafs_ops() : rootfs_pick(path);
+        sb = nullptr;
+        if (!ops) return nullptr;
     }
 
-    data = procfs_get_file_alloc(path, &len);
-    if (data && len > 0) {
-        *out_len = len;
-        return data;
+    vfs_file* f = (vfs_file*)hanacore::mem::kmalloc(sizeof(vfs_file));
+    if (!f) return nullptr;
+    memset(f, 0, sizeof(*f));
+    f->sb = sb;
+    f->ops = ops;
+    f->refs = 1;
+    bool ok;
+    if (ops->open) {
+        f->h = ops->open(sb, rel, flags);
+        ok = f->h != nullptr;
+    } else {
+        f->path = (char*)hanacore::mem::kmalloc(strlen(rel) + 1);
+        ok = f->path != nullptr;
+        if (ok) strcpy(f->path, rel);
+        if (ok && type < 0) ok = ops->create && ops->create(sb, rel) == 0;
+        if (ok && ops->read) {
+            f->data = (uint8_t*)ops->read(sb, rel, &f->len);
+            if (!f->data) f->len = 0;
+        }
     }
-    if (data) {
-        hanacore::mem::kfree(data);
+    if (type < 0) dcache_invalidate(path);
+    if (!ok) {
+        hanacore::mem::kfree(f->path);
+        hanacore::mem::kfree(f);
+        return nullptr;
     }
+    return f;
+}
+
+// Only device-backed filesystems implement read-ahead, and their disks are
+// read by polled PIO, so a window is CPU time taken from everything else.
+// Keep it small enough that one request is a short run of page reads.
+static constexpr size_t RA_MIN_WINDOW = 16 * 1024;
+static constexpr size_t RA_MAX_WINDOW = 128 * 1024;
+
+static void file_put(vfs_file* f) {
+    if (__atomic_sub_fetch(&f->refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+    if (f->ops->open && f->ops->close) f->ops->close(f->sb, f->h);
+    hanacore::mem::kfree(f->path);
+    hanacore::mem::kfree(f->data);
+    hanacore::mem::kfree(f);
+}
 
-    data = devfs_get_file_alloc(path, &len);
-    if (data && len > 0) {
-        *out_len = len;
-        return data;
+static void readahead_run(void* arg, uint64_t off, size_t len) {
+    vfs_file* f = (vfs_file*)arg;
+    if (!__atomic_load_n(&f->closed, __ATOMIC_ACQUIRE)) f->ops->readahead(f->sb, f->h, off, len);
+    file_put(f);
+}
+
+// Called after every native read. A read that starts where the last one
+// ended is sequential: the first asks for RA_MIN_WINDOW past it, and each
+// time the reader gets within half a window of what was asked for, the
+// window doubles (up to RA_MAX_WINDOW) and the next one is queued. Any
+// other read drops the window.
+static void readahead_after(vfs_file* f, uint64_t off, size_t got) {
+    uint64_t end = off + got;
+    bool sequential = off == f->ra_next;
+    f->ra_next = end;
+    if (!sequential) {
+        f->ra_window = 0;
+        f->ra_end = 0;
+        return;
     }
-    if (data) {
-        hanacore::mem::kfree(data);
+    if (!got || !f->ops->readahead || !f->ops->size) return;
+    if (!f->ra_window) {
+        f->ra_window = RA_MIN_WINDOW;
+    } else {
+        if (f->ra_end > end && f->ra_end - end > f->ra_window / 2) return;
+        if (f->ra_window < RA_MAX_WINDOW) f->ra_window *= 2;
+    }
+    uint64_t from = f->ra_end > end ? f->ra_end : end;
+    uint64_t size = f->ops->size(f->sb, f->h);
+    if (from >= size) return;
+    size_t n = size - from < f->ra_window ? (size_t)(size - from) : f->ra_window;
+    __atomic_add_fetch(&f->refs, 1, __ATOMIC_ACQ_REL);
+    if (!hanacore::fs::readahead_submit(readahead_run, f, from, n)) {
+        __atomic_sub_fetch(&f->refs, 1, __ATOMIC_ACQ_REL);
+        return;
     }
+    f->ra_end = from + n;
+}
 
-    data = fat32_get_file_alloc(path, &len);
-    if (data && len > 0) {
-        *out_len = len;
-        return data;
+int64_t vfs_read_at(vfs_file* f, uint64_t off, void* buf, size_t len) {
+    if (!f || (len && !buf)) return -1;
+    if (f->ops->open) {
+        if (!f->ops->read_at) return -1;
+        int64_t r = f->ops->read_at(f->sb, f->h, off, buf, len);
+        if (r >= 0) readahead_after(f, off, (size_t)r);
+        return r;
     }
-    if (data) {
-        hanacore::mem::kfree(data);
+    if (off >= f->len) return 0;
+    size_t n = f->len - off < len ? (size_t)(f->len - off) : len;
+    memcpy(buf, f->data + off, n);
+    return (int64_t)n;
+}
+
+// Resize a snapshot; new bytes are zero.
+static bool snapshot_resize(vfs_file* f, size_t size) {
+    if (size > f->len) {
+        uint8_t* nd = (uint8_t*)hanacore::mem::kmalloc(size);
+        if (!nd) return false;
+        if (f->data) memcpy(nd, f->data, f->len);
+        memset(nd + f->len, 0, size - f->len);
+        hanacore::mem::kfree(f->data);
+        f->data = nd;
     }
+    f->len = size;
+    f->dirty = true;
+    return true;
+}
 
-    *out_len = 0;
-    return nullptr;
+int64_t vfs_write_at(vfs_file* f, uint64_t off, const void* buf, size_t len) {
+    if (!f || (len && !buf)) return -1;
+    if (f->ops->open) return f->ops->write_at ? f->ops->write_at(f->sb, f->h, off, buf, len) : -1;
+    if (len == 0) return 0;
+    if (off + len > f->len && !snapshot_resize(f, (size_t)(off + len))) return -1;
+    memcpy(f->data + off, buf, len);
+    f->dirty = true;
+    return (int64_t)len;
+}
+
+int vfs_truncate(vfs_file* f, uint64_t size) {
+    if (!f) return -1;
+    if (f->ops->open) return f->ops->truncate ? f->ops->truncate(f->sb, f->h, size) : -1;
+    return snapshot_resize(f, (size_t)size) ? 0 : -1;
+}
+
+uint64_t vfs_file_size(vfs_file* f) {
+    if (!f) return 0;
+    if (f->ops->open) return f->ops->size ? f->ops->size(f->sb, f->h) : 0;
+    return f->len;
+}
+
+int vfs_fsync(vfs_file* f) {
+    if (!f) return -1;
+    if (f->ops->open) return f->ops->fsync ? f->ops->fsync(f->sb, f->h) : 0;
+    if (!f->dirty) return 0;
+    if (!f->ops->write || f->ops->write(f->sb, f->path, f->data, f->len) != 0) return -1;
+    f->dirty = false;
+    return 0;
+}
+
+void vfs_close(vfs_file* f) {
+    if (!f) return;
+    __atomic_store_n(&f->closed, true, __ATOMIC_RELEASE);
+    file_put(f);
+}
+
+// ------------------------------------------------------------------
+// Directory streams
+// ------------------------------------------------------------------
+
+vfs_dir* vfs_opendir(const char* path) {
+    if (!path) return nullptr;
+    // Missing directories list as empty, like vfs_list_dir: HanaFS
+    // directories can exist only through the files below them.
+    int type = vfs_lookup(path);
+    if (type >= 0 && type != VFS_TYPE_DIR) return nullptr;
+    const char* rel;
+    super_block* sb = resolve(path, &rel);
+    if (!sb->ops->iterate) return nullptr;
+    vfs_dir* d = (vfs_dir*)hanacore::mem::kmalloc(sizeof(vfs_dir));
+    char* rcopy = (char*)hanacore::mem::kmalloc(strlen(rel) + 1);
+    if (!d || !rcopy) {
+        hanacore::mem::kfree(d);
+        hanacore::mem::kfree(rcopy);
+        return nullptr;
+    }
+    strcpy(rcopy, rel);
+    memset(d, 0, sizeof(*d));
+    d->sb = sb;
+    d->path = rcopy;
+    return d;
+}
+
+struct iterate_ctx {
+    vfs_dir* d;
+    vfs_filldir_t fill;
+    void* ctx;
+};
+
+// Advance the stream past every entry the caller takes.
+static int iterate_fill(void* c, const char* name, uint64_t ino, unsigned type, uint64_t next) {
+    iterate_ctx* ic = (iterate_ctx*)c;
+    int stop = ic->fill(ic->ctx, name, ino, type, next);
+    if (!stop) ic->d->pos = next;
+    return stop;
+}
+
+int vfs_iterate_dir(vfs_dir* d, vfs_filldir_t fill, void* ctx) {
+    if (!d || !fill) return -1;
+    iterate_ctx ic = { d, fill, ctx };
+    return d->sb->ops->iterate(d->sb, d->path, d->pos, iterate_fill, &ic);
+}
+
+static int readdir_fill(void* c, const char* name, uint64_t ino, unsigned type, uint64_t next) {
+    vfs_dirent* ent = (vfs_dirent*)c;
+    if (ent->d_name[0]) return 1;       // already have one
+    size_t n = strlen(name);
+    if (n >= sizeof(ent->d_name)) n = sizeof(ent->d_name) - 1;
+    memcpy(ent->d_name, name, n);
+    ent->d_name[n] = '\0';
+    ent->d_ino = ino;
+    ent->d_off = next;
+    ent->d_type = (unsigned char)type;
+    return 0;
+}
+
+vfs_dirent* vfs_readdir(vfs_dir* d) {
+    if (!d) return nullptr;
+    d->ent.d_name[0] = '\0';
+    if (hanacore::fs::vfs_iterate_dir(d, readdir_fill, &d->ent) != 0 || !d->ent.d_name[0]) return nullptr;
+    return &d->ent;
+}
+
+uint64_t vfs_telldir(vfs_dir* d) {
+    return d ? d->pos : 0;
+}
+
+void vfs_seekdir(vfs_dir* d, uint64_t cookie) {
+    if (d) d->pos = cookie;
+}
+
+void vfs_closedir(vfs_dir* d) {
+    if (!d) return;
+    hanacore::mem::kfree(d->path);
+    hanacore::mem::kfree(d);
 }
 
 } // namespace fs
@@ -342,6 +729,10 @@ extern "C" {
         hanacore::fs::vfs_register_mount(fsname, mountpoint);
     }
 
+    int vfs_unmount(const char* mountpoint) {
+        return hanacore::fs::vfs_unmount(mountpoint);
+    }
+
     int vfs_list_mounts(void (*cb)(const char* line)) {
         return hanacore::fs::vfs_list_mounts(cb);
     }
@@ -373,4 +764,72 @@ extern "C" {
     void* vfs_get_file_alloc(const char* path, size_t* out_len) {
         return hanacore::fs::vfs_get_file_alloc(path, out_len);
     }
+
+    int vfs_stat(const char* path, struct hana_stat* st) {
+        return hanacore::fs::vfs_stat(path, st);
+    }
+
+    int vfs_lookup(const char* path) {
+        return hanacore::fs::vfs_lookup(path);
+    }
+
+    void vfs_invalidate(const char* path) {
+        hanacore::fs::vfs_invalidate(path);
+    }
+
+    void vfs_forget_misses(void) {
+        hanacore::fs::vfs_forget_misses();
+    }
+
+    struct vfs_file* vfs_open(const char* path, int flags) {
+        return hanacore::fs::vfs_open(path, flags);
+    }
+
+    int64_t vfs_read_at(struct vfs_file* f, uint64_t off, void* buf, size_t len) {
+        return hanacore::fs::vfs_read_at(f, off, buf, len);
+    }
+
+    int64_t vfs_write_at(struct vfs_file* f, uint64_t off, const void* buf, size_t len) {
+        return hanacore::fs::vfs_write_at(f, off, buf, len);
+    }
+
+    int vfs_truncate(struct vfs_file* f, uint64_t size) {
+        return hanacore::fs::vfs_truncate(f, size);
+    }
+
+    uint64_t vfs_file_size(struct vfs_file* f) {
+        return hanacore::fs::vfs_file_size(f);
+    }
+
+    int vfs_fsync(struct vfs_file* f) {
+        return hanacore::fs::vfs_fsync(f);
+    }
+
+    void vfs_close(struct vfs_file* f) {
+        hanacore::fs::vfs_close(f);
+    }
+
+    struct vfs_dir* vfs_opendir(const char* path) {
+        return hanacore::fs::vfs_opendir(path);
+    }
+
+    int vfs_iterate_dir(struct vfs_dir* d, vfs_filldir_t fill, void* ctx) {
+        return hanacore::fs::vfs_iterate_dir(d, fill, ctx);
+    }
+
+    struct vfs_dirent* vfs_readdir(struct vfs_dir* d) {
+        return hanacore::fs::vfs_readdir(d);
+    }
+
+    uint64_t vfs_telldir(struct vfs_dir* d) {
+        return hanacore::fs::vfs_telldir(d);
+    }
+
+    void vfs_seekdir(struct vfs_dir* d, uint64_t cookie) {
+        hanacore::fs::vfs_seekdir(d, cookie);
+    }
+
+    void vfs_closedir(struct vfs_dir* d) {
+        hanacore::fs::vfs_closedir(d);
+    }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -8,12 +9,33 @@ extern "C" {
 
 typedef void (*vfs_dir_cb_t)(const char* name);
 
+// d_type of a directory entry (Linux DT_* values).
+#define VFS_DT_UNKNOWN 0
+#define VFS_DT_CHR     2
+#define VFS_DT_DIR     4
+#define VFS_DT_REG     8
+
+// Receives directory entries one at a time. `next` is the cookie that
+// resumes iteration after this entry. Return 0 to take the entry and go
+// on, nonzero to stop without taking it.
+typedef int (*vfs_filldir_t)(void* ctx, const char* name, uint64_t ino, unsigned type, uint64_t next);
+
+struct hana_stat;
+
 #define VFS_TYPE_FILE  0x01
 #define VFS_TYPE_DIR   0x02
 #define VFS_TYPE_OTHER 0x04
 
+// vfs_open flags
+#define VFS_O_CREAT    0x01
+
 void vfs_init(void);
+// Mount the registered filesystem `fsname` at `mountpoint`. Mounting on
+// an existing mount point stacks the new mount on top of the old one.
 void vfs_register_mount(const char* fsname, const char* mountpoint);
+// Remove the topmost mount at `mountpoint`, uncovering the one below it.
+// Returns 0, or -1 if nothing is mounted there.
+int vfs_unmount(const char* mountpoint);
 int vfs_list_mounts(void (*cb)(const char* line));
 int vfs_list_dir(const char* path, vfs_dir_cb_t cb);
 int vfs_make_dir(const char* path);
@@ -22,6 +44,62 @@ int vfs_create_file(const char* path);
 int vfs_unlink(const char* path);
 int vfs_write_file(const char* path, const void* buf, size_t len);
 void* vfs_get_file_alloc(const char* path, size_t* out_len);
+// Stat the file vfs_get_file_alloc would return. Only HanaFS-backed files
+// report an identity (st_ino, st_mtime_ns); others fail with -1.
+int vfs_stat(const char* path, struct hana_stat* st);
+// VFS_TYPE_* of the object at `path`, or -1 if it does not exist.
+// Answered from the dentry cache when possible (see dcache.hpp).
+int vfs_lookup(const char* path);
+// Forget cached lookups at and below `path`. For filesystems whose
+// namespace changes without going through the vfs_* calls.
+void vfs_invalidate(const char* path);
+// A filesystem gained files it cannot name by path (a volume came
+// online): forget every cached miss. Cached hits are kept.
+void vfs_forget_misses(void);
+
+// Open files. Reads and writes act on the file at an offset and cost what
+// they touch, not the whole file. Filesystems that cannot open files
+// natively are served from a snapshot taken at open and written back
+// whole by vfs_fsync. Sequential reads of native files are followed by
+// background read-ahead into the filesystem's cache.
+struct vfs_file;
+// Open the regular file at `path`, creating it if VFS_O_CREAT is set.
+// Returns NULL if it is missing, a directory, or cannot be opened.
+struct vfs_file* vfs_open(const char* path, int flags);
+// Return the byte count (short at end of file) or -1.
+int64_t vfs_read_at(struct vfs_file* f, uint64_t off, void* buf, size_t len);
+// Return `len`, or -1. Writing past the end extends the file with zeros.
+int64_t vfs_write_at(struct vfs_file* f, uint64_t off, const void* buf, size_t len);
+int vfs_truncate(struct vfs_file* f, uint64_t size);
+uint64_t vfs_file_size(struct vfs_file* f);
+// Make the file's writes durable. Returns 0 or -1.
+int vfs_fsync(struct vfs_file* f);
+// Drop the handle without writing anything back (call vfs_fsync first);
+// safe to call where blocking I/O is not.
+void vfs_close(struct vfs_file* f);
+
+// Directory streams. The position is a cookie: 0 is the start, and every
+// entry reports the cookie that follows it, so a listing can stop and
+// resume without rescanning. "." and ".." are not reported; d_ino is 0
+// where a filesystem has no inode numbers.
+struct vfs_dirent {
+    uint64_t d_ino;
+    uint64_t d_off;             // cookie after this entry
+    unsigned char d_type;       // VFS_DT_*
+    char d_name[256];
+};
+struct vfs_dir;
+// NULL if `path` exists but is not a directory.
+struct vfs_dir* vfs_opendir(const char* path);
+// Hand entries from the current position to `fill` until it stops or the
+// directory ends; the position advances past every entry taken.
+// Returns 0, or -1 if the directory cannot be read.
+int vfs_iterate_dir(struct vfs_dir* d, vfs_filldir_t fill, void* ctx);
+// Next entry, or NULL at the end. Valid until the next call.
+struct vfs_dirent* vfs_readdir(struct vfs_dir* d);
+uint64_t vfs_telldir(struct vfs_dir* d);
+void vfs_seekdir(struct vfs_dir* d, uint64_t cookie);
+void vfs_closedir(struct vfs_dir* d);
 
 #ifdef __cplusplus
 }
@@ -30,6 +108,64 @@ void* vfs_get_file_alloc(const char* path, size_t* out_len);
 #ifdef __cplusplus
 namespace hanacore {
 namespace fs {
+
+struct super_block;
+
+// What a filesystem implements. Paths are relative to the mount root ("/"
+// is the root itself). A null op makes the VFS call fail with -1.
+struct fs_ops {
+    // VFS_TYPE_* of the object at `path`, or -1 if there is none.
+    int (*lookup)(super_block* sb, const char* path);
+    // Whole file in a kmalloc'd buffer (NULL if missing or empty).
+    void* (*read)(super_block* sb, const char* path, size_t* out_len);
+    int (*write)(super_block* sb, const char* path, const void* buf, size_t len);
+    int (*readdir)(super_block* sb, const char* path, vfs_dir_cb_t cb);
+    // Feed the entries of directory `path` from `cookie` on to `fill`
+    // (see vfs_filldir_t). Returns 0 at the end or when `fill` stops, -1
+    // if `path` cannot be listed.
+    int (*iterate)(super_block* sb, const char* path, uint64_t cookie, vfs_filldir_t fill, void* ctx);
+    int (*stat)(super_block* sb, const char* path, struct hana_stat* st);
+    int (*create)(super_block* sb, const char* path);
+    int (*mkdir)(super_block* sb, const char* path);
+    int (*rmdir)(super_block* sb, const char* path);
+    int (*unlink)(super_block* sb, const char* path);
+    // Open files; see vfs_open and friends for the semantics. `open`
+    // returns the filesystem's own handle, passed back to the others.
+    // Without `open`, files are read through `read` into a snapshot; a
+    // null write_at or truncate makes the file read-only.
+    void* (*open)(super_block* sb, const char* path, int flags);
+    int64_t (*read_at)(super_block* sb, void* h, uint64_t off, void* buf, size_t len);
+    int64_t (*write_at)(super_block* sb, void* h, uint64_t off, const void* buf, size_t len);
+    int (*truncate)(super_block* sb, void* h, uint64_t size);
+    uint64_t (*size)(super_block* sb, void* h);
+    int (*fsync)(super_block* sb, void* h);
+    void (*close)(super_block* sb, void* h);
+    // Bring [off, off + len) into the filesystem's cache without copying
+    // it anywhere. Called from the read-ahead thread while the file is
+    // open; optional.
+    int (*readahead)(super_block* sb, void* h, uint64_t off, size_t len);
+};
+
+// A filesystem implementation, registered once under its mount name.
+struct filesystem_type {
+    const char* name;
+    const fs_ops* ops;
+    filesystem_type* next;
+};
+
+// One mounted instance of a filesystem.
+struct super_block {
+    filesystem_type* type;
+    const fs_ops* ops;          // type->ops
+    char* mountpoint;           // normalised: no trailing '/' except for "/"
+    void* fs_info;              // backend private data
+    super_block* covered;       // mount this one is stacked on, or NULL
+};
+
+// Make `fs` mountable by name. Registering the same type again is a no-op.
+void register_filesystem(filesystem_type* fs);
+filesystem_type* find_filesystem(const char* name);
+
 inline void init() { ::vfs_init(); }
 
 inline int list_dir(const char* path, void (*cb)(const char* name)) {
@@ -42,7 +178,22 @@ inline int create_file(const char* path) { return ::vfs_create_file(path); }
 inline int unlink(const char* path) { return ::vfs_unlink(path); }
 inline int write_file(const char* path, const void* buf, size_t len) { return ::vfs_write_file(path, buf, len); }
 inline void* get_file_alloc(const char* path, size_t* out_len) { return ::vfs_get_file_alloc(path, out_len); }
+inline int stat(const char* path, struct hana_stat* st) { return ::vfs_stat(path, st); }
+inline int lookup(const char* path) { return ::vfs_lookup(path); }
+inline void invalidate(const char* path) { ::vfs_invalidate(path); }
+inline void forget_misses() { ::vfs_forget_misses(); }
+inline struct vfs_file* open(const char* path, int flags) { return ::vfs_open(path, flags); }
+inline int64_t read_at(struct vfs_file* f, uint64_t off, void* buf, size_t len) { return ::vfs_read_at(f, off, buf, len); }
+inline int64_t write_at(struct vfs_file* f, uint64_t off, const void* buf, size_t len) { return ::vfs_write_at(f, off, buf, len); }
+inline int truncate(struct vfs_file* f, uint64_t size) { return ::vfs_truncate(f, size); }
+inline uint64_t file_size(struct vfs_file* f) { return ::vfs_file_size(f); }
+inline int fsync(struct vfs_file* f) { return ::vfs_fsync(f); }
+inline void close(struct vfs_file* f) { ::vfs_close(f); }
+inline struct vfs_dir* opendir(const char* path) { return ::vfs_opendir(path); }
+inline struct vfs_dirent* readdir(struct vfs_dir* d) { return ::vfs_readdir(d); }
+inline void closedir(struct vfs_dir* d) { ::vfs_closedir(d); }
 inline void register_mount(const char* fsname, const char* mountpoint) { ::vfs_register_mount(fsname, mountpoint); }
+inline int unmount(const char* mountpoint) { return ::vfs_unmount(mountpoint); }
 inline int list_mounts(void (*cb)(const char* line)) { return ::vfs_list_mounts(cb); }
 
 } 
@@ -2,7 +2,7 @@
 // Controls: WASD to move the green cursor square, 'q' to quit.
 
 #include "../drivers/framebuffer.hpp"
-#include "../drivers/keyboard.hpp"
+#include "../tty/tty.hpp"
 #include "../drivers/mouse.hpp"
 #include "cursor.hpp"
 #include "../mem/heap.hpp"
@@ -62,6 +62,13 @@ extern "C" void builtin_wm_cmd(const char* arg) {
 
     int oldx = cx, oldy = cy;
 
+    // Run the compositor loop in the real-time band so cursor updates are
+    // not delayed by batch tasks; restore our previous class on exit.
+    int prev_policy = hanacore::scheduler::sched_getscheduler(0);
+    int prev_prio = hanacore::scheduler::sched_getparam(0);
+    hanacore::scheduler::sched_setscheduler(0, hanacore::scheduler::SCHED_FIFO,
+                                            hanacore::scheduler::SCHED_PRIO_COMPOSITOR);
+
     // Main loop: poll mouse (preferred) and keyboard (fallback) and update cursor.
     while (1) {
         bool moved = false;
@@ -76,7 +83,7 @@ extern "C" void builtin_wm_cmd(const char* arg) {
         }
 
         // Keyboard fallback: allow quitting via 'q'
-        char kc = keyboard_poll_char();
+        char kc = tty_poll_char();
         if (kc) {
             if (kc == 'q' || kc == 'Q') break;
         }
@@ -98,6 +105,9 @@ extern "C" void builtin_wm_cmd(const char* arg) {
         hanacore::scheduler::sched_yield();
     }
 
+    if (prev_policy >= 0)
+        hanacore::scheduler::sched_setscheduler(0, prev_policy, prev_prio);
+
     // Exit: leave the screen as-is. Print a message to the console TTY as well.
     print("wm: exiting\n");
 }
@@ -5,6 +5,9 @@
 #include "arch/idt.hpp"
 #include "arch/pic.hpp"
 #include "arch/pit.hpp"
+#include "arch/percpu.hpp"
+#include "arch/tsc.hpp"
+#include "drivers/rtc.hpp"
 #include "utils/logger.hpp"
 #include "filesystem/fat32.hpp"
 #include "filesystem/initrd.hpp"
@@ -18,6 +21,7 @@
 #include "userland/login.hpp"
 #include "mem/heap.hpp"
 #include "userland/elf_loader.hpp"
+#include "userland/vdso.hpp"
 #include "utils/utils.hpp"
 #include  "libs/libc.h"
 #include <stdint.h>
@@ -75,9 +79,21 @@ extern "C" void kernel_main() {
 
     gdt_install();
     idt_install();
+    // Remap the legacy PIC away from the exception vectors and keep every
+    // line masked until its driver installs a handler.
+    pic_remap();
+    pic_mask_all();
+    percpu_init();
     init_syscall();
     heap_init(1024 * 1024);
+    // Clock source for clock_gettime and the vDSO; the RTC only seeds the
+    // wall-clock offset, after that time advances on the TSC.
+    hanacore::arch::tsc_init();
+    hanacore::arch::clock_set_realtime_ns(rtc_read_unix_seconds() * 1000000000ULL);
+    hanacore::userland::vdso_init();
     keyboard_init();
+    // Keyboard input is interrupt driven: readers sleep until IRQ1.
+    keyboard_enable_irq();
 
     log_ok("Core subsystems initialized");
     log_info("Build: %s | Version: %s", hanacore::utils::build_date, hanacore::utils::version);
@@ -118,6 +134,14 @@ extern "C" void kernel_main() {
     hanacore::scheduler::init_scheduler();
     log_info("Scheduler initialized");
 
+    // 100 Hz tick: timeslice accounting and preemption of user code.
+    pit_init(100);
+
+    // The main task becomes the console (login + shell): run it in the
+    // real-time band so keystrokes are handled ahead of batch work.
+    hanacore::scheduler::sched_setscheduler(0, hanacore::scheduler::SCHED_FIFO,
+                                            hanacore::scheduler::SCHED_PRIO_CONSOLE);
+
     hanacore::userland::login_main();
     
     // Block the main kernel task so it won't be selected by the scheduler
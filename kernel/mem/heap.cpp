@@ -3,10 +3,12 @@
 #include "pma.hpp"
 #include "vmm.hpp"
 #include "../utils/logger.hpp"
+#include "../sync/spinlock.hpp"
 #include <stdint.h>
 
-// Very small, single-threaded free-list heap for kernel use.
-// Not re-entrant or SMP-safe. Intended as a simple first-pass heap.
+// Very small free-list heap for kernel use. All free-list manipulation is
+// serialised by `heap_lock` (IRQ-saving), so kmalloc/kfree may be called
+// from any task and from interrupt handlers.
 
 namespace hanacore::utils {
     extern void log_hex64(const char *label, uint64_t value);
@@ -26,6 +28,9 @@ namespace hanacore { namespace mem {
     static void *heap_start = nullptr;
     static size_t heap_size = 0;
 
+    HANA_LOCK_CLASS(heap_lock_class, "heap");
+    static hanacore::sync::Spinlock heap_lock = { 0, &heap_lock_class, 0 };
+
     static inline size_t align_up(size_t v, size_t a) {
         return (v + (a - 1)) & ~(a - 1);
     }
@@ -81,9 +86,26 @@ namespace hanacore { namespace mem {
         free_list->next = nullptr;
     }
 
+    static void *kmalloc_locked(size_t size);
+    static void kfree_locked(void *ptr);
+
     void *kmalloc(size_t size) {
-        if (!free_list) return nullptr;
         if (size == 0) return nullptr;
+        uint64_t flags = hanacore::sync::spin_lock_irqsave(&heap_lock);
+        void *p = kmalloc_locked(size);
+        hanacore::sync::spin_unlock_irqrestore(&heap_lock, flags);
+        return p;
+    }
+
+    void kfree(void *ptr) {
+        if (!ptr) return;
+        uint64_t flags = hanacore::sync::spin_lock_irqsave(&heap_lock);
+        kfree_locked(ptr);
+        hanacore::sync::spin_unlock_irqrestore(&heap_lock, flags);
+    }
+
+    static void *kmalloc_locked(size_t size) {
+        if (!free_list) return nullptr;
 
         const size_t align = 16;
         size_t payload = align_up(size, align);
@@ -136,8 +158,7 @@ namespace hanacore { namespace mem {
         return nullptr; // unreachable, but keep signature
     }
 
-    void kfree(void *ptr) {
-        if (!ptr) return;
+    static void kfree_locked(void *ptr) {
         const size_t align = 16;
         const size_t header = align_up(sizeof(FreeBlock), align);
         FreeBlock *blk = (FreeBlock *)((uint8_t *)ptr - header);
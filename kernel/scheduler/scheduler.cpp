@@ -2,6 +2,12 @@
 #include "../mem/heap.hpp"
 #include "../utils/logger.hpp"
 #include "../userland/fdtable.hpp"
+#include "../userland/fileio.hpp"
+#include "../userland/vdso.hpp"
+#include "../userland/exec_cache.hpp"
+#include "../sync/spinlock.hpp"
+#include "../arch/percpu.hpp"
+#include "../arch/gdt.hpp"
 #include <string.h>
 
 extern "C" void context_switch(uint64_t **old_sp_ptr, uint64_t **new_sp_ptr,
@@ -15,6 +21,13 @@ static int next_pid = 1;
 Task *current_task = nullptr;
 Task *task_list = nullptr;
 
+// Protects the circular task list and task state transitions.
+HANA_LOCK_CLASS(sched_lock_class, "sched");
+static hanacore::sync::Spinlock sched_lock = { 0, &sched_lock_class, 0 };
+
+// Number of tasks with an armed wake_at_ns, so the tick can skip the walk.
+static int armed_timeouts = 0;
+
 static inline int get_cpu_id() { return 0; }
 
 // ==========================================================
@@ -30,6 +43,7 @@ void init_scheduler() {
     memset(main, 0, sizeof(Task));
     main->pid = next_pid++;
     main->state = TASK_RUNNING;
+    main->timeslice = SCHED_TIMESLICE_TICKS;
 
     uint64_t *rsp_val;
     asm volatile("mov %%rsp, %0" : "=r"(rsp_val));
@@ -54,6 +68,9 @@ static void idle_task() {
 void task_cleanup() {
     log_info("scheduler: task %d exiting", current_task ? current_task->pid : -1);
     if (current_task) {
+        // Release descriptors here, in task context, so the reaper only has
+        // table memory left to free.
+        hanacore::userland::fileio_close_all(current_task->fds);
         current_task->state = TASK_DEAD;
     }
 
@@ -68,6 +85,9 @@ void task_cleanup() {
 // ==========================================================
 static void user_mode_entry_trampoline();
 static void task_trampoline() {
+    // New tasks may be first switched to from IRQ context (timer
+    // preemption) or with IRQs masked; start them with interrupts enabled.
+    asm volatile("sti" ::: "memory");
     if (current_task) {
         if (current_task->is_user) {
             user_mode_entry_trampoline();
@@ -93,12 +113,17 @@ static void user_mode_entry_trampoline() {
     uintptr_t uentry = (uintptr_t)current_task->user_entry;
     uintptr_t ustack_top = (uintptr_t)current_task->user_stack + current_task->user_stack_size;
     ustack_top &= ~0xFULL;
+    // A prepared initial stack (argc/argv/envp/auxv) starts below the top.
+    if (current_task->user_sp) ustack_top = (uintptr_t)current_task->user_sp;
 
-    const uint64_t user_cs = 0x1B;
-    const uint64_t user_ss = 0x23;
+    const uint64_t user_cs = GDT_USER_CS;
+    const uint64_t user_ss = GDT_USER_DS;
 
+    // swapgs last thing before leaving ring 0: user mode runs with the
+    // user GS base, the per-CPU pointer waits in KERNEL_GS_BASE.
     asm volatile (
         "cli\n\t"
+        "swapgs\n\t"
         "pushq %[ss]\n\t"
         "pushq %[rsp]\n\t"
         "pushfq\n\t"
@@ -107,11 +132,12 @@ static void user_mode_entry_trampoline() {
         "pushq %%rax\n\t"
         "pushq %[cs]\n\t"
         "pushq %[rip]\n\t"
+        "xorl %%edx, %%edx\n\t"   // ABI: rdx = atexit hook, none
         "iretq\n\t"
         :
         : [ss]"r"(user_ss), [rsp]"r"(ustack_top),
           [cs]"r"(user_cs), [rip]"r"(uentry)
-        : "rax", "memory"
+        : "rax", "rdx", "memory"
     );
 
     task_cleanup();
@@ -126,14 +152,8 @@ static Task* alloc_task_common() {
     memset(t, 0, sizeof(Task));
 
     t->pid = next_pid++;
-    t->fd_count = 64;
-    t->fds = fdtable_create(t->fd_count);
-
-    if (t->fds) {
-        for (int i = 0; i < 3 && i < t->fd_count; ++i) {
-            t->fds[i].type = FD_TTY;
-        }
-    }
+    t->fds = fdtable_create();
+    fdtable_init_stdio(t->fds);
 
     t->exit_status = -1;
     t->parent_pid = current_task ? current_task->pid : 0;
@@ -176,22 +196,29 @@ int create_task(void (*entry)(void)) {
 }
 
 int create_user_task(void* user_entry, size_t user_stack_size) {
-    if (!user_entry || user_stack_size == 0) return 0;
+    Task* t = create_user_task_blocked(user_entry, user_stack_size);
+    if (!t) return 0;
+    sched_wake(t);
+    return t->pid;
+}
+
+Task* create_user_task_blocked(void* user_entry, size_t user_stack_size) {
+    if (!user_entry || user_stack_size == 0) return nullptr;
 
     Task* t = (Task*)kmalloc(sizeof(Task));
-    if (!t) return 0;
+    if (!t) return nullptr;
     memset(t, 0, sizeof(Task));
 
     // Kernel stack
     uint8_t* kstack = (uint8_t*)kmalloc(TASK_STACK_SIZE);
-    if (!kstack) { kfree(t); return 0; }
+    if (!kstack) { kfree(t); return nullptr; }
 
     // User stack
     void* ustack = kmalloc(user_stack_size);
-    if (!ustack) { kfree(kstack); kfree(t); return 0; }
+    if (!ustack) { kfree(kstack); kfree(t); return nullptr; }
 
     t->pid = next_pid++;
-    t->state = TASK_READY;
+    t->state = TASK_BLOCKED;
     t->is_user = true;
     t->user_entry = user_entry;
     t->user_stack = ustack;
@@ -200,12 +227,8 @@ int create_user_task(void* user_entry, size_t user_stack_size) {
     t->entry_arg = nullptr;
 
     // Allocate FD table
-    t->fd_count = 64;
-    t->fds = fdtable_create(t->fd_count);
-    if (t->fds) {
-        for (int i = 0; i < 3 && i < t->fd_count; ++i)
-            t->fds[i].type = FD_TTY;
-    }
+    t->fds = fdtable_create();
+    fdtable_init_stdio(t->fds);
     t->exit_status = -1;
     t->parent_pid = 0;
 
@@ -236,7 +259,7 @@ int create_user_task(void* user_entry, size_t user_stack_size) {
     }
 
     log_info("scheduler: created user task (pid=%d)", t->pid);
-    return t->pid;
+    return t;
 }
 
 
@@ -279,13 +302,60 @@ int create_task_with_arg(void (*entry)(void*), void* arg) {
 // SCHEDULING
 // ==========================================================
 
+volatile bool need_resched = false;
+
+static inline bool task_runnable(const Task *t) {
+    return t->state == TASK_READY || t->state == TASK_RUNNING;
+}
+
+static inline bool task_is_rt(const Task *t) {
+    return t->policy == SCHED_FIFO || t->policy == SCHED_RR;
+}
+
+// Choose the next task to run, scanning the circular list from `start`
+// (which is prev->next, so equal candidates rotate round-robin). `prev` is
+// null when the previous task has just been freed. Caller holds sched_lock.
+//
+// The highest-priority runnable RT task always wins, and a running
+// SCHED_FIFO task keeps the CPU against equal-priority peers. The one
+// exception is an explicit sched_yield() from an RT task: because keyboard
+// and mouse input are still polled, RT input/compositor loops yield when
+// idle, and that yield hands the CPU to the next runnable task of any class
+// for one turn instead of starving the normal band.
+static Task* pick_next_task(Task *prev, Task *start) {
+    bool pass = prev && prev->yield_pass;
+    if (prev) prev->yield_pass = false;
+
+    Task *best_rt = nullptr;
+    Task *first = nullptr;
+    Task *t = start;
+    do {
+        if (task_runnable(t)) {
+            if (!first && !(pass && t == prev)) first = t;
+            if (task_is_rt(t) && (!best_rt || t->rt_priority > best_rt->rt_priority))
+                best_rt = t;
+        }
+        t = t->next;
+    } while (t && t != start);
+
+    if (pass && first) return first;
+    if (best_rt) {
+        if (prev && task_runnable(prev) && prev->policy == SCHED_FIFO && !pass &&
+            prev->rt_priority >= best_rt->rt_priority)
+            return prev;
+        return best_rt;
+    }
+    if (first) return first;
+    return (prev && task_runnable(prev)) ? prev : nullptr;
+}
+
 void schedule_next() {
     if (!current_task || !task_list) return;
 
     Task *prev = current_task;
 
-    // Disable interrupts while mutating the task list to avoid races
-    asm volatile ("cli" ::: "memory");
+    // Hold the scheduler lock (IRQs off) while mutating the task list
+    uint64_t irqflags = hanacore::sync::spin_lock_irqsave(&sched_lock);
 
     // Clean up any DEAD tasks in the circular list, including current task
     Task *freed_current = nullptr;
@@ -311,7 +381,10 @@ void schedule_next() {
                     freed_current = prev;
                 }
                 log_info("scheduler: freeing dead task pid=%d", iter->pid);
-                if (iter->fds) fdtable_destroy(iter->fds, iter->fd_count);
+                if (iter->wake_at_ns) --armed_timeouts;
+                if (iter->fds) fdtable_destroy(iter->fds);
+                if (iter->exec_image)
+                    hanacore::userland::exec_instance_put((hanacore::userland::ExecInstance*)iter->exec_image);
                 if (iter->user_stack) hanacore::mem::kfree(iter->user_stack);
                 if (iter->kstack) hanacore::mem::kfree(iter->kstack);
                 hanacore::mem::kfree(iter);
@@ -323,68 +396,159 @@ void schedule_next() {
         } while (iter != task_list && task_list);
     }
 
-    // Re-enable interrupts after list mutation
-    asm volatile ("sti" ::: "memory");
-
     // Find next runnable task
     if (!task_list) {
+        hanacore::sync::spin_unlock_irqrestore(&sched_lock, irqflags);
         log_info("scheduler: no tasks in list");
         return;
     }
 
-    // Debug: list all tasks
-    {
-        Task *debug_iter = task_list;
-        int count = 0;
-        do {
-            log_info("scheduler: task[%d] pid=%d state=%d", count++, debug_iter->pid, debug_iter->state);
-            debug_iter = debug_iter->next;
-            if (count > 10) break; // Safety: prevent infinite loop in logging
-        } while (debug_iter && debug_iter != task_list);
+    Task *start = freed_current ? task_list : (prev->next ? prev->next : prev);
+    Task *next = pick_next_task(freed_current ? nullptr : prev, start);
+
+    if (!next) {
+        hanacore::sync::spin_unlock_irqrestore(&sched_lock, irqflags);
+        if (!freed_current && prev->state != TASK_BLOCKED)
+            log_info("scheduler: no runnable tasks found in list (prev pid=%d state=%d)", prev->pid, prev->state);
+        return;
     }
 
-    // Sanity check: ensure at least one READY/RUNNING task exists
-    {
-        Task *debug_iter = task_list;
-        int found_runnable = 0, count = 0;
-        do {
-            if (debug_iter->state == TASK_READY || debug_iter->state == TASK_RUNNING) found_runnable++;
-            debug_iter = debug_iter->next;
-            if (++count > 10) break;
-        } while (debug_iter && debug_iter != task_list);
-        if (!found_runnable) log_info("scheduler: SANITY CHECK FAILED: no READY/RUNNING tasks in list!");
+    if (!freed_current && prev->state == TASK_RUNNING) prev->state = TASK_READY;
+    next->state = TASK_RUNNING;
+    if (next != prev) next->timeslice = SCHED_TIMESLICE_TICKS;
+    // Syscalls and ring-3 interrupts of the incoming task must land on its
+    // own kernel stack.
+    if (next->kstack)
+        hanacore::arch::set_kernel_stack(((uintptr_t)next->kstack + TASK_STACK_SIZE) & ~0xFULL);
+    need_resched = false;
+    current_task = next;
+    hanacore::userland::vdso_set_current(next->pid, hanacore::arch::this_cpu()->cpu_id);
+    hanacore::sync::spin_unlock_irqrestore(&sched_lock, irqflags);
+    asm volatile ("" ::: "memory");
+    // A freed task has nowhere to save its stack pointer; park it in a
+    // scratch slot instead of writing into released memory.
+    static uint64_t *dead_rsp;
+    context_switch(freed_current ? &dead_rsp : &prev->rsp, &next->rsp, nullptr, nullptr);
+}
+
+void sched_block_current() {
+    if (!current_task) return;
+    uint64_t flags = hanacore::sync::spin_lock_irqsave(&sched_lock);
+    current_task->state = TASK_BLOCKED;
+    hanacore::sync::spin_unlock_irqrestore(&sched_lock, flags);
+}
+
+// Would `t` preempt the running task?
+static bool preempts_current(const Task* t) {
+    Task* cur = current_task;
+    if (!cur || t == cur || !task_is_rt(t)) return false;
+    return !task_is_rt(cur) || t->rt_priority > cur->rt_priority;
+}
+
+void sched_wake(Task* t) {
+    if (!t) return;
+    uint64_t flags = hanacore::sync::spin_lock_irqsave(&sched_lock);
+    if (t->state == TASK_BLOCKED) {
+        t->state = TASK_READY;
+        if (preempts_current(t)) need_resched = true;
     }
+    hanacore::sync::spin_unlock_irqrestore(&sched_lock, flags);
+}
+
+void sched_sleep() {
+    Task* self = current_task;
+    if (!self) return;
+    schedule_next();
+    // schedule_next returns without switching when nothing else is runnable;
+    // in that case idle until an interrupt (which may deliver the wakeup).
+    if (self->state == TASK_BLOCKED) asm volatile("sti; hlt" ::: "memory");
+}
+
+void sched_set_timeout(uint64_t deadline_ns) {
+    Task* self = current_task;
+    if (!self) return;
+    uint64_t flags = hanacore::sync::spin_lock_irqsave(&sched_lock);
+    if (self->wake_at_ns && !deadline_ns) --armed_timeouts;
+    else if (!self->wake_at_ns && deadline_ns) ++armed_timeouts;
+    self->wake_at_ns = deadline_ns;
+    hanacore::sync::spin_unlock_irqrestore(&sched_lock, flags);
+}
 
-    Task *next = nullptr;
-    if (freed_current) {
-        // The current task was freed, so start from task_list
-        next = task_list;
+void sched_expire_timeouts(uint64_t now_ns) {
+    if (!armed_timeouts || !task_list) return;
+    uint64_t flags = hanacore::sync::spin_lock_irqsave(&sched_lock);
+    Task* t = task_list;
+    do {
+        if (t->wake_at_ns && t->wake_at_ns <= now_ns) {
+            // Disarm here so a task that never calls sched_set_timeout(0)
+            // again (e.g. it exits) does not keep the counter raised.
+            t->wake_at_ns = 0;
+            --armed_timeouts;
+            if (t->state == TASK_BLOCKED) {
+                t->state = TASK_READY;
+                if (preempts_current(t)) need_resched = true;
+            }
+        }
+        t = t->next;
+    } while (t && t != task_list);
+    hanacore::sync::spin_unlock_irqrestore(&sched_lock, flags);
+}
+
+void sched_yield() {
+    if (current_task && task_is_rt(current_task)) current_task->yield_pass = true;
+    schedule_next();
+}
+
+int sched_setscheduler(int pid, int policy, int rt_priority) {
+    if (policy == SCHED_NORMAL) {
+        if (rt_priority != 0) return -1;
+    } else if (policy == SCHED_FIFO || policy == SCHED_RR) {
+        if (rt_priority < SCHED_RT_PRIO_MIN || rt_priority > SCHED_RT_PRIO_MAX) return -1;
     } else {
-        // Normal case: start from prev->next
-        next = prev->next ? prev->next : prev;
+        return -1;
     }
-    
-    Task *probe_start = next;
-    do {
-        if (next && (next->state == TASK_READY || next->state == TASK_RUNNING)) break;
-        if (next) next = next->next ? next->next : prev;
-        else break;
-    } while (next && next != probe_start);
 
-    if (!next || (next->state != TASK_READY && next->state != TASK_RUNNING)) {
-        log_info("scheduler: no runnable tasks found in list (prev pid=%d state=%d)", prev->pid, prev->state);
-        return;
+    uint64_t flags = hanacore::sync::spin_lock_irqsave(&sched_lock);
+    Task* t = pid == 0 ? current_task : find_task_by_pid(pid);
+    if (!t || t->state == TASK_DEAD) {
+        hanacore::sync::spin_unlock_irqrestore(&sched_lock, flags);
+        return -1;
     }
+    t->policy = policy;
+    t->rt_priority = rt_priority;
+    t->timeslice = SCHED_TIMESLICE_TICKS;
+    // Raising another task above us, or lowering ourselves, may mean we are
+    // no longer the right task to be running.
+    if (t == current_task || (task_runnable(t) && preempts_current(t)))
+        need_resched = true;
+    hanacore::sync::spin_unlock_irqrestore(&sched_lock, flags);
+    return 0;
+}
 
-    if (prev->state == TASK_RUNNING) prev->state = TASK_READY;
-    next->state = TASK_RUNNING;
-    log_info("scheduler: switch pid=%d -> pid=%d", prev->pid, next->pid);
-    current_task = next;
-    asm volatile ("" ::: "memory");
-    context_switch(&prev->rsp, &next->rsp, nullptr, nullptr);
+int sched_getscheduler(int pid) {
+    Task* t = pid == 0 ? current_task : find_task_by_pid(pid);
+    return t ? t->policy : -1;
 }
 
-void sched_yield() {
+int sched_getparam(int pid) {
+    Task* t = pid == 0 ? current_task : find_task_by_pid(pid);
+    return t ? t->rt_priority : -1;
+}
+
+// Called from the timer interrupt. Only bookkeeping happens here; the
+// actual switch is deferred to the next preemption point.
+void sched_tick() {
+    Task* cur = current_task;
+    if (!cur || cur->policy == SCHED_FIFO) return;
+    if (--cur->timeslice <= 0) {
+        cur->timeslice = SCHED_TIMESLICE_TICKS;
+        need_resched = true;
+    }
+}
+
+void sched_preempt_check() {
+    if (!need_resched) return;
+    need_resched = false;
     schedule_next();
 }
 
@@ -394,15 +558,23 @@ int sched_getpid() {
 
 Task* find_task_by_pid(int pid) {
     Task* cur = task_list;
-    while (cur) {
+    if (!cur) return nullptr;
+    // The task list is circular: stop once we are back at the head.
+    do {
         if (cur->pid == pid) return cur;
         cur = cur->next;
-    }
+    } while (cur && cur != task_list);
     return nullptr;
 }
 
 void kill_task(int pid) {
     Task* t = find_task_by_pid(pid);
+    if (!t || t->state == TASK_DEAD) return;
+    if (t == current_task) task_cleanup();
+    // Close the victim's descriptors from the killer's context while the
+    // victim is still alive, since io-ring workers resolve fds through it.
+    hanacore::userland::fileio_close_all(t->fds);
+    t = find_task_by_pid(pid);
     if (t && t->state != TASK_DEAD) {
         t->state = TASK_DEAD;
         log_info("scheduler: killed task pid=%d", pid);
@@ -415,10 +587,16 @@ void wait_task(int pid) {
         Task* t = find_task_by_pid(pid);
         if (!t || t->state == TASK_DEAD) break;
         
-        // Explicitly call schedule_next to let other tasks run
-        schedule_next();
+        // Yield (rather than schedule_next) so an RT waiter still lets the
+        // child run.
+        sched_yield();
     }
 }
 
 } // namespace hanacore::scheduler
 
+// C ABI preemption point for assembly entry/exit paths.
+extern "C" void sched_preempt_point() {
+    hanacore::scheduler::sched_preempt_check();
+}
+
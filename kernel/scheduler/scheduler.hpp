@@ -12,6 +12,24 @@ enum TaskState {
 	TASK_DEAD
 };
 
+// Scheduling policies (values match Linux so the syscalls pass straight
+// through). SCHED_FIFO/SCHED_RR tasks form a real-time band that always runs
+// before SCHED_NORMAL tasks; within the band the highest rt_priority wins.
+enum SchedPolicy {
+	SCHED_NORMAL = 0,
+	SCHED_FIFO   = 1,
+	SCHED_RR     = 2
+};
+
+static constexpr int SCHED_RT_PRIO_MIN = 1;
+static constexpr int SCHED_RT_PRIO_MAX = 99;
+// Priorities used by the kernel's own interactive tasks.
+static constexpr int SCHED_PRIO_COMPOSITOR = 60;
+static constexpr int SCHED_PRIO_CONSOLE = 50;
+// Timer ticks a SCHED_NORMAL or SCHED_RR task may run before it is asked
+// to give up the CPU.
+static constexpr int SCHED_TIMESLICE_TICKS = 10;
+
 struct Task {
 	int pid;
 	TaskState state;
@@ -24,8 +42,7 @@ struct Task {
 	void (*entry_arg_fn)(void*);
 	void *entry_arg;      // optional argument passed to entry when using create_task_with_arg
 	// Per-task file descriptor table
-	struct FDEntry *fds; // pointer to fd table (allocated at task creation)
-	int fd_count;
+	struct FDTable *fds; // fd table (allocated at task creation, grows on demand)
 	// Simple child/wait tracking
 	int exit_status; // if task exited, store status
 	int parent_pid;
@@ -34,10 +51,22 @@ struct Task {
 	void *user_entry;    // user-mode RIP
 	void *user_stack;    // pointer to user-mode stack bottom (virtual)
 	size_t user_stack_size;
+	void *user_sp;       // initial user RSP if the stack was prepared, else 0
+	void *exec_image;    // exec cache instance holding the program (userland/exec_cache.hpp)
 
 	// Kernel-mode stack buffer pointer (allocated at task creation). Used
 	// so the scheduler can free the stack when the task is destroyed.
 	void *kstack;
+
+	// Scheduling class
+	int policy;          // SchedPolicy
+	int rt_priority;     // 1..99 for SCHED_FIFO/SCHED_RR, 0 otherwise
+	int timeslice;       // remaining ticks (SCHED_NORMAL / SCHED_RR)
+	bool yield_pass;     // RT task yielded: let the next runnable task go once
+
+	// Timed sleep: if non-zero and the task is still blocked once
+	// CLOCK_MONOTONIC reaches this value, the timer tick wakes it.
+	uint64_t wake_at_ns;
 };
 
 // Globals for single-CPU scheduler
@@ -54,6 +83,10 @@ int create_task_with_arg(void (*entry)(void*), void* arg);
 // transition. This is a minimal implementation that does not yet provide
 // full address-space isolation (VMM mapping is a no-op at present).
 int create_user_task(void *user_entry, size_t user_stack_size);
+// Same, but the task is left TASK_BLOCKED so the caller can fill in its
+// user stack (user_sp) and descriptors before releasing it with sched_wake.
+// Returns nullptr on allocation failure.
+Task* create_user_task_blocked(void *user_entry, size_t user_stack_size);
 void sched_yield();
 void schedule_next();
 int sched_getpid();
@@ -61,5 +94,29 @@ Task* find_task_by_pid(int pid);
 void kill_task(int pid);
 void wait_task(int pid);
 
+// Sleep/wakeup hooks used by sync::WaitQueue. sched_block_current marks the
+// running task blocked (it keeps running until it calls sched_sleep);
+// sched_wake makes a blocked task runnable again and is IRQ-safe.
+void sched_block_current();
+void sched_wake(Task* t);
+void sched_sleep();
+// Arm (deadline_ns != 0) or disarm the current task's wakeup deadline for
+// the next sched_sleep(). sched_expire_timeouts wakes blocked tasks whose
+// deadline has passed; it runs from the timer interrupt.
+void sched_set_timeout(uint64_t deadline_ns);
+void sched_expire_timeouts(uint64_t now_ns);
+
+// Real-time class control. pid 0 means the calling task. Return 0 / -1.
+int sched_setscheduler(int pid, int policy, int rt_priority);
+int sched_getscheduler(int pid);   // policy or -1
+int sched_getparam(int pid);       // rt_priority or -1
+
+// Preemption support. need_resched is raised when a higher-priority task
+// becomes runnable or the running task's slice expires; it is acted on at
+// the next preemption point (syscall exit, timer tick from user mode).
+extern volatile bool need_resched;
+void sched_tick();
+void sched_preempt_check();
+
 } // namespace hanacore::scheduler
 
@@ -201,19 +201,6 @@ int cmd_exec_external(const char* cmdname, const char* args) {
     return 127;
 }
 
-// Helper callback for ls command
-static struct {
-    int count;
-} ls_context = {0};
-
-static void ls_callback(const char* name) {
-    if (name) {
-        print(name);
-        print("\n");
-        ls_context.count++;
-    }
-}
-
 int cmd_ls(const char* args) {
     const char* path = "/";
     
@@ -222,23 +209,23 @@ int cmd_ls(const char* args) {
         path = args;
     }
     
-    ls_context.count = 0;
-    
-    // Use VFS to list the directory
-    int rc = ::vfs_list_dir(path, ls_callback);
-    
-    if (rc != 0) {
+    struct vfs_dir* dir = ::vfs_opendir(path);
+    if (!dir) {
         print("Cannot list directory: ");
         print(path);
-        print(" (rc=");
-        char tmp[16];
-        snprintf(tmp, sizeof(tmp), "%d", rc);
-        print(tmp);
-        print(")\n");
+        print("\n");
         return 1;
     }
     
-    if (ls_context.count == 0) {
+    // Directories are marked with a trailing '/'
+    int count = 0;
+    for (struct vfs_dirent* de; (de = ::vfs_readdir(dir)) != nullptr; ++count) {
+        print(de->d_name);
+        print(de->d_type == VFS_DT_DIR ? "/\n" : "\n");
+    }
+    ::vfs_closedir(dir);
+    
+    if (count == 0) {
         print("(empty directory)\n");
     }
     
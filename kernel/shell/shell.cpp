@@ -4,12 +4,12 @@
 #include "../libs/libc.h"
 #include "../utils/logger.hpp"
 #include "../userland/users.hpp"
+#include "../scheduler/scheduler.hpp"
 #include <cstdio>
 #include <cstring>
 
 extern "C" {
     void print(const char*);
-    char keyboard_poll_char(void);
 }
 
 namespace hanacore {
@@ -79,8 +79,7 @@ int CommandParser::tokenize(const char* args, char* tokens[], int max_tokens, in
 static void read_line(char* buf, int maxlen) {
     int pos = 0;
     while (pos < maxlen - 1) {
-        char c = keyboard_poll_char();
-        if (c == 0) continue;
+        char c = tty_getchar();
         if (c == '\n' || c == '\r') {
             print("\n");
             break;
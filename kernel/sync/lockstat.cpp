@@ -0,0 +1,98 @@
+#include "lockstat.hpp"
+#include "../arch/cpu.hpp"
+#include "../libs/libc.h"
+
+namespace hanacore { namespace sync {
+
+    // Registry of every class seen so far. Protected by a raw flag rather than
+    // a Spinlock so the registry itself never shows up in its own statistics.
+    static LockClass* class_list = nullptr;
+    static volatile uint32_t registry_lock = 0;
+
+    static void registry_acquire(uint64_t* flags) {
+        *flags = hanacore::arch::irq_save();
+        while (__atomic_exchange_n(&registry_lock, 1, __ATOMIC_ACQUIRE))
+            hanacore::arch::cpu_relax();
+    }
+
+    static void registry_release(uint64_t flags) {
+        __atomic_store_n(&registry_lock, 0, __ATOMIC_RELEASE);
+        hanacore::arch::irq_restore(flags);
+    }
+
+    static void register_class(LockClass* cls) {
+        uint64_t flags;
+        registry_acquire(&flags);
+        if (!cls->registered) {
+            // Append so /proc/lock_stat lists classes in first-use order.
+            cls->next = nullptr;
+            LockClass** pp = &class_list;
+            while (*pp) pp = &(*pp)->next;
+            *pp = cls;
+            cls->registered = true;
+        }
+        registry_release(flags);
+    }
+
+    void lockstat_acquired(LockClass* cls, bool contended, uint64_t wait_cycles) {
+        if (!cls) return;
+        if (!__atomic_load_n(&cls->registered, __ATOMIC_ACQUIRE)) register_class(cls);
+        __atomic_fetch_add(&cls->acquisitions, 1, __ATOMIC_RELAXED);
+        if (contended) {
+            __atomic_fetch_add(&cls->contended, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&cls->wait_total, wait_cycles, __ATOMIC_RELAXED);
+        }
+    }
+
+    void lockstat_released(LockClass* cls, uint64_t hold_cycles) {
+        if (!cls) return;
+        __atomic_fetch_add(&cls->hold_total, hold_cycles, __ATOMIC_RELAXED);
+        uint64_t cur = __atomic_load_n(&cls->hold_max, __ATOMIC_RELAXED);
+        while (hold_cycles > cur &&
+               !__atomic_compare_exchange_n(&cls->hold_max, &cur, hold_cycles, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    size_t lockstat_format(char* buf, size_t cap) {
+        if (!buf || cap == 0) return 0;
+        size_t off = 0;
+        int n = snprintf(buf, cap,
+                         "# class acquisitions contended wait_total hold_total hold_max hold_avg (cycles)\n");
+        if (n > 0) off = ((size_t)n < cap) ? (size_t)n : cap - 1;
+
+        uint64_t flags;
+        registry_acquire(&flags);
+        for (LockClass* c = class_list; c && off + 1 < cap; c = c->next) {
+            uint64_t acq = c->acquisitions;
+            uint64_t avg = acq ? c->hold_total / acq : 0;
+            n = snprintf(buf + off, cap - off, "%s %llu %llu %llu %llu %llu %llu\n",
+                         c->name ? c->name : "?",
+                         (unsigned long long)acq,
+                         (unsigned long long)c->contended,
+                         (unsigned long long)c->wait_total,
+                         (unsigned long long)c->hold_total,
+                         (unsigned long long)c->hold_max,
+                         (unsigned long long)avg);
+            if (n <= 0) break;
+            off += ((size_t)n < cap - off) ? (size_t)n : cap - off - 1;
+        }
+        registry_release(flags);
+        buf[off] = '\0';
+        return off;
+    }
+
+    void lockstat_reset() {
+        uint64_t flags;
+        registry_acquire(&flags);
+        for (LockClass* c = class_list; c; c = c->next) {
+            c->acquisitions = 0;
+            c->contended = 0;
+            c->wait_total = 0;
+            c->hold_total = 0;
+            c->hold_max = 0;
+        }
+        registry_release(flags);
+    }
+
+}} // namespace hanacore::sync
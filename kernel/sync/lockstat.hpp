@@ -0,0 +1,40 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Per lock-class contention statistics. Every lock names a LockClass; all
+// instances of the same class (e.g. every pipe lock) share one record so the
+// numbers answer "which kind of lock is hot" rather than "which object".
+// Classes register themselves on first acquisition and are listed in
+// /proc/lock_stat. All times are raw TSC cycles.
+
+namespace hanacore { namespace sync {
+
+    struct LockClass {
+        const char* name;
+        uint64_t acquisitions;  // successful acquisitions
+        uint64_t contended;     // acquisitions that had to wait
+        uint64_t wait_total;    // cycles spent waiting for the lock
+        uint64_t hold_total;    // cycles the lock was held (exclusive holds)
+        uint64_t hold_max;      // longest single exclusive hold
+        LockClass* next;        // registry link
+        bool registered;
+    };
+
+    // Declare a named lock class with static storage.
+    #define HANA_LOCK_CLASS(var, lock_name) \
+        static hanacore::sync::LockClass var = { lock_name, 0, 0, 0, 0, 0, nullptr, false }
+
+    // Record one acquisition. `wait_cycles` is non-zero only when the
+    // acquisition was contended.
+    void lockstat_acquired(LockClass* cls, bool contended, uint64_t wait_cycles);
+    // Record the end of an exclusive hold that lasted `hold_cycles`.
+    void lockstat_released(LockClass* cls, uint64_t hold_cycles);
+
+    // Render the registry as text (one class per line). Returns the number of
+    // bytes written, excluding the terminating NUL.
+    size_t lockstat_format(char* buf, size_t cap);
+    // Zero all counters (classes stay registered).
+    void lockstat_reset();
+
+}} // namespace hanacore::sync
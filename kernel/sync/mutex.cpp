@@ -0,0 +1,50 @@
+#include "mutex.hpp"
+#include "../arch/cpu.hpp"
+#include "../scheduler/scheduler.hpp"
+
+namespace hanacore { namespace sync {
+
+    using hanacore::arch::rdtsc;
+
+    void mutex_init(Mutex* m, LockClass* cls) {
+        m->locked = 0;
+        m->owner = nullptr;
+        m->cls = cls;
+        m->acquired_at = 0;
+        wait_queue_init(&m->waiters);
+    }
+
+    static bool try_acquire(Mutex* m) {
+        return !__atomic_exchange_n(&m->locked, 1, __ATOMIC_ACQUIRE);
+    }
+
+    void mutex_lock(Mutex* m) {
+        if (try_acquire(m)) {
+            m->owner = hanacore::scheduler::current_task;
+            m->acquired_at = rdtsc();
+            lockstat_acquired(m->cls, false, 0);
+            return;
+        }
+        uint64_t start = rdtsc();
+        wait_event(&m->waiters, [m] { return try_acquire(m); });
+        m->owner = hanacore::scheduler::current_task;
+        m->acquired_at = rdtsc();
+        lockstat_acquired(m->cls, true, m->acquired_at - start);
+    }
+
+    bool mutex_trylock(Mutex* m) {
+        if (!try_acquire(m)) return false;
+        m->owner = hanacore::scheduler::current_task;
+        m->acquired_at = rdtsc();
+        lockstat_acquired(m->cls, false, 0);
+        return true;
+    }
+
+    void mutex_unlock(Mutex* m) {
+        lockstat_released(m->cls, rdtsc() - m->acquired_at);
+        m->owner = nullptr;
+        __atomic_store_n(&m->locked, 0, __ATOMIC_RELEASE);
+        wake_up_one(&m->waiters);
+    }
+
+}} // namespace hanacore::sync
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include "waitqueue.hpp"
+
+// Sleeping mutex. Uncontended lock/unlock is a single atomic exchange; a
+// contended locker sleeps on the mutex's wait queue instead of spinning, so
+// a mutex may be held across operations that block (disk I/O, waiting for
+// another task). Must not be taken from IRQ context.
+
+namespace hanacore { namespace sync {
+
+    struct Mutex {
+        volatile uint32_t locked;
+        hanacore::scheduler::Task* owner;
+        WaitQueue waiters;
+        LockClass* cls;
+        uint64_t acquired_at;
+    };
+
+    void mutex_init(Mutex* m, LockClass* cls);
+    void mutex_lock(Mutex* m);
+    bool mutex_trylock(Mutex* m);
+    void mutex_unlock(Mutex* m);
+
+    class MutexGuard {
+    public:
+        explicit MutexGuard(Mutex* m) : m_(m) { mutex_lock(m_); }
+        ~MutexGuard() { mutex_unlock(m_); }
+        MutexGuard(const MutexGuard&) = delete;
+        MutexGuard& operator=(const MutexGuard&) = delete;
+    private:
+        Mutex* m_;
+    };
+
+}} // namespace hanacore::sync
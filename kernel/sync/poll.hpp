@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include "waitqueue.hpp"
+
+// Readiness polling. Every pollable object has a poll function that returns
+// its current POLL* mask and, when given a PollTable, first hands the table
+// each wait queue that is woken whenever that mask may change. poll() and
+// epoll supply tables that hook callback entries onto those queues; a null
+// table just samples the mask.
+
+#ifndef POLLIN
+// Event bits (Linux values; epoll uses the same ones as EPOLL*)
+#define POLLIN     0x001
+#define POLLPRI    0x002
+#define POLLOUT    0x004
+#define POLLERR    0x008
+#define POLLHUP    0x010
+#define POLLNVAL   0x020
+#define POLLRDNORM 0x040
+#define POLLWRNORM 0x100
+#endif
+
+namespace hanacore { namespace sync {
+
+    struct PollTable {
+        void (*queue)(PollTable* pt, WaitQueue* wq);
+    };
+
+    static inline void poll_wait(PollTable* pt, WaitQueue* wq) {
+        if (pt && pt->queue && wq) pt->queue(pt, wq);
+    }
+
+}} // namespace hanacore::sync
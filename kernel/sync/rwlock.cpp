@@ -0,0 +1,78 @@
+#include "rwlock.hpp"
+#include "../arch/cpu.hpp"
+
+namespace hanacore { namespace sync {
+
+    using hanacore::arch::rdtsc;
+    using hanacore::arch::cpu_relax;
+
+    static bool try_read(RWLock* l) {
+        if (__atomic_load_n(&l->writers_waiting, __ATOMIC_RELAXED)) return false;
+        int32_t s = __atomic_load_n(&l->state, __ATOMIC_RELAXED);
+        if (s < 0) return false;
+        return __atomic_compare_exchange_n(&l->state, &s, s + 1, false,
+                                           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    }
+
+    void read_lock(RWLock* l) {
+        if (try_read(l)) {
+            lockstat_acquired(l->cls, false, 0);
+            return;
+        }
+        uint64_t start = rdtsc();
+        while (!try_read(l)) cpu_relax();
+        lockstat_acquired(l->cls, true, rdtsc() - start);
+    }
+
+    void read_unlock(RWLock* l) {
+        __atomic_fetch_sub(&l->state, 1, __ATOMIC_RELEASE);
+    }
+
+    static bool try_write(RWLock* l) {
+        int32_t expected = 0;
+        return __atomic_compare_exchange_n(&l->state, &expected, -1, false,
+                                           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    }
+
+    void write_lock(RWLock* l) {
+        if (try_write(l)) {
+            l->acquired_at = rdtsc();
+            lockstat_acquired(l->cls, false, 0);
+            return;
+        }
+        uint64_t start = rdtsc();
+        __atomic_fetch_add(&l->writers_waiting, 1, __ATOMIC_RELAXED);
+        while (!try_write(l)) cpu_relax();
+        __atomic_fetch_sub(&l->writers_waiting, 1, __ATOMIC_RELAXED);
+        l->acquired_at = rdtsc();
+        lockstat_acquired(l->cls, true, l->acquired_at - start);
+    }
+
+    void write_unlock(RWLock* l) {
+        lockstat_released(l->cls, rdtsc() - l->acquired_at);
+        __atomic_store_n(&l->state, 0, __ATOMIC_RELEASE);
+    }
+
+    uint64_t read_lock_irqsave(RWLock* l) {
+        uint64_t flags = hanacore::arch::irq_save();
+        read_lock(l);
+        return flags;
+    }
+
+    void read_unlock_irqrestore(RWLock* l, uint64_t flags) {
+        read_unlock(l);
+        hanacore::arch::irq_restore(flags);
+    }
+
+    uint64_t write_lock_irqsave(RWLock* l) {
+        uint64_t flags = hanacore::arch::irq_save();
+        write_lock(l);
+        return flags;
+    }
+
+    void write_unlock_irqrestore(RWLock* l, uint64_t flags) {
+        write_unlock(l);
+        hanacore::arch::irq_restore(flags);
+    }
+
+}} // namespace hanacore::sync
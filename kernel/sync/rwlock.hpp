@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include "lockstat.hpp"
+
+// Spinning reader-writer lock. Any number of readers may hold the lock at
+// once; a writer holds it exclusively. Waiting writers block new readers so
+// a steady stream of lookups cannot starve an update. Only write holds are
+// timed for the hold statistics (readers overlap, so a per-class read hold
+// time would be meaningless).
+
+namespace hanacore { namespace sync {
+
+    struct RWLock {
+        volatile int32_t state;            // >0 reader count, -1 writer, 0 free
+        volatile uint32_t writers_waiting;
+        LockClass* cls;
+        uint64_t acquired_at;              // TSC at write acquisition
+    };
+
+    void read_lock(RWLock* l);
+    void read_unlock(RWLock* l);
+    void write_lock(RWLock* l);
+    void write_unlock(RWLock* l);
+
+    uint64_t read_lock_irqsave(RWLock* l);
+    void read_unlock_irqrestore(RWLock* l, uint64_t flags);
+    uint64_t write_lock_irqsave(RWLock* l);
+    void write_unlock_irqrestore(RWLock* l, uint64_t flags);
+
+}} // namespace hanacore::sync
@@ -0,0 +1,82 @@
+#include "spinlock.hpp"
+#include "../arch/cpu.hpp"
+
+namespace hanacore { namespace sync {
+
+    using hanacore::arch::rdtsc;
+    using hanacore::arch::cpu_relax;
+
+    // ------------------------------------------------------------------
+    // Spinlock
+    // ------------------------------------------------------------------
+    void spin_lock(Spinlock* l) {
+        if (!__atomic_exchange_n(&l->locked, 1, __ATOMIC_ACQUIRE)) {
+            l->acquired_at = rdtsc();
+            lockstat_acquired(l->cls, false, 0);
+            return;
+        }
+        uint64_t start = rdtsc();
+        do {
+            // Spin on a plain read so waiters don't bounce the cache line.
+            while (__atomic_load_n(&l->locked, __ATOMIC_RELAXED)) cpu_relax();
+        } while (__atomic_exchange_n(&l->locked, 1, __ATOMIC_ACQUIRE));
+        l->acquired_at = rdtsc();
+        lockstat_acquired(l->cls, true, l->acquired_at - start);
+    }
+
+    bool spin_trylock(Spinlock* l) {
+        if (__atomic_exchange_n(&l->locked, 1, __ATOMIC_ACQUIRE)) return false;
+        l->acquired_at = rdtsc();
+        lockstat_acquired(l->cls, false, 0);
+        return true;
+    }
+
+    void spin_unlock(Spinlock* l) {
+        lockstat_released(l->cls, rdtsc() - l->acquired_at);
+        __atomic_store_n(&l->locked, 0, __ATOMIC_RELEASE);
+    }
+
+    uint64_t spin_lock_irqsave(Spinlock* l) {
+        uint64_t flags = hanacore::arch::irq_save();
+        spin_lock(l);
+        return flags;
+    }
+
+    void spin_unlock_irqrestore(Spinlock* l, uint64_t flags) {
+        spin_unlock(l);
+        hanacore::arch::irq_restore(flags);
+    }
+
+    // ------------------------------------------------------------------
+    // Ticket lock
+    // ------------------------------------------------------------------
+    void ticket_lock(TicketLock* l) {
+        uint32_t me = __atomic_fetch_add(&l->next, 1, __ATOMIC_RELAXED);
+        if (__atomic_load_n(&l->owner, __ATOMIC_ACQUIRE) == me) {
+            l->acquired_at = rdtsc();
+            lockstat_acquired(l->cls, false, 0);
+            return;
+        }
+        uint64_t start = rdtsc();
+        while (__atomic_load_n(&l->owner, __ATOMIC_ACQUIRE) != me) cpu_relax();
+        l->acquired_at = rdtsc();
+        lockstat_acquired(l->cls, true, l->acquired_at - start);
+    }
+
+    void ticket_unlock(TicketLock* l) {
+        lockstat_released(l->cls, rdtsc() - l->acquired_at);
+        __atomic_store_n(&l->owner, l->owner + 1, __ATOMIC_RELEASE);
+    }
+
+    uint64_t ticket_lock_irqsave(TicketLock* l) {
+        uint64_t flags = hanacore::arch::irq_save();
+        ticket_lock(l);
+        return flags;
+    }
+
+    void ticket_unlock_irqrestore(TicketLock* l, uint64_t flags) {
+        ticket_unlock(l);
+        hanacore::arch::irq_restore(flags);
+    }
+
+}} // namespace hanacore::sync
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include "lockstat.hpp"
+
+// Busy-waiting locks. Spinlock is a plain test-and-test-and-set lock; the
+// TicketLock hands the lock out in FIFO order so waiters cannot starve once
+// there is more than one CPU. Both have *_irqsave variants which disable
+// interrupts for the duration of the hold and must be used whenever the
+// protected data is also touched from an IRQ handler.
+//
+// Locks are zero-initialisable apart from the class pointer, e.g.
+//     HANA_LOCK_CLASS(heap_class, "heap");
+//     static hanacore::sync::Spinlock heap_lock = { 0, &heap_class, 0 };
+
+namespace hanacore { namespace sync {
+
+    struct Spinlock {
+        volatile uint32_t locked;
+        LockClass* cls;
+        uint64_t acquired_at;   // TSC at acquisition, for hold-time stats
+    };
+
+    void spin_lock(Spinlock* l);
+    bool spin_trylock(Spinlock* l);
+    void spin_unlock(Spinlock* l);
+    uint64_t spin_lock_irqsave(Spinlock* l);
+    void spin_unlock_irqrestore(Spinlock* l, uint64_t flags);
+
+    struct TicketLock {
+        volatile uint32_t next;   // next ticket to hand out
+        volatile uint32_t owner;  // ticket currently being served
+        LockClass* cls;
+        uint64_t acquired_at;
+    };
+
+    void ticket_lock(TicketLock* l);
+    void ticket_unlock(TicketLock* l);
+    uint64_t ticket_lock_irqsave(TicketLock* l);
+    void ticket_unlock_irqrestore(TicketLock* l, uint64_t flags);
+
+    // RAII guard for the common "lock for this scope with IRQs off" case.
+    class SpinGuard {
+    public:
+        explicit SpinGuard(Spinlock* l) : lock_(l), flags_(spin_lock_irqsave(l)) {}
+        ~SpinGuard() { spin_unlock_irqrestore(lock_, flags_); }
+        SpinGuard(const SpinGuard&) = delete;
+        SpinGuard& operator=(const SpinGuard&) = delete;
+    private:
+        Spinlock* lock_;
+        uint64_t flags_;
+    };
+
+}} // namespace hanacore::sync
@@ -0,0 +1,118 @@
+#include "waitqueue.hpp"
+#include "../scheduler/scheduler.hpp"
+#include "../arch/tsc.hpp"
+
+namespace hanacore { namespace sync {
+
+    HANA_LOCK_CLASS(waitqueue_class, "waitqueue");
+
+    using hanacore::scheduler::current_task;
+
+    void wait_queue_init(WaitQueue* wq, LockClass* cls) {
+        wq->lock.locked = 0;
+        wq->lock.cls = cls ? cls : &waitqueue_class;
+        wq->lock.acquired_at = 0;
+        wq->head = wq->tail = nullptr;
+    }
+
+    void wait_entry_init(WaitQueueEntry* e) {
+        e->task = current_task;
+        e->wake = nullptr;
+        e->data = nullptr;
+        e->prev = e->next = nullptr;
+        e->queued = false;
+    }
+
+    void wait_entry_init_callback(WaitQueueEntry* e, WakeFn fn, void* data) {
+        e->task = current_task;
+        e->wake = fn;
+        e->data = data;
+        e->prev = e->next = nullptr;
+        e->queued = false;
+    }
+
+    // Queue manipulation helpers; caller holds wq->lock.
+    static void enqueue_locked(WaitQueue* wq, WaitQueueEntry* e) {
+        if (e->queued) return;
+        e->next = nullptr;
+        e->prev = wq->tail;
+        if (wq->tail) wq->tail->next = e; else wq->head = e;
+        wq->tail = e;
+        e->queued = true;
+    }
+
+    static void dequeue_locked(WaitQueue* wq, WaitQueueEntry* e) {
+        if (!e->queued) return;
+        if (e->prev) e->prev->next = e->next; else wq->head = e->next;
+        if (e->next) e->next->prev = e->prev; else wq->tail = e->prev;
+        e->prev = e->next = nullptr;
+        e->queued = false;
+    }
+
+    void prepare_to_wait(WaitQueue* wq, WaitQueueEntry* e) {
+        uint64_t flags = spin_lock_irqsave(&wq->lock);
+        enqueue_locked(wq, e);
+        hanacore::scheduler::sched_block_current();
+        spin_unlock_irqrestore(&wq->lock, flags);
+    }
+
+    void finish_wait(WaitQueue* wq, WaitQueueEntry* e) {
+        uint64_t flags = spin_lock_irqsave(&wq->lock);
+        dequeue_locked(wq, e);
+        if (current_task) current_task->state = hanacore::scheduler::TASK_RUNNING;
+        spin_unlock_irqrestore(&wq->lock, flags);
+    }
+
+    void add_wait_queue(WaitQueue* wq, WaitQueueEntry* e) {
+        uint64_t flags = spin_lock_irqsave(&wq->lock);
+        enqueue_locked(wq, e);
+        spin_unlock_irqrestore(&wq->lock, flags);
+    }
+
+    void remove_wait_queue(WaitQueue* wq, WaitQueueEntry* e) {
+        uint64_t flags = spin_lock_irqsave(&wq->lock);
+        dequeue_locked(wq, e);
+        spin_unlock_irqrestore(&wq->lock, flags);
+    }
+
+    int wake_up(WaitQueue* wq, int nr) {
+        int woken = 0;
+        uint64_t flags = spin_lock_irqsave(&wq->lock);
+        WaitQueueEntry* e = wq->head;
+        while (e) {
+            WaitQueueEntry* next = e->next;
+            if (e->wake) {
+                e->wake(e);
+            } else if (nr <= 0 || woken < nr) {
+                dequeue_locked(wq, e);
+                if (e->task) hanacore::scheduler::sched_wake(e->task);
+                ++woken;
+            }
+            e = next;
+        }
+        spin_unlock_irqrestore(&wq->lock, flags);
+        return woken;
+    }
+
+    bool wait_queue_active(WaitQueue* wq) {
+        return __atomic_load_n(&wq->head, __ATOMIC_RELAXED) != nullptr;
+    }
+
+    void wait_queue_sleep() {
+        hanacore::scheduler::sched_sleep();
+    }
+
+    bool wait_queue_sleep_until(uint64_t deadline_ns) {
+        if (hanacore::arch::clock_monotonic_ns() >= deadline_ns) return false;
+        hanacore::scheduler::sched_set_timeout(deadline_ns);
+        hanacore::scheduler::sched_sleep();
+        hanacore::scheduler::sched_set_timeout(0);
+        return hanacore::arch::clock_monotonic_ns() < deadline_ns;
+    }
+
+    uint64_t wait_deadline_after(uint64_t timeout_ns) {
+        uint64_t now = hanacore::arch::clock_monotonic_ns();
+        return timeout_ns > UINT64_MAX - now ? UINT64_MAX : now + timeout_ns;
+    }
+
+}} // namespace hanacore::sync
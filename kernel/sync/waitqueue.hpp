@@ -0,0 +1,107 @@
+#pragma once
+#include <stdint.h>
+#include "spinlock.hpp"
+
+// Wait queues: the building block for every sleeping primitive. A task that
+// needs to wait for a condition links a WaitQueueEntry (usually on its own
+// stack) into the queue, marks itself blocked, re-checks the condition and
+// only then gives up the CPU. Whoever makes the condition true calls
+// wake_up(), which moves waiters back to READY. Checking after queueing is
+// what makes the pattern immune to lost wakeups.
+//
+// Entries may also carry a callback instead of a task; the callback runs
+// from wake_up() and the entry stays queued (used by poll/epoll style
+// watchers that observe several queues at once).
+
+namespace hanacore { namespace scheduler { struct Task; } }
+
+namespace hanacore { namespace sync {
+
+    struct WaitQueueEntry;
+    typedef void (*WakeFn)(WaitQueueEntry* e);
+
+    struct WaitQueueEntry {
+        hanacore::scheduler::Task* task;
+        WakeFn wake;            // nullptr: wake `task` and dequeue
+        void* data;             // owner cookie for callback entries
+        WaitQueueEntry* prev;
+        WaitQueueEntry* next;
+        bool queued;
+    };
+
+    struct WaitQueue {
+        Spinlock lock;
+        WaitQueueEntry* head;
+        WaitQueueEntry* tail;
+    };
+
+    // `cls` may be null, in which case the queue lock is accounted to the
+    // generic "waitqueue" class.
+    void wait_queue_init(WaitQueue* wq, LockClass* cls = nullptr);
+    // Bind an entry to the calling task.
+    void wait_entry_init(WaitQueueEntry* e);
+    // Bind an entry to a callback.
+    void wait_entry_init_callback(WaitQueueEntry* e, WakeFn fn, void* data);
+
+    // Queue `e` (if not already queued) and mark the current task blocked.
+    void prepare_to_wait(WaitQueue* wq, WaitQueueEntry* e);
+    // Dequeue `e` (if still queued) and mark the current task running.
+    void finish_wait(WaitQueue* wq, WaitQueueEntry* e);
+    // Plain add/remove without touching the task state.
+    void add_wait_queue(WaitQueue* wq, WaitQueueEntry* e);
+    void remove_wait_queue(WaitQueue* wq, WaitQueueEntry* e);
+
+    // Wake at most `nr` task waiters (nr <= 0 wakes all). Callback entries
+    // are always invoked and do not count towards `nr`. Returns the number
+    // of tasks woken. Safe to call from IRQ context.
+    int wake_up(WaitQueue* wq, int nr);
+    static inline int wake_up_one(WaitQueue* wq) { return wake_up(wq, 1); }
+    static inline int wake_up_all(WaitQueue* wq) { return wake_up(wq, 0); }
+    bool wait_queue_active(WaitQueue* wq);
+
+    // Give up the CPU after prepare_to_wait(). Returns once the task has been
+    // woken (or immediately if a wakeup already happened).
+    void wait_queue_sleep();
+    // As wait_queue_sleep(), but also return once CLOCK_MONOTONIC reaches
+    // `deadline_ns`. Returns false if the deadline has passed.
+    bool wait_queue_sleep_until(uint64_t deadline_ns);
+    // Absolute deadline `timeout_ns` from now.
+    uint64_t wait_deadline_after(uint64_t timeout_ns);
+
+    // Sleep on `wq` until `cond()` is true.
+    template <typename Cond>
+    void wait_event(WaitQueue* wq, Cond cond) {
+        if (cond()) return;
+        WaitQueueEntry e;
+        wait_entry_init(&e);
+        for (;;) {
+            prepare_to_wait(wq, &e);
+            if (cond()) break;
+            wait_queue_sleep();
+        }
+        finish_wait(wq, &e);
+    }
+
+    // Sleep on `wq` until `cond()` is true or `deadline_ns` (absolute
+    // CLOCK_MONOTONIC) passes. Returns the final value of `cond()`.
+    template <typename Cond>
+    bool wait_event_deadline(WaitQueue* wq, Cond cond, uint64_t deadline_ns) {
+        if (cond()) return true;
+        WaitQueueEntry e;
+        wait_entry_init(&e);
+        bool ok;
+        for (;;) {
+            prepare_to_wait(wq, &e);
+            if ((ok = cond())) break;
+            if (!wait_queue_sleep_until(deadline_ns)) { ok = cond(); break; }
+        }
+        finish_wait(wq, &e);
+        return ok;
+    }
+
+    template <typename Cond>
+    bool wait_event_timeout(WaitQueue* wq, Cond cond, uint64_t timeout_ns) {
+        return wait_event_deadline(wq, cond, wait_deadline_after(timeout_ns));
+    }
+
+}} // namespace hanacore::sync
@@ -3,6 +3,9 @@
 #include <stddef.h>
 #include <string.h>
 #include "tty.hpp"
+#include "../sync/waitqueue.hpp"
+#include "../sync/poll.hpp"
+#include "../userland/errno.hpp"
 
 // Simple ring buffer helper
 struct rbuf {
@@ -52,9 +55,22 @@ struct pty_pair {
     rbuf m2s;
     rbuf s2m;
     int attached_vt; // -1 if none
+    // Woken on every transfer in either direction and on destroy. Set up
+    // once: pollers may still be queued when a slot is reused.
+    hanacore::sync::WaitQueue wait;
+    bool wait_ready;
+    // Bumped on every create, so a sleeper notices its pair was destroyed
+    // even if the slot has been reused since.
+    unsigned gen;
 };
 
 static pty_pair ptys[HANACORE_PTY_MAX];
+
+HANA_LOCK_CLASS(pty_wait_class, "pty_wait");
+
+static void pty_wake(int id) {
+    if (ptys[id].wait_ready) hanacore::sync::wake_up_all(&ptys[id].wait);
+}
 // Map VT index to attached PTY id (-1 if none). Size equals 12
 // Map VT index to attached PTY id (-1 if none). Size equals 12
 // Initialize all entries to -1 explicitly (constructor functions are
@@ -72,37 +88,104 @@ extern "C" int pty_create_pair(void) {
     for (int i = 0; i < HANACORE_PTY_MAX; ++i) {
         if (!ptys[i].in_use) {
             ptys[i].in_use = true;
+            ptys[i].gen++;
             rbuf_init(&ptys[i].m2s, ptys[i].m2s_area, pty_pair::BUFSZ);
             rbuf_init(&ptys[i].s2m, ptys[i].s2m_area, pty_pair::BUFSZ);
             ptys[i].attached_vt = -1;
+            if (!ptys[i].wait_ready) {
+                hanacore::sync::wait_queue_init(&ptys[i].wait, &pty_wait_class);
+                ptys[i].wait_ready = true;
+            }
             return i;
         }
     }
     return -1;
 }
 
+extern "C" void pty_destroy_pair(int id) {
+    if (id < 0 || id >= HANACORE_PTY_MAX) return;
+    if (!ptys[id].in_use) return;
+    pty_attach_slave_to_vt(id, -1);
+    ptys[id].in_use = false;
+    pty_wake(id);
+}
+
+extern "C" int pty_is_open(int id) {
+    return id >= 0 && id < HANACORE_PTY_MAX && ptys[id].in_use;
+}
+
 extern "C" int pty_master_read(int id, void* buf, size_t len) {
     if (id < 0 || id >= HANACORE_PTY_MAX) return -1;
     if (!ptys[id].in_use) return -1;
-    return (int)rbuf_read(&ptys[id].s2m, (char*)buf, len);
+    size_t n = rbuf_read(&ptys[id].s2m, (char*)buf, len);
+    if (n) pty_wake(id);
+    return (int)n;
 }
 
 extern "C" int pty_master_write(int id, const void* buf, size_t len) {
     if (id < 0 || id >= HANACORE_PTY_MAX) return -1;
     if (!ptys[id].in_use) return -1;
-    return (int)rbuf_write(&ptys[id].m2s, (const char*)buf, len);
+    size_t n = rbuf_write(&ptys[id].m2s, (const char*)buf, len);
+    if (n) pty_wake(id);
+    return (int)n;
 }
 
 extern "C" int pty_slave_read(int id, void* buf, size_t len) {
     if (id < 0 || id >= HANACORE_PTY_MAX) return -1;
     if (!ptys[id].in_use) return -1;
-    return (int)rbuf_read(&ptys[id].m2s, (char*)buf, len);
+    size_t n = rbuf_read(&ptys[id].m2s, (char*)buf, len);
+    if (n) pty_wake(id);
+    return (int)n;
 }
 
 extern "C" int pty_slave_write(int id, const void* buf, size_t len) {
     if (id < 0 || id >= HANACORE_PTY_MAX) return -1;
     if (!ptys[id].in_use) return -1;
-    return (int)rbuf_write(&ptys[id].s2m, (const char*)buf, len);
+    size_t n = rbuf_write(&ptys[id].s2m, (const char*)buf, len);
+    if (n) pty_wake(id);
+    return (int)n;
+}
+
+extern "C" long pty_read(int id, int master, void* buf, size_t len, int nonblock) {
+    if (id < 0 || id >= HANACORE_PTY_MAX) return -EIO;
+    if (len == 0) return 0;
+    if (!buf) return -EFAULT;
+    pty_pair* p = &ptys[id];
+    rbuf* in = master ? &p->s2m : &p->m2s;
+    unsigned gen = p->gen;
+    for (;;) {
+        if (!p->in_use || p->gen != gen) return 0;
+        size_t n = rbuf_read(in, (char*)buf, len);
+        if (n) {
+            pty_wake(id);
+            return (long)n;
+        }
+        if (nonblock) return -EAGAIN;
+        hanacore::sync::wait_event(&p->wait, [p, in, gen] {
+            return !p->in_use || p->gen != gen || rbuf_available(in) > 0;
+        });
+    }
+}
+
+extern "C" long pty_write(int id, int master, const void* buf, size_t len, int nonblock) {
+    if (id < 0 || id >= HANACORE_PTY_MAX) return -EIO;
+    if (len == 0) return 0;
+    if (!buf) return -EFAULT;
+    pty_pair* p = &ptys[id];
+    rbuf* out = master ? &p->m2s : &p->s2m;
+    unsigned gen = p->gen;
+    for (;;) {
+        if (!p->in_use || p->gen != gen) return -EIO;
+        size_t n = rbuf_write(out, (const char*)buf, len);
+        if (n) {
+            pty_wake(id);
+            return (long)n;
+        }
+        if (nonblock) return -EAGAIN;
+        hanacore::sync::wait_event(&p->wait, [p, out, gen] {
+            return !p->in_use || p->gen != gen || rbuf_available(out) < rbuf_capacity(out);
+        });
+    }
 }
 
 extern "C" void pty_slave_push_input(int id, char c) {
@@ -110,7 +193,7 @@ extern "C" void pty_slave_push_input(int id, char c) {
     if (!ptys[id].in_use) return;
     // push single char into slave-readable buffer (m2s)
     char ch = c;
-    rbuf_write(&ptys[id].m2s, &ch, 1);
+    if (rbuf_write(&ptys[id].m2s, &ch, 1)) pty_wake(id);
 }
 
 extern "C" int pty_attach_slave_to_vt(int id, int vt_index) {
@@ -126,3 +209,16 @@ extern "C" int pty_attach_slave_to_vt(int id, int vt_index) {
     }
     return 0;
 }
+
+uint32_t pty_poll(int id, bool master, hanacore::sync::PollTable* pt) {
+    if (id < 0 || id >= HANACORE_PTY_MAX) return POLLNVAL;
+    pty_pair* p = &ptys[id];
+    if (p->wait_ready) hanacore::sync::poll_wait(pt, &p->wait);
+    if (!p->in_use) return POLLHUP;
+    const rbuf* in = master ? &p->s2m : &p->m2s;
+    const rbuf* out = master ? &p->m2s : &p->s2m;
+    uint32_t mask = 0;
+    if (rbuf_available(in)) mask |= POLLIN | POLLRDNORM;
+    if (rbuf_available(out) < rbuf_capacity(out)) mask |= POLLOUT | POLLWRNORM;
+    return mask;
+}
@@ -9,6 +9,12 @@ extern "C" {
     // Create a new PTY pair. Returns index (0..HANACORE_PTY_MAX-1) or -1 on failure.
     int pty_create_pair(void);
 
+    // Release a pair created by pty_create_pair (master closed).
+    void pty_destroy_pair(int id);
+
+    // Non-zero if `id` names a live pair.
+    int pty_is_open(int id);
+
     // Master-side operations: master reads data written by slave, and writes data
     // which the slave can read.
     int pty_master_read(int id, void* buf, size_t len);
@@ -19,6 +25,13 @@ extern "C" {
     int pty_slave_read(int id, void* buf, size_t len);
     int pty_slave_write(int id, const void* buf, size_t len);
 
+    // Blocking transfers for fds: sleep until there is data to read or
+    // room to write, then move what fits. Return a byte count or -errno:
+    // -EAGAIN where `nonblock` would sleep; once the pair is destroyed
+    // reads return 0 (EOF) and writes -EIO.
+    long pty_read(int id, int master, void* buf, size_t len, int nonblock);
+    long pty_write(int id, int master, const void* buf, size_t len, int nonblock);
+
     // Push input keystroke into slave input buffer (used by keyboard/TTY).
     void pty_slave_push_input(int id, char c);
 
@@ -29,3 +42,12 @@ extern "C" {
     // Query mapping from VT index to pty id (-1 if none)
     int pty_vt_map_get(int vt_index);
 }
+
+#if defined(__cplusplus)
+#include <stdint.h>
+namespace hanacore { namespace sync { struct PollTable; } }
+
+// Readiness of one side of pair `id` (POLLIN / POLLOUT, POLLHUP once the
+// pair is gone). Every read, write and destroy wakes the pair's queue.
+uint32_t pty_poll(int id, bool master, hanacore::sync::PollTable* pt);
+#endif
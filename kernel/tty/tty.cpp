@@ -4,31 +4,58 @@
 
 extern "C" {
     void print(const char* s);
+    void print_n(const char* s, size_t len);
     char keyboard_poll_char(void);
+    int keyboard_pending(void);
 }
 
 #include "pty.hpp"
+#include "../sync/spinlock.hpp"
+#include "../sync/waitqueue.hpp"
+#include "../sync/poll.hpp"
+#include "../userland/errno.hpp"
+#include <string.h>
 
 // Small internal input buffer (not strictly necessary yet)
 static char input_buf[256];
 static unsigned input_read = 0;
 static unsigned input_write = 0;
 
+// Serialises producers (keyboard/IRQ) and consumers of input_buf.
+HANA_LOCK_CLASS(tty_input_class, "tty_input");
+static hanacore::sync::Spinlock input_lock = { 0, &tty_input_class, 0 };
+
+// Readers sleep here until the keyboard IRQ (or tty_enqueue_input) delivers
+// something.
+HANA_LOCK_CLASS(tty_wait_class, "tty_wait");
+static hanacore::sync::WaitQueue input_wait = { { 0, &tty_wait_class, 0 }, nullptr, nullptr };
+
+extern "C" void tty_input_notify(void) {
+    hanacore::sync::wake_up_all(&input_wait);
+}
+
 extern "C" void tty_init(void) {
+    hanacore::sync::SpinGuard g(&input_lock);
     input_read = input_write = 0;
 }
 
 // Enqueue a NUL-terminated string into the TTY input buffer. Called by
-// keyboard driver to inject sequences like "\x1b[A". It's safe to call
-// from IRQ/poll contexts in our simple kernel.
+// keyboard driver to inject sequences like "\x1b[A". Safe to call from
+// IRQ/poll contexts: the ring is protected by an IRQ-saving spinlock.
 extern "C" void tty_enqueue_input(const char* s) {
     if (!s) return;
-    const char* p = s;
-    while (*p) {
-        unsigned idx = input_write & (sizeof(input_buf) - 1);
-        input_buf[idx] = *p++;
-        ++input_write;
+    {
+        hanacore::sync::SpinGuard g(&input_lock);
+        const char* p = s;
+        while (*p) {
+            // Drop input rather than overwrite unread bytes when full
+            if (input_write - input_read >= sizeof(input_buf)) break;
+            unsigned idx = input_write & (sizeof(input_buf) - 1);
+            input_buf[idx] = *p++;
+            ++input_write;
+        }
     }
+    tty_input_notify();
 }
 
 // tty_write/tty_putc implemented further below (with VT buffering)
@@ -88,18 +115,23 @@ extern "C" void tty_switch_vt(int n) {
     }
 }
 
-// Append to active VT buffer and print if active
-static void vt_append(const char* s) {
-    if (!s) return;
-    // append bytes to buffer until NUL
-    const char* p = s;
-    while (*p) {
+// Append `len` bytes to the active VT buffer
+static void vt_append_n(const char* s, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
         unsigned h = vt_head[active_vt] & (TTY_BUF_SZ - 1);
-        vt_buf[active_vt][h] = *p++;
+        vt_buf[active_vt][h] = s[i];
         vt_head[active_vt]++;
     }
 }
 
+// Append to active VT buffer and print if active
+static void vt_append(const char* s) {
+    if (!s) return;
+    size_t len = 0;
+    while (s[len]) ++len;
+    vt_append_n(s, len);
+}
+
 extern "C" void tty_write(const char* s) {
     if (!s) return;
     vt_append(s);
@@ -107,6 +139,12 @@ extern "C" void tty_write(const char* s) {
     print(s);
 }
 
+extern "C" void tty_write_n(const char* s, size_t len) {
+    if (!s || len == 0) return;
+    vt_append_n(s, len);
+    print_n(s, len);
+}
+
 extern "C" void tty_putc(char c) {
     char tmp[2] = { c, '\0' };
     vt_append(tmp);
@@ -116,21 +154,226 @@ extern "C" void tty_putc(char c) {
 // Now define tty_poll_char with VT/PTY integration
 extern "C" char tty_poll_char(void) {
     // If we have buffered input, return it first
-    if (input_read != input_write) {
-        char c = input_buf[input_read & (sizeof(input_buf)-1)];
-        ++input_read;
-        return c;
+    {
+        hanacore::sync::SpinGuard g(&input_lock);
+        if (input_read != input_write) {
+            char c = input_buf[input_read & (sizeof(input_buf)-1)];
+            ++input_read;
+            return c;
+        }
     }
 
-    // Otherwise poll keyboard directly
-    char c = keyboard_poll_char();
-    if (!c) return 0;
+    // Otherwise translate pending scancodes; modifier keys yield nothing,
+    // so keep going until a character comes out or the queue is empty.
+    char c = 0;
+    while (!(c = keyboard_poll_char())) {
+        if (!keyboard_pending()) return 0;
+    }
 
     // Push into active VT buffer
-    vt_append((const char[]){c, '\0'});
+    char echo[2] = { c, '\0' };
+    vt_append(echo);
 
     // If an attached PTY slave exists for the active VT, push input to it
     int pid = pty_vt_map_get(active_vt);
     if (pid >= 0) pty_slave_push_input(pid, c);
     return c;
 }
+
+// ---------------------------------------------------------------------------
+// Line discipline. Input is cooked when a reader asks for it, in the
+// reader's task context; the keyboard IRQ only queues scancodes and wakes
+// input_wait. Kernel code is not preempted, so the state below only changes
+// between a reader's sleeps and needs no lock of its own.
+// ---------------------------------------------------------------------------
+
+#define TTY_LINE_MAX 256
+
+static struct tty_termios termios = {
+    ICRNL,                      // c_iflag
+    0,                          // c_oflag
+    0,                          // c_cflag
+    ISIG | ICANON | ECHO | ECHOE,
+    0,
+    // VINTR ^C, VQUIT ^\, VERASE (the keyboard sends \b), VKILL ^U,
+    // VEOF ^D, VTIME 0, VMIN 1
+    { 0x03, 0x1C, '\b', 0x15, 0x04, 0, 1 },
+};
+
+// Canonical mode: the line being edited and, once terminated by newline or
+// VEOF, the line being handed out (canon_pos bytes already returned).
+static char canon_buf[TTY_LINE_MAX];
+static unsigned canon_len = 0;
+static unsigned canon_pos = 0;
+static bool canon_ready = false;
+
+static void tty_echo(const char* s, size_t n) {
+    if (termios.c_lflag & ECHO) tty_write_n(s, n);
+}
+
+// A character pulled ahead by tty_poll() in raw mode, or -1.
+static int lookahead = -1;
+
+static char next_char() {
+    if (lookahead >= 0) {
+        char c = (char)lookahead;
+        lookahead = -1;
+        return c;
+    }
+    return tty_poll_char();
+}
+
+static char input_take() {
+    char c = next_char();
+    if (c == '\r' && (termios.c_iflag & ICRNL)) c = '\n';
+    return c;
+}
+
+// Feed one byte into the line being edited.
+static void canon_input(char c) {
+    const uint8_t* cc = termios.c_cc;
+    bool echoe = (termios.c_lflag & ECHOE) != 0;
+    if ((uint8_t)c == cc[VERASE] || c == 0x7F) {
+        if (canon_len) {
+            --canon_len;
+            if (echoe) tty_echo("\b \b", 3);
+        }
+    } else if ((uint8_t)c == cc[VKILL]) {
+        for (; canon_len; --canon_len)
+            if (echoe) tty_echo("\b \b", 3);
+    } else if ((uint8_t)c == cc[VEOF]) {
+        canon_ready = true;
+    } else if (c == '\n') {
+        // Always keep room for the terminator.
+        if (canon_len == TTY_LINE_MAX) --canon_len;
+        canon_buf[canon_len++] = '\n';
+        tty_echo("\n", 1);
+        canon_ready = true;
+    } else if (canon_len < TTY_LINE_MAX - 1) {
+        canon_buf[canon_len++] = c;
+        tty_echo(&c, 1);
+    }
+}
+
+// Cook available input until a line is complete. Returns canon_ready.
+static bool canon_pump() {
+    while (!canon_ready) {
+        char c = input_take();
+        if (!c) break;
+        canon_input(c);
+    }
+    return canon_ready;
+}
+
+static long canon_read(uint8_t* dst, size_t count, int nonblock) {
+    if (!canon_pump()) {
+        if (nonblock) return -EAGAIN;
+        hanacore::sync::wait_event(&input_wait, [] { return canon_pump(); });
+    }
+    // A VEOF on an empty line completes a zero-length line: read returns 0.
+    size_t n = canon_len - canon_pos;
+    if (n > count) n = count;
+    memcpy(dst, canon_buf + canon_pos, n);
+    canon_pos += n;
+    if (canon_pos >= canon_len) {
+        canon_len = canon_pos = 0;
+        canon_ready = false;
+    }
+    return (long)n;
+}
+
+// Non-canonical read with POSIX VMIN/VTIME semantics:
+//   MIN=0 TIME=0  return what is there
+//   MIN>0 TIME=0  block until MIN bytes
+//   MIN=0 TIME>0  wait up to TIME for the first byte
+//   MIN>0 TIME>0  block for the first byte, then stop once MIN bytes arrived
+//                 or TIME passed without a new byte
+static long raw_read(uint8_t* dst, size_t count, int nonblock) {
+    size_t got = 0;
+    // Bytes left from a line that was being edited when ICANON was cleared.
+    while (got < count && canon_pos < canon_len) dst[got++] = canon_buf[canon_pos++];
+    if (canon_pos >= canon_len) { canon_len = canon_pos = 0; canon_ready = false; }
+
+    auto pump = [&]() -> size_t {
+        while (got < count) {
+            char c = input_take();
+            if (!c) break;
+            tty_echo(&c, 1);
+            dst[got++] = (uint8_t)c;
+        }
+        return got;
+    };
+    pump();
+    if (nonblock) return got ? (long)got : -EAGAIN;
+
+    size_t vmin = termios.c_cc[VMIN];
+    uint64_t vtime_ns = (uint64_t)termios.c_cc[VTIME] * 100000000ULL;
+    size_t want = vmin < count ? vmin : count;
+
+    if (vtime_ns == 0) {
+        if (got < want) hanacore::sync::wait_event(&input_wait, [&] { return pump() >= want; });
+        return (long)got;
+    }
+    if (vmin == 0) {
+        if (!got) hanacore::sync::wait_event_timeout(&input_wait, [&] { return pump() > 0; }, vtime_ns);
+        return (long)got;
+    }
+    if (!got) hanacore::sync::wait_event(&input_wait, [&] { return pump() > 0; });
+    while (got < want) {
+        size_t before = got;
+        if (!hanacore::sync::wait_event_timeout(&input_wait, [&] { return pump() > before; }, vtime_ns))
+            break;
+    }
+    return (long)got;
+}
+
+extern "C" long tty_read(void* buf, size_t count, int nonblock) {
+    if (count == 0) return 0;
+    if (!buf) return -EFAULT;
+    uint8_t* dst = (uint8_t*)buf;
+    if (termios.c_lflag & ICANON) return canon_read(dst, count, nonblock);
+    return raw_read(dst, count, nonblock);
+}
+
+extern "C" char tty_getchar(void) {
+    char c = 0;
+    hanacore::sync::wait_event(&input_wait, [&] { return (c = next_char()) != 0; });
+    return c;
+}
+
+extern "C" void tty_tcgetattr(struct tty_termios* t) {
+    if (t) *t = termios;
+}
+
+extern "C" void tty_tcsetattr(const struct tty_termios* t, int when) {
+    if (!t) return;
+    // Output is written synchronously, so "after output drains" is now.
+    if (when == 2) {
+        {
+            hanacore::sync::SpinGuard g(&input_lock);
+            input_read = input_write;
+        }
+        while (keyboard_pending()) (void)keyboard_poll_char();
+        lookahead = -1;
+        canon_len = canon_pos = 0;
+        canon_ready = false;
+    }
+    termios = *t;
+}
+
+uint32_t tty_poll(hanacore::sync::PollTable* pt) {
+    hanacore::sync::poll_wait(pt, &input_wait);
+    uint32_t mask = POLLOUT | POLLWRNORM;
+    bool readable;
+    if (termios.c_lflag & ICANON) {
+        readable = canon_pump();
+    } else {
+        if (lookahead < 0) {
+            char c = tty_poll_char();
+            if (c) lookahead = (uint8_t)c;
+        }
+        readable = lookahead >= 0 || canon_pos < canon_len;
+    }
+    if (readable) mask |= POLLIN | POLLRDNORM;
+    return mask;
+}
@@ -1,5 +1,37 @@
 // Minimal TTY abstraction layer
 #pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Linux kernel struct termios (what TCGETS/TCSETS copy). Only the flags
+// below are interpreted; the rest are stored and reported back.
+#define TTY_NCCS 19
+struct tty_termios {
+    uint32_t c_iflag;
+    uint32_t c_oflag;
+    uint32_t c_cflag;
+    uint32_t c_lflag;
+    uint8_t c_line;
+    uint8_t c_cc[TTY_NCCS];
+};
+
+#ifndef ICANON
+// c_cc indices
+#define VINTR  0
+#define VQUIT  1
+#define VERASE 2
+#define VKILL  3
+#define VEOF   4
+#define VTIME  5
+#define VMIN   6
+// c_iflag
+#define ICRNL  0x100
+// c_lflag
+#define ISIG   0x1
+#define ICANON 0x2
+#define ECHO   0x8
+#define ECHOE  0x10
+#endif
 
 extern "C" {
     // Initialize TTY subsystem (optional)
@@ -8,6 +40,9 @@ extern "C" {
     // Write a NUL-terminated string to the TTY
     void tty_write(const char* s);
 
+    // Write exactly `len` bytes (no NUL terminator needed)
+    void tty_write_n(const char* s, size_t len);
+
     // Write a single character to the TTY
     void tty_putc(char c);
 
@@ -22,9 +57,32 @@ extern "C" {
     // Switch to virtual terminal number (1..12). If n is out of range,
     // the call is ignored.
     void tty_switch_vt(int n);
+
+    // Wake tasks sleeping for TTY input (called from the keyboard IRQ).
+    void tty_input_notify(void);
+
+    // Block until a raw input character arrives and return it (no echo, no
+    // line editing). Used by the in-kernel console.
+    char tty_getchar(void);
+
+    // read(2) on the console: applies the termios line discipline
+    // (canonical line editing or VMIN/VTIME raw reads) and sleeps until
+    // input arrives unless `nonblock`. Returns a byte count or -errno.
+    long tty_read(void* buf, size_t count, int nonblock);
+
+    // TCGETS / TCSETS. `when` is 0 (now), 1 (after output drains) or 2
+    // (also discard pending input), i.e. TCSETS, TCSETSW, TCSETSF.
+    void tty_tcgetattr(struct tty_termios* t);
+    void tty_tcsetattr(const struct tty_termios* t, int when);
 }
 
 #if defined(__cplusplus)
+namespace hanacore { namespace sync { struct PollTable; } }
+
+// Console readiness for poll/epoll: POLLIN once a read would not block
+// (a complete line in canonical mode), POLLOUT always.
+uint32_t tty_poll(hanacore::sync::PollTable* pt);
+
 namespace hanacore { namespace tty {
     void tty_init();
     void tty_write(const char* s);
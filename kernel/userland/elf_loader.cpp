@@ -44,6 +44,8 @@ struct Elf64_Phdr {
 #define ELFMAG2 'L'
 #define ELFMAG3 'F'
 #define PT_LOAD 1
+#define PT_PHDR 6
+#define PF_W 2
 
 static inline bool is_valid_elf64(const Elf64_Ehdr* eh) {
     return eh->e_ident[EI_MAG0] == ELFMAG0 &&
@@ -52,26 +54,27 @@ static inline bool is_valid_elf64(const Elf64_Ehdr* eh) {
            eh->e_ident[EI_MAG3] == ELFMAG3;
 }
 
-void* elf64_load_from_memory(const void* data, size_t size) {
-    if (!data || size < sizeof(Elf64_Ehdr))
-        return nullptr;
+bool elf64_parse_layout(const void* data, size_t size, struct ElfLayout* out) {
+    if (!data || !out || size < sizeof(Elf64_Ehdr))
+        return false;
 
     const auto* eh = reinterpret_cast<const Elf64_Ehdr*>(data);
     if (!is_valid_elf64(eh))
-        return nullptr;
+        return false;
 
     if (eh->e_phoff == 0 || eh->e_phnum == 0)
-        return nullptr;
+        return false;
 
     // Ensure program header table fits within blob
     const size_t ph_table_end = eh->e_phoff + (size_t)eh->e_phnum * eh->e_phentsize;
     if (ph_table_end > size)
-        return nullptr;
+        return false;
 
     const uint8_t* base = static_cast<const uint8_t*>(data);
 
     uint64_t min_vaddr = UINT64_MAX;
     uint64_t max_vaddr = 0;
+    int nseg = 0;
 
     // Calculate memory span of all PT_LOAD segments
     for (uint16_t i = 0; i < eh->e_phnum; ++i) {
@@ -79,6 +82,12 @@ void* elf64_load_from_memory(const void* data, size_t size) {
         if (ph->p_type != PT_LOAD)
             continue;
 
+        if (ph->p_offset + ph->p_filesz > size || ph->p_filesz > ph->p_memsz)
+            return false;
+        if (nseg == ELF_MAX_LOAD_SEGMENTS)
+            return false;
+        ++nseg;
+
         if (ph->p_vaddr < min_vaddr)
             min_vaddr = ph->p_vaddr;
         if (ph->p_vaddr + ph->p_memsz > max_vaddr)
@@ -86,48 +95,85 @@ void* elf64_load_from_memory(const void* data, size_t size) {
     }
 
     if (min_vaddr == UINT64_MAX || max_vaddr <= min_vaddr)
-        return nullptr;
+        return false;
 
     const uint64_t total_size = max_vaddr - min_vaddr;
 
     // Avoid absurd allocations
     constexpr uint64_t MAX_USER_IMAGE = 64ull * 1024ull * 1024ull;
     if (total_size == 0 || total_size > MAX_USER_IMAGE)
-        return nullptr;
+        return false;
 
-    // Allocate aligned region
-    void* mem = bump_alloc_alloc((size_t)total_size, 0x1000);
-    if (!mem)
-        return nullptr;
-
-    memset(mem, 0, (size_t)total_size);
-
-    // Load all PT_LOAD segments
+    // Entry point must lie inside the image
+    if (eh->e_entry < min_vaddr || eh->e_entry >= max_vaddr)
+        return false;
+
+    out->span = total_size;
+    out->entry_off = eh->e_entry - min_vaddr;
+    out->phnum = eh->e_phnum;
+    out->phentsize = eh->e_phentsize;
+    out->nseg = 0;
+    // Locate the program headers inside the loaded image: PT_PHDR if
+    // present, else the PT_LOAD whose file range covers e_phoff.
+    out->phdr_off = UINT64_MAX;
+    bool have_pt_phdr = false;
     for (uint16_t i = 0; i < eh->e_phnum; ++i) {
         const auto* ph = reinterpret_cast<const Elf64_Phdr*>(base + eh->e_phoff + i * eh->e_phentsize);
+        if (ph->p_type == PT_PHDR && ph->p_vaddr >= min_vaddr) {
+            out->phdr_off = ph->p_vaddr - min_vaddr;
+            have_pt_phdr = true;
+        }
         if (ph->p_type != PT_LOAD)
             continue;
+        ElfSegment* seg = &out->seg[out->nseg++];
+        seg->file_off = ph->p_offset;
+        seg->filesz = ph->p_filesz;
+        seg->memsz = ph->p_memsz;
+        seg->mem_off = ph->p_vaddr - min_vaddr;
+        seg->writable = (ph->p_flags & PF_W) != 0;
+        if (!have_pt_phdr && out->phdr_off == UINT64_MAX && eh->e_phoff >= ph->p_offset &&
+            ph_table_end <= ph->p_offset + ph->p_filesz)
+            out->phdr_off = seg->mem_off + (eh->e_phoff - ph->p_offset);
+    }
+    return true;
+}
 
-        if (ph->p_offset + ph->p_filesz > size)
-            return nullptr;
-
-        uintptr_t dest = reinterpret_cast<uintptr_t>(mem) + (ph->p_vaddr - min_vaddr);
-
-        if ((dest + ph->p_filesz) > (uintptr_t)mem + total_size)
-            return nullptr;
-
-        memcpy(reinterpret_cast<void*>(dest), base + ph->p_offset, (size_t)ph->p_filesz);
+void elf64_copy_segments(const void* data, const struct ElfLayout* layout, void* mem) {
+    const uint8_t* base = static_cast<const uint8_t*>(data);
+    memset(mem, 0, (size_t)layout->span);
+    for (int i = 0; i < layout->nseg; ++i) {
+        const ElfSegment* seg = &layout->seg[i];
+        memcpy(static_cast<uint8_t*>(mem) + seg->mem_off, base + seg->file_off, (size_t)seg->filesz);
         // rest is already zeroed
     }
+}
 
-    // Compute relocated entry point
-    if (eh->e_entry < min_vaddr || eh->e_entry >= max_vaddr)
-        return nullptr;
+void elf64_image_info(const struct ElfLayout* layout, void* mem, struct ElfImageInfo* info) {
+    const uintptr_t m = reinterpret_cast<uintptr_t>(mem);
+    info->entry = reinterpret_cast<void*>(m + layout->entry_off);
+    info->phdr = layout->phdr_off == UINT64_MAX ? 0 : m + layout->phdr_off;
+    info->phnum = layout->phnum;
+    info->phentsize = layout->phentsize;
+}
 
-    void* entry = reinterpret_cast<void*>((uintptr_t)mem + (eh->e_entry - min_vaddr));
+void* elf64_load_from_memory(const void* data, size_t size) {
+    return elf64_load_image(data, size, nullptr);
+}
 
-    if ((uintptr_t)entry < (uintptr_t)mem || (uintptr_t)entry >= (uintptr_t)mem + total_size)
+void* elf64_load_image(const void* data, size_t size, struct ElfImageInfo* info) {
+    ElfLayout layout;
+    if (!elf64_parse_layout(data, size, &layout))
         return nullptr;
 
-    return entry;
+    // Allocate aligned region
+    void* mem = bump_alloc_alloc((size_t)layout.span, 0x1000);
+    if (!mem)
+        return nullptr;
+
+    elf64_copy_segments(data, &layout, mem);
+
+    ElfImageInfo tmp;
+    if (!info) info = &tmp;
+    elf64_image_info(&layout, mem, info);
+    return info->entry;
 }
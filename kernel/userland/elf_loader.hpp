@@ -11,6 +11,48 @@ extern "C" {
 // entry point pointer (callable as void(*)(void)). Returns NULL on error.
 void* elf64_load_from_memory(const void* data, size_t size);
 
+// What the process start-up code needs to know about a loaded image
+// (passed to it through the auxiliary vector).
+struct ElfImageInfo {
+	void* entry;           // relocated entry point
+	uintptr_t phdr;        // program headers in the loaded image, 0 if not loaded
+	uint16_t phnum;
+	uint16_t phentsize;
+};
+
+#define ELF_MAX_LOAD_SEGMENTS 16
+
+// One PT_LOAD segment, with addresses relative to the start of the image.
+struct ElfSegment {
+	uint64_t file_off;
+	uint64_t filesz;
+	uint64_t memsz;
+	uint64_t mem_off;
+	bool writable;
+};
+
+// Parsed and validated program headers: everything needed to instantiate
+// the image again without re-reading the ELF headers.
+struct ElfLayout {
+	uint64_t span;         // bytes from the lowest to the highest PT_LOAD address
+	uint64_t entry_off;
+	uint64_t phdr_off;     // UINT64_MAX if the headers are not in a segment
+	uint16_t phnum;
+	uint16_t phentsize;
+	int nseg;
+	struct ElfSegment seg[ELF_MAX_LOAD_SEGMENTS];
+};
+
+// Validate the ELF in (data,size) and describe its PT_LOAD segments.
+bool elf64_parse_layout(const void* data, size_t size, struct ElfLayout* out);
+// Zero `mem` (layout->span bytes) and copy the segments' file bytes in.
+void elf64_copy_segments(const void* data, const struct ElfLayout* layout, void* mem);
+// Describe an image instantiated at `mem`.
+void elf64_image_info(const struct ElfLayout* layout, void* mem, struct ElfImageInfo* info);
+
+// As elf64_load_from_memory, and describe the result in *info (optional).
+void* elf64_load_image(const void* data, size_t size, struct ElfImageInfo* info);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,85 @@
+// Linux errno values. Syscall handlers return them negated (-ENOENT, ...),
+// which is what musl and other Linux-targeted userland expect.
+#pragma once
+
+#ifndef EPERM
+#define EPERM 1
+#endif
+#ifndef ENOENT
+#define ENOENT 2
+#endif
+#ifndef ESRCH
+#define ESRCH 3
+#endif
+#ifndef EINTR
+#define EINTR 4
+#endif
+#ifndef EIO
+#define EIO 5
+#endif
+#ifndef E2BIG
+#define E2BIG 7
+#endif
+#ifndef ENOEXEC
+#define ENOEXEC 8
+#endif
+#ifndef EBADF
+#define EBADF 9
+#endif
+#ifndef ECHILD
+#define ECHILD 10
+#endif
+#ifndef EAGAIN
+#define EAGAIN 11
+#endif
+#ifndef ENOMEM
+#define ENOMEM 12
+#endif
+#ifndef EFAULT
+#define EFAULT 14
+#endif
+#ifndef EBUSY
+#define EBUSY 16
+#endif
+#ifndef EEXIST
+#define EEXIST 17
+#endif
+#ifndef ENOTDIR
+#define ENOTDIR 20
+#endif
+#ifndef EISDIR
+#define EISDIR 21
+#endif
+#ifndef EINVAL
+#define EINVAL 22
+#endif
+#ifndef EMFILE
+#define EMFILE 24
+#endif
+#ifndef ENOTTY
+#define ENOTTY 25
+#endif
+#ifndef ENOSPC
+#define ENOSPC 28
+#endif
+#ifndef ESPIPE
+#define ESPIPE 29
+#endif
+#ifndef EPIPE
+#define EPIPE 32
+#endif
+#ifndef ERANGE
+#define ERANGE 34
+#endif
+#ifndef ENOSYS
+#define ENOSYS 38
+#endif
+#ifndef ENOTEMPTY
+#define ENOTEMPTY 39
+#endif
+#ifndef ETIMEDOUT
+#define ETIMEDOUT 110
+#endif
+#ifndef ECANCELED
+#define ECANCELED 125
+#endif
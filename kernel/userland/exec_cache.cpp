@@ -0,0 +1,277 @@
+#include "exec_cache.hpp"
+#include "errno.hpp"
+#include "../filesystem/vfs.hpp"
+#include "../api/hanaapi.h"
+#include "../mem/heap.hpp"
+#include "../sync/spinlock.hpp"
+#include "../utils/logger.hpp"
+#include <string.h>
+
+namespace hanacore { namespace userland {
+
+    using hanacore::sync::Spinlock;
+    using hanacore::sync::SpinGuard;
+
+    HANA_LOCK_CLASS(exec_cache_class, "exec_cache");
+
+    // Cached images beyond this are evicted (least recently launched first)
+    // once none of their instances is running.
+    static constexpr int EXEC_CACHE_MAX = 16;
+    static constexpr size_t EXEC_IMAGE_ALIGN = 0x1000;
+
+    struct ExecImage;
+
+    struct ExecInstance {
+        ExecImage* image;
+        void* raw;              // kmalloc block holding mem
+        uint8_t* mem;           // page-aligned image; null while being filled
+        int users;              // processes running this copy
+        ExecInstance* next;
+    };
+
+    struct ExecImage {
+        char* path;
+        uint64_t ino;
+        uint64_t size;
+        uint64_t mtime_ns;
+        ElfLayout layout;
+        bool writable;          // has a writable segment
+        void* raw;
+        uint8_t* pristine;      // segments as loaded from the file
+        ExecInstance* instances;
+        uint64_t last_use;
+        ExecImage* next;
+    };
+
+    static Spinlock cache_lock = { 0, &exec_cache_class, 0 };
+    static ExecImage* images = nullptr;         // current versions
+    static ExecImage* stale_images = nullptr;   // replaced or evicted, still running
+    static int image_count = 0;
+    static uint64_t use_clock = 0;
+
+    static uint8_t* alloc_aligned(size_t size, void** raw) {
+        *raw = hanacore::mem::kmalloc(size + EXEC_IMAGE_ALIGN);
+        if (!*raw) return nullptr;
+        uintptr_t p = ((uintptr_t)*raw + EXEC_IMAGE_ALIGN - 1) & ~(uintptr_t)(EXEC_IMAGE_ALIGN - 1);
+        return (uint8_t*)p;
+    }
+
+    // Caller holds cache_lock.
+    static bool image_busy(const ExecImage* img) {
+        for (const ExecInstance* in = img->instances; in; in = in->next)
+            if (in->users > 0) return true;
+        return false;
+    }
+
+    static void free_image(ExecImage* img) {
+        ExecInstance* in = img->instances;
+        while (in) {
+            ExecInstance* next = in->next;
+            hanacore::mem::kfree(in->raw);
+            hanacore::mem::kfree(in);
+            in = next;
+        }
+        hanacore::mem::kfree(img->raw);
+        hanacore::mem::kfree(img->path);
+        hanacore::mem::kfree(img);
+    }
+
+    static void unlink_image(ExecImage** list, ExecImage* img) {
+        for (ExecImage** pp = list; *pp; pp = &(*pp)->next) {
+            if (*pp == img) { *pp = img->next; img->next = nullptr; return; }
+        }
+    }
+
+    // Free stale images nobody runs any more, and evict idle images while
+    // the cache is over its size.
+    static void reclaim() {
+        ExecImage* dead = nullptr;
+        {
+            SpinGuard g(&cache_lock);
+            ExecImage** pp = &stale_images;
+            while (*pp) {
+                ExecImage* img = *pp;
+                if (image_busy(img)) { pp = &img->next; continue; }
+                *pp = img->next;
+                img->next = dead;
+                dead = img;
+            }
+            while (image_count > EXEC_CACHE_MAX) {
+                ExecImage* lru = nullptr;
+                for (ExecImage* img = images; img; img = img->next)
+                    if (!image_busy(img) && (!lru || img->last_use < lru->last_use)) lru = img;
+                if (!lru) break;
+                unlink_image(&images, lru);
+                --image_count;
+                lru->next = dead;
+                dead = lru;
+            }
+        }
+        while (dead) {
+            ExecImage* next = dead->next;
+            free_image(dead);
+            dead = next;
+        }
+    }
+
+    // Put the writable segments of a reused instance back to their
+    // as-loaded state (data from the file, bss zeroed).
+    static void restore_writable(const ExecImage* img, ExecInstance* in) {
+        for (int i = 0; i < img->layout.nseg; ++i) {
+            const ElfSegment* seg = &img->layout.seg[i];
+            if (!seg->writable) continue;
+            memcpy(in->mem + seg->mem_off, img->pristine + seg->mem_off, (size_t)seg->memsz);
+        }
+    }
+
+    static int64_t load_uncached(const char* path, struct ElfImageInfo* info) {
+        size_t len = 0;
+        void* data = hanacore::fs::get_file_alloc(path, &len);
+        if (!data) return -ENOENT;
+        void* entry = len ? elf64_load_image(data, len, info) : nullptr;
+        hanacore::mem::kfree(data);
+        return entry ? 0 : -ENOEXEC;
+    }
+
+    // Read and parse `path` into a new cache image with one claimed
+    // instance. Returns the instance or nullptr with *err set.
+    static ExecInstance* load_image(const char* path, const struct hana_stat* st, int64_t* err) {
+        size_t len = 0;
+        void* data = hanacore::fs::get_file_alloc(path, &len);
+        if (!data) { *err = -ENOENT; return nullptr; }
+
+        ExecImage* img = (ExecImage*)hanacore::mem::kmalloc(sizeof(ExecImage));
+        ExecInstance* in = (ExecInstance*)hanacore::mem::kmalloc(sizeof(ExecInstance));
+        if (!img || !in) {
+            hanacore::mem::kfree(data); hanacore::mem::kfree(img); hanacore::mem::kfree(in);
+            *err = -ENOMEM;
+            return nullptr;
+        }
+        memset(img, 0, sizeof(*img));
+        memset(in, 0, sizeof(*in));
+
+        if (!len || !elf64_parse_layout(data, len, &img->layout)) {
+            hanacore::mem::kfree(data); hanacore::mem::kfree(img); hanacore::mem::kfree(in);
+            *err = -ENOEXEC;
+            return nullptr;
+        }
+        size_t span = (size_t)img->layout.span;
+        img->pristine = alloc_aligned(span, &img->raw);
+        in->mem = alloc_aligned(span, &in->raw);
+        img->path = (char*)hanacore::mem::kmalloc(strlen(path) + 1);
+        if (!img->pristine || !in->mem || !img->path) {
+            hanacore::mem::kfree(data);
+            hanacore::mem::kfree(in->raw); hanacore::mem::kfree(in);
+            hanacore::mem::kfree(img->raw); hanacore::mem::kfree(img->path); hanacore::mem::kfree(img);
+            *err = -ENOMEM;
+            return nullptr;
+        }
+        strcpy(img->path, path);
+        img->ino = st->st_ino;
+        img->size = st->st_size;
+        img->mtime_ns = st->st_mtime_ns;
+        for (int i = 0; i < img->layout.nseg; ++i)
+            if (img->layout.seg[i].writable) img->writable = true;
+
+        elf64_copy_segments(data, &img->layout, img->pristine);
+        hanacore::mem::kfree(data);
+        memcpy(in->mem, img->pristine, span);
+
+        in->image = img;
+        in->users = 1;
+        img->instances = in;
+        {
+            SpinGuard g(&cache_lock);
+            img->last_use = ++use_clock;
+            img->next = images;
+            images = img;
+            ++image_count;
+        }
+        log_info("exec_cache: cached %s (%d segments, %d bytes)", path, img->layout.nseg, (int)span);
+        return in;
+    }
+
+    int64_t exec_image_get(const char* path, struct ElfImageInfo* info, ExecInstance** inst) {
+        if (!path || !info || !inst) return -EFAULT;
+        *inst = nullptr;
+
+        struct hana_stat st;
+        if (hanacore::fs::stat(path, &st) != 0 || st.st_ino == 0)
+            return load_uncached(path, info);
+        if (st.st_mode & 0x4000) return -EISDIR;
+
+        reclaim();
+
+        // Allocated up front so a new instance can be linked (and so keep
+        // the image alive) before its memory is filled outside the lock.
+        ExecInstance* spare = (ExecInstance*)hanacore::mem::kmalloc(sizeof(ExecInstance));
+        if (!spare) return -ENOMEM;
+        memset(spare, 0, sizeof(*spare));
+
+        ExecImage* img = nullptr;
+        ExecInstance* in = nullptr;
+        bool fresh = false;
+        {
+            SpinGuard g(&cache_lock);
+            for (img = images; img; img = img->next)
+                if (strcmp(img->path, path) == 0) break;
+            if (img && (img->ino != st.st_ino || img->size != st.st_size ||
+                        img->mtime_ns != st.st_mtime_ns)) {
+                // The file changed: the old version lives on for the
+                // processes still running it.
+                unlink_image(&images, img);
+                --image_count;
+                img->next = stale_images;
+                stale_images = img;
+                img = nullptr;
+            }
+            if (img) {
+                img->last_use = ++use_clock;
+                for (ExecInstance* c = img->instances; c; c = c->next) {
+                    // Read-only images are shared; otherwise take an idle copy.
+                    if (c->mem && (!img->writable || c->users == 0)) { in = c; break; }
+                }
+                if (in) {
+                    ++in->users;
+                } else {
+                    in = spare;
+                    spare = nullptr;
+                    in->image = img;
+                    in->users = 1;
+                    in->next = img->instances;
+                    img->instances = in;
+                    fresh = true;
+                }
+            }
+        }
+        if (spare) hanacore::mem::kfree(spare);
+
+        if (!img) {
+            int64_t err = 0;
+            in = load_image(path, &st, &err);
+            if (!in) return err;
+            img = in->image;
+        } else if (fresh) {
+            uint8_t* mem = alloc_aligned((size_t)img->layout.span, &in->raw);
+            if (!mem) {
+                exec_instance_put(in);  // reclaimed with the image
+                return -ENOMEM;
+            }
+            memcpy(mem, img->pristine, (size_t)img->layout.span);
+            in->mem = mem;
+        } else if (img->writable) {
+            restore_writable(img, in);
+        }
+
+        elf64_image_info(&img->layout, in->mem, info);
+        *inst = in;
+        return 0;
+    }
+
+    void exec_instance_put(ExecInstance* inst) {
+        if (!inst) return;
+        SpinGuard g(&cache_lock);
+        if (inst->users > 0) --inst->users;
+    }
+
+}} // namespace hanacore::userland
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include "elf_loader.hpp"
+
+// Cache of parsed executable images, keyed by path and file version
+// (HanaFS inode number, size and mtime). A cached image keeps its parsed
+// program headers and a pristine copy of the loaded segments, so launching
+// it again needs neither the file read nor the ELF parse.
+//
+// There is no per-process address space yet: each running process needs
+// its own instance of the image, text included, because its code reaches
+// its data at a fixed distance. An instance whose process has exited is
+// reused by the next launch, which then only restores the writable
+// segments from the pristine copy; read-only segments are left as they
+// are. Images without writable segments share one instance between all
+// their processes.
+
+namespace hanacore { namespace userland {
+
+    struct ExecInstance;
+
+    // Load `path` for a new process. On success fills *info and returns 0;
+    // *inst is the instance to release with exec_instance_put when the
+    // process is gone (nullptr for files that cannot be cached, e.g. on
+    // filesystems without a file version). Returns -errno on failure.
+    int64_t exec_image_get(const char* path, struct ElfImageInfo* info, ExecInstance** inst);
+
+    // The process running `inst` is gone. Safe from any context (the
+    // scheduler calls it while reaping with its lock held); memory is
+    // reclaimed by later exec_image_get calls.
+    void exec_instance_put(ExecInstance* inst);
+
+}} // namespace hanacore::userland
@@ -1,43 +1,190 @@
 #include "fdtable.hpp"
+#include "errno.hpp"
 #include "../mem/heap.hpp"
+#include "../utils/logger.hpp"
 #include <string.h>
 
-extern "C" struct FDEntry* fdtable_create(int count) {
-    if (count <= 0) return NULL;
-    struct FDEntry* tbl = (struct FDEntry*)hanacore::mem::kmalloc(sizeof(struct FDEntry) * (size_t)count);
-    if (!tbl) return NULL;
-    for (int i = 0; i < count; ++i) {
-        tbl[i].type = FD_NONE;
-        tbl[i].path = NULL;
-        tbl[i].buf = NULL;
-        tbl[i].len = 0;
-        tbl[i].pos = 0;
-        tbl[i].flags = 0;
-        tbl[i].pipe_obj = NULL;
+static constexpr int FDTABLE_INITIAL = FDTABLE_CHUNK;
+
+static inline int words_for(int slots) { return slots / 64; }
+static inline int summary_words_for(int slots) { return (words_for(slots) + 63) / 64; }
+
+static void set_open_bit(struct FDTable* t, int fd) {
+    int w = fd / 64;
+    t->open_bits[w] |= 1ULL << (fd % 64);
+    if (t->open_bits[w] == ~0ULL) t->full_bits[w / 64] |= 1ULL << (w % 64);
+}
+
+static void clear_open_bit(struct FDTable* t, int fd) {
+    int w = fd / 64;
+    t->open_bits[w] &= ~(1ULL << (fd % 64));
+    t->full_bits[w / 64] &= ~(1ULL << (w % 64));
+}
+
+// Lowest free slot >= minfd; at or past t->count if the table must grow.
+static int find_free(const struct FDTable* t, int minfd) {
+    int nwords = words_for(t->count);
+    int w = minfd / 64;
+    if (w >= nwords) return minfd;
+    uint64_t bits = t->open_bits[w] | ((1ULL << (minfd % 64)) - 1);
+    if (~bits) return w * 64 + __builtin_ctzll(~bits);
+    // Skip whole words through the summary.
+    int first = w + 1;
+    for (int s = first / 64; s < summary_words_for(t->count); ++s) {
+        uint64_t sum = t->full_bits[s];
+        if (s == first / 64) sum |= (1ULL << (first % 64)) - 1;
+        if (!~sum) continue;
+        int word = s * 64 + __builtin_ctzll(~sum);
+        if (word >= nwords) break;
+        return word * 64 + __builtin_ctzll(~t->open_bits[word]);
     }
-    return tbl;
+    return t->count;
 }
 
-extern "C" void fdtable_destroy(struct FDEntry* table, int count) {
+// Grow to at least `slots` slots (doubling, capped at the hard limit).
+static bool grow(struct FDTable* t, int slots) {
+    if (slots <= t->count) return true;
+    int want = t->count ? t->count : FDTABLE_INITIAL;
+    while (want < slots) want *= 2;
+    int cap = (t->limit_max + FDTABLE_CHUNK - 1) / FDTABLE_CHUNK * FDTABLE_CHUNK;
+    if (want > cap) want = cap;
+    if (want < slots) return false;
+
+    int nchunks = want / FDTABLE_CHUNK;
+    int oldchunks = t->count / FDTABLE_CHUNK;
+    struct FDEntry** chunks = (struct FDEntry**)hanacore::mem::kmalloc(sizeof(struct FDEntry*) * nchunks);
+    uint64_t* open_bits = (uint64_t*)hanacore::mem::kmalloc(sizeof(uint64_t) * words_for(want));
+    uint64_t* full_bits = (uint64_t*)hanacore::mem::kmalloc(sizeof(uint64_t) * summary_words_for(want));
+    bool ok = chunks && open_bits && full_bits;
+    int filled = oldchunks;
+    for (; ok && filled < nchunks; ++filled) {
+        chunks[filled] = (struct FDEntry*)hanacore::mem::kmalloc(sizeof(struct FDEntry) * FDTABLE_CHUNK);
+        if (!chunks[filled]) ok = false;
+    }
+    if (!ok) {
+        for (int i = oldchunks; chunks && i < filled; ++i) hanacore::mem::kfree(chunks[i]);
+        hanacore::mem::kfree(chunks);
+        hanacore::mem::kfree(open_bits);
+        hanacore::mem::kfree(full_bits);
+        return false;
+    }
+
+    for (int i = oldchunks; i < nchunks; ++i) {
+        for (int j = 0; j < FDTABLE_CHUNK; ++j) {
+            chunks[i][j].type = FD_NONE;
+            chunks[i][j].fd_flags = 0;
+            chunks[i][j].file = NULL;
+        }
+    }
+    memset(open_bits, 0, sizeof(uint64_t) * words_for(want));
+    memset(full_bits, 0, sizeof(uint64_t) * summary_words_for(want));
+    if (t->count) {
+        memcpy(chunks, t->chunks, sizeof(struct FDEntry*) * oldchunks);
+        memcpy(open_bits, t->open_bits, sizeof(uint64_t) * words_for(t->count));
+        memcpy(full_bits, t->full_bits, sizeof(uint64_t) * summary_words_for(t->count));
+        hanacore::mem::kfree(t->chunks);
+        hanacore::mem::kfree(t->open_bits);
+        hanacore::mem::kfree(t->full_bits);
+    }
+    t->chunks = chunks;
+    t->open_bits = open_bits;
+    t->full_bits = full_bits;
+    t->count = want;
+    return true;
+}
+
+extern "C" struct FDTable* fdtable_create(void) {
+    struct FDTable* t = (struct FDTable*)hanacore::mem::kmalloc(sizeof(struct FDTable));
+    if (!t) return NULL;
+    memset(t, 0, sizeof(*t));
+    t->limit = FDTABLE_DEF_LIMIT;
+    t->limit_max = FDTABLE_DEF_MAX;
+    if (!grow(t, FDTABLE_INITIAL)) {
+        hanacore::mem::kfree(t);
+        return NULL;
+    }
+    return t;
+}
+
+extern "C" void fdtable_destroy(struct FDTable* table) {
     if (!table) return;
-    for (int i = 0; i < count; ++i) {
-        if (table[i].path) hanacore::mem::kfree(table[i].path);
-        if (table[i].buf) hanacore::mem::kfree(table[i].buf);
-        table[i].type = FD_NONE;
+    // Descriptions are released only through fileio_close_all/file_put,
+    // which may sleep; anything still installed here is leaked rather than
+    // half torn down.
+    int leaked = 0;
+    for (int i = 0; i < table->count; ++i) {
+        struct FDEntry* ent = &table->chunks[i / FDTABLE_CHUNK][i % FDTABLE_CHUNK];
+        if (ent->type != FD_NONE) ++leaked;
     }
+    if (leaked) log_fail("fdtable: destroying table with %d open descriptors", leaked);
+    for (int i = 0; i < table->count / FDTABLE_CHUNK; ++i) hanacore::mem::kfree(table->chunks[i]);
+    hanacore::mem::kfree(table->chunks);
+    hanacore::mem::kfree(table->open_bits);
+    hanacore::mem::kfree(table->full_bits);
     hanacore::mem::kfree(table);
 }
 
-extern "C" int fdtable_alloc_fd(struct FDEntry* table, int count) {
-    if (!table) return -1;
-    for (int i = 3; i < count; ++i) { // reserve 0/1/2 for stdio
-        if (table[i].type == FD_NONE) return i;
-    }
-    return -1;
+extern "C" int fdtable_alloc_fd(struct FDTable* table, int minfd) {
+    if (!table || minfd < 0) return -EINVAL;
+    if (minfd >= table->limit) return -EMFILE;
+    int fd = find_free(table, minfd);
+    if (fd >= table->limit) return -EMFILE;
+    if (fd >= table->count && !grow(table, fd + 1)) return -ENOMEM;
+    set_open_bit(table, fd);
+    return fd;
+}
+
+extern "C" int fdtable_reserve_fd(struct FDTable* table, int fd) {
+    if (!table || fd < 0 || fd >= table->limit) return -EBADF;
+    if (!grow(table, fd + 1)) return -ENOMEM;
+    set_open_bit(table, fd);
+    return 0;
+}
+
+extern "C" void fdtable_free_fd(struct FDTable* table, int fd) {
+    if (!table || fd < 0 || fd >= table->count) return;
+    clear_open_bit(table, fd);
 }
 
-extern "C" struct FDEntry* fdtable_get(struct FDEntry* table, int count, int fd) {
+extern "C" struct FDEntry* fdtable_get(struct FDTable* table, int fd) {
     if (!table) return NULL;
-    if (fd < 0 || fd >= count) return NULL;
-    return &table[fd];
+    if (fd < 0 || fd >= table->count) return NULL;
+    return &table->chunks[fd / FDTABLE_CHUNK][fd % FDTABLE_CHUNK];
+}
+
+extern "C" struct OpenFile* fdtable_install(struct FDEntry* ent, FDType type) {
+    if (!ent) return NULL;
+    struct OpenFile* f = (struct OpenFile*)hanacore::mem::kmalloc(sizeof(struct OpenFile));
+    if (!f) return NULL;
+    memset(f, 0, sizeof(*f));
+    f->refs = 1;
+    f->type = type;
+    f->pty_id = -1;
+    ent->type = type;
+    ent->fd_flags = 0;
+    ent->file = f;
+    return f;
+}
+
+extern "C" void fdtable_init_stdio(struct FDTable* table) {
+    if (!table || table->count < 3) return;
+    struct OpenFile* f = fdtable_install(fdtable_get(table, 0), FD_TTY);
+    if (!f) return;
+    set_open_bit(table, 0);
+    for (int i = 1; i < 3; ++i) {
+        struct FDEntry* ent = fdtable_get(table, i);
+        ent->type = FD_TTY;
+        ent->fd_flags = 0;
+        ent->file = f;
+        ++f->refs;
+        set_open_bit(table, i);
+    }
+}
+
+extern "C" int fdtable_set_limit(struct FDTable* table, uint64_t soft, uint64_t hard) {
+    if (!table) return -EINVAL;
+    if (soft > hard || hard > FDTABLE_NR_OPEN) return -EINVAL;
+    table->limit = (int)soft;
+    table->limit_max = (int)hard;
+    return 0;
 }
@@ -2,8 +2,7 @@
 #include <stdint.h>
 #include <stddef.h>
 
-// Simple FD table and types used by kernel syscalls. This is intentionally
-// small and minimal to support BusyBox-style file I/O backed by HanaFS.
+// Per-task FD table and types used by kernel syscalls.
 
 enum FDType {
     FD_NONE = 0,
@@ -11,20 +10,77 @@ enum FDType {
     FD_TTY,
     FD_PIPE_READ,
     FD_PIPE_WRITE,
+    FD_IORING,
+    FD_PTY_MASTER,
+    FD_PTY_SLAVE,
+    FD_EPOLL,
+    FD_DIR,
 };
 
-struct FDEntry {
+// An open file description: what open(), pipe() etc. create. dup(),
+// dup2() and spawn share it between descriptors, which then see the same
+// offset and status flags; it is released when the last one is closed.
+struct OpenFile {
+    int refs; // descriptors pointing here
     FDType type;
     char *path; // for FD_FILE, owned copy
-    uint8_t *buf; // in-memory buffer for file contents
-    size_t len; // length of buf
     size_t pos; // current file offset
     int flags; // open flags
-    void *pipe_obj; // placeholder for pipe implementation
+    void *pipe_obj; // FD_PIPE_READ / FD_PIPE_WRITE: the Pipe (pipe.hpp)
+    void *obj; // type-specific object (FD_IORING: the IoRing, FD_EPOLL: the Epoll,
+               // FD_FILE: the vfs_file, FD_DIR: the vfs_dir)
+    int pty_id; // FD_PTY_MASTER / FD_PTY_SLAVE: pair index
+};
+
+// Descriptor flags (fcntl F_GETFD / F_SETFD); per slot, not shared.
+#define FD_CLOEXEC 1
+
+struct FDEntry {
+    FDType type; // file->type while open, FD_NONE for a free slot
+    int fd_flags; // FD_CLOEXEC
+    struct OpenFile *file;
+};
+
+// Slots are kept in fixed chunks so an FDEntry never moves while the
+// table grows. open_bits has one bit per slot (set: open or reserved);
+// full_bits has one bit per open_bits word that is all ones, so the lowest
+// free slot is found with two find-first-zero steps.
+#define FDTABLE_CHUNK 64
+#define FDTABLE_NR_OPEN 65536       // ceiling for any RLIMIT_NOFILE
+#define FDTABLE_DEF_LIMIT 1024      // default soft RLIMIT_NOFILE
+#define FDTABLE_DEF_MAX 4096        // default hard RLIMIT_NOFILE
+#define FDTABLE_MIN_FD 3            // open(), pipe() etc. leave 0/1/2 to stdio
+
+struct FDTable {
+    int count;                  // slots allocated, a multiple of FDTABLE_CHUNK
+    int limit;                  // RLIMIT_NOFILE soft limit: new fds are below it
+    int limit_max;              // RLIMIT_NOFILE hard limit
+    struct FDEntry **chunks;    // count / FDTABLE_CHUNK chunks
+    uint64_t *open_bits;        // count / 64 words
+    uint64_t *full_bits;        // one bit per open_bits word
 };
 
-// Allocate per-task FD table with given size. Returns pointer or NULL.
-extern "C" struct FDEntry* fdtable_create(int count);
-extern "C" void fdtable_destroy(struct FDEntry* table, int count);
-extern "C" int fdtable_alloc_fd(struct FDEntry* table, int count);
-extern "C" struct FDEntry* fdtable_get(struct FDEntry* table, int count, int fd);
+// New table with stdio slots 0/1/2 free. Returns NULL if out of memory.
+extern "C" struct FDTable* fdtable_create(void);
+// Free the table itself. Runs under the scheduler lock, so it never releases
+// descriptions: every exit path closes them with fileio_close_all first.
+extern "C" void fdtable_destroy(struct FDTable* table);
+// Reserve the lowest free slot >= minfd, growing the table if needed.
+// The slot stays FD_NONE until installed; give it back with
+// fdtable_free_fd if unused. Returns the fd, -EMFILE or -ENOMEM.
+extern "C" int fdtable_alloc_fd(struct FDTable* table, int minfd);
+// Reserve slot `fd` itself (dup2, spawn file actions), growing the table
+// if needed. The caller closes whatever is open there first. Returns 0,
+// -EBADF if fd is outside the limit, or -ENOMEM.
+extern "C" int fdtable_reserve_fd(struct FDTable* table, int fd);
+// Mark a closed or unused slot free again.
+extern "C" void fdtable_free_fd(struct FDTable* table, int fd);
+extern "C" struct FDEntry* fdtable_get(struct FDTable* table, int fd);
+// Put a new open file description of `type` (one reference) in the
+// reserved slot `ent`. Returns it, or NULL if out of memory.
+extern "C" struct OpenFile* fdtable_install(struct FDEntry* ent, FDType type);
+// Give fds 0, 1 and 2 one shared description of the console.
+extern "C" void fdtable_init_stdio(struct FDTable* table);
+// Change RLIMIT_NOFILE. There are no users yet, so any task may raise
+// the hard limit up to FDTABLE_NR_OPEN. Returns 0 or -EINVAL.
+extern "C" int fdtable_set_limit(struct FDTable* table, uint64_t soft, uint64_t hard);
@@ -0,0 +1,563 @@
+#include "fileio.hpp"
+#include "ioring.hpp"
+#include "pipe.hpp"
+#include "poll.hpp"
+#include "errno.hpp"
+#include "../filesystem/vfs.hpp"
+#include "../mem/heap.hpp"
+#include "../tty/tty.hpp"
+#include "../tty/pty.hpp"
+#include <string.h>
+
+#ifndef O_CREAT
+#define O_CREAT 0x40
+#endif
+#ifndef O_TRUNC
+#define O_TRUNC 0x200
+#endif
+#ifndef O_APPEND
+#define O_APPEND 0x400
+#endif
+#ifndef O_NONBLOCK
+#define O_NONBLOCK 0x800
+#endif
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0x10000
+#endif
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0x80000
+#endif
+#ifndef SEEK_SET
+#define SEEK_SET 0
+#endif
+#ifndef SEEK_CUR
+#define SEEK_CUR 1
+#endif
+#ifndef SEEK_END
+#define SEEK_END 2
+#endif
+
+namespace hanacore { namespace userland {
+
+    // An FD_FILE description holds an open VFS file (f->obj); every read
+    // or write goes to the file at the description's offset. Writes are
+    // made durable on fsync and on the last close.
+    static struct vfs_file* file_handle(const struct OpenFile* f) {
+        return f && f->type == FD_FILE ? (struct vfs_file*)f->obj : NULL;
+    }
+
+    uint64_t fileio_size(const struct FDEntry* ent) {
+        if (!ent || !ent->file) return 0;
+        return vfs_file_size(file_handle(ent->file));
+    }
+
+    static bool ent_nonblock(const struct FDEntry* ent) {
+        return ent->file && (ent->file->flags & O_NONBLOCK);
+    }
+
+    static int64_t write_ent(struct FDEntry* ent, const void* buf, size_t count, bool nonblock) {
+        struct OpenFile* f = ent->file;
+        const uint8_t* src = (const uint8_t*)buf;
+
+        if (ent->type == FD_TTY) {
+            if (buf) tty_write_n((const char*)buf, count);
+            return count;
+        } else if (ent->type == FD_PTY_MASTER || ent->type == FD_PTY_SLAVE) {
+            return pty_write(f->pty_id, ent->type == FD_PTY_MASTER, buf, count, nonblock);
+        } else if (ent->type == FD_PIPE_WRITE) {
+            return pipe_write((Pipe*)f->pipe_obj, buf, count, nonblock);
+        } else if (ent->type == FD_FILE) {
+            struct vfs_file* vf = file_handle(f);
+            if (count && !src) return -EFAULT;
+            if (f->flags & O_APPEND) f->pos = (size_t)vfs_file_size(vf);
+            int64_t r = vfs_write_at(vf, f->pos, src, count);
+            if (r < 0) return -EIO;
+            f->pos += (size_t)r;
+            return r;
+        }
+        return -EBADF;
+    }
+
+    int64_t fileio_write(struct FDEntry* ent, const void* buf, size_t count) {
+        if (!ent) return -EBADF;
+        return write_ent(ent, buf, count, ent_nonblock(ent));
+    }
+
+    static int64_t read_ent(struct FDEntry* ent, void* buf, size_t count, bool nonblock) {
+        struct OpenFile* f = ent->file;
+        uint8_t* dst = (uint8_t*)buf;
+
+        if (ent->type == FD_FILE) {
+            if (count && !dst) return -EFAULT;
+            int64_t r = vfs_read_at(file_handle(f), f->pos, dst, count);
+            if (r < 0) return -EIO;
+            f->pos += (size_t)r;
+            return r;
+        } else if (ent->type == FD_PIPE_READ) {
+            return pipe_read((Pipe*)f->pipe_obj, buf, count, nonblock);
+        } else if (ent->type == FD_TTY) {
+            return tty_read(buf, count, nonblock);
+        } else if (ent->type == FD_PTY_MASTER || ent->type == FD_PTY_SLAVE) {
+            return pty_read(f->pty_id, ent->type == FD_PTY_MASTER, buf, count, nonblock);
+        } else if (ent->type == FD_DIR) {
+            return -EISDIR;
+        }
+        return -EBADF;
+    }
+
+    int64_t fileio_read(struct FDEntry* ent, void* buf, size_t count) {
+        if (!ent) return -EBADF;
+        return read_ent(ent, buf, count, ent_nonblock(ent));
+    }
+
+    int64_t fileio_read_nonblock(struct FDEntry* ent, void* buf, size_t count) {
+        if (!ent) return -EBADF;
+        return read_ent(ent, buf, count, true);
+    }
+
+    int64_t fileio_write_nonblock(struct FDEntry* ent, const void* buf, size_t count) {
+        if (!ent) return -EBADF;
+        return write_ent(ent, buf, count, true);
+    }
+
+    static int64_t iov_total(const struct IoVec* iov, int iovcnt, size_t* total) {
+        if (iovcnt < 0 || iovcnt > FILEIO_IOV_MAX) return -EINVAL;
+        if (iovcnt > 0 && !iov) return -EFAULT;
+        size_t sum = 0;
+        for (int i = 0; i < iovcnt; ++i) {
+            if (iov[i].iov_len > (size_t)INT64_MAX - sum) return -EINVAL;
+            sum += iov[i].iov_len;
+        }
+        *total = sum;
+        return 0;
+    }
+
+    int64_t fileio_readv(struct FDEntry* ent, const struct IoVec* iov, int iovcnt) {
+        size_t total = 0;
+        int64_t err = iov_total(iov, iovcnt, &total);
+        if (err < 0) return err;
+        if (!ent) return -EBADF;
+        int64_t done = 0;
+        for (int i = 0; i < iovcnt; ++i) {
+            if (iov[i].iov_len == 0) continue;
+            // Only the first transfer may sleep on a stream: once data has
+            // moved, the rest is whatever is already there.
+            bool nonblock = ent_nonblock(ent) || (done > 0 && ent->type != FD_FILE);
+            int64_t r = read_ent(ent, iov[i].iov_base, iov[i].iov_len, nonblock);
+            if (r < 0) return done ? done : r;
+            done += r;
+            if ((size_t)r < iov[i].iov_len) break;
+        }
+        return done;
+    }
+
+    int64_t fileio_writev(struct FDEntry* ent, const struct IoVec* iov, int iovcnt) {
+        size_t total = 0;
+        int64_t err = iov_total(iov, iovcnt, &total);
+        if (err < 0) return err;
+        if (!ent) return -EBADF;
+        int64_t done = 0;
+        for (int i = 0; i < iovcnt; ++i) {
+            if (iov[i].iov_len == 0) continue;
+            int64_t r = fileio_write(ent, iov[i].iov_base, iov[i].iov_len);
+            if (r < 0) return done ? done : r;
+            done += r;
+            if ((size_t)r < iov[i].iov_len) break;
+        }
+        return done;
+    }
+
+    // Positional I/O goes straight to the file at `off` and never touches
+    // the shared description's offset.
+    int64_t fileio_preadv(struct FDEntry* ent, const struct IoVec* iov, int iovcnt, uint64_t off) {
+        size_t total = 0;
+        int64_t err = iov_total(iov, iovcnt, &total);
+        if (err < 0) return err;
+        if (!ent || ent->type == FD_NONE) return -EBADF;
+        if (ent->type != FD_FILE) return -ESPIPE;
+        struct vfs_file* vf = file_handle(ent->file);
+        int64_t done = 0;
+        for (int i = 0; i < iovcnt; ++i) {
+            if (iov[i].iov_len == 0) continue;
+            if (!iov[i].iov_base) return done ? done : -EFAULT;
+            int64_t r = vfs_read_at(vf, off + (uint64_t)done, iov[i].iov_base, iov[i].iov_len);
+            if (r < 0) return done ? done : -EIO;
+            done += r;
+            if ((size_t)r < iov[i].iov_len) break;
+        }
+        return done;
+    }
+
+    int64_t fileio_pwritev(struct FDEntry* ent, const struct IoVec* iov, int iovcnt, uint64_t off) {
+        size_t total = 0;
+        int64_t err = iov_total(iov, iovcnt, &total);
+        if (err < 0) return err;
+        if (!ent || ent->type == FD_NONE) return -EBADF;
+        if (ent->type != FD_FILE) return -ESPIPE;
+        struct vfs_file* vf = file_handle(ent->file);
+        // As on Linux, O_APPEND wins over the offset.
+        if (ent->file->flags & O_APPEND) off = vfs_file_size(vf);
+        int64_t done = 0;
+        for (int i = 0; i < iovcnt; ++i) {
+            if (iov[i].iov_len == 0) continue;
+            if (!iov[i].iov_base) return done ? done : -EFAULT;
+            int64_t r = vfs_write_at(vf, off + (uint64_t)done, iov[i].iov_base, iov[i].iov_len);
+            if (r < 0) return done ? done : -EIO;
+            done += r;
+            if ((size_t)r < iov[i].iov_len) break;
+        }
+        return done;
+    }
+
+    // /dev/ptmx and /dev/pts/N. Returns 1 and fills `type`/`id` if `path`
+    // names a pty, 0 if it does not, or -errno.
+    static int64_t open_pty(const char* path, int* type, int* id) {
+        if (strcmp(path, "/dev/ptmx") == 0) {
+            int n = pty_create_pair();
+            if (n < 0) return -ENOSPC;
+            *type = FD_PTY_MASTER;
+            *id = n;
+            return 1;
+        }
+        if (strncmp(path, "/dev/pts/", 9) != 0) return 0;
+        const char* p = path + 9;
+        if (!*p) return -ENOENT;
+        int n = 0;
+        for (; *p; ++p) {
+            if (*p < '0' || *p > '9' || n > HANACORE_PTY_MAX) return -ENOENT;
+            n = n * 10 + (*p - '0');
+        }
+        if (!pty_is_open(n)) return -ENOENT;
+        *type = FD_PTY_SLAVE;
+        *id = n;
+        return 1;
+    }
+
+    int64_t fileio_pread(struct FDEntry* ent, void* buf, size_t count, uint64_t off) {
+        if (!ent || ent->type == FD_NONE) return -EBADF;
+        if (ent->type != FD_FILE) return -ESPIPE;
+        if (count && !buf) return -EFAULT;
+        int64_t r = vfs_read_at(file_handle(ent->file), off, buf, count);
+        return r < 0 ? -EIO : r;
+    }
+
+    int64_t fileio_pwrite(struct FDEntry* ent, const void* buf, size_t count, uint64_t off) {
+        if (!ent || ent->type == FD_NONE) return -EBADF;
+        if (ent->type != FD_FILE) return -ESPIPE;
+        if (count && !buf) return -EFAULT;
+        struct vfs_file* vf = file_handle(ent->file);
+        if (ent->file->flags & O_APPEND) off = vfs_file_size(vf);
+        int64_t r = vfs_write_at(vf, off, buf, count);
+        return r < 0 ? -EIO : r;
+    }
+
+    // An FD_DIR description holds a directory stream (f->obj); its
+    // position is the stream's cookie, not a byte offset.
+    static int64_t open_dir(struct FDTable* tbl, const char* path, int flags) {
+        struct vfs_dir* d = vfs_opendir(path);
+        if (!d) return -ENOENT;
+        int fd = fdtable_alloc_fd(tbl, FDTABLE_MIN_FD);
+        struct FDEntry* ent = fdtable_get(tbl, fd);
+        struct OpenFile* f = ent ? fdtable_install(ent, FD_DIR) : NULL;
+        if (!f) {
+            vfs_closedir(d);
+            if (fd < 0) return fd;
+            fdtable_free_fd(tbl, fd);
+            return -ENOMEM;
+        }
+        f->path = (char*)hanacore::mem::kmalloc(strlen(path) + 1);
+        if (f->path) strcpy(f->path, path);
+        f->obj = d;
+        f->flags = flags & ~O_CLOEXEC;
+        if (flags & O_CLOEXEC) ent->fd_flags = FD_CLOEXEC;
+        return fd;
+    }
+
+    int64_t fileio_open(struct FDTable* tbl, const char* path, int flags) {
+        if (!path) return -EFAULT;
+
+        int pty_type = FD_NONE, pty_id = -1;
+        int64_t is_pty = open_pty(path, &pty_type, &pty_id);
+        if (is_pty < 0) return is_pty;
+        if (is_pty) {
+            int fd = fdtable_alloc_fd(tbl, FDTABLE_MIN_FD);
+            struct FDEntry* ent = fdtable_get(tbl, fd);
+            struct OpenFile* f = ent ? fdtable_install(ent, (FDType)pty_type) : NULL;
+            if (!f) {
+                if (pty_type == FD_PTY_MASTER) pty_destroy_pair(pty_id);
+                if (fd < 0) return fd;
+                fdtable_free_fd(tbl, fd);
+                return -ENOMEM;
+            }
+            f->pty_id = pty_id;
+            f->flags = flags & ~O_CLOEXEC;
+            if (flags & O_CLOEXEC) ent->fd_flags = FD_CLOEXEC;
+            return fd;
+        }
+
+        bool writable = (flags & 3) != 0;
+        if (hanacore::fs::lookup(path) == VFS_TYPE_DIR) {
+            if (writable) return -EISDIR;
+            return open_dir(tbl, path, flags);
+        }
+        if (flags & O_DIRECTORY) return -ENOTDIR;
+        struct vfs_file* vf = vfs_open(path, (flags & O_CREAT) ? VFS_O_CREAT : 0);
+        if (!vf) return -ENOENT;
+
+        int fd = fdtable_alloc_fd(tbl, FDTABLE_MIN_FD);
+        struct FDEntry* ent = fdtable_get(tbl, fd);
+        struct OpenFile* f = ent ? fdtable_install(ent, FD_FILE) : NULL;
+        if (!f) {
+            vfs_close(vf);
+            if (fd < 0) return fd;
+            fdtable_free_fd(tbl, fd);
+            return -ENOMEM;
+        }
+
+        f->path = (char*)hanacore::mem::kmalloc(strlen(path) + 1);
+        if (f->path) strcpy(f->path, path);
+        f->obj = vf;
+        if ((flags & O_TRUNC) && writable) vfs_truncate(vf, 0);
+        f->pos = (flags & O_APPEND) ? (size_t)fileio_size(ent) : 0;
+        // O_CLOEXEC belongs to the descriptor, not the description.
+        f->flags = flags & ~O_CLOEXEC;
+        if (flags & O_CLOEXEC) ent->fd_flags = FD_CLOEXEC;
+        return fd;
+    }
+
+    int64_t fileio_lseek(struct FDEntry* ent, int64_t offset, int whence) {
+        if (!ent || ent->type == FD_NONE) return -EBADF;
+        if (ent->type == FD_DIR) {
+            // Directories seek to cookies from telldir/getdents64 (d_off),
+            // or rewind.
+            struct vfs_dir* d = (struct vfs_dir*)ent->file->obj;
+            if (whence == SEEK_CUR && offset == 0) return (int64_t)vfs_telldir(d);
+            if (whence != SEEK_SET || offset < 0) return -EINVAL;
+            vfs_seekdir(d, (uint64_t)offset);
+            return offset;
+        }
+        if (ent->type != FD_FILE) return -ESPIPE;
+        struct OpenFile* f = ent->file;
+        int64_t base;
+        switch (whence) {
+        case SEEK_SET: base = 0; break;
+        case SEEK_CUR: base = (int64_t)f->pos; break;
+        case SEEK_END: base = (int64_t)fileio_size(ent); break;
+        default: return -EINVAL;
+        }
+        int64_t newpos = base + offset;
+        if (newpos < 0) return -EINVAL;
+        // Seeking past the end is allowed; a later write leaves a hole.
+        f->pos = (size_t)newpos;
+        return newpos;
+    }
+
+    static int64_t file_sync(struct OpenFile* f) {
+        if (f->type == FD_FILE) return vfs_fsync(file_handle(f)) == 0 ? 0 : -EIO;
+        if (f->type == FD_TTY || f->type == FD_PTY_MASTER || f->type == FD_PTY_SLAVE) return 0;
+        return -EINVAL;
+    }
+
+    int64_t fileio_fsync(struct FDEntry* ent) {
+        if (!ent || ent->type == FD_NONE) return -EBADF;
+        return file_sync(ent->file);
+    }
+
+    // Drop one reference to an open file description; the last one
+    // releases what the description holds.
+    void file_put(struct OpenFile* f) {
+        if (--f->refs > 0) return;
+        if (f->type == FD_FILE) {
+            file_sync(f);
+            vfs_close(file_handle(f));
+        }
+        if (f->type == FD_DIR) vfs_closedir((struct vfs_dir*)f->obj);
+        if (f->type == FD_IORING) ioring_release((IoRing*)f->obj);
+        if (f->type == FD_EPOLL) epoll_release((Epoll*)f->obj);
+        if (f->type == FD_PTY_MASTER) pty_destroy_pair(f->pty_id);
+        if (f->type == FD_PIPE_READ || f->type == FD_PIPE_WRITE)
+            pipe_put((Pipe*)f->pipe_obj, f->type == FD_PIPE_WRITE);
+        if (f->path) hanacore::mem::kfree(f->path);
+        hanacore::mem::kfree(f);
+    }
+
+    int64_t fileio_close(struct FDTable* tbl, int fd) {
+        struct FDEntry* ent = fdtable_get(tbl, fd);
+        if (!ent || ent->type == FD_NONE) return -EBADF;
+
+        epoll_fd_closed(ent);
+        struct OpenFile* f = ent->file;
+        ent->type = FD_NONE;
+        ent->fd_flags = 0;
+        ent->file = NULL;
+        fdtable_free_fd(tbl, fd);
+        file_put(f);
+        return 0;
+    }
+
+    int64_t fileio_pipe(struct FDTable* tbl, int* fds, int flags) {
+        if (!fds) return -EFAULT;
+        if (flags & ~(O_NONBLOCK | O_CLOEXEC)) return -EINVAL;
+        int rd = fdtable_alloc_fd(tbl, FDTABLE_MIN_FD);
+        if (rd < 0) return rd;
+        int wr = fdtable_alloc_fd(tbl, FDTABLE_MIN_FD);
+        if (wr < 0) { fdtable_free_fd(tbl, rd); return wr; }
+
+        Pipe* p = pipe_create(PIPE_DEF_SIZE);
+        struct FDEntry* rent = fdtable_get(tbl, rd);
+        struct FDEntry* went = fdtable_get(tbl, wr);
+        struct OpenFile* rf = p ? fdtable_install(rent, FD_PIPE_READ) : NULL;
+        if (rf) rf->pipe_obj = p;
+        struct OpenFile* wf = rf ? fdtable_install(went, FD_PIPE_WRITE) : NULL;
+        if (!wf) {
+            if (rf) fileio_close(tbl, rd);      // drops the read end
+            else fdtable_free_fd(tbl, rd);
+            fdtable_free_fd(tbl, wr);
+            if (p && !rf) pipe_put(p, false);
+            if (p) pipe_put(p, true);
+            return -ENOMEM;
+        }
+        rf->flags = flags & O_NONBLOCK;
+        wf->pipe_obj = p;
+        wf->flags = (flags & O_NONBLOCK) | 1;   // O_WRONLY
+        if (flags & O_CLOEXEC) rent->fd_flags = went->fd_flags = FD_CLOEXEC;
+        fds[0] = rd;
+        fds[1] = wr;
+        return 0;
+    }
+
+    int64_t fileio_dup_into(struct FDTable* tbl, int fd, const struct FDEntry* src) {
+        if (!src || src->type == FD_NONE) return -EBADF;
+        struct FDEntry* dst = fdtable_get(tbl, fd);
+        if (dst == src) return 0;
+        // Take the reference first: closing dst may drop src's last other one.
+        struct OpenFile* f = src->file;
+        ++f->refs;
+        if (dst && dst->type != FD_NONE) fileio_close(tbl, fd);
+        int r = fdtable_reserve_fd(tbl, fd);
+        if (r < 0) { file_put(f); return r; }
+        dst = fdtable_get(tbl, fd);
+        dst->type = f->type;
+        dst->fd_flags = 0;
+        dst->file = f;
+        return 0;
+    }
+
+    int64_t fileio_dup(struct FDTable* tbl, int oldfd, int minfd, int fd_flags) {
+        struct FDEntry* src = fdtable_get(tbl, oldfd);
+        if (!src || src->type == FD_NONE) return -EBADF;
+        int fd = fdtable_alloc_fd(tbl, minfd);
+        if (fd < 0) return fd;
+        struct FDEntry* dst = fdtable_get(tbl, fd);
+        ++src->file->refs;
+        dst->type = src->type;
+        dst->fd_flags = fd_flags;
+        dst->file = src->file;
+        return fd;
+    }
+
+    int64_t fileio_fcntl(struct FDEntry* ent, int cmd, uint64_t arg) {
+        if (!ent || ent->type == FD_NONE) return -EBADF;
+        struct OpenFile* f = ent->file;
+        bool is_pipe = ent->type == FD_PIPE_READ || ent->type == FD_PIPE_WRITE;
+        switch (cmd) {
+        case F_GETFD:
+            return ent->fd_flags;
+        case F_SETFD:
+            ent->fd_flags = (int)arg & FD_CLOEXEC;
+            return 0;
+        case F_GETFL:
+            return f->flags;
+        case F_SETFL: {
+            // Only the status flags may change; the access mode stays.
+            const int settable = O_APPEND | O_NONBLOCK;
+            f->flags = (f->flags & ~settable) | ((int)arg & settable);
+            return 0;
+        }
+        case F_SETPIPE_SZ:
+            if (!is_pipe) return -EBADF;
+            return pipe_set_size((Pipe*)f->pipe_obj, (size_t)arg);
+        case F_GETPIPE_SZ:
+            if (!is_pipe) return -EBADF;
+            return (int64_t)pipe_get_size((Pipe*)f->pipe_obj);
+        }
+        return -EINVAL;
+    }
+
+    // Linux struct linux_dirent64; records are padded to 8 bytes.
+    struct Dirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        uint16_t d_reclen;
+        uint8_t d_type;
+        char d_name[];
+    };
+
+    struct GetdentsBuf {
+        uint8_t* buf;
+        size_t size;
+        size_t used;
+        bool full;          // a record did not fit
+    };
+
+    static int getdents_fill(void* ctx, const char* name, uint64_t ino, unsigned type, uint64_t next) {
+        GetdentsBuf* gb = (GetdentsBuf*)ctx;
+        size_t namelen = strlen(name);
+        size_t reclen = (offsetof(Dirent64, d_name) + namelen + 1 + 7) & ~(size_t)7;
+        if (gb->used + reclen > gb->size) {
+            gb->full = true;
+            return 1;
+        }
+        Dirent64* de = (Dirent64*)(gb->buf + gb->used);
+        de->d_ino = ino;
+        de->d_off = (int64_t)next;
+        de->d_reclen = (uint16_t)reclen;
+        de->d_type = (uint8_t)type;
+        memcpy(de->d_name, name, namelen + 1);
+        memset(de->d_name + namelen + 1, 0, reclen - offsetof(Dirent64, d_name) - namelen - 1);
+        gb->used += reclen;
+        return 0;
+    }
+
+    int64_t fileio_getdents64(struct FDEntry* ent, void* buf, size_t count) {
+        if (!ent || ent->type == FD_NONE) return -EBADF;
+        if (ent->type != FD_DIR) return -ENOTDIR;
+        if (!buf) return -EFAULT;
+        GetdentsBuf gb = { (uint8_t*)buf, count, 0, false };
+        if (vfs_iterate_dir((struct vfs_dir*)ent->file->obj, getdents_fill, &gb) != 0) return -EIO;
+        if (gb.used == 0 && gb.full) return -EINVAL;
+        return (int64_t)gb.used;
+    }
+
+    void fileio_close_all(struct FDTable* tbl) {
+        if (!tbl) return;
+        for (int i = 0; i < tbl->count; ++i) {
+            struct FDEntry* ent = fdtable_get(tbl, i);
+            if (ent->type != FD_NONE) fileio_close(tbl, i);
+        }
+    }
+
+    uint32_t fileio_poll(struct FDEntry* ent, hanacore::sync::PollTable* pt) {
+        if (!ent || ent->type == FD_NONE) return POLLNVAL;
+        struct OpenFile* f = ent->file;
+        switch (ent->type) {
+        case FD_FILE:
+        case FD_DIR:
+            // Regular files never block.
+            return POLLIN | POLLRDNORM | POLLOUT | POLLWRNORM;
+        case FD_TTY:
+            return tty_poll(pt);
+        case FD_PIPE_READ:
+        case FD_PIPE_WRITE:
+            return pipe_poll((Pipe*)f->pipe_obj, ent->type == FD_PIPE_WRITE, pt);
+        case FD_PTY_MASTER:
+        case FD_PTY_SLAVE:
+            return pty_poll(f->pty_id, ent->type == FD_PTY_MASTER, pt);
+        case FD_EPOLL:
+            return epoll_poll((Epoll*)f->obj, pt);
+        default:
+            return 0;
+        }
+    }
+
+}} // namespace hanacore::userland
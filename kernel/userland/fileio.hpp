@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "fdtable.hpp"
+
+// Descriptor-level file operations shared by the syscall handlers and the
+// io ring workers. They act on an explicit FD table / entry rather than the
+// calling task's, because ring requests execute on worker tasks on behalf of
+// the task that submitted them. All return a non-negative result or -errno.
+
+// Linux struct iovec
+struct IoVec {
+    void *iov_base;
+    size_t iov_len;
+};
+
+// Most segments one vectored call may carry (Linux UIO_MAXIOV).
+#define FILEIO_IOV_MAX 1024
+
+// fcntl commands handled by fileio_fcntl (F_DUPFD* by fileio_dup).
+#define F_DUPFD 0
+#define F_GETFD 1
+#define F_SETFD 2
+#define F_GETFL 3
+#define F_SETFL 4
+#define F_DUPFD_CLOEXEC 1030
+#define F_SETPIPE_SZ 1031
+#define F_GETPIPE_SZ 1032
+
+namespace hanacore { namespace sync { struct PollTable; } }
+
+namespace hanacore { namespace userland {
+
+    int64_t fileio_read(struct FDEntry* ent, void* buf, size_t count);
+    int64_t fileio_write(struct FDEntry* ent, const void* buf, size_t count);
+    // One attempt that never sleeps: -EAGAIN where the above would block.
+    int64_t fileio_read_nonblock(struct FDEntry* ent, void* buf, size_t count);
+    int64_t fileio_write_nonblock(struct FDEntry* ent, const void* buf, size_t count);
+    // Positional variants: FD_FILE only, the descriptor offset is unchanged.
+    int64_t fileio_pread(struct FDEntry* ent, void* buf, size_t count, uint64_t off);
+    int64_t fileio_pwrite(struct FDEntry* ent, const void* buf, size_t count, uint64_t off);
+    // Vectored variants. Segments are transferred straight between the
+    // descriptor and each user buffer in order; a short transfer ends the
+    // call. On a pipe, tty or pty only the first segment may block.
+    // Returns the total byte count, or -errno if nothing moved.
+    int64_t fileio_readv(struct FDEntry* ent, const struct IoVec* iov, int iovcnt);
+    int64_t fileio_writev(struct FDEntry* ent, const struct IoVec* iov, int iovcnt);
+    int64_t fileio_preadv(struct FDEntry* ent, const struct IoVec* iov, int iovcnt, uint64_t off);
+    int64_t fileio_pwritev(struct FDEntry* ent, const struct IoVec* iov, int iovcnt, uint64_t off);
+    // Open `path` into the lowest free slot of `tbl`; returns the new fd.
+    // /dev/ptmx allocates a new pty pair (master side), /dev/pts/N opens
+    // the slave side of pair N.
+    int64_t fileio_open(struct FDTable* tbl, const char* path, int flags);
+    int64_t fileio_close(struct FDTable* tbl, int fd);
+    // Reposition an FD_FILE (whence: SEEK_SET/CUR/END); returns the offset.
+    // An FD_DIR only seeks to a cookie (SEEK_SET) or reports its own.
+    int64_t fileio_lseek(struct FDEntry* ent, int64_t offset, int whence);
+    // Current size of the file behind an FD_FILE descriptor.
+    uint64_t fileio_size(const struct FDEntry* ent);
+    // Create a pipe in the two lowest free slots; fds[0] reads, fds[1]
+    // writes. `flags` may carry O_NONBLOCK (pipe2).
+    int64_t fileio_pipe(struct FDTable* tbl, int* fds, int flags);
+    // Make `fd` of `tbl` (closed first if open) another descriptor for
+    // `src`'s open file description; `src` may belong to another table.
+    // O(1): the description is shared, not copied, and the new descriptor
+    // starts without FD_CLOEXEC. -EBADF if fd is outside RLIMIT_NOFILE.
+    int64_t fileio_dup_into(struct FDTable* tbl, int fd, const struct FDEntry* src);
+    // Duplicate `oldfd` into the lowest free slot >= minfd with the given
+    // descriptor flags (dup, F_DUPFD, F_DUPFD_CLOEXEC); returns the new fd.
+    int64_t fileio_dup(struct FDTable* tbl, int oldfd, int minfd, int fd_flags);
+    int64_t fileio_fcntl(struct FDEntry* ent, int cmd, uint64_t arg);
+    // Current POLL* mask of the descriptor; with a table, also register
+    // the wait queues that signal changes (see sync/poll.hpp).
+    uint32_t fileio_poll(struct FDEntry* ent, hanacore::sync::PollTable* pt);
+    // Fill `buf` with Linux dirent64 records from an FD_DIR, resuming
+    // where the last call stopped. Returns the bytes used, 0 at the end,
+    // or -EINVAL if even one record does not fit.
+    int64_t fileio_getdents64(struct FDEntry* ent, void* buf, size_t count);
+    // Write an FD_FILE's changes back without closing it.
+    int64_t fileio_fsync(struct FDEntry* ent);
+    // Close every open descriptor (task exit).
+    void fileio_close_all(struct FDTable* tbl);
+    // Drop a reference taken with ++f->refs; the last one releases the
+    // description. May sleep.
+    void file_put(struct OpenFile* f);
+
+}} // namespace hanacore::userland
@@ -0,0 +1,210 @@
+#include "futex.hpp"
+#include "errno.hpp"
+#include "../scheduler/scheduler.hpp"
+#include "../sync/spinlock.hpp"
+#include "../sync/waitqueue.hpp"
+
+namespace hanacore { namespace userland {
+
+    using hanacore::scheduler::Task;
+    using hanacore::sync::Spinlock;
+    using hanacore::sync::SpinGuard;
+
+    HANA_LOCK_CLASS(futex_class, "futex_bucket");
+
+    static constexpr int FUTEX_HASH_BITS = 6;
+    static constexpr int FUTEX_BUCKETS = 1 << FUTEX_HASH_BITS;
+
+    struct FutexBucket;
+
+    // One sleeping waiter; lives on the waiter's kernel stack.
+    struct FutexQ {
+        uintptr_t key;
+        uint32_t bitset;
+        Task* task;
+        FutexBucket* bucket;    // changes on requeue (both locks held)
+        volatile bool woken;
+        FutexQ* prev;
+        FutexQ* next;
+    };
+
+    struct FutexBucket {
+        Spinlock lock;
+        FutexQ* head;
+        FutexQ* tail;
+    };
+
+    static FutexBucket buckets[FUTEX_BUCKETS];
+    static bool buckets_ready = false;
+
+    static FutexBucket* bucket_for(uintptr_t key) {
+        if (!buckets_ready) {
+            for (int i = 0; i < FUTEX_BUCKETS; ++i) {
+                buckets[i].lock = { 0, &futex_class, 0 };
+                buckets[i].head = buckets[i].tail = nullptr;
+            }
+            buckets_ready = true;
+        }
+        // Fibonacci hashing of the word index.
+        uint64_t h = (uint64_t)(key >> 2) * 0x9E3779B97F4A7C15ULL;
+        return &buckets[h >> (64 - FUTEX_HASH_BITS)];
+    }
+
+    // List helpers; caller holds b->lock.
+    static void q_link(FutexBucket* b, FutexQ* q) {
+        q->bucket = b;
+        q->next = nullptr;
+        q->prev = b->tail;
+        if (b->tail) b->tail->next = q; else b->head = q;
+        b->tail = q;
+    }
+
+    static void q_unlink(FutexBucket* b, FutexQ* q) {
+        if (q->prev) q->prev->next = q->next; else b->head = q->next;
+        if (q->next) q->next->prev = q->prev; else b->tail = q->prev;
+        q->prev = q->next = nullptr;
+    }
+
+    // Wake and dequeue `q`; caller holds its bucket lock. The woken flag is
+    // what the waiter tests, sched_wake just makes it runnable.
+    static void q_wake(FutexBucket* b, FutexQ* q) {
+        q_unlink(b, q);
+        q->bucket = nullptr;
+        q->woken = true;
+        hanacore::scheduler::sched_wake(q->task);
+    }
+
+    static bool bad_addr(volatile uint32_t* uaddr) {
+        return !uaddr || ((uintptr_t)uaddr & 3);
+    }
+
+    // Take the lock of the bucket `q` is on right now; requeue may move it
+    // between buckets until we hold the right lock.
+    static FutexBucket* lock_q_bucket(FutexQ* q, uint64_t* flags) {
+        for (;;) {
+            FutexBucket* b = q->bucket;
+            if (!b) return nullptr;
+            *flags = hanacore::sync::spin_lock_irqsave(&b->lock);
+            if (q->bucket == b) return b;
+            hanacore::sync::spin_unlock_irqrestore(&b->lock, *flags);
+        }
+    }
+
+    int64_t futex_wait(volatile uint32_t* uaddr, uint32_t val, uint64_t deadline_ns, uint32_t bitset) {
+        if (bad_addr(uaddr)) return -EFAULT;
+        if (bitset == 0) return -EINVAL;
+
+        FutexQ q;
+        q.key = (uintptr_t)uaddr;
+        q.bitset = bitset;
+        q.task = hanacore::scheduler::current_task;
+        q.woken = false;
+        FutexBucket* b = bucket_for(q.key);
+        {
+            // Compare and queue under the bucket lock: a waker changes the
+            // value first and then takes the lock, so it either sees us
+            // queued or we see the new value.
+            SpinGuard g(&b->lock);
+            if (*uaddr != val) return -EAGAIN;
+            q_link(b, &q);
+            hanacore::scheduler::sched_block_current();
+        }
+
+        bool timed_out = false;
+        for (;;) {
+            if (q.woken) break;
+            if (deadline_ns) {
+                if (!hanacore::sync::wait_queue_sleep_until(deadline_ns)) { timed_out = true; break; }
+            } else {
+                hanacore::sync::wait_queue_sleep();
+            }
+            // Spurious return (nothing else was runnable): block again,
+            // unless a wakeup came in meanwhile.
+            uint64_t flags;
+            FutexBucket* cur = lock_q_bucket(&q, &flags);
+            if (!cur) break;
+            hanacore::scheduler::sched_block_current();
+            hanacore::sync::spin_unlock_irqrestore(&cur->lock, flags);
+        }
+
+        uint64_t flags;
+        FutexBucket* cur = lock_q_bucket(&q, &flags);
+        if (cur) {
+            q_unlink(cur, &q);
+            q.bucket = nullptr;
+            hanacore::sync::spin_unlock_irqrestore(&cur->lock, flags);
+        }
+        if (q.task) q.task->state = hanacore::scheduler::TASK_RUNNING;
+        if (q.woken) return 0;
+        return timed_out ? -ETIMEDOUT : 0;
+    }
+
+    int64_t futex_wake(volatile uint32_t* uaddr, int nr, uint32_t bitset) {
+        if (bad_addr(uaddr)) return -EFAULT;
+        if (bitset == 0) return -EINVAL;
+        if (nr <= 0) return 0;
+        uintptr_t key = (uintptr_t)uaddr;
+        FutexBucket* b = bucket_for(key);
+        int woken = 0;
+        SpinGuard g(&b->lock);
+        FutexQ* q = b->head;
+        while (q && woken < nr) {
+            FutexQ* next = q->next;
+            if (q->key == key && (q->bitset & bitset)) {
+                q_wake(b, q);
+                ++woken;
+            }
+            q = next;
+        }
+        return woken;
+    }
+
+    int64_t futex_requeue(volatile uint32_t* uaddr, volatile uint32_t* uaddr2, int nr_wake,
+                          int nr_requeue, bool cmp, uint32_t val3) {
+        if (bad_addr(uaddr) || bad_addr(uaddr2)) return -EFAULT;
+        if (nr_wake < 0 || nr_requeue < 0) return -EINVAL;
+        uintptr_t key1 = (uintptr_t)uaddr, key2 = (uintptr_t)uaddr2;
+        FutexBucket* b1 = bucket_for(key1);
+        FutexBucket* b2 = bucket_for(key2);
+
+        // Lock both buckets in a fixed order.
+        FutexBucket* first = b1 < b2 ? b1 : b2;
+        FutexBucket* second = b1 < b2 ? b2 : b1;
+        uint64_t f1 = hanacore::sync::spin_lock_irqsave(&first->lock);
+        uint64_t f2 = 0;
+        if (second != first) f2 = hanacore::sync::spin_lock_irqsave(&second->lock);
+
+        int64_t ret = 0;
+        if (cmp && *uaddr != val3) {
+            ret = -EAGAIN;
+        } else {
+            int woken = 0, moved = 0;
+            FutexQ* q = b1->head;
+            while (q) {
+                FutexQ* next = q->next;
+                if (q->key == key1) {
+                    if (woken < nr_wake) {
+                        q_wake(b1, q);
+                        ++woken;
+                    } else if (moved < nr_requeue) {
+                        q->key = key2;
+                        if (b2 != b1) {
+                            q_unlink(b1, q);
+                            q_link(b2, q);
+                        }
+                        ++moved;
+                    } else {
+                        break;
+                    }
+                }
+                q = next;
+            }
+            ret = woken + moved;
+        }
+
+        if (second != first) hanacore::sync::spin_unlock_irqrestore(&second->lock, f2);
+        hanacore::sync::spin_unlock_irqrestore(&first->lock, f1);
+        return ret;
+    }
+
+}} // namespace hanacore::userland
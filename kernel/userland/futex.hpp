@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+
+// Linux-compatible futex(2). Waiters are kept in a fixed hash table of
+// buckets keyed by the futex address; each bucket has its own lock, so
+// unrelated futexes do not contend. User tasks currently share one address
+// space, so private and shared futexes use the same key (the address).
+
+#define FUTEX_WAIT            0
+#define FUTEX_WAKE            1
+#define FUTEX_REQUEUE         3
+#define FUTEX_CMP_REQUEUE     4
+#define FUTEX_WAIT_BITSET     9
+#define FUTEX_WAKE_BITSET     10
+#define FUTEX_PRIVATE_FLAG    128
+#define FUTEX_CLOCK_REALTIME  256
+#define FUTEX_BITSET_MATCH_ANY 0xffffffffu
+
+namespace hanacore { namespace userland {
+
+    // Sleep while *uaddr == val, until woken or the deadline passes.
+    // `deadline_ns` is absolute CLOCK_MONOTONIC, 0 for no timeout.
+    // Returns 0, -EAGAIN (value changed) or -ETIMEDOUT.
+    int64_t futex_wait(volatile uint32_t* uaddr, uint32_t val, uint64_t deadline_ns, uint32_t bitset);
+    // Wake up to `nr` waiters on uaddr whose bitset intersects `bitset`.
+    // Returns the number woken.
+    int64_t futex_wake(volatile uint32_t* uaddr, int nr, uint32_t bitset);
+    // Wake `nr_wake` waiters on uaddr and move up to `nr_requeue` of the
+    // rest to uaddr2. With `cmp`, fail with -EAGAIN unless *uaddr == val3.
+    // Returns woken + requeued.
+    int64_t futex_requeue(volatile uint32_t* uaddr, volatile uint32_t* uaddr2, int nr_wake,
+                          int nr_requeue, bool cmp, uint32_t val3);
+
+}} // namespace hanacore::userland
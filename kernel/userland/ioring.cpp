@@ -0,0 +1,441 @@
+#include "ioring.hpp"
+#include "fileio.hpp"
+#include "errno.hpp"
+#include "../scheduler/scheduler.hpp"
+#include "../sync/spinlock.hpp"
+#include "../sync/waitqueue.hpp"
+#include "../sync/poll.hpp"
+#include "../mem/heap.hpp"
+#include "../arch/tsc.hpp"
+#include "../utils/logger.hpp"
+#include <string.h>
+
+#ifndef O_NONBLOCK
+#define O_NONBLOCK 0x800
+#endif
+
+namespace hanacore { namespace userland {
+
+    using hanacore::scheduler::Task;
+    using hanacore::sync::Spinlock;
+    using hanacore::sync::SpinGuard;
+    using hanacore::sync::WaitQueue;
+    using hanacore::sync::WaitQueueEntry;
+    using hanacore::sync::PollTable;
+
+    HANA_LOCK_CLASS(ioring_class, "ioring");
+    HANA_LOCK_CLASS(ioworker_class, "ioring_worker");
+
+    static constexpr int IORING_WORKERS = 2;
+    static constexpr uint32_t SQPOLL_DEFAULT_IDLE_MS = 10;
+
+    struct IoRing {
+        Spinlock lock;          // serialises SQ consumption and CQ posting
+        struct hana_io_sq* sq;
+        struct hana_io_cq* cq;
+        void* mem;              // backs both ring headers and arrays
+        Task* owner;            // requests run against owner->fds
+        int refs;               // descriptor + queued requests + SQ poller
+        int inflight;           // requests handed to workers, not yet posted
+        bool closed;
+        bool sqpoll;
+        uint64_t sq_idle_ns;
+        WaitQueue cq_wait;      // enter(GETEVENTS) and release sleep here
+        WaitQueue sq_wait;      // idle SQ poller sleeps here
+        WaitQueue close_wait;   // requests waiting on a descriptor; woken on release
+    };
+
+    struct IoWork {
+        IoRing* ring;
+        struct hana_io_sqe sqe;
+        IoWork* next;
+    };
+
+    struct IoWorker {
+        Spinlock lock;
+        IoWork* head;
+        IoWork* tail;
+        WaitQueue wait;
+    };
+
+    static IoWorker workers[IORING_WORKERS];
+    static bool workers_started = false;
+    static uint32_t unkeyed_rr = 0;    // spreads requests that carry no fd
+
+    static void ring_get(IoRing* r) {
+        __atomic_fetch_add(&r->refs, 1, __ATOMIC_ACQ_REL);
+    }
+
+    static void ring_put(IoRing* r) {
+        if (__atomic_sub_fetch(&r->refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+        hanacore::mem::kfree(r->mem);
+        hanacore::mem::kfree(r);
+    }
+
+    static uint32_t sq_pending(IoRing* r) {
+        return __atomic_load_n(&r->sq->tail, __ATOMIC_ACQUIRE) - r->sq->head;
+    }
+
+    static uint32_t cq_ready(IoRing* r) {
+        return __atomic_load_n(&r->cq->tail, __ATOMIC_ACQUIRE) -
+               __atomic_load_n(&r->cq->head, __ATOMIC_ACQUIRE);
+    }
+
+    // Append a completion; a full CQ drops it and counts an overflow.
+    // Callers wake cq_wait once their bookkeeping is done.
+    static void post_cqe(IoRing* r, uint64_t user_data, int64_t res) {
+        SpinGuard g(&r->lock);
+        struct hana_io_cq* cq = r->cq;
+        uint32_t tail = cq->tail;
+        if (tail - __atomic_load_n(&cq->head, __ATOMIC_ACQUIRE) >= cq->entries) {
+            cq->overflow++;
+            return;
+        }
+        cq->cqes[tail & cq->mask].user_data = user_data;
+        cq->cqes[tail & cq->mask].res = res;
+        __atomic_store_n(&cq->tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    // ------------------------------------------------------------------
+    // Reads and writes on pipes, ttys and ptys never sleep inside the
+    // object: the worker tries non-blocking and waits for readiness here,
+    // where closing the ring can also wake it and cancel the request.
+    // ------------------------------------------------------------------
+
+    static constexpr int READY_HOOKS = 3;   // close_wait + the object's queues
+
+    struct ReadyHook {
+        WaitQueueEntry entry;
+        WaitQueue* wq;
+    };
+
+    struct ReadyWait {
+        PollTable pt;           // first: the queue callback casts back
+        Task* task;
+        volatile bool triggered;
+        ReadyHook hooks[READY_HOOKS];
+        int nhooks;
+    };
+
+    static void ready_hook_wake(WaitQueueEntry* e) {
+        ReadyWait* w = (ReadyWait*)e->data;
+        w->triggered = true;
+        hanacore::scheduler::sched_wake(w->task);
+    }
+
+    static void ready_hook_queue(PollTable* pt, WaitQueue* wq) {
+        ReadyWait* w = (ReadyWait*)pt;
+        if (w->nhooks >= READY_HOOKS) return;
+        ReadyHook* h = &w->hooks[w->nhooks++];
+        hanacore::sync::wait_entry_init_callback(&h->entry, ready_hook_wake, w);
+        h->wq = wq;
+        hanacore::sync::add_wait_queue(wq, &h->entry);
+    }
+
+    // Sleep until `ent` reports one of `events` (or an error/hangup).
+    // Returns false if the ring was closed first.
+    static bool wait_ready(IoRing* r, struct FDEntry* ent, uint32_t events) {
+        ReadyWait w;
+        w.pt.queue = ready_hook_queue;
+        w.task = hanacore::scheduler::current_task;
+        w.nhooks = 0;
+        ready_hook_queue(&w.pt, &r->close_wait);
+
+        PollTable* pt = &w.pt;
+        bool ready;
+        for (;;) {
+            w.triggered = false;
+            uint32_t mask = fileio_poll(ent, pt);
+            pt = nullptr;
+            if (__atomic_load_n(&r->closed, __ATOMIC_ACQUIRE)) { ready = false; break; }
+            if (mask & (events | POLLERR | POLLHUP | POLLNVAL)) { ready = true; break; }
+            // A hook firing between the sample above and here sets
+            // `triggered`, so the wakeup cannot be lost.
+            hanacore::scheduler::sched_block_current();
+            if (!w.triggered) hanacore::sync::wait_queue_sleep();
+            w.task->state = hanacore::scheduler::TASK_RUNNING;
+        }
+
+        for (int i = 0; i < w.nhooks; ++i)
+            hanacore::sync::remove_wait_queue(w.hooks[i].wq, &w.hooks[i].entry);
+        return ready;
+    }
+
+    static int64_t ioring_rw(IoRing* r, struct FDEntry* ent, const struct hana_io_sqe* sqe) {
+        bool write = sqe->opcode == HANA_IORING_OP_WRITE;
+        void* buf = (void*)(uintptr_t)sqe->addr;
+        if (sqe->off != HANA_IORING_OFF_CURRENT)
+            return write ? fileio_pwrite(ent, buf, sqe->len, sqe->off)
+                         : fileio_pread(ent, buf, sqe->len, sqe->off);
+        // Files only ever wait on the disk; O_NONBLOCK descriptors not at all.
+        if (ent->type == FD_FILE || ent->type == FD_DIR || (ent->file->flags & O_NONBLOCK))
+            return write ? fileio_write(ent, buf, sqe->len) : fileio_read(ent, buf, sqe->len);
+        for (;;) {
+            int64_t res = write ? fileio_write_nonblock(ent, buf, sqe->len)
+                                : fileio_read_nonblock(ent, buf, sqe->len);
+            if (res != -EAGAIN) return res;
+            if (!wait_ready(r, ent, write ? POLLOUT : POLLIN)) return -ECANCELED;
+        }
+    }
+
+    static int64_t ioring_execute(IoRing* r, const struct hana_io_sqe* sqe) {
+        Task* owner = r->owner;
+        struct FDTable* tbl = owner->fds;
+
+        if (sqe->opcode == HANA_IORING_OP_OPEN)
+            return fileio_open(tbl, (const char*)(uintptr_t)sqe->addr, (int)sqe->open_flags);
+
+        struct FDEntry* ent = fdtable_get(tbl, sqe->fd);
+        if (!ent || ent->type == FD_NONE) return -EBADF;
+        // Releasing a ring waits for its requests, so none may hold one.
+        if (ent->type == FD_IORING) return -EINVAL;
+        if (sqe->opcode == HANA_IORING_OP_CLOSE) return fileio_close(tbl, sqe->fd);
+
+        // Pin the description: the owner may close the fd while this sleeps.
+        struct FDEntry pinned = *ent;
+        ++pinned.file->refs;
+        int64_t res = -EINVAL;
+        switch (sqe->opcode) {
+        case HANA_IORING_OP_READ:
+        case HANA_IORING_OP_WRITE:
+            res = ioring_rw(r, &pinned, sqe);
+            break;
+        case HANA_IORING_OP_FSYNC:
+            res = fileio_fsync(&pinned);
+            break;
+        }
+        file_put(pinned.file);
+        return res;
+    }
+
+    static void worker_main(void* arg) {
+        IoWorker* w = (IoWorker*)arg;
+        for (;;) {
+            hanacore::sync::wait_event(&w->wait, [w] {
+                return __atomic_load_n(&w->head, __ATOMIC_ACQUIRE) != nullptr;
+            });
+            IoWork* work;
+            {
+                SpinGuard g(&w->lock);
+                work = w->head;
+                if (!work) continue;
+                w->head = work->next;
+                if (!w->head) w->tail = nullptr;
+            }
+            IoRing* r = work->ring;
+            int64_t res = __atomic_load_n(&r->closed, __ATOMIC_ACQUIRE)
+                              ? -ECANCELED : ioring_execute(r, &work->sqe);
+            post_cqe(r, work->sqe.user_data, res);
+            __atomic_sub_fetch(&r->inflight, 1, __ATOMIC_ACQ_REL);
+            hanacore::sync::wake_up_all(&r->cq_wait);
+            hanacore::mem::kfree(work);
+            ring_put(r);
+        }
+    }
+
+    static bool start_workers() {
+        if (workers_started) return true;
+        for (int i = 0; i < IORING_WORKERS; ++i) {
+            workers[i].lock = { 0, &ioworker_class, 0 };
+            workers[i].head = workers[i].tail = nullptr;
+            hanacore::sync::wait_queue_init(&workers[i].wait);
+        }
+        for (int i = 0; i < IORING_WORKERS; ++i) {
+            if (!hanacore::scheduler::create_task_with_arg(worker_main, &workers[i])) return false;
+        }
+        workers_started = true;
+        log_info("ioring: started %d workers", IORING_WORKERS);
+        return true;
+    }
+
+    // Every request for a given fd goes to the same worker, which runs its
+    // queue in order; open/nop carry no fd and are spread round-robin.
+    static void queue_work(IoWork* work) {
+        uint32_t key = work->sqe.opcode == HANA_IORING_OP_OPEN ? unkeyed_rr++ : (uint32_t)work->sqe.fd;
+        IoWorker* w = &workers[key % IORING_WORKERS];
+        {
+            SpinGuard g(&w->lock);
+            if (w->tail) w->tail->next = work; else w->head = work;
+            w->tail = work;
+        }
+        hanacore::sync::wake_up_one(&w->wait);
+    }
+
+    // Consume up to `to_submit` SQEs. NOPs and malformed entries complete
+    // inline; everything else goes to the worker pool.
+    static uint32_t ioring_submit(IoRing* r, uint32_t to_submit) {
+        uint32_t done = 0;
+        while (done < to_submit) {
+            struct hana_io_sqe sqe;
+            {
+                SpinGuard g(&r->lock);
+                if (r->closed) break;
+                uint32_t head = r->sq->head;
+                if (head == __atomic_load_n(&r->sq->tail, __ATOMIC_ACQUIRE)) break;
+                sqe = r->sq->sqes[head & r->sq->mask];
+                __atomic_store_n(&r->sq->head, head + 1, __ATOMIC_RELEASE);
+            }
+            ++done;
+
+            IoWork* work = nullptr;
+            int64_t res = 0;
+            if (sqe.opcode > HANA_IORING_OP_FSYNC) res = -EINVAL;
+            else if (sqe.opcode != HANA_IORING_OP_NOP) {
+                work = (IoWork*)hanacore::mem::kmalloc(sizeof(IoWork));
+                if (!work) res = -ENOMEM;
+            }
+            if (!work) {
+                post_cqe(r, sqe.user_data, res);
+                hanacore::sync::wake_up_all(&r->cq_wait);
+                continue;
+            }
+            work->ring = r;
+            work->sqe = sqe;
+            work->next = nullptr;
+            ring_get(r);
+            __atomic_add_fetch(&r->inflight, 1, __ATOMIC_ACQ_REL);
+            queue_work(work);
+        }
+        return done;
+    }
+
+    // SQPOLL: drain the SQ without syscalls. After sq_idle_ns with nothing
+    // to do, advertise NEED_WAKEUP and sleep until enter(SQ_WAKEUP).
+    static void sqpoll_main(void* arg) {
+        IoRing* r = (IoRing*)arg;
+        uint64_t last_work = hanacore::arch::clock_monotonic_ns();
+        while (!__atomic_load_n(&r->closed, __ATOMIC_ACQUIRE)) {
+            if (ioring_submit(r, UINT32_MAX)) {
+                last_work = hanacore::arch::clock_monotonic_ns();
+            } else if (hanacore::arch::clock_monotonic_ns() - last_work >= r->sq_idle_ns) {
+                // Set the flag before the final emptiness check inside
+                // wait_event so a concurrent submitter either sees it or we
+                // see its entry.
+                __atomic_fetch_or(&r->sq->flags, HANA_IORING_SQ_NEED_WAKEUP, __ATOMIC_SEQ_CST);
+                hanacore::sync::wait_event(&r->sq_wait, [r] {
+                    return __atomic_load_n(&r->closed, __ATOMIC_ACQUIRE) || sq_pending(r) != 0;
+                });
+                __atomic_fetch_and(&r->sq->flags, ~(uint32_t)HANA_IORING_SQ_NEED_WAKEUP, __ATOMIC_SEQ_CST);
+                last_work = hanacore::arch::clock_monotonic_ns();
+                continue;
+            }
+            hanacore::scheduler::sched_yield();
+        }
+        ring_put(r);
+    }
+
+    int64_t ioring_setup(uint32_t entries, struct hana_ioring_params* params) {
+        Task* cur = hanacore::scheduler::current_task;
+        if (!cur || !params) return -EFAULT;
+        if (entries == 0 || entries > HANA_IORING_MAX_ENTRIES) return -EINVAL;
+        if (!start_workers()) return -ENOMEM;
+
+        uint32_t sq_entries = 1;
+        while (sq_entries < entries) sq_entries <<= 1;
+        uint32_t cq_entries = sq_entries * 2;
+
+        size_t bytes = sizeof(struct hana_io_sq) + sizeof(struct hana_io_cq) +
+                       sq_entries * sizeof(struct hana_io_sqe) +
+                       cq_entries * sizeof(struct hana_io_cqe);
+        uint8_t* mem = (uint8_t*)hanacore::mem::kmalloc(bytes);
+        IoRing* r = (IoRing*)hanacore::mem::kmalloc(sizeof(IoRing));
+        if (!mem || !r) {
+            if (mem) hanacore::mem::kfree(mem);
+            if (r) hanacore::mem::kfree(r);
+            return -ENOMEM;
+        }
+        memset(mem, 0, bytes);
+        memset(r, 0, sizeof(IoRing));
+
+        struct hana_io_sq* sq = (struct hana_io_sq*)mem;
+        struct hana_io_cq* cq = (struct hana_io_cq*)(sq + 1);
+        sq->sqes = (struct hana_io_sqe*)(cq + 1);
+        sq->entries = sq_entries;
+        sq->mask = sq_entries - 1;
+        cq->cqes = (struct hana_io_cqe*)(sq->sqes + sq_entries);
+        cq->entries = cq_entries;
+        cq->mask = cq_entries - 1;
+
+        r->lock = { 0, &ioring_class, 0 };
+        r->sq = sq;
+        r->cq = cq;
+        r->mem = mem;
+        r->owner = cur;
+        r->refs = 1;
+        r->sqpoll = (params->flags & HANA_IORING_SETUP_SQPOLL) != 0;
+        uint32_t idle_ms = params->sq_thread_idle_ms ? params->sq_thread_idle_ms : SQPOLL_DEFAULT_IDLE_MS;
+        r->sq_idle_ns = (uint64_t)idle_ms * 1000000ULL;
+        hanacore::sync::wait_queue_init(&r->cq_wait);
+        hanacore::sync::wait_queue_init(&r->sq_wait);
+        hanacore::sync::wait_queue_init(&r->close_wait);
+
+        int fd = fdtable_alloc_fd(cur->fds, FDTABLE_MIN_FD);
+        if (fd < 0) {
+            ring_put(r);
+            return fd;
+        }
+        if (r->sqpoll) {
+            ring_get(r);
+            if (!hanacore::scheduler::create_task_with_arg(sqpoll_main, r)) {
+                r->refs = 1;
+                ring_put(r);
+                fdtable_free_fd(cur->fds, fd);
+                return -ENOMEM;
+            }
+        }
+
+        struct OpenFile* f = fdtable_install(fdtable_get(cur->fds, fd), FD_IORING);
+        if (!f) {
+            fdtable_free_fd(cur->fds, fd);
+            ioring_release(r);  // also stops the SQPOLL task
+            return -ENOMEM;
+        }
+        f->obj = r;
+
+        params->sq_entries = sq_entries;
+        params->cq_entries = cq_entries;
+        params->sq = sq;
+        params->cq = cq;
+        return fd;
+    }
+
+    int64_t ioring_enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags) {
+        Task* cur = hanacore::scheduler::current_task;
+        struct FDEntry* ent = cur ? fdtable_get(cur->fds, fd) : nullptr;
+        if (!ent || ent->type != FD_IORING || !ent->file->obj) return -EBADF;
+        IoRing* r = (IoRing*)ent->file->obj;
+
+        int64_t submitted;
+        if (r->sqpoll) {
+            if (flags & HANA_IORING_ENTER_SQ_WAKEUP) hanacore::sync::wake_up_all(&r->sq_wait);
+            submitted = to_submit;
+        } else {
+            submitted = ioring_submit(r, to_submit);
+        }
+
+        if ((flags & HANA_IORING_ENTER_GETEVENTS) && min_complete) {
+            // Give up early once nothing is left that could complete.
+            hanacore::sync::wait_event(&r->cq_wait, [r, min_complete] {
+                if (cq_ready(r) >= min_complete) return true;
+                return __atomic_load_n(&r->inflight, __ATOMIC_ACQUIRE) == 0 &&
+                       (!r->sqpoll || sq_pending(r) == 0);
+            });
+        }
+        return submitted;
+    }
+
+    void ioring_release(IoRing* r) {
+        if (!r) return;
+        __atomic_store_n(&r->closed, true, __ATOMIC_RELEASE);
+        hanacore::sync::wake_up_all(&r->sq_wait);
+        // Requests still queued or waiting on a descriptor complete with
+        // -ECANCELED; the rest only wait on the disk. Workers use the
+        // owner's FD table, so it must outlive them.
+        hanacore::sync::wake_up_all(&r->close_wait);
+        hanacore::sync::wait_event(&r->cq_wait, [r] {
+            return __atomic_load_n(&r->inflight, __ATOMIC_ACQUIRE) == 0;
+        });
+        ring_put(r);
+    }
+
+}} // namespace hanacore::userland
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include "../api/hana_ioring.h"
+
+// Kernel side of the I/O rings (see api/hana_ioring.h for the user ABI).
+// A ring is owned by one FD_IORING descriptor. Entries pulled off its SQ are
+// queued to a small pool of kernel worker tasks, which run them against the
+// submitting task's FD table and post the result to the CQ. Each fd hashes
+// to one worker, so requests for one fd keep their submission order.
+
+namespace hanacore { namespace userland {
+
+    struct IoRing;
+
+    // Create a ring for the calling task and install it in a new fd.
+    // Returns the fd or -errno.
+    int64_t ioring_setup(uint32_t entries, struct hana_ioring_params* params);
+
+    // Submit up to `to_submit` SQEs and optionally wait for `min_complete`
+    // completions. Returns the number of SQEs consumed or -errno.
+    int64_t ioring_enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags);
+
+    // Drop the descriptor's reference: stop the SQ poller, cancel requests
+    // that are queued or waiting on a descriptor (-ECANCELED), wait for the
+    // rest and free the ring once nothing uses it.
+    void ioring_release(IoRing* ring);
+
+}} // namespace hanacore::userland
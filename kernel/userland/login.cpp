@@ -17,7 +17,6 @@ extern volatile struct limine_hhdm_request limine_hhdm_request;
 
 extern "C" {
     void print(const char*);
-    char keyboard_poll_char(void);
     int memcmp(const void* s1, const void* s2, size_t n);
 }
 
@@ -28,8 +27,8 @@ namespace hanacore {
         static void read_password(char* buf, int maxlen) {
             int pos = 0;
             while (pos < maxlen - 1) {
-                char c = keyboard_poll_char();
-                if (c == 0) continue;  // No character available, try again
+                // Sleeps until the keyboard IRQ delivers a key
+                char c = tty_getchar();
                 if (c == '\n' || c == '\r') {
                     tty_write("\n");
                     break;
@@ -49,8 +48,8 @@ namespace hanacore {
         static void read_line(char* buf, int maxlen) {
             int pos = 0;
             while (pos < maxlen - 1) {
-                char c = keyboard_poll_char();
-                if (c == 0) continue;  // No character available, try again
+                // Sleeps until the keyboard IRQ delivers a key
+                char c = tty_getchar();
                 if (c == '\n' || c == '\r') {
                     tty_write("\n");
                     break;
@@ -1,17 +1,21 @@
 // Minimal musl syscall shim implementation
 #include "musl_shim.h"
+#include "../../api/hana_vdso.h"
 #include <stdarg.h>
 #include <stddef.h>
-// Hana syscall numbers (keep in sync with kernel/userland/syscalls.hpp)
-#define HANA_SYSCALL_READ 10
-#define HANA_SYSCALL_WRITE 11
-#define HANA_SYSCALL_OPEN 12
-#define HANA_SYSCALL_CLOSE 13
-#define HANA_SYSCALL_LSEEK 14
-
-// Basic direct syscalls also present
+// Hana syscall numbers (keep in sync with kernel/userland/syscalls.hpp).
+// They start above the Linux range so they never shadow a Linux number.
+#define HANA_SYSCALL_BASE 512
+#define HANA_SYSCALL_READ (HANA_SYSCALL_BASE + 0)
+#define HANA_SYSCALL_WRITE (HANA_SYSCALL_BASE + 1)
+#define HANA_SYSCALL_OPEN (HANA_SYSCALL_BASE + 2)
+#define HANA_SYSCALL_CLOSE (HANA_SYSCALL_BASE + 3)
+#define HANA_SYSCALL_LSEEK (HANA_SYSCALL_BASE + 4)
+#define HANA_SYSCALL_VDSO (HANA_SYSCALL_BASE + 18)
+
+// Basic direct syscalls also present (aliases of the Linux numbers)
 #define SYSCALL_WRITE 1
-#define SYSCALL_EXIT 2
+#define SYSCALL_EXIT 60
 
 // Linux/x86_64 syscall numbers we expect musl to use (subset)
 #define __NR_read 0
@@ -21,13 +25,84 @@
 #define __NR_stat 4
 #define __NR_fstat 5
 #define __NR_lseek 8
+#define __NR_getpid 39
+#define __NR_gettimeofday 96
+#define __NR_clock_gettime 228
 #define __NR_openat 257
 #define __NR_exit 60
+#define __NR_getcpu 309
+
+static long raw_syscall(long num, unsigned long a1, unsigned long a2, unsigned long a3,
+                        unsigned long a4, unsigned long a5, unsigned long a6){
+    long ret;
+    register unsigned long r10 __asm__("r10") = a4;
+    register unsigned long r8  __asm__("r8")  = a5;
+    register unsigned long r9  __asm__("r9")  = a6;
+    __asm__ volatile (
+        "syscall"
+        : "=a" (ret)
+        : "a" (num), "D" (a1), "S" (a2), "d" (a3), "r" (r10), "r" (r8), "r" (r9)
+        : "rcx", "r11", "memory"
+    );
+    return ret;
+}
+
+// vDSO lookup, done once. Kernels without HANA_SYSCALL_VDSO answer -ENOSYS
+// and we keep using real syscalls. The vDSO lives in the kernel's upper
+// half, so only -4095..-1 count as errors.
+static const struct hana_vdso *vdso_get(void){
+    static int state; // 0 = not asked yet, 1 = present, -1 = absent
+    static const struct hana_vdso *vdso;
+    if (state == 0) {
+        long r = raw_syscall(HANA_SYSCALL_VDSO, 0, 0, 0, 0, 0, 0);
+        const struct hana_vdso *v = (const struct hana_vdso *)r;
+        if ((unsigned long)r < (unsigned long)-4095 && v &&
+            v->magic == HANA_VDSO_MAGIC && v->version == HANA_VDSO_VERSION) {
+            vdso = v;
+            state = 1;
+        } else {
+            state = -1;
+        }
+    }
+    return state > 0 ? vdso : NULL;
+}
+
+// Calls answered from the vDSO without entering the kernel. Returns 1 and
+// stores the result in *ret when handled.
+static int vdso_call(long num, unsigned long a1, unsigned long a2, unsigned long a3, long *ret){
+    if (num != __NR_clock_gettime && num != __NR_gettimeofday &&
+        num != __NR_getpid && num != __NR_getcpu)
+        return 0;
+    const struct hana_vdso *v = vdso_get();
+    if (!v) return 0;
+    switch (num) {
+    case __NR_clock_gettime:
+        *ret = v->clock_gettime((int)a1, (struct hana_timespec *)a2);
+        return 1;
+    case __NR_gettimeofday:
+        *ret = v->gettimeofday((struct hana_timeval *)a1, (void *)a2);
+        return 1;
+    case __NR_getpid:
+        *ret = v->getpid();
+        return 1;
+    case __NR_getcpu:
+        *ret = v->getcpu((unsigned *)a1, (unsigned *)a2, (void *)a3);
+        return 1;
+    }
+    return 0;
+}
+
+uint64_t hana_time_now_ns(void){
+    struct hana_timespec ts;
+    if (syscall(__NR_clock_gettime, 1 /* CLOCK_MONOTONIC */, &ts) != 0) return 0;
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
 
 // Directly invoke the syscall instruction with the original (Linux) syscall
 // number. The kernel provides a Linux-compatible dispatcher for common
 // syscalls, so pass-through makes userland programs compiled for Linux
-// work without additional mapping.
+// work without additional mapping. Time and pid queries are served from the
+// vDSO when the kernel exports one.
 long syscall(long num, ...){
     va_list ap; va_start(ap, num);
     unsigned long a1 = va_arg(ap, unsigned long);
@@ -39,14 +114,6 @@ long syscall(long num, ...){
     va_end(ap);
 
     long ret;
-    register unsigned long r10 __asm__("r10") = a4;
-    register unsigned long r8  __asm__("r8")  = a5;
-    register unsigned long r9  __asm__("r9")  = a6;
-    __asm__ volatile (
-        "syscall"
-        : "=a" (ret)
-        : "a" (num), "D" (a1), "S" (a2), "d" (a3), "r" (r10), "r" (r8), "r" (r9)
-        : "rcx", "r11", "memory"
-    );
-    return ret;
+    if (vdso_call(num, a1, a2, a3, &ret)) return ret;
+    return raw_syscall(num, a1, a2, a3, a4, a5, a6);
 }
@@ -12,6 +12,10 @@ extern "C" {
 
 long syscall(long num, ...);
 
+// Monotonic nanoseconds (CLOCK_MONOTONIC), served from the vDSO when the
+// kernel provides one. Matches the declaration in hanaapi.h.
+uint64_t hana_time_now_ns(void);
+
 #ifdef __cplusplus
 }
 #endif
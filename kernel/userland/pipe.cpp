@@ -0,0 +1,212 @@
+#include "pipe.hpp"
+#include "errno.hpp"
+#include "../sync/spinlock.hpp"
+#include "../sync/waitqueue.hpp"
+#include "../sync/poll.hpp"
+#include "../mem/heap.hpp"
+#include <string.h>
+
+namespace hanacore { namespace userland {
+
+    using hanacore::sync::Spinlock;
+    using hanacore::sync::SpinGuard;
+    using hanacore::sync::WaitQueue;
+
+    HANA_LOCK_CLASS(pipe_class, "pipe");
+    HANA_LOCK_CLASS(pipe_wait_class, "pipe_wait");
+
+    struct Pipe {
+        Spinlock lock;
+        uint8_t* buf;
+        size_t size;            // power of two
+        size_t head;            // free-running read counter
+        size_t tail;            // free-running write counter
+        int readers;
+        int writers;
+        WaitQueue rd_wait;      // readers wait for data or the last writer
+        WaitQueue wr_wait;      // writers wait for room or the last reader
+    };
+
+    static size_t round_size(size_t size) {
+        if (size < PIPE_MIN_SIZE) size = PIPE_MIN_SIZE;
+        size_t s = PIPE_MIN_SIZE;
+        while (s < size) s <<= 1;
+        return s;
+    }
+
+    static size_t used(const Pipe* p) { return p->tail - p->head; }
+
+    Pipe* pipe_create(size_t size) {
+        size = round_size(size);
+        Pipe* p = (Pipe*)hanacore::mem::kmalloc(sizeof(Pipe));
+        if (!p) return nullptr;
+        p->buf = (uint8_t*)hanacore::mem::kmalloc(size);
+        if (!p->buf) { hanacore::mem::kfree(p); return nullptr; }
+        p->lock = { 0, &pipe_class, 0 };
+        p->size = size;
+        p->head = p->tail = 0;
+        p->readers = p->writers = 1;
+        hanacore::sync::wait_queue_init(&p->rd_wait, &pipe_wait_class);
+        hanacore::sync::wait_queue_init(&p->wr_wait, &pipe_wait_class);
+        return p;
+    }
+
+    void pipe_get(Pipe* p, bool writer) {
+        if (!p) return;
+        SpinGuard g(&p->lock);
+        if (writer) ++p->writers; else ++p->readers;
+    }
+
+    void pipe_put(Pipe* p, bool writer) {
+        if (!p) return;
+        bool last;
+        {
+            SpinGuard g(&p->lock);
+            if (writer) --p->writers; else --p->readers;
+            last = p->readers == 0 && p->writers == 0;
+        }
+        if (last) {
+            hanacore::mem::kfree(p->buf);
+            hanacore::mem::kfree(p);
+            return;
+        }
+        // Closing the last writer is EOF for readers, the last reader is
+        // EPIPE for writers; either way the sleepers must re-check.
+        hanacore::sync::wake_up_all(writer ? &p->rd_wait : &p->wr_wait);
+    }
+
+    // Copy out of / into the ring at a free-running offset, splitting at
+    // the wrap point. Caller holds p->lock.
+    static void ring_copy_out(Pipe* p, uint8_t* dst, size_t n) {
+        size_t off = p->head & (p->size - 1);
+        size_t first = p->size - off < n ? p->size - off : n;
+        memcpy(dst, p->buf + off, first);
+        if (n > first) memcpy(dst + first, p->buf, n - first);
+        p->head += n;
+    }
+
+    static void ring_copy_in(Pipe* p, const uint8_t* src, size_t n) {
+        size_t off = p->tail & (p->size - 1);
+        size_t first = p->size - off < n ? p->size - off : n;
+        memcpy(p->buf + off, src, first);
+        if (n > first) memcpy(p->buf, src + first, n - first);
+        p->tail += n;
+    }
+
+    int64_t pipe_read(Pipe* p, void* buf, size_t count, bool nonblock) {
+        if (!p) return -EBADF;
+        if (count == 0) return 0;
+        if (!buf) return -EFAULT;
+        for (;;) {
+            size_t n = 0;
+            {
+                SpinGuard g(&p->lock);
+                n = used(p);
+                if (n == 0 && p->writers == 0) return 0;
+                if (n > 0) {
+                    if (n > count) n = count;
+                    ring_copy_out(p, (uint8_t*)buf, n);
+                }
+            }
+            if (n > 0) {
+                hanacore::sync::wake_up_all(&p->wr_wait);
+                return (int64_t)n;
+            }
+            if (nonblock) return -EAGAIN;
+            hanacore::sync::wait_event(&p->rd_wait, [p] {
+                return used(p) > 0 || p->writers == 0;
+            });
+        }
+    }
+
+    int64_t pipe_write(Pipe* p, const void* buf, size_t count, bool nonblock) {
+        if (!p) return -EBADF;
+        if (count == 0) return 0;
+        if (!buf) return -EFAULT;
+        const uint8_t* src = (const uint8_t*)buf;
+        size_t done = 0;
+        while (done < count) {
+            size_t n = 0;
+            size_t need;
+            {
+                SpinGuard g(&p->lock);
+                if (p->readers == 0) return done ? (int64_t)done : -EPIPE;
+                size_t room = p->size - used(p);
+                // Small writes go in whole or not at all.
+                need = (count <= PIPE_BUF && count <= p->size) ? count : 1;
+                if (room >= need) {
+                    n = count - done < room ? count - done : room;
+                    ring_copy_in(p, src + done, n);
+                }
+            }
+            if (n > 0) {
+                done += n;
+                hanacore::sync::wake_up_all(&p->rd_wait);
+                continue;
+            }
+            if (nonblock) return done ? (int64_t)done : -EAGAIN;
+            hanacore::sync::wait_event(&p->wr_wait, [p, need] {
+                return p->size - used(p) >= need || p->readers == 0;
+            });
+        }
+        return (int64_t)done;
+    }
+
+    int64_t pipe_set_size(Pipe* p, size_t size) {
+        if (!p) return -EBADF;
+        if (size > PIPE_MAX_SIZE) return -EPERM;
+        size = round_size(size);
+        uint8_t* nb = (uint8_t*)hanacore::mem::kmalloc(size);
+        if (!nb) return -ENOMEM;
+        uint8_t* old;
+        {
+            SpinGuard g(&p->lock);
+            size_t n = used(p);
+            if (n > size) {
+                old = nb;
+                size = 0;
+            } else {
+                // Linearise the buffered bytes at the start of the new ring.
+                ring_copy_out(p, nb, n);
+                old = p->buf;
+                p->buf = nb;
+                p->size = size;
+                p->head = 0;
+                p->tail = n;
+            }
+        }
+        hanacore::mem::kfree(old);
+        if (!size) return -EBUSY;
+        // A bigger ring may let blocked writers proceed.
+        hanacore::sync::wake_up_all(&p->wr_wait);
+        return (int64_t)size;
+    }
+
+    size_t pipe_get_size(Pipe* p) {
+        return p ? p->size : 0;
+    }
+
+    size_t pipe_avail(Pipe* p) {
+        if (!p) return 0;
+        SpinGuard g(&p->lock);
+        return used(p);
+    }
+
+    uint32_t pipe_poll(Pipe* p, bool writer, hanacore::sync::PollTable* pt) {
+        if (!p) return POLLNVAL;
+        hanacore::sync::poll_wait(pt, writer ? &p->wr_wait : &p->rd_wait);
+        SpinGuard g(&p->lock);
+        uint32_t mask = 0;
+        if (writer) {
+            size_t room = p->size - used(p);
+            // Writable once an atomic write would go through.
+            if (room >= (p->size < PIPE_BUF ? p->size : PIPE_BUF)) mask |= POLLOUT | POLLWRNORM;
+            if (p->readers == 0) mask |= POLLERR;
+        } else {
+            if (used(p) > 0) mask |= POLLIN | POLLRDNORM;
+            if (p->writers == 0) mask |= POLLHUP;
+        }
+        return mask;
+    }
+
+}} // namespace hanacore::userland
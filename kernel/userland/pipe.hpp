@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Kernel pipe object. Data lives in a power-of-two ring that is filled and
+// drained with at most two memcpy calls per transfer. Each end is reference
+// counted: a read end sees EOF once every writer has closed, a write end
+// gets -EPIPE once every reader has closed. Blocking readers and writers
+// sleep on the pipe's wait queues.
+
+// Default capacity and the F_SETPIPE_SZ bounds (Linux: one page up to
+// /proc/sys/fs/pipe-max-size).
+#define PIPE_DEF_SIZE (64 * 1024)
+#define PIPE_MIN_SIZE 4096
+#define PIPE_MAX_SIZE (1024 * 1024)
+// Writes of at most this many bytes are never interleaved with other writers.
+#define PIPE_BUF 4096
+
+namespace hanacore { namespace sync { struct PollTable; } }
+
+namespace hanacore { namespace userland {
+
+    struct Pipe;
+
+    // New pipe with one reader and one writer reference, or nullptr.
+    Pipe* pipe_create(size_t size);
+    // Take / drop a reference to one end (dup, close, exit). The pipe is
+    // freed when both ends are gone.
+    void pipe_get(Pipe* p, bool writer);
+    void pipe_put(Pipe* p, bool writer);
+
+    // Return a byte count or -errno (-EAGAIN when `nonblock` would sleep).
+    int64_t pipe_read(Pipe* p, void* buf, size_t count, bool nonblock);
+    int64_t pipe_write(Pipe* p, const void* buf, size_t count, bool nonblock);
+
+    // F_SETPIPE_SZ / F_GETPIPE_SZ. Setting rounds up to a power of two and
+    // returns the new capacity, or -EBUSY if buffered data would not fit.
+    int64_t pipe_set_size(Pipe* p, size_t size);
+    size_t pipe_get_size(Pipe* p);
+    // Bytes currently buffered (FIONREAD / fstat).
+    size_t pipe_avail(Pipe* p);
+    // Readiness of one end: POLLIN/POLLHUP for the reader, POLLOUT/POLLERR
+    // for the writer.
+    uint32_t pipe_poll(Pipe* p, bool writer, hanacore::sync::PollTable* pt);
+
+}} // namespace hanacore::userland
@@ -0,0 +1,418 @@
+#include "poll.hpp"
+#include "fileio.hpp"
+#include "errno.hpp"
+#include "../scheduler/scheduler.hpp"
+#include "../sync/spinlock.hpp"
+#include "../sync/waitqueue.hpp"
+#include "../mem/heap.hpp"
+#include <string.h>
+
+namespace hanacore { namespace userland {
+
+    using hanacore::scheduler::Task;
+    using hanacore::sync::PollTable;
+    using hanacore::sync::Spinlock;
+    using hanacore::sync::SpinGuard;
+    using hanacore::sync::WaitQueue;
+    using hanacore::sync::WaitQueueEntry;
+
+    HANA_LOCK_CLASS(epoll_class, "epoll");
+    HANA_LOCK_CLASS(epoll_wait_class, "epoll_wait");
+    HANA_LOCK_CLASS(epoll_list_class, "epoll_list");
+
+    // Most wait queues one object registers per poll call (pipes, ptys and
+    // the tty use one).
+    static constexpr int POLL_QUEUES_PER_FD = 2;
+
+    static uint32_t poll_one(struct FDTable* tbl, int fd, PollTable* pt) {
+        struct FDEntry* ent = fdtable_get(tbl, fd);
+        if (!ent || ent->type == FD_NONE) return POLLNVAL;
+        return fileio_poll(ent, pt);
+    }
+
+    // ------------------------------------------------------------------
+    // poll()
+    // ------------------------------------------------------------------
+
+    struct PollHook {
+        WaitQueueEntry entry;
+        WaitQueue* wq;
+    };
+
+    struct PollWaiter {
+        PollTable pt;           // first: the queue callback casts back
+        Task* task;
+        volatile bool triggered;
+        PollHook* hooks;
+        int nhooks;
+        int cap;
+    };
+
+    static void poll_hook_wake(WaitQueueEntry* e) {
+        PollWaiter* w = (PollWaiter*)e->data;
+        w->triggered = true;
+        hanacore::scheduler::sched_wake(w->task);
+    }
+
+    static void poll_hook_queue(PollTable* pt, WaitQueue* wq) {
+        PollWaiter* w = (PollWaiter*)pt;
+        if (w->nhooks >= w->cap) return;
+        PollHook* h = &w->hooks[w->nhooks++];
+        hanacore::sync::wait_entry_init_callback(&h->entry, poll_hook_wake, w);
+        h->wq = wq;
+        hanacore::sync::add_wait_queue(wq, &h->entry);
+    }
+
+    int64_t poll_fds(struct FDTable* tbl, struct PollFd* fds, uint64_t nfds,
+                     int64_t timeout_ns) {
+        if (nfds > (uint64_t)(tbl ? tbl->limit : 0)) return -EINVAL;
+        if (nfds && !fds) return -EFAULT;
+
+        PollWaiter w;
+        w.pt.queue = poll_hook_queue;
+        w.task = hanacore::scheduler::current_task;
+        w.triggered = false;
+        w.nhooks = 0;
+        w.cap = 0;
+        w.hooks = nullptr;
+        if (timeout_ns != 0 && nfds) {
+            w.hooks = (PollHook*)hanacore::mem::kmalloc(sizeof(PollHook) * nfds * POLL_QUEUES_PER_FD);
+            if (!w.hooks) return -ENOMEM;
+            w.cap = (int)nfds * POLL_QUEUES_PER_FD;
+        }
+        uint64_t deadline = timeout_ns > 0 ? hanacore::sync::wait_deadline_after((uint64_t)timeout_ns) : 0;
+
+        // Hooks are installed on the first pass only; they stay queued
+        // until we return, so later passes just sample.
+        PollTable* pt = w.hooks ? &w.pt : nullptr;
+        bool timed_out = timeout_ns == 0;
+        int64_t ready;
+        for (;;) {
+            w.triggered = false;
+            ready = 0;
+            for (uint64_t i = 0; i < nfds; ++i) {
+                fds[i].revents = 0;
+                if (fds[i].fd < 0) continue;
+                uint32_t mask = poll_one(tbl, fds[i].fd, pt);
+                mask &= (uint32_t)(uint16_t)fds[i].events | POLLERR | POLLHUP | POLLNVAL;
+                fds[i].revents = (short)mask;
+                if (mask) ++ready;
+            }
+            pt = nullptr;
+            if (ready || timed_out) break;
+
+            // A hook firing between the scan above and here sets
+            // `triggered`, so the wakeup cannot be lost.
+            hanacore::scheduler::sched_block_current();
+            if (!w.triggered) {
+                if (timeout_ns < 0) hanacore::sync::wait_queue_sleep();
+                else if (!hanacore::sync::wait_queue_sleep_until(deadline)) timed_out = true;
+            }
+            if (w.task) w.task->state = hanacore::scheduler::TASK_RUNNING;
+        }
+
+        for (int i = 0; i < w.nhooks; ++i)
+            hanacore::sync::remove_wait_queue(w.hooks[i].wq, &w.hooks[i].entry);
+        if (w.hooks) hanacore::mem::kfree(w.hooks);
+        return ready;
+    }
+
+    // ------------------------------------------------------------------
+    // epoll
+    // ------------------------------------------------------------------
+
+    struct EpItem;
+
+    struct EpHook {
+        WaitQueueEntry entry;
+        WaitQueue* wq;
+    };
+
+    struct EpItem {
+        PollTable pt;           // first: the queue callback casts back
+        struct Epoll* ep;
+        Task* owner;            // the watched fd lives in owner's table
+        int fd;
+        uint32_t events;
+        uint64_t data;
+        EpHook hooks[POLL_QUEUES_PER_FD];
+        int nhooks;
+        bool on_rdlist;
+        EpItem* next;           // all items of the instance
+        EpItem* rd_next;        // ready list
+    };
+
+    struct Epoll {
+        Spinlock lock;          // items, ready list
+        int refs;
+        EpItem* items;
+        EpItem* rdlist;
+        WaitQueue wq;           // epoll_wait sleepers and nested pollers
+        Epoll* next;            // global instance list
+    };
+
+    // Every live instance, so closing an fd can find its registrations.
+    static Spinlock ep_list_lock = { 0, &epoll_list_class, 0 };
+    static Epoll* ep_list = nullptr;
+
+    static struct FDEntry* item_entry(EpItem* it) {
+        Task* t = it->owner;
+        if (!t || !t->fds) return nullptr;
+        return fdtable_get(t->fds, it->fd);
+    }
+
+    // Caller holds ep->lock.
+    static void rdlist_add(Epoll* ep, EpItem* it) {
+        if (it->on_rdlist) return;
+        it->on_rdlist = true;
+        it->rd_next = ep->rdlist;
+        ep->rdlist = it;
+    }
+
+    static void ep_hook_wake(WaitQueueEntry* e) {
+        EpItem* it = (EpItem*)e->data;
+        Epoll* ep = it->ep;
+        {
+            SpinGuard g(&ep->lock);
+            if (!it->events) return;     // disarmed EPOLLONESHOT item
+            rdlist_add(ep, it);
+        }
+        hanacore::sync::wake_up_all(&ep->wq);
+    }
+
+    static void ep_hook_queue(PollTable* pt, WaitQueue* wq) {
+        EpItem* it = (EpItem*)pt;
+        if (it->nhooks >= POLL_QUEUES_PER_FD) return;
+        EpHook* h = &it->hooks[it->nhooks++];
+        hanacore::sync::wait_entry_init_callback(&h->entry, ep_hook_wake, it);
+        h->wq = wq;
+        hanacore::sync::add_wait_queue(wq, &h->entry);
+    }
+
+    // Unhook and unlink `it` (caller does not hold ep->lock) and free it.
+    static void ep_remove(Epoll* ep, EpItem* it) {
+        for (int i = 0; i < it->nhooks; ++i)
+            hanacore::sync::remove_wait_queue(it->hooks[i].wq, &it->hooks[i].entry);
+        {
+            SpinGuard g(&ep->lock);
+            EpItem** pp = &ep->items;
+            while (*pp && *pp != it) pp = &(*pp)->next;
+            if (*pp) *pp = it->next;
+            if (it->on_rdlist) {
+                EpItem** rp = &ep->rdlist;
+                while (*rp && *rp != it) rp = &(*rp)->rd_next;
+                if (*rp) *rp = it->rd_next;
+            }
+        }
+        hanacore::mem::kfree(it);
+    }
+
+    static Epoll* epoll_of(struct FDTable* tbl, int epfd) {
+        struct FDEntry* ent = fdtable_get(tbl, epfd);
+        if (!ent || ent->type != FD_EPOLL) return nullptr;
+        return (Epoll*)ent->file->obj;
+    }
+
+    int64_t epoll_create(struct FDTable* tbl) {
+        Epoll* ep = (Epoll*)hanacore::mem::kmalloc(sizeof(Epoll));
+        if (!ep) return -ENOMEM;
+        int fd = fdtable_alloc_fd(tbl, FDTABLE_MIN_FD);
+        if (fd < 0) { hanacore::mem::kfree(ep); return fd; }
+        struct OpenFile* f = fdtable_install(fdtable_get(tbl, fd), FD_EPOLL);
+        if (!f) { fdtable_free_fd(tbl, fd); hanacore::mem::kfree(ep); return -ENOMEM; }
+        ep->lock = { 0, &epoll_class, 0 };
+        ep->refs = 1;
+        ep->items = nullptr;
+        ep->rdlist = nullptr;
+        hanacore::sync::wait_queue_init(&ep->wq, &epoll_wait_class);
+        {
+            SpinGuard g(&ep_list_lock);
+            ep->next = ep_list;
+            ep_list = ep;
+        }
+        f->obj = ep;
+        return fd;
+    }
+
+    int64_t epoll_ctl(struct FDTable* tbl, int epfd, int op, int fd,
+                      const struct EpollEvent* ev) {
+        Epoll* ep = epoll_of(tbl, epfd);
+        if (!ep) return -EBADF;
+        struct FDEntry* target = fdtable_get(tbl, fd);
+        if (!target || target->type == FD_NONE) return -EBADF;
+        if (fd == epfd) return -EINVAL;
+        if (target->type == FD_FILE) return -EPERM;     // always ready
+        if (op != EPOLL_CTL_DEL && !ev) return -EFAULT;
+
+        Task* self = hanacore::scheduler::current_task;
+        EpItem* it;
+        {
+            SpinGuard g(&ep->lock);
+            for (it = ep->items; it; it = it->next)
+                if (it->owner == self && it->fd == fd) break;
+        }
+
+        if (op == EPOLL_CTL_DEL) {
+            if (!it) return -ENOENT;
+            ep_remove(ep, it);
+            return 0;
+        }
+        if (op == EPOLL_CTL_ADD) {
+            if (it) return -EEXIST;
+            it = (EpItem*)hanacore::mem::kmalloc(sizeof(EpItem));
+            if (!it) return -ENOMEM;
+            memset(it, 0, sizeof(*it));
+            it->pt.queue = ep_hook_queue;
+            it->ep = ep;
+            it->owner = self;
+            it->fd = fd;
+            it->events = ev->events | POLLERR | POLLHUP;
+            it->data = ev->data;
+            {
+                SpinGuard g(&ep->lock);
+                it->next = ep->items;
+                ep->items = it;
+            }
+            // Install the hooks; an fd that is already ready goes straight
+            // onto the ready list.
+            uint32_t mask = fileio_poll(target, &it->pt);
+            if (mask & it->events) {
+                {
+                    SpinGuard g(&ep->lock);
+                    rdlist_add(ep, it);
+                }
+                hanacore::sync::wake_up_all(&ep->wq);
+            }
+            return 0;
+        }
+        if (op == EPOLL_CTL_MOD) {
+            if (!it) return -ENOENT;
+            bool ready = (fileio_poll(target, nullptr) & (ev->events | POLLERR | POLLHUP)) != 0;
+            {
+                SpinGuard g(&ep->lock);
+                it->events = ev->events | POLLERR | POLLHUP;
+                it->data = ev->data;
+                if (ready) rdlist_add(ep, it);
+            }
+            if (ready) hanacore::sync::wake_up_all(&ep->wq);
+            return 0;
+        }
+        return -EINVAL;
+    }
+
+    // Report ready items into `out`. Level-triggered items that are still
+    // ready go back on the list so the next call checks them again;
+    // edge-triggered ones wait for the next wakeup.
+    static int ep_collect(Epoll* ep, struct EpollEvent* out, int maxevents) {
+        EpItem* list;
+        {
+            SpinGuard g(&ep->lock);
+            list = ep->rdlist;
+            ep->rdlist = nullptr;
+            for (EpItem* it = list; it; it = it->rd_next) it->on_rdlist = false;
+        }
+
+        int n = 0;
+        EpItem* keep = nullptr;
+        EpItem* it = list;
+        while (it) {
+            EpItem* next = it->rd_next;
+            if (n >= maxevents) {
+                it->rd_next = keep;
+                keep = it;
+                it = next;
+                continue;
+            }
+            uint32_t events;
+            {
+                SpinGuard g(&ep->lock);
+                events = it->events;
+            }
+            struct FDEntry* ent = item_entry(it);
+            uint32_t mask = ent && ent->type != FD_NONE ? fileio_poll(ent, nullptr) : POLLNVAL;
+            mask &= events;
+            if (mask) {
+                out[n].events = mask;
+                out[n].data = it->data;
+                ++n;
+                SpinGuard g(&ep->lock);
+                if (events & EPOLLONESHOT) it->events = 0;
+                else if (!(events & EPOLLET)) { it->rd_next = keep; keep = it; }
+            }
+            it = next;
+        }
+
+        if (keep) {
+            SpinGuard g(&ep->lock);
+            while (keep) {
+                EpItem* next = keep->rd_next;
+                rdlist_add(ep, keep);
+                keep = next;
+            }
+        }
+        return n;
+    }
+
+    int64_t epoll_wait(struct FDTable* tbl, int epfd, struct EpollEvent* events,
+                       int maxevents, int64_t timeout_ns) {
+        Epoll* ep = epoll_of(tbl, epfd);
+        if (!ep) return -EBADF;
+        if (maxevents <= 0) return -EINVAL;
+        if (!events) return -EFAULT;
+
+        uint64_t deadline = timeout_ns > 0 ? hanacore::sync::wait_deadline_after((uint64_t)timeout_ns) : 0;
+        auto has_ready = [ep] { return __atomic_load_n(&ep->rdlist, __ATOMIC_ACQUIRE) != nullptr; };
+        for (;;) {
+            int n = ep_collect(ep, events, maxevents);
+            if (n > 0 || timeout_ns == 0) return n;
+            if (timeout_ns < 0) {
+                hanacore::sync::wait_event(&ep->wq, has_ready);
+            } else if (!hanacore::sync::wait_event_deadline(&ep->wq, has_ready, deadline)) {
+                return ep_collect(ep, events, maxevents);
+            }
+        }
+    }
+
+    void epoll_get(Epoll* ep) {
+        if (ep) __atomic_fetch_add(&ep->refs, 1, __ATOMIC_ACQ_REL);
+    }
+
+    void epoll_release(Epoll* ep) {
+        if (!ep) return;
+        if (__atomic_sub_fetch(&ep->refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+        {
+            SpinGuard g(&ep_list_lock);
+            Epoll** pp = &ep_list;
+            while (*pp && *pp != ep) pp = &(*pp)->next;
+            if (*pp) *pp = ep->next;
+        }
+        while (ep->items) ep_remove(ep, ep->items);
+        hanacore::mem::kfree(ep);
+    }
+
+    uint32_t epoll_poll(Epoll* ep, PollTable* pt) {
+        if (!ep) return POLLNVAL;
+        hanacore::sync::poll_wait(pt, &ep->wq);
+        return __atomic_load_n(&ep->rdlist, __ATOMIC_ACQUIRE) ? (POLLIN | POLLRDNORM) : 0;
+    }
+
+    void epoll_fd_closed(struct FDEntry* ent) {
+        if (!ent || !__atomic_load_n(&ep_list, __ATOMIC_ACQUIRE)) return;
+        // Kernel code is not preempted and nothing below sleeps, so the
+        // instance list cannot change under us once the lock is dropped.
+        Epoll* ep;
+        {
+            SpinGuard g(&ep_list_lock);
+            ep = ep_list;
+        }
+        for (; ep; ep = ep->next) {
+            EpItem* it = ep->items;
+            while (it) {
+                EpItem* next = it->next;
+                if (item_entry(it) == ent) ep_remove(ep, it);
+                it = next;
+            }
+        }
+    }
+
+}} // namespace hanacore::userland
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "fdtable.hpp"
+#include "../sync/poll.hpp"
+
+// poll/select and epoll on top of the objects' poll functions (see
+// sync/poll.hpp). A sleeping poll() hooks a callback entry onto every wait
+// queue its fds registered; an epoll instance keeps its hooks installed
+// between calls and collects woken items on a ready list, so epoll_wait
+// only looks at fds that have signalled since the last call.
+
+// Linux struct pollfd
+struct PollFd {
+    int fd;
+    short events;
+    short revents;
+};
+
+// Linux struct epoll_event (packed on x86_64)
+struct EpollEvent {
+    uint32_t events;
+    uint64_t data;
+} __attribute__((packed));
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+#define EPOLLONESHOT (1u << 30)
+#define EPOLLET      (1u << 31)
+
+namespace hanacore { namespace userland {
+
+    struct Epoll;
+
+    // Wait until one of `fds` is ready or `timeout_ns` passes (negative:
+    // no limit, 0: just sample). Returns the number of fds with non-zero
+    // revents, or -errno.
+    int64_t poll_fds(struct FDTable* tbl, struct PollFd* fds, uint64_t nfds,
+                     int64_t timeout_ns);
+
+    // Create an epoll instance in a new fd of `tbl`. Returns the fd.
+    int64_t epoll_create(struct FDTable* tbl);
+    int64_t epoll_ctl(struct FDTable* tbl, int epfd, int op, int fd,
+                      const struct EpollEvent* ev);
+    int64_t epoll_wait(struct FDTable* tbl, int epfd, struct EpollEvent* events,
+                       int maxevents, int64_t timeout_ns);
+
+    // FD_EPOLL descriptor lifetime.
+    void epoll_get(Epoll* ep);
+    void epoll_release(Epoll* ep);
+    // An epoll fd is readable while its ready list is non-empty.
+    uint32_t epoll_poll(Epoll* ep, hanacore::sync::PollTable* pt);
+    // `ent` is being closed: drop every epoll registration that watches it.
+    void epoll_fd_closed(struct FDEntry* ent);
+
+}} // namespace hanacore::userland
@@ -0,0 +1,198 @@
+#include "spawn.hpp"
+#include "errno.hpp"
+#include "elf_loader.hpp"
+#include "exec_cache.hpp"
+#include "fileio.hpp"
+#include "vdso.hpp"
+#include "../scheduler/scheduler.hpp"
+#include "../arch/cpu.hpp"
+#include "../utils/logger.hpp"
+#include <string.h>
+
+// Auxiliary vector types (System V x86_64 ABI / Linux values)
+#define AT_NULL   0
+#define AT_PHDR   3
+#define AT_PHENT  4
+#define AT_PHNUM  5
+#define AT_PAGESZ 6
+#define AT_BASE   7
+#define AT_ENTRY  9
+#define AT_SECURE 23
+#define AT_RANDOM 25
+
+namespace hanacore { namespace userland {
+
+    using hanacore::scheduler::Task;
+
+    static constexpr size_t SPAWN_STACK_SIZE = 64 * 1024;
+    // argv + envp strings and pointers may use at most this much of the
+    // stack; the rest is left to the program.
+    static constexpr size_t SPAWN_ARG_MAX = SPAWN_STACK_SIZE / 4;
+    static constexpr int SPAWN_AUXV_MAX = 10;   // including AT_NULL
+
+    // Count a NULL-terminated string vector and add its string bytes to
+    // *bytes. Returns the count or -E2BIG.
+    static int64_t count_strings(const char* const* v, size_t* bytes) {
+        if (!v) return 0;
+        int64_t n = 0;
+        for (; v[n]; ++n) {
+            *bytes += strlen(v[n]) + 1;
+            if (*bytes > SPAWN_ARG_MAX) return -E2BIG;
+        }
+        return n;
+    }
+
+    static char* copy_strings(uint64_t** slot, char* dst, const char* const* v, int64_t n) {
+        for (int64_t i = 0; i < n; ++i) {
+            size_t len = strlen(v[i]) + 1;
+            memcpy(dst, v[i], len);
+            *(*slot)++ = (uint64_t)(uintptr_t)dst;
+            dst += len;
+        }
+        *(*slot)++ = 0;
+        return dst;
+    }
+
+    // Fill the 16 AT_RANDOM bytes (splitmix64 over the TSC; good enough
+    // for stack-protector and pointer-guard seeds, not for cryptography).
+    static void fill_random(uint8_t* out) {
+        uint64_t x = hanacore::arch::rdtsc();
+        for (int i = 0; i < 2; ++i) {
+            x += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = x;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z ^= z >> 31;
+            memcpy(out + 8 * i, &z, 8);
+        }
+    }
+
+    // Lay out the System V initial stack at the top of t's user stack:
+    //   [sp] argc, argv[0..argc-1], NULL, envp[0..], NULL, auxv pairs,
+    //   AT_NULL, then AT_RANDOM bytes and the strings towards the top.
+    static void build_initial_stack(Task* t, const ElfImageInfo& img,
+                                    const char* const* argv, int64_t argc,
+                                    const char* const* envp, int64_t envc, size_t strbytes) {
+        uintptr_t top = ((uintptr_t)t->user_stack + t->user_stack_size) & ~0xFULL;
+        uintptr_t strings = top - strbytes;
+        uintptr_t random = (strings - 16) & ~0xFULL;
+        size_t words = 1 + (argc + 1) + (envc + 1) + 2 * SPAWN_AUXV_MAX;
+        uintptr_t sp = (random - words * 8) & ~0xFULL;
+
+        uint64_t* slot = (uint64_t*)sp;
+        *slot++ = (uint64_t)argc;
+        char* dst = (char*)strings;
+        dst = copy_strings(&slot, dst, argv, argc);
+        copy_strings(&slot, dst, envp, envc);
+
+        fill_random((uint8_t*)random);
+
+        auto aux = [&slot](uint64_t type, uint64_t val) { *slot++ = type; *slot++ = val; };
+        if (img.phdr) {
+            aux(AT_PHDR, img.phdr);
+            aux(AT_PHENT, img.phentsize);
+            aux(AT_PHNUM, img.phnum);
+        }
+        aux(AT_PAGESZ, 4096);
+        aux(AT_BASE, 0);
+        aux(AT_ENTRY, (uint64_t)(uintptr_t)img.entry);
+        aux(AT_SECURE, 0);
+        aux(AT_RANDOM, random);
+        aux(HANA_AT_VDSO, (uint64_t)(uintptr_t)vdso_base());
+        aux(AT_NULL, 0);
+
+        t->user_sp = (void*)sp;
+    }
+
+    // Give the child the parent's descriptors and RLIMIT_NOFILE; each
+    // descriptor shares the parent's open file description. FD_CLOEXEC
+    // descriptors stay behind, and so do io rings, whose requests run
+    // against their creator's FD table.
+    static int64_t inherit_fds(Task* child, Task* parent) {
+        if (!parent || !parent->fds || !child->fds) return 0;
+        fileio_close_all(child->fds);
+        fdtable_set_limit(child->fds, (uint64_t)parent->fds->limit, (uint64_t)parent->fds->limit_max);
+        for (int i = 0; i < parent->fds->count; ++i) {
+            const FDEntry* src = fdtable_get(parent->fds, i);
+            if (src->type == FD_NONE || (src->fd_flags & FD_CLOEXEC)) continue;
+            if (src->type == FD_IORING) continue;
+            int64_t r = fileio_dup_into(child->fds, i, src);
+            if (r < 0) return r;
+        }
+        return 0;
+    }
+
+    static int64_t apply_file_actions(Task* child, const struct hana_spawn_file_action* actions,
+                                      int nactions) {
+        FDTable* tbl = child->fds;
+        for (int i = 0; i < nactions; ++i) {
+            const struct hana_spawn_file_action* fa = &actions[i];
+            int64_t r;
+            switch (fa->type) {
+            case HANA_SPAWN_FA_CLOSE:
+                r = fileio_close(tbl, fa->fd);
+                break;
+            case HANA_SPAWN_FA_DUP2:
+                r = fileio_dup_into(tbl, fa->newfd, fdtable_get(tbl, fa->fd));
+                break;
+            case HANA_SPAWN_FA_OPEN: {
+                if (fa->fd < 0 || fa->fd >= tbl->limit) return -EBADF;
+                fileio_close(tbl, fa->fd);
+                r = fileio_open(tbl, fa->path, fa->oflag);
+                // The lowest free slot is not necessarily the one asked for.
+                if (r >= 0 && r != fa->fd) {
+                    int64_t moved = fileio_dup_into(tbl, fa->fd, fdtable_get(tbl, (int)r));
+                    fileio_close(tbl, (int)r);
+                    r = moved;
+                }
+                break;
+            }
+            default:
+                r = -EINVAL;
+                break;
+            }
+            if (r < 0) return r;
+        }
+        return 0;
+    }
+
+    int64_t spawn(const char* path, const char* const* argv, const char* const* envp,
+                  const struct hana_spawn_file_action* actions, int nactions) {
+        if (!path) return -EFAULT;
+        if (nactions < 0 || nactions > HANA_SPAWN_MAX_ACTIONS) return -EINVAL;
+        if (nactions && !actions) return -EFAULT;
+
+        size_t strbytes = 0;
+        int64_t argc = count_strings(argv, &strbytes);
+        if (argc < 0) return argc;
+        int64_t envc = count_strings(envp, &strbytes);
+        if (envc < 0) return envc;
+        if (strbytes + (argc + envc + 2) * sizeof(uint64_t) > SPAWN_ARG_MAX) return -E2BIG;
+
+        ElfImageInfo img;
+        ExecInstance* inst = nullptr;
+        int64_t r = exec_image_get(path, &img, &inst);
+        if (r < 0) return r;
+
+        Task* parent = hanacore::scheduler::current_task;
+        Task* child = hanacore::scheduler::create_user_task_blocked(img.entry, SPAWN_STACK_SIZE);
+        if (!child) { exec_instance_put(inst); return -ENOMEM; }
+        child->exec_image = inst;
+
+        build_initial_stack(child, img, argv, argc, envp, envc, strbytes);
+        r = inherit_fds(child, parent);
+        if (r == 0) r = apply_file_actions(child, actions, nactions);
+        if (r < 0) {
+            // Never ran: drop what it holds and let the scheduler reap it.
+            fileio_close_all(child->fds);
+            child->state = hanacore::scheduler::TASK_DEAD;
+            return r;
+        }
+
+        child->parent_pid = parent ? parent->pid : 0;
+        log_info("spawn: %s -> pid %d (argc=%d)", path, child->pid, (int)argc);
+        hanacore::scheduler::sched_wake(child);
+        return child->pid;
+    }
+
+}} // namespace hanacore::userland
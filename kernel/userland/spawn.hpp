@@ -0,0 +1,18 @@
+#pragma once
+#include <stdint.h>
+#include "../api/hana_spawn.h"
+
+// Process creation from a path (see api/hana_spawn.h for the user ABI).
+// The image is loaded into a new task that is kept blocked while its
+// initial stack and descriptor table are filled in, so a failure part way
+// through never lets a half-built process run.
+
+namespace hanacore { namespace userland {
+
+    // Start `path` as a child of the calling task. argv/envp are
+    // NULL-terminated (either may be NULL); `actions` are applied to the
+    // child's inherited descriptors in order. Returns the pid or -errno.
+    int64_t spawn(const char* path, const char* const* argv, const char* const* envp,
+                  const struct hana_spawn_file_action* actions, int nactions);
+
+}} // namespace hanacore::userland
@@ -17,33 +17,24 @@
 #include "../tty/tty.hpp"
 #include "../scheduler/scheduler.hpp"
 #include "module_runner.hpp"
+#include "errno.hpp"
+#include "../arch/cpu.hpp"
+#include "../arch/tsc.hpp"
+#include "../arch/percpu.hpp"
+#include "vdso.hpp"
+#include "fileio.hpp"
+#include "ioring.hpp"
+#include "poll.hpp"
+#include "futex.hpp"
+#include "spawn.hpp"
+#include "../sync/waitqueue.hpp"
+#include "../libs/libc.h"
 
 #include <sys/types.h>
 
-#ifndef O_CREAT
-#define O_CREAT 0x40
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0x80000
 #endif
-#ifndef O_TRUNC
-#define O_TRUNC 0x200
-#endif
-#ifndef O_APPEND
-#define O_APPEND 0x400
-#endif
-#ifndef SEEK_SET
-#define SEEK_SET 0
-#endif
-#ifndef SEEK_CUR
-#define SEEK_CUR 1
-#endif
-#ifndef SEEK_END
-#define SEEK_END 2
-#endif
-
-static size_t kstrlen(const char *s) {
-    const char *p = s;
-    while (p && *p) ++p;
-    return (size_t)(p - s);
-}
 
 // Linux-like syscall numbers
 enum LinuxSyscall {
@@ -53,293 +44,831 @@ enum LinuxSyscall {
     SYS_CLOSE = 3,
     SYS_STAT = 4,
     SYS_FSTAT = 5,
+    SYS_POLL = 7,
     SYS_LSEEK = 8,
-    SYS_DUP2 = 33,
+    SYS_IOCTL = 16,
+    SYS_PREAD64 = 17,
+    SYS_PWRITE64 = 18,
+    SYS_READV = 19,
+    SYS_WRITEV = 20,
     SYS_PIPE = 22,
-    SYS_EXIT = 60,
+    SYS_SELECT = 23,
+    SYS_SCHED_YIELD = 24,
+    SYS_DUP = 32,
+    SYS_DUP2 = 33,
+    SYS_GETPID = 39,
     SYS_FORK = 57,
+    SYS_EXECVE = 59,
+    SYS_EXIT = 60,
     SYS_WAITPID = 61,
+    SYS_FCNTL = 72,
+    SYS_FSYNC = 74,
     SYS_MKDIR = 83,
     SYS_RMDIR = 84,
     SYS_UNLINK = 87,
+    SYS_GETTIMEOFDAY = 96,
+    SYS_GETRLIMIT = 97,
+    SYS_SCHED_SETPARAM = 142,
+    SYS_SCHED_GETPARAM = 143,
+    SYS_SCHED_SETSCHEDULER = 144,
+    SYS_SCHED_GETSCHEDULER = 145,
+    SYS_SCHED_GET_PRIORITY_MAX = 146,
+    SYS_SCHED_GET_PRIORITY_MIN = 147,
+    SYS_SETRLIMIT = 160,
+    SYS_FUTEX = 202,
+    SYS_EPOLL_CREATE = 213,
+    SYS_GETDENTS64 = 217,
+    SYS_CLOCK_GETTIME = 228,
+    SYS_EPOLL_WAIT = 232,
+    SYS_EPOLL_CTL = 233,
+    SYS_PSELECT6 = 270,
+    SYS_PPOLL = 271,
+    SYS_EPOLL_PWAIT = 281,
+    SYS_EPOLL_CREATE1 = 291,
+    SYS_DUP3 = 292,
+    SYS_PIPE2 = 293,
+    SYS_PREADV = 295,
+    SYS_PWRITEV = 296,
+    SYS_PRLIMIT64 = 302,
+    SYS_GETCPU = 309,
 };
 
-// Simple pipe implementation
-struct PipeObj {
-    uint8_t *buf;
-    size_t cap;
-    size_t rpos;
-    size_t wpos;
-    int refs;
+// Linux struct sched_param
+struct SchedParam {
+    int sched_priority;
 };
 
-extern "C" uint64_t syscall_dispatch(uint64_t num, uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f) {
-    (void)d; (void)e; (void)f;
+// Linux struct rlimit / rlimit64
+struct RLimit {
+    uint64_t rlim_cur;
+    uint64_t rlim_max;
+};
+
+#define RLIMIT_NOFILE 7
+#define RLIM_NLIMITS 16
+#define RLIM_INFINITY (~0ULL)
+
+// ==========================================================
+// Handlers
+// ==========================================================
+// Every handler takes the six raw argument registers and returns either a
+// non-negative result or a negative value on failure.
+#define SYSCALL_ARGS uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f
 
+// FD table of the calling task.
+static struct FDTable* current_fdtable() {
     hanacore::scheduler::Task* cur = hanacore::scheduler::current_task;
-    if (!cur || !cur->fds) return (uint64_t)-1;
-    struct FDEntry* tbl = cur->fds;
-    int cnt = cur->fd_count;
-
-    switch (num) {
-        case SYS_WRITE: {
-            int fd = (int)a;
-            const char* buf = (const char*)(uintptr_t)b;
-            size_t count = (size_t)c;
-            struct FDEntry* ent = fdtable_get(tbl, cnt, fd);
-            if (!ent) return (uint64_t)-1;
-
-            if (ent->type == FD_TTY) {
-                if (buf) tty_write(buf);
-                return count;
-            } else if (ent->type == FD_PIPE_WRITE) {
-                struct PipeObj* p = (struct PipeObj*)ent->pipe_obj;
-                if (!p) return (uint64_t)-1;
-                size_t written = 0;
-                for (size_t i = 0; i < count; ++i) {
-                    size_t next = (p->wpos + 1) % p->cap;
-                    if (next == p->rpos) break;
-                    p->buf[p->wpos] = (uint8_t)buf[i];
-                    p->wpos = next;
-                    ++written;
-                }
-                return written;
-            } else if (ent->type == FD_FILE) {
-                size_t needed = ent->pos + count;
-                if (needed > ent->len) {
-                    uint8_t* nb = (uint8_t*)hanacore::mem::kmalloc(needed);
-                    if (!nb) return (uint64_t)-1;
-                    for (size_t i = 0; i < ent->len; ++i) nb[i] = ent->buf[i];
-                    for (size_t i = ent->len; i < needed; ++i) nb[i] = 0;
-                    if (ent->buf) hanacore::mem::kfree(ent->buf);
-                    ent->buf = nb; ent->len = needed;
-                }
-                for (size_t i = 0; i < count; ++i) ent->buf[ent->pos + i] = (uint8_t)buf[i];
-                ent->pos += count;
-                return count;
-            }
-            return (uint64_t)-1;
-        }
+    return cur ? cur->fds : NULL;
+}
 
-        case SYS_READ: {
-            int fd = (int)a;
-            char* buf = (char*)(uintptr_t)b;
-            size_t count = (size_t)c;
-            struct FDEntry* ent = fdtable_get(tbl, cnt, fd);
-            if (!ent) return (uint64_t)-1;
-
-            if (ent->type == FD_FILE) {
-                size_t avail = ent->len > ent->pos ? (ent->len - ent->pos) : 0;
-                size_t tocopy = avail < count ? avail : count;
-                if (tocopy > 0 && buf) {
-                    for (size_t i = 0; i < tocopy; ++i) buf[i] = (char)ent->buf[ent->pos + i];
-                }
-                ent->pos += tocopy;
-                return tocopy;
-            } else if (ent->type == FD_PIPE_READ) {
-                struct PipeObj* p = (struct PipeObj*)ent->pipe_obj;
-                if (!p) return (uint64_t)-1;
-                size_t available = (p->wpos + p->cap - p->rpos) % p->cap;
-                size_t toread = available < count ? available : count;
-                for (size_t i = 0; i < toread; ++i) {
-                    buf[i] = (char)p->buf[(p->rpos + i) % p->cap];
-                }
-                p->rpos = (p->rpos + toread) % p->cap;
-                return toread;
-            }
-            return (uint64_t)-1;
-        }
+static struct FDEntry* current_fd(int fd) {
+    struct FDTable* tbl = current_fdtable();
+    return fdtable_get(tbl, fd);
+}
 
-        case SYS_OPEN: {
-            const char* path = (const char*)(uintptr_t)a;
-            int flags = (int)b;
-            mode_t mode = (mode_t)c; // ignored for now
-            if (!path) return (uint64_t)-1;
+static int64_t sys_write(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_write(current_fd((int)a), (const void*)(uintptr_t)b, (size_t)c);
+}
 
-            size_t len = 0;
-            void* data = hanacore::fs::get_file_alloc(path, &len);
-            if (!data && (flags & O_CREAT)) ramfs_create_file(path);
+static int64_t sys_read(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_read(current_fd((int)a), (void*)(uintptr_t)b, (size_t)c);
+}
 
-            int fd = fdtable_alloc_fd(tbl, cnt);
-            if (fd < 0) { if (data) hanacore::mem::kfree(data); return (uint64_t)-1; }
+static int64_t sys_open(SYSCALL_ARGS) {
+    struct FDTable* tbl = current_fdtable();
+    return hanacore::userland::fileio_open(tbl, (const char*)(uintptr_t)a, (int)b);
+}
 
-            struct FDEntry* ent = &tbl[fd];
-            ent->type = FD_FILE;
-            ent->path = (char*)hanacore::mem::kmalloc(strlen(path)+1);
-            if (ent->path) strcpy(ent->path, path);
+static int64_t sys_execve(SYSCALL_ARGS) {
+    using hanacore::scheduler::Task;
+    int64_t pid = hanacore::userland::spawn((const char*)(uintptr_t)a, (const char* const*)(uintptr_t)b,
+                                           (const char* const*)(uintptr_t)c, nullptr, 0);
+    if (pid < 0) return pid;
+
+    // Emulate execve semantics: the new task takes the caller's place in
+    // the process tree (it got a copy of the descriptors) and the caller
+    // goes away. The pid changes; this is a simplification.
+    Task* self = hanacore::scheduler::current_task;
+    if (self) {
+        Task* t = hanacore::scheduler::find_task_by_pid((int)pid);
+        if (t) t->parent_pid = self->parent_pid;
+        hanacore::userland::fileio_close_all(self->fds);
+        self->state = hanacore::scheduler::TASK_DEAD;
+    }
+    hanacore::scheduler::schedule_next();
+    return -ENOEXEC; // should not return on success
+}
 
-            if (data && len > 0) { ent->buf = (uint8_t*)data; ent->len = len; } 
-            else { ent->buf = NULL; ent->len = 0; if (data) hanacore::mem::kfree(data); }
+static int64_t sys_pread64(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_pread(current_fd((int)a), (void*)(uintptr_t)b, (size_t)c, d);
+}
 
-            if (ent->buf && (flags & O_TRUNC)) { hanacore::mem::kfree(ent->buf); ent->buf=NULL; ent->len=0; }
-            ent->pos = (flags & O_APPEND) ? ent->len : 0;
-            ent->flags = flags;
-            return fd;
-        }
+static int64_t sys_pwrite64(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_pwrite(current_fd((int)a), (const void*)(uintptr_t)b, (size_t)c, d);
+}
 
-        // Linux: SYS_execve = 59
-        case 59: /* execve */ {
-            const char* path = (const char*)(uintptr_t)a;
-            char **argv = (char**)(uintptr_t)b;
-            (void)argv; // not currently passed to loader
-            (void)c; // envp
-            if (!path) return (uint64_t)-1;
-            size_t len = 0;
-            void* data = hanacore::fs::get_file_alloc(path, &len);
-            if (!data || len == 0) {
-                if (data) hanacore::mem::kfree(data);
-                return (uint64_t)-1;
-            }
-            void* entry = elf64_load_from_memory(data, len);
-            // free VFS buffer returned
-            hanacore::mem::kfree(data);
-            if (!entry) return (uint64_t)-1;
-
-            // Create user task to run the entry. Use reasonable stack size.
-            const size_t USER_STACK = 64 * 1024;
-            int pid = hanacore::scheduler::create_user_task(entry, USER_STACK);
-            if (pid == 0) return (uint64_t)-1;
-
-            // Emulate execve semantics: replace current task by marking it dead
-            // and switch to the new task. This is a simplification.
-            if (hanacore::scheduler::current_task) {
-                hanacore::scheduler::current_task->state = hanacore::scheduler::TASK_DEAD;
-            }
-            hanacore::scheduler::schedule_next();
-            return (uint64_t)-1; // should not return on success
-        }
+static int64_t sys_readv(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_readv(current_fd((int)a), (const struct IoVec*)(uintptr_t)b, (int)c);
+}
 
-        case SYS_CLOSE: {
-            int fd = (int)a;
-            struct FDEntry* ent = fdtable_get(tbl, cnt, fd);
-            if (!ent) return (uint64_t)-1;
+static int64_t sys_writev(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_writev(current_fd((int)a), (const struct IoVec*)(uintptr_t)b, (int)c);
+}
 
-            if (ent->type == FD_FILE && ent->path) hanacore::fs::hanafs_write_file(ent->path, ent->buf, ent->len);
+// preadv/pwritev pass the offset split into low/high halves (d, e); on
+// x86_64 the low half already holds all 64 bits.
+static int64_t sys_preadv(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_preadv(current_fd((int)a), (const struct IoVec*)(uintptr_t)b, (int)c, d);
+}
 
-            if (ent->path) hanacore::mem::kfree(ent->path);
-            if (ent->buf) hanacore::mem::kfree(ent->buf);
-            ent->type = FD_NONE; ent->path=NULL; ent->buf=NULL; ent->len=0; ent->pos=0;
-            return 0;
-        }
+static int64_t sys_pwritev(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_pwritev(current_fd((int)a), (const struct IoVec*)(uintptr_t)b, (int)c, d);
+}
 
-        case SYS_LSEEK: {
-            int fd = (int)a;
-            int64_t offset = (int64_t)b;
-            int whence = (int)c;
-            struct FDEntry* ent = fdtable_get(tbl, cnt, fd);
-            if (!ent || ent->type != FD_FILE) return (uint64_t)-1;
-
-            int64_t newpos = 0;
-            if (whence == SEEK_SET) newpos = offset;
-            else if (whence == SEEK_CUR) newpos = (int64_t)ent->pos + offset;
-            else if (whence == SEEK_END) newpos = (int64_t)ent->len + offset;
-
-            if (newpos < 0) return (uint64_t)-1;
-            if ((size_t)newpos > ent->len) newpos = ent->len;
-            ent->pos = (size_t)newpos;
-            return ent->pos;
-        }
+// ioctl requests understood so far.
+enum {
+    TCGETS = 0x5401,            // console: read struct termios
+    TCSETS = 0x5402,            // console: set termios now
+    TCSETSW = 0x5403,           // ... after output drains
+    TCSETSF = 0x5404,           // ... and discard pending input
+    TIOCGPTN = 0x80045430,      // pty master: number of the slave (/dev/pts/N)
+};
 
-        case SYS_DUP2: {
-            int oldfd = (int)a;
-            int newfd = (int)b;
-            if (oldfd == newfd) return newfd;
-            struct FDEntry* olde = fdtable_get(tbl, cnt, oldfd);
-            struct FDEntry* nde = fdtable_get(tbl, cnt, newfd);
-            if (!olde || olde->type==FD_NONE) return -1;
-            if (nde && nde->type!=FD_NONE) {
-                if (nde->path) hanacore::mem::kfree(nde->path);
-                if (nde->buf) hanacore::mem::kfree(nde->buf);
-                nde->type = FD_NONE; nde->path=NULL; nde->buf=NULL; nde->len=0; nde->pos=0;
-            }
-            if (olde->path) {
-                nde->path = (char*)hanacore::mem::kmalloc(strlen(olde->path)+1);
-                strcpy(nde->path, olde->path);
-            }
-            if (olde->buf && olde->len>0) {
-                nde->buf = (uint8_t*)hanacore::mem::kmalloc(olde->len);
-                for (size_t i=0;i<olde->len;i++) nde->buf[i]=olde->buf[i];
-                nde->len=olde->len;
-            }
-            nde->pos=olde->pos; nde->flags=olde->flags; nde->type=olde->type;
-            return newfd;
-        }
+static int64_t sys_ioctl(SYSCALL_ARGS) {
+    struct FDEntry* ent = current_fd((int)a);
+    if (!ent || ent->type == FD_NONE) return -EBADF;
+    switch ((uint32_t)b) {
+    case TCGETS: {
+        struct tty_termios* out = (struct tty_termios*)(uintptr_t)c;
+        if (ent->type != FD_TTY) return -ENOTTY;
+        if (!out) return -EFAULT;
+        tty_tcgetattr(out);
+        return 0;
+    }
+    case TCSETS:
+    case TCSETSW:
+    case TCSETSF: {
+        const struct tty_termios* in = (const struct tty_termios*)(uintptr_t)c;
+        if (ent->type != FD_TTY) return -ENOTTY;
+        if (!in) return -EFAULT;
+        tty_tcsetattr(in, (int)((uint32_t)b - TCSETS));
+        return 0;
+    }
+    case TIOCGPTN: {
+        unsigned* out = (unsigned*)(uintptr_t)c;
+        if (ent->type != FD_PTY_MASTER) return -ENOTTY;
+        if (!out) return -EFAULT;
+        *out = (unsigned)ent->file->pty_id;
+        return 0;
+    }
+    }
+    return -ENOTTY;
+}
 
-        case SYS_PIPE: {
-            int* fds = (int*)(uintptr_t)a;
-            if (!fds) return -1;
-            int rd = fdtable_alloc_fd(tbl, cnt);
-            int wr = fdtable_alloc_fd(tbl, cnt);
-            if (rd<0 || wr<0) return -1;
-            struct PipeObj* p = (struct PipeObj*)hanacore::mem::kmalloc(sizeof(PipeObj));
-            p->cap=4096; p->buf=(uint8_t*)hanacore::mem::kmalloc(p->cap); p->rpos=0; p->wpos=0; p->refs=2;
-            struct FDEntry* rde=&tbl[rd]; struct FDEntry* wre=&tbl[wr];
-            rde->type=FD_PIPE_READ; rde->pipe_obj=p;
-            wre->type=FD_PIPE_WRITE; wre->pipe_obj=p;
-            fds[0]=rd; fds[1]=wr;
-            return 0;
-        }
+static int64_t sys_close(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_close(current_fdtable(), (int)a);
+}
 
-        case SYS_STAT: {
-            const char* path = (const char*)(uintptr_t)a;
-            struct hana_stat* st = (struct hana_stat*)(uintptr_t)b;
-            if (!path || !st) return -1;
-            return ::hanafs_stat(path, st)==0 ? 0 : -1;
-        }
+static int64_t sys_fsync(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_fsync(current_fd((int)a));
+}
+
+static int64_t sys_lseek(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_lseek(current_fd((int)a), (int64_t)b, (int)c);
+}
+
+static int64_t sys_getdents64(SYSCALL_ARGS) {
+    return hanacore::userland::fileio_getdents64(current_fd((int)a), (void*)(uintptr_t)b, (size_t)c);
+}
+
+// dup/dup2/dup3 share the open file description: O(1) whatever is open.
+static int64_t sys_dup(SYSCALL_ARGS) {
+    struct FDTable* tbl = current_fdtable();
+    return hanacore::userland::fileio_dup(tbl, (int)a, 0, 0);
+}
+
+static int64_t sys_dup3(SYSCALL_ARGS) {
+    int oldfd = (int)a;
+    int newfd = (int)b;
+    int flags = (int)c;
+    if (flags & ~O_CLOEXEC) return -EINVAL;
+    if (oldfd == newfd) return -EINVAL;
+    struct FDTable* tbl = current_fdtable();
+    struct FDEntry* olde = fdtable_get(tbl, oldfd);
+    if (!olde || olde->type == FD_NONE) return -EBADF;
+    int64_t r = hanacore::userland::fileio_dup_into(tbl, newfd, olde);
+    if (r < 0) return r;
+    fdtable_get(tbl, newfd)->fd_flags = (flags & O_CLOEXEC) ? FD_CLOEXEC : 0;
+    return newfd;
+}
+
+static int64_t sys_dup2(SYSCALL_ARGS) {
+    int oldfd = (int)a;
+    int newfd = (int)b;
+    struct FDEntry* olde = current_fd(oldfd);
+    if (!olde || olde->type == FD_NONE) return -EBADF;
+    if (oldfd == newfd) return newfd;
+    return sys_dup3(a, b, 0, d, e, f);
+}
+
+static int64_t sys_pipe2(SYSCALL_ARGS) {
+    struct FDTable* tbl = current_fdtable();
+    return hanacore::userland::fileio_pipe(tbl, (int*)(uintptr_t)a, (int)b);
+}
+
+static int64_t sys_pipe(SYSCALL_ARGS) {
+    return sys_pipe2(a, 0, c, d, e, f);
+}
+
+static int64_t sys_fcntl(SYSCALL_ARGS) {
+    int cmd = (int)b;
+    if (cmd == F_DUPFD || cmd == F_DUPFD_CLOEXEC) {
+        struct FDTable* tbl = current_fdtable();
+        if (!tbl || (int64_t)c >= tbl->limit) return -EINVAL;
+        return hanacore::userland::fileio_dup(tbl, (int)a, (int)c,
+                                              cmd == F_DUPFD_CLOEXEC ? FD_CLOEXEC : 0);
+    }
+    return hanacore::userland::fileio_fcntl(current_fd((int)a), cmd, c);
+}
 
-        case SYS_FSTAT: {
-            int fd=(int)a; struct hana_stat* st=(struct hana_stat*)(uintptr_t)b;
-            struct FDEntry* ent = fdtable_get(tbl,cnt,fd);
-            if (!ent || !st) return -1;
-            if (ent->type==FD_FILE && ent->path) return ::hanafs_stat(ent->path, st)==0 ? 0 : -1;
-            memset(st,0,sizeof(*st));
-            st->st_size=ent->len;
-            st->st_mode=(ent->type==FD_TTY)?0x2000:0;
-            return 0;
+// Readiness. There are no signals yet, so the sigmask arguments of ppoll,
+// pselect6 and epoll_pwait are accepted and ignored.
+
+// Timeout in ns from a millisecond count (negative: wait forever).
+static int64_t timeout_from_ms(int ms) {
+    return ms < 0 ? -1 : (int64_t)ms * 1000000LL;
+}
+
+// Timeout in ns from an optional timespec (NULL: wait forever, -1);
+// -EINVAL for a malformed one.
+static int64_t timeout_from_timespec(const struct hana_timespec* ts) {
+    if (!ts) return -1;
+    if (ts->tv_sec < 0 || ts->tv_nsec < 0 || ts->tv_nsec >= 1000000000LL) return -EINVAL;
+    if (ts->tv_sec > INT64_MAX / 1000000000LL - 1) return INT64_MAX;
+    return ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+static int64_t sys_poll(SYSCALL_ARGS) {
+    struct FDTable* tbl = current_fdtable();
+    return hanacore::userland::poll_fds(tbl, (struct PollFd*)(uintptr_t)a, b, timeout_from_ms((int)c));
+}
+
+static int64_t sys_ppoll(SYSCALL_ARGS) {
+    struct FDTable* tbl = current_fdtable();
+    int64_t timeout = timeout_from_timespec((const struct hana_timespec*)(uintptr_t)c);
+    if (timeout < -1) return timeout;
+    return hanacore::userland::poll_fds(tbl, (struct PollFd*)(uintptr_t)a, b, timeout);
+}
+
+// select() on top of poll_fds: fd_sets are bitmaps of 64-bit words.
+static int64_t do_select(int nfds, uint64_t* rd, uint64_t* wr, uint64_t* ex, int64_t timeout_ns) {
+    struct FDTable* tbl = current_fdtable();
+    if (!tbl || nfds < 0 || nfds > tbl->limit) return -EINVAL;
+    if (timeout_ns < -1) return timeout_ns;
+    auto isset = [](const uint64_t* set, int fd) { return set && (set[fd / 64] >> (fd % 64)) & 1; };
+
+    struct PollFd* pfds = (struct PollFd*)hanacore::mem::kmalloc(sizeof(struct PollFd) * (nfds ? nfds : 1));
+    if (!pfds) return -ENOMEM;
+    int n = 0;
+    for (int fd = 0; fd < nfds; ++fd) {
+        short ev = 0;
+        if (isset(rd, fd)) ev |= POLLIN;
+        if (isset(wr, fd)) ev |= POLLOUT;
+        if (isset(ex, fd)) ev |= POLLPRI;
+        if (!ev) continue;
+        pfds[n].fd = fd;
+        pfds[n].events = ev;
+        pfds[n].revents = 0;
+        ++n;
+    }
+    int64_t r = hanacore::userland::poll_fds(tbl, pfds, (uint64_t)n, timeout_ns);
+    if (r >= 0) {
+        size_t words = ((size_t)nfds + 63) / 64;
+        if (rd) memset(rd, 0, words * 8);
+        if (wr) memset(wr, 0, words * 8);
+        if (ex) memset(ex, 0, words * 8);
+        r = 0;
+        for (int i = 0; i < n; ++i) {
+            short re = pfds[i].revents;
+            int fd = pfds[i].fd;
+            uint64_t bit = 1ULL << (fd % 64);
+            if (re & POLLNVAL) { r = -EBADF; break; }
+            if ((pfds[i].events & POLLIN) && (re & (POLLIN | POLLHUP | POLLERR))) { rd[fd / 64] |= bit; ++r; }
+            if ((pfds[i].events & POLLOUT) && (re & (POLLOUT | POLLERR))) { wr[fd / 64] |= bit; ++r; }
+            if ((pfds[i].events & POLLPRI) && (re & POLLPRI)) { ex[fd / 64] |= bit; ++r; }
         }
+    }
+    hanacore::mem::kfree(pfds);
+    return r;
+}
+
+static int64_t sys_select(SYSCALL_ARGS) {
+    const struct hana_timeval* tv = (const struct hana_timeval*)(uintptr_t)e;
+    int64_t timeout = -1;
+    if (tv) {
+        if (tv->tv_sec < 0 || tv->tv_usec < 0 || tv->tv_usec >= 1000000) return -EINVAL;
+        timeout = tv->tv_sec * 1000000000LL + tv->tv_usec * 1000LL;
+    }
+    return do_select((int)a, (uint64_t*)(uintptr_t)b, (uint64_t*)(uintptr_t)c, (uint64_t*)(uintptr_t)d, timeout);
+}
+
+static int64_t sys_pselect6(SYSCALL_ARGS) {
+    int64_t timeout = timeout_from_timespec((const struct hana_timespec*)(uintptr_t)e);
+    return do_select((int)a, (uint64_t*)(uintptr_t)b, (uint64_t*)(uintptr_t)c, (uint64_t*)(uintptr_t)d, timeout);
+}
+
+static int64_t sys_epoll_create1(SYSCALL_ARGS) {
+    // EPOLL_CLOEXEC (== O_CLOEXEC) is the only flag.
+    if ((int)a & ~O_CLOEXEC) return -EINVAL;
+    struct FDTable* tbl = current_fdtable();
+    int64_t fd = hanacore::userland::epoll_create(tbl);
+    if (fd >= 0 && ((int)a & O_CLOEXEC)) fdtable_get(tbl, (int)fd)->fd_flags = FD_CLOEXEC;
+    return fd;
+}
+
+static int64_t sys_epoll_create(SYSCALL_ARGS) {
+    if ((int)a <= 0) return -EINVAL;
+    return sys_epoll_create1(0, b, c, d, e, f);
+}
+
+static int64_t sys_epoll_ctl(SYSCALL_ARGS) {
+    struct FDTable* tbl = current_fdtable();
+    return hanacore::userland::epoll_ctl(tbl, (int)a, (int)b, (int)c,
+                                         (const struct EpollEvent*)(uintptr_t)d);
+}
+
+static int64_t sys_epoll_pwait(SYSCALL_ARGS) {
+    struct FDTable* tbl = current_fdtable();
+    return hanacore::userland::epoll_wait(tbl, (int)a, (struct EpollEvent*)(uintptr_t)b, (int)c,
+                                          timeout_from_ms((int)d));
+}
 
-        // Linux: SYS_exit = 60 ; HANA_SYSCALL_EXIT also maps to exit
-    case SYS_EXIT: {
-            int code = (int)a;
-            (void)code;
-            log_info("sys_exit: marking current task as dead (code=%d)", code);
-            if (hanacore::scheduler::current_task) {
-                hanacore::scheduler::current_task->exit_status = code;
-                hanacore::scheduler::current_task->state = hanacore::scheduler::TASK_DEAD;
+static int64_t sys_epoll_wait(SYSCALL_ARGS) {
+    return sys_epoll_pwait(a, b, c, d, 0, 0);
+}
+
+static int64_t sys_futex(SYSCALL_ARGS) {
+    volatile uint32_t* uaddr = (volatile uint32_t*)(uintptr_t)a;
+    int op = (int)b;
+    int cmd = op & ~(FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME);
+    uint32_t val = (uint32_t)c;
+    switch (cmd) {
+    case FUTEX_WAIT:
+    case FUTEX_WAIT_BITSET: {
+        // FUTEX_WAIT takes a relative timeout, FUTEX_WAIT_BITSET an absolute
+        // one on CLOCK_MONOTONIC (or CLOCK_REALTIME with the flag).
+        const struct hana_timespec* ts = (const struct hana_timespec*)(uintptr_t)d;
+        uint64_t deadline = 0;
+        if (ts) {
+            if (ts->tv_sec < 0 || ts->tv_nsec < 0 || ts->tv_nsec >= 1000000000LL) return -EINVAL;
+            uint64_t ns = (uint64_t)ts->tv_sec * 1000000000ULL + (uint64_t)ts->tv_nsec;
+            if (cmd == FUTEX_WAIT) {
+                deadline = hanacore::sync::wait_deadline_after(ns);
+            } else if (op & FUTEX_CLOCK_REALTIME) {
+                int64_t mono = (int64_t)ns - hanacore::arch::clock_realtime_offset_ns();
+                deadline = mono > 0 ? (uint64_t)mono : 1;
+            } else {
+                deadline = ns ? ns : 1;
             }
-            // Switch to next task; this function does not return for exited task
-            hanacore::scheduler::schedule_next();
-            return 0;
         }
+        uint32_t bitset = cmd == FUTEX_WAIT ? FUTEX_BITSET_MATCH_ANY : (uint32_t)f;
+        return hanacore::userland::futex_wait(uaddr, val, deadline, bitset);
+    }
+    case FUTEX_WAKE:
+        return hanacore::userland::futex_wake(uaddr, (int)val, FUTEX_BITSET_MATCH_ANY);
+    case FUTEX_WAKE_BITSET:
+        return hanacore::userland::futex_wake(uaddr, (int)val, (uint32_t)f);
+    case FUTEX_REQUEUE:
+    case FUTEX_CMP_REQUEUE:
+        // The fourth argument carries nr_requeue instead of a timeout.
+        return hanacore::userland::futex_requeue(uaddr, (volatile uint32_t*)(uintptr_t)e, (int)val,
+                                                 (int)(uint32_t)d, cmd == FUTEX_CMP_REQUEUE, (uint32_t)f);
+    }
+    return -ENOSYS;
+}
 
-        // Linux: SYS_waitpid = 61
-        case SYS_WAITPID:
-        case HANA_SYSCALL_WAITPID: {
-            int pid = (int)a;
-            (void)b;
-            hanacore::scheduler::Task* t = hanacore::scheduler::find_task_by_pid(pid);
-            if (!t) return -1;
-            while (t->state != hanacore::scheduler::TASK_DEAD) hanacore::scheduler::sched_yield();
-            return pid;
+static int64_t sys_stat(SYSCALL_ARGS) {
+    const char* path = (const char*)(uintptr_t)a;
+    struct hana_stat* st = (struct hana_stat*)(uintptr_t)b;
+    if (!path || !st) return -EFAULT;
+    if (vfs_stat(path, st) == 0) return 0;
+    // Filesystems without a stat op still know the type, and the size
+    // through an open file.
+    int type = vfs_lookup(path);
+    if (type < 0) return -ENOENT;
+    memset(st, 0, sizeof(*st));
+    st->st_mode = type == VFS_TYPE_DIR ? 0x4000 : 0x8000;
+    if (type == VFS_TYPE_FILE) {
+        struct vfs_file* f = vfs_open(path, 0);
+        if (f) {
+            st->st_size = vfs_file_size(f);
+            vfs_close(f);
         }
+    }
+    return 0;
+}
 
-        case SYS_MKDIR: {
-            const char* path=(const char*)(uintptr_t)a;
-            return path?hanacore::fs::hanafs_make_dir(path)==0?0:-1:-1;
-        }
+static int64_t sys_fstat(SYSCALL_ARGS) {
+    int fd=(int)a; struct hana_stat* st=(struct hana_stat*)(uintptr_t)b;
+    struct FDEntry* ent = current_fd(fd);
+    if (!ent || ent->type==FD_NONE) return -EBADF;
+    if (!st) return -EFAULT;
+    if (ent->type==FD_FILE && ent->file->path && vfs_stat(ent->file->path, st)==0) return 0;
+    memset(st,0,sizeof(*st));
+    st->st_size=hanacore::userland::fileio_size(ent);
+    bool chr = ent->type==FD_TTY || ent->type==FD_PTY_MASTER || ent->type==FD_PTY_SLAVE;
+    bool fifo = ent->type==FD_PIPE_READ || ent->type==FD_PIPE_WRITE;
+    st->st_mode=chr?0x2000:fifo?0x1000:ent->type==FD_DIR?0x4000:ent->type==FD_FILE?0x8000:0;
+    return 0;
+}
 
-        case SYS_RMDIR: {
-            const char* path=(const char*)(uintptr_t)a;
-            return path?hanacore::fs::hanafs_remove_dir(path)==0?0:-1:-1;
-        }
+static int64_t sys_exit(SYSCALL_ARGS) {
+    int code = (int)a;
+    log_info("sys_exit: marking current task as dead (code=%d)", code);
+    if (hanacore::scheduler::current_task) {
+        // Close descriptors while we can still sleep: rings wait for their
+        // in-flight requests, files are written back.
+        hanacore::userland::fileio_close_all(hanacore::scheduler::current_task->fds);
+        hanacore::scheduler::current_task->exit_status = code;
+        hanacore::scheduler::current_task->state = hanacore::scheduler::TASK_DEAD;
+    }
+    // Switch to next task; this function does not return for exited task
+    hanacore::scheduler::schedule_next();
+    return 0;
+}
 
-        case SYS_UNLINK: {
-            const char* path=(const char*)(uintptr_t)a;
-            return path?hanacore::fs::hanafs_unlink(path)==0?0:-1:-1;
-        }
+static int64_t sys_waitpid(SYSCALL_ARGS) {
+    int pid = (int)a;
+    if (!hanacore::scheduler::find_task_by_pid(pid)) return -ECHILD;
+    // wait_task re-looks the pid up each round: the task may be reaped
+    // (and freed) as soon as it is DEAD.
+    hanacore::scheduler::wait_task(pid);
+    return pid;
+}
+
+// Filesystems only report failure; name the likely cause from what is at
+// `path` before the call.
+static int64_t sys_mkdir(SYSCALL_ARGS) {
+    const char* path=(const char*)(uintptr_t)a;
+    if (!path) return -EFAULT;
+    if (vfs_lookup(path) >= 0) return -EEXIST;
+    return vfs_make_dir(path)==0 ? 0 : -ENOENT;
+}
+
+static int64_t sys_rmdir(SYSCALL_ARGS) {
+    const char* path=(const char*)(uintptr_t)a;
+    if (!path) return -EFAULT;
+    int type = vfs_lookup(path);
+    if (type < 0) return -ENOENT;
+    if (type != VFS_TYPE_DIR) return -ENOTDIR;
+    return vfs_remove_dir(path)==0 ? 0 : -ENOTEMPTY;
+}
+
+static int64_t sys_unlink(SYSCALL_ARGS) {
+    const char* path=(const char*)(uintptr_t)a;
+    if (!path) return -EFAULT;
+    int type = vfs_lookup(path);
+    if (type < 0) return -ENOENT;
+    if (type == VFS_TYPE_DIR) return -EISDIR;
+    return vfs_unlink(path)==0 ? 0 : -EIO;
+}
 
-        default:
-            log_info("sys_unknown");
-            return (uint64_t)-1;
+static int64_t sys_sched_yield(SYSCALL_ARGS) {
+    hanacore::scheduler::sched_yield();
+    return 0;
+}
+
+// sched_setscheduler fails for an unknown pid or a bad policy/priority;
+// the pid is checked first so the two can be told apart.
+static int64_t set_policy(int pid, int policy, int prio) {
+    if (hanacore::scheduler::sched_getscheduler(pid) < 0) return -ESRCH;
+    return hanacore::scheduler::sched_setscheduler(pid, policy, prio) == 0 ? 0 : -EINVAL;
+}
+
+static int64_t sys_sched_setscheduler(SYSCALL_ARGS) {
+    const SchedParam* sp = (const SchedParam*)(uintptr_t)c;
+    if (!sp) return -EFAULT;
+    return set_policy((int)a, (int)b, sp->sched_priority);
+}
+
+static int64_t sys_sched_setparam(SYSCALL_ARGS) {
+    const SchedParam* sp = (const SchedParam*)(uintptr_t)b;
+    if (!sp) return -EFAULT;
+    int policy = hanacore::scheduler::sched_getscheduler((int)a);
+    if (policy < 0) return -ESRCH;
+    return set_policy((int)a, policy, sp->sched_priority);
+}
+
+static int64_t sys_sched_getscheduler(SYSCALL_ARGS) {
+    int policy = hanacore::scheduler::sched_getscheduler((int)a);
+    return policy < 0 ? -ESRCH : policy;
+}
+
+static int64_t sys_sched_getparam(SYSCALL_ARGS) {
+    SchedParam* sp = (SchedParam*)(uintptr_t)b;
+    if (!sp) return -EFAULT;
+    int prio = hanacore::scheduler::sched_getparam((int)a);
+    if (prio < 0) return -ESRCH;
+    sp->sched_priority = prio;
+    return 0;
+}
+
+// Resource limits. Only RLIMIT_NOFILE is enforced (by the FD table); the
+// others read as unlimited and cannot be changed.
+static int64_t do_prlimit(hanacore::scheduler::Task* t, int resource, const RLimit* nl, RLimit* ol) {
+    if (resource < 0 || resource >= RLIM_NLIMITS) return -EINVAL;
+    if (!t || !t->fds) return -ESRCH;
+    RLimit cur = { RLIM_INFINITY, RLIM_INFINITY };
+    if (resource == RLIMIT_NOFILE) {
+        cur.rlim_cur = (uint64_t)t->fds->limit;
+        cur.rlim_max = (uint64_t)t->fds->limit_max;
     }
+    if (nl) {
+        if (resource != RLIMIT_NOFILE) return -EINVAL;
+        int64_t r = fdtable_set_limit(t->fds, nl->rlim_cur, nl->rlim_max);
+        if (r < 0) return r;
+    }
+    if (ol) *ol = cur;
+    return 0;
+}
+
+static int64_t sys_getrlimit(SYSCALL_ARGS) {
+    RLimit* out = (RLimit*)(uintptr_t)b;
+    if (!out) return -EFAULT;
+    return do_prlimit(hanacore::scheduler::current_task, (int)a, nullptr, out);
+}
+
+static int64_t sys_setrlimit(SYSCALL_ARGS) {
+    const RLimit* in = (const RLimit*)(uintptr_t)b;
+    if (!in) return -EFAULT;
+    return do_prlimit(hanacore::scheduler::current_task, (int)a, in, nullptr);
+}
+
+static int64_t sys_prlimit64(SYSCALL_ARGS) {
+    int pid = (int)a;
+    hanacore::scheduler::Task* t = pid == 0 ? hanacore::scheduler::current_task
+                                            : hanacore::scheduler::find_task_by_pid(pid);
+    if (!t) return -ESRCH;
+    return do_prlimit(t, (int)b, (const RLimit*)(uintptr_t)c, (RLimit*)(uintptr_t)d);
+}
+
+static int64_t sched_priority_bound(int policy, bool want_max) {
+    if (policy == hanacore::scheduler::SCHED_NORMAL) return 0;
+    if (policy != hanacore::scheduler::SCHED_FIFO && policy != hanacore::scheduler::SCHED_RR)
+        return -EINVAL;
+    return want_max ? hanacore::scheduler::SCHED_RT_PRIO_MAX : hanacore::scheduler::SCHED_RT_PRIO_MIN;
+}
+
+static int64_t sys_sched_get_priority_max(SYSCALL_ARGS) {
+    return sched_priority_bound((int)a, true);
 }
+
+static int64_t sys_sched_get_priority_min(SYSCALL_ARGS) {
+    return sched_priority_bound((int)a, false);
+}
+
+// Slow paths for the vDSO calls. User space normally never gets here; these
+// serve callers that have not looked up the vDSO and clocks the vDSO does
+// not handle.
+enum {
+    CLOCK_REALTIME = 0,
+    CLOCK_MONOTONIC = 1,
+    CLOCK_MONOTONIC_RAW = 4,
+    CLOCK_REALTIME_COARSE = 5,
+    CLOCK_MONOTONIC_COARSE = 6,
+    CLOCK_BOOTTIME = 7,
+};
+
+static int64_t sys_clock_gettime(SYSCALL_ARGS) {
+    struct hana_timespec* ts = (struct hana_timespec*)(uintptr_t)b;
+    uint64_t ns;
+    switch ((int)a) {
+    case CLOCK_REALTIME:
+    case CLOCK_REALTIME_COARSE:
+        ns = hanacore::arch::clock_realtime_ns();
+        break;
+    case CLOCK_MONOTONIC:
+    case CLOCK_MONOTONIC_RAW:
+    case CLOCK_MONOTONIC_COARSE:
+    case CLOCK_BOOTTIME:
+        ns = hanacore::arch::clock_monotonic_ns();
+        break;
+    default:
+        return -EINVAL;
+    }
+    if (!ts) return -EFAULT;
+    ts->tv_sec = (int64_t)(ns / 1000000000ULL);
+    ts->tv_nsec = (int64_t)(ns % 1000000000ULL);
+    return 0;
+}
+
+static int64_t sys_gettimeofday(SYSCALL_ARGS) {
+    struct hana_timeval* tv = (struct hana_timeval*)(uintptr_t)a;
+    int* tz = (int*)(uintptr_t)b;
+    if (tv) {
+        uint64_t ns = hanacore::arch::clock_realtime_ns();
+        tv->tv_sec = (int64_t)(ns / 1000000000ULL);
+        tv->tv_usec = (int64_t)((ns % 1000000000ULL) / 1000);
+    }
+    if (tz) { tz[0] = 0; tz[1] = 0; }
+    return 0;
+}
+
+static int64_t sys_getpid(SYSCALL_ARGS) {
+    return hanacore::scheduler::sched_getpid();
+}
+
+static int64_t sys_getcpu(SYSCALL_ARGS) {
+    unsigned* cpu = (unsigned*)(uintptr_t)a;
+    unsigned* node = (unsigned*)(uintptr_t)b;
+    if (cpu) *cpu = hanacore::arch::this_cpu()->cpu_id;
+    if (node) *node = 0;
+    return 0;
+}
+
+static int64_t sys_hana_vdso(SYSCALL_ARGS) {
+    return (int64_t)(uintptr_t)hanacore::userland::vdso_base();
+}
+
+static int64_t sys_hana_spawn(SYSCALL_ARGS) {
+    (void)f; // flags: none defined yet
+    return hanacore::userland::spawn((const char*)(uintptr_t)a, (const char* const*)(uintptr_t)b,
+                                     (const char* const*)(uintptr_t)c,
+                                     (const struct hana_spawn_file_action*)(uintptr_t)d, (int)e);
+}
+
+static int64_t sys_ioring_setup(SYSCALL_ARGS) {
+    return hanacore::userland::ioring_setup((uint32_t)a, (struct hana_ioring_params*)(uintptr_t)b);
+}
+
+static int64_t sys_ioring_enter(SYSCALL_ARGS) {
+    return hanacore::userland::ioring_enter((int)a, (uint32_t)b, (uint32_t)c, (uint32_t)d);
+}
+
+// ==========================================================
+// Dispatch table
+// ==========================================================
+typedef int64_t (*SyscallHandler)(SYSCALL_ARGS);
+
+// log2 latency buckets: bucket i counts calls that took [2^i, 2^(i+1))
+// TSC cycles (bucket 0 also takes 0 and 1).
+static constexpr int SYSCALL_HIST_BUCKETS = 32;
+
+struct SyscallEntry {
+    uint16_t nr;
+    const char* name;
+    SyscallHandler handler;
+    uint8_t nargs;
+    // Statistics
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t cycles;
+    uint64_t hist[SYSCALL_HIST_BUCKETS];
+};
+
+#define SYSCALL_ENTRY(nr, name, fn, nargs) { (uint16_t)(nr), name, fn, nargs, 0, 0, 0, {} }
+
+static SyscallEntry syscall_entries[] = {
+    SYSCALL_ENTRY(SYS_READ, "read", sys_read, 3),
+    SYSCALL_ENTRY(SYS_WRITE, "write", sys_write, 3),
+    SYSCALL_ENTRY(SYS_OPEN, "open", sys_open, 3),
+    SYSCALL_ENTRY(SYS_CLOSE, "close", sys_close, 1),
+    SYSCALL_ENTRY(SYS_STAT, "stat", sys_stat, 2),
+    SYSCALL_ENTRY(SYS_FSTAT, "fstat", sys_fstat, 2),
+    SYSCALL_ENTRY(SYS_LSEEK, "lseek", sys_lseek, 3),
+    SYSCALL_ENTRY(SYS_IOCTL, "ioctl", sys_ioctl, 3),
+    SYSCALL_ENTRY(SYS_PREAD64, "pread64", sys_pread64, 4),
+    SYSCALL_ENTRY(SYS_PWRITE64, "pwrite64", sys_pwrite64, 4),
+    SYSCALL_ENTRY(SYS_READV, "readv", sys_readv, 3),
+    SYSCALL_ENTRY(SYS_WRITEV, "writev", sys_writev, 3),
+    SYSCALL_ENTRY(SYS_POLL, "poll", sys_poll, 3),
+    SYSCALL_ENTRY(SYS_PIPE, "pipe", sys_pipe, 1),
+    SYSCALL_ENTRY(SYS_SELECT, "select", sys_select, 5),
+    SYSCALL_ENTRY(SYS_SCHED_YIELD, "sched_yield", sys_sched_yield, 0),
+    SYSCALL_ENTRY(SYS_DUP, "dup", sys_dup, 1),
+    SYSCALL_ENTRY(SYS_DUP2, "dup2", sys_dup2, 2),
+    SYSCALL_ENTRY(SYS_EXECVE, "execve", sys_execve, 3),
+    SYSCALL_ENTRY(SYS_EXIT, "exit", sys_exit, 1),
+    SYSCALL_ENTRY(SYS_WAITPID, "wait4", sys_waitpid, 4),
+    SYSCALL_ENTRY(SYS_FCNTL, "fcntl", sys_fcntl, 3),
+    SYSCALL_ENTRY(SYS_FSYNC, "fsync", sys_fsync, 1),
+    SYSCALL_ENTRY(SYS_MKDIR, "mkdir", sys_mkdir, 2),
+    SYSCALL_ENTRY(SYS_RMDIR, "rmdir", sys_rmdir, 1),
+    SYSCALL_ENTRY(SYS_UNLINK, "unlink", sys_unlink, 1),
+    SYSCALL_ENTRY(SYS_SCHED_SETPARAM, "sched_setparam", sys_sched_setparam, 2),
+    SYSCALL_ENTRY(SYS_SCHED_GETPARAM, "sched_getparam", sys_sched_getparam, 2),
+    SYSCALL_ENTRY(SYS_SCHED_SETSCHEDULER, "sched_setscheduler", sys_sched_setscheduler, 3),
+    SYSCALL_ENTRY(SYS_SCHED_GETSCHEDULER, "sched_getscheduler", sys_sched_getscheduler, 1),
+    SYSCALL_ENTRY(SYS_SCHED_GET_PRIORITY_MAX, "sched_get_priority_max", sys_sched_get_priority_max, 1),
+    SYSCALL_ENTRY(SYS_SCHED_GET_PRIORITY_MIN, "sched_get_priority_min", sys_sched_get_priority_min, 1),
+    SYSCALL_ENTRY(SYS_GETPID, "getpid", sys_getpid, 0),
+    SYSCALL_ENTRY(SYS_GETTIMEOFDAY, "gettimeofday", sys_gettimeofday, 2),
+    SYSCALL_ENTRY(SYS_GETRLIMIT, "getrlimit", sys_getrlimit, 2),
+    SYSCALL_ENTRY(SYS_SETRLIMIT, "setrlimit", sys_setrlimit, 2),
+    SYSCALL_ENTRY(SYS_PRLIMIT64, "prlimit64", sys_prlimit64, 4),
+    SYSCALL_ENTRY(SYS_CLOCK_GETTIME, "clock_gettime", sys_clock_gettime, 2),
+    SYSCALL_ENTRY(SYS_GETCPU, "getcpu", sys_getcpu, 3),
+    SYSCALL_ENTRY(SYS_FUTEX, "futex", sys_futex, 6),
+    SYSCALL_ENTRY(SYS_EPOLL_CREATE, "epoll_create", sys_epoll_create, 1),
+    SYSCALL_ENTRY(SYS_GETDENTS64, "getdents64", sys_getdents64, 3),
+    SYSCALL_ENTRY(SYS_EPOLL_WAIT, "epoll_wait", sys_epoll_wait, 4),
+    SYSCALL_ENTRY(SYS_EPOLL_CTL, "epoll_ctl", sys_epoll_ctl, 4),
+    SYSCALL_ENTRY(SYS_PSELECT6, "pselect6", sys_pselect6, 6),
+    SYSCALL_ENTRY(SYS_PPOLL, "ppoll", sys_ppoll, 5),
+    SYSCALL_ENTRY(SYS_EPOLL_PWAIT, "epoll_pwait", sys_epoll_pwait, 6),
+    SYSCALL_ENTRY(SYS_EPOLL_CREATE1, "epoll_create1", sys_epoll_create1, 1),
+    SYSCALL_ENTRY(SYS_DUP3, "dup3", sys_dup3, 3),
+    SYSCALL_ENTRY(SYS_PIPE2, "pipe2", sys_pipe2, 2),
+    SYSCALL_ENTRY(SYS_PREADV, "preadv", sys_preadv, 5),
+    SYSCALL_ENTRY(SYS_PWRITEV, "pwritev", sys_pwritev, 5),
+    SYSCALL_ENTRY(HANA_SYSCALL_SPAWN, "hana_spawn", sys_hana_spawn, 6),
+    SYSCALL_ENTRY(HANA_SYSCALL_WAITPID, "hana_waitpid", sys_waitpid, 2),
+    SYSCALL_ENTRY(HANA_SYSCALL_VDSO, "hana_vdso", sys_hana_vdso, 0),
+    SYSCALL_ENTRY(HANA_SYSCALL_IORING_SETUP, "hana_ioring_setup", sys_ioring_setup, 2),
+    SYSCALL_ENTRY(HANA_SYSCALL_IORING_ENTER, "hana_ioring_enter", sys_ioring_enter, 4),
+};
+
+// Number -> entry. Built on first use from syscall_entries.
+static SyscallEntry* syscall_table[SYSCALL_TABLE_SIZE];
+static bool syscall_table_ready = false;
+static uint64_t syscall_unknown_calls = 0;
+
+static void syscall_table_init() {
+    for (size_t i = 0; i < sizeof(syscall_entries) / sizeof(syscall_entries[0]); ++i) {
+        SyscallEntry* ent = &syscall_entries[i];
+        if (ent->nr < SYSCALL_TABLE_SIZE) syscall_table[ent->nr] = ent;
+    }
+    syscall_table_ready = true;
+}
+
+static inline int latency_bucket(uint64_t cycles) {
+    if (cycles < 2) return 0;
+    int b = 63 - __builtin_clzll(cycles);
+    return b < SYSCALL_HIST_BUCKETS ? b : SYSCALL_HIST_BUCKETS - 1;
+}
+
+extern "C" uint64_t syscall_dispatch(uint64_t num, uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f) {
+    if (!hanacore::scheduler::current_task) return (uint64_t)-1;
+    if (!syscall_table_ready) syscall_table_init();
+
+    SyscallEntry* ent = num < SYSCALL_TABLE_SIZE ? syscall_table[num] : nullptr;
+    if (!ent) {
+        __atomic_fetch_add(&syscall_unknown_calls, 1, __ATOMIC_RELAXED);
+        log_debug("syscall: unknown number %llu", (unsigned long long)num);
+        return (uint64_t)(int64_t)-ENOSYS;
+    }
+
+    // Count before calling: exit/execve never come back here.
+    __atomic_fetch_add(&ent->calls, 1, __ATOMIC_RELAXED);
+    uint64_t start = hanacore::arch::rdtsc();
+    int64_t ret = ent->handler(a, b, c, d, e, f);
+    uint64_t cycles = hanacore::arch::rdtsc() - start;
+
+    // Errors are -1..-4095, as on Linux; larger "negative" values are
+    // kernel addresses (e.g. the vDSO pointer), not failures.
+    if ((uint64_t)ret >= (uint64_t)-4095) __atomic_fetch_add(&ent->errors, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ent->cycles, cycles, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ent->hist[latency_bucket(cycles)], 1, __ATOMIC_RELAXED);
+    return (uint64_t)ret;
+}
+
+namespace hanacore { namespace userland {
+
+    // One line per syscall that has been called at least once:
+    //   nr name calls errors avg_cycles | log2(cycles):count ...
+    size_t syscall_stats_format(char* buf, size_t cap) {
+        if (!buf || cap == 0) return 0;
+        size_t off = 0;
+        auto append = [&](const char* fmt, auto... args) {
+            if (off + 1 >= cap) return;
+            int n = snprintf(buf + off, cap - off, fmt, args...);
+            if (n > 0) off += ((size_t)n < cap - off) ? (size_t)n : cap - off - 1;
+        };
+
+        append("# nr name calls errors avg_cycles | log2(cycles):count\n");
+        for (size_t i = 0; i < sizeof(syscall_entries) / sizeof(syscall_entries[0]); ++i) {
+            const SyscallEntry* ent = &syscall_entries[i];
+            if (ent->calls == 0) continue;
+            append("%u %s %llu %llu %llu |", (unsigned)ent->nr, ent->name,
+                   (unsigned long long)ent->calls, (unsigned long long)ent->errors,
+                   (unsigned long long)(ent->cycles / ent->calls));
+            for (int bkt = 0; bkt < SYSCALL_HIST_BUCKETS; ++bkt) {
+                if (ent->hist[bkt]) append(" %d:%llu", bkt, (unsigned long long)ent->hist[bkt]);
+            }
+            append("\n");
+        }
+        append("unknown %llu\n", (unsigned long long)syscall_unknown_calls);
+        buf[off] = '\0';
+        return off;
+    }
+
+    void syscall_stats_reset() {
+        for (size_t i = 0; i < sizeof(syscall_entries) / sizeof(syscall_entries[0]); ++i) {
+            SyscallEntry* ent = &syscall_entries[i];
+            ent->calls = ent->errors = ent->cycles = 0;
+            for (int bkt = 0; bkt < SYSCALL_HIST_BUCKETS; ++bkt) ent->hist[bkt] = 0;
+        }
+        syscall_unknown_calls = 0;
+    }
+
+} }
@@ -7,34 +7,46 @@
 extern "C" {
 #endif
 
-// Basic syscall numbers for the minimal kernel implementation.
+// Basic syscall numbers for the minimal kernel implementation (aliases of
+// the Linux numbers the dispatcher implements).
 enum {
     SYSCALL_WRITE = 1,
-    SYSCALL_EXIT  = 2,
+    SYSCALL_EXIT  = 60,
 };
 
-// Extended syscall numbers for POSIX-like operations (local kernel numbers)
+// HanaCore-specific syscalls live above the Linux x86_64 range so the two
+// number spaces never collide in the dispatch table.
+#define HANA_SYSCALL_BASE 512
+
 enum {
-    HANA_SYSCALL_READ = 10,
-    HANA_SYSCALL_WRITE = 11,
-    HANA_SYSCALL_OPEN = 12,
-    HANA_SYSCALL_CLOSE = 13,
-    HANA_SYSCALL_LSEEK = 14,
-    HANA_SYSCALL_UNLINK = 15,
-    HANA_SYSCALL_MKDIR = 16,
-    HANA_SYSCALL_RMDIR = 17,
-    HANA_SYSCALL_STAT = 18,
-    HANA_SYSCALL_SPAWN = 19,
-    HANA_SYSCALL_WAITPID = 20,
-    HANA_SYSCALL_FORK = 21,
-    HANA_SYSCALL_DUP2 = 22,
-    HANA_SYSCALL_PIPE = 23,
-    HANA_SYSCALL_FSTAT = 24,
-    HANA_SYSCALL_OPENDIR = 25,
-    HANA_SYSCALL_READDIR = 26,
-    HANA_SYSCALL_CLOSEDIR = 27,
+    HANA_SYSCALL_READ = HANA_SYSCALL_BASE + 0,
+    HANA_SYSCALL_WRITE = HANA_SYSCALL_BASE + 1,
+    HANA_SYSCALL_OPEN = HANA_SYSCALL_BASE + 2,
+    HANA_SYSCALL_CLOSE = HANA_SYSCALL_BASE + 3,
+    HANA_SYSCALL_LSEEK = HANA_SYSCALL_BASE + 4,
+    HANA_SYSCALL_UNLINK = HANA_SYSCALL_BASE + 5,
+    HANA_SYSCALL_MKDIR = HANA_SYSCALL_BASE + 6,
+    HANA_SYSCALL_RMDIR = HANA_SYSCALL_BASE + 7,
+    HANA_SYSCALL_STAT = HANA_SYSCALL_BASE + 8,
+    HANA_SYSCALL_SPAWN = HANA_SYSCALL_BASE + 9,
+    HANA_SYSCALL_WAITPID = HANA_SYSCALL_BASE + 10,
+    HANA_SYSCALL_FORK = HANA_SYSCALL_BASE + 11,
+    HANA_SYSCALL_DUP2 = HANA_SYSCALL_BASE + 12,
+    HANA_SYSCALL_PIPE = HANA_SYSCALL_BASE + 13,
+    HANA_SYSCALL_FSTAT = HANA_SYSCALL_BASE + 14,
+    HANA_SYSCALL_OPENDIR = HANA_SYSCALL_BASE + 15,
+    HANA_SYSCALL_READDIR = HANA_SYSCALL_BASE + 16,
+    HANA_SYSCALL_CLOSEDIR = HANA_SYSCALL_BASE + 17,
+    // Returns the address of the struct hana_vdso (see api/hana_vdso.h).
+    HANA_SYSCALL_VDSO = HANA_SYSCALL_BASE + 18,
+    // Batched file I/O rings (see api/hana_ioring.h).
+    HANA_SYSCALL_IORING_SETUP = HANA_SYSCALL_BASE + 19,
+    HANA_SYSCALL_IORING_ENTER = HANA_SYSCALL_BASE + 20,
 };
 
+// Size of the dispatch table; every valid syscall number is below this.
+#define SYSCALL_TABLE_SIZE 640
+
 // Kernel syscall dispatcher. Implemented in syscalls.cpp.
 // num: syscall number
 // a,b,c: opaque arguments (up to three 64-bit args)
@@ -44,3 +56,13 @@ uint64_t syscall_dispatch(uint64_t num, uint64_t a, uint64_t b, uint64_t c, uint
 #ifdef __cplusplus
 }
 #endif
+
+#ifdef __cplusplus
+#include <stddef.h>
+namespace hanacore { namespace userland {
+    // Render per-syscall call/error counts and latency histograms (the
+    // contents of /proc/syscalls). Returns bytes written excluding the NUL.
+    size_t syscall_stats_format(char* buf, size_t cap);
+    void syscall_stats_reset();
+} }
+#endif
@@ -0,0 +1,147 @@
+#include "vdso.hpp"
+#include "../arch/tsc.hpp"
+#include "../utils/logger.hpp"
+#include <stddef.h>
+
+// Code in VDSO_TEXT runs in ring 3. It may only touch the vDSO data page and
+// its arguments, and may only call helpers that are forced inline (the
+// kernel builds at -O0, so plain `static inline` would land in .text).
+#define VDSO_TEXT __attribute__((section(".vdso.text"), used, noinline))
+#define VDSO_INLINE static inline __attribute__((always_inline))
+
+// Linux clock ids served from the data page.
+enum {
+    VDSO_CLOCK_REALTIME = 0,
+    VDSO_CLOCK_MONOTONIC = 1,
+    VDSO_CLOCK_MONOTONIC_RAW = 4,
+    VDSO_CLOCK_REALTIME_COARSE = 5,
+    VDSO_CLOCK_MONOTONIC_COARSE = 6,
+    VDSO_CLOCK_BOOTTIME = 7,
+};
+
+// Fallback syscall number (Linux clock_gettime) for clocks the page does
+// not describe. An enumerator, not a variable: it must not live in .rodata.
+enum { VDSO_NR_CLOCK_GETTIME = 228 };
+
+struct VdsoPage {
+    struct hana_vdso hdr;
+    struct hana_vdso_data data;
+};
+static_assert(sizeof(VdsoPage) <= 4096, "vDSO data must fit in one page");
+
+static VdsoPage vdso_page __attribute__((section(".vdso.data"), aligned(4096), used));
+
+VDSO_INLINE uint64_t vdso_rdtsc() {
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+VDSO_INLINE long vdso_syscall3(long nr, long a1, long a2, long a3) {
+    long ret;
+    asm volatile("syscall"
+                 : "=a"(ret)
+                 : "a"(nr), "D"(a1), "S"(a2), "d"(a3)
+                 : "rcx", "r11", "memory");
+    return ret;
+}
+
+// Seqlock read side: spin while the kernel is mid-update, retry if the
+// sequence moved while we were reading.
+VDSO_INLINE uint32_t vdso_read_begin(const struct hana_vdso_data* d) {
+    uint32_t seq;
+    while ((seq = __atomic_load_n(&d->seq, __ATOMIC_ACQUIRE)) & 1)
+        asm volatile("pause" ::: "memory");
+    return seq;
+}
+
+VDSO_INLINE bool vdso_read_retry(const struct hana_vdso_data* d, uint32_t seq) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&d->seq, __ATOMIC_RELAXED) != seq;
+}
+
+VDSO_INLINE uint64_t vdso_now_ns(const struct hana_vdso_data* d, bool realtime) {
+    uint64_t ns;
+    uint32_t seq;
+    do {
+        seq = vdso_read_begin(d);
+        uint64_t delta = vdso_rdtsc() - d->tsc_base;
+        ns = (uint64_t)(((unsigned __int128)delta * d->tsc_mult) >> 32);
+        if (realtime) ns += (uint64_t)d->realtime_offset_ns;
+    } while (vdso_read_retry(d, seq));
+    return ns;
+}
+
+VDSO_TEXT static long vdso_clock_gettime(int clk, struct hana_timespec* ts) {
+    bool realtime = clk == VDSO_CLOCK_REALTIME || clk == VDSO_CLOCK_REALTIME_COARSE;
+    bool monotonic = clk == VDSO_CLOCK_MONOTONIC || clk == VDSO_CLOCK_MONOTONIC_RAW ||
+                     clk == VDSO_CLOCK_MONOTONIC_COARSE || clk == VDSO_CLOCK_BOOTTIME;
+    if (!realtime && !monotonic)
+        return vdso_syscall3(VDSO_NR_CLOCK_GETTIME, clk, (long)ts, 0);
+    uint64_t ns = vdso_now_ns(&vdso_page.data, realtime);
+    ts->tv_sec = (int64_t)(ns / 1000000000ULL);
+    ts->tv_nsec = (int64_t)(ns % 1000000000ULL);
+    return 0;
+}
+
+VDSO_TEXT static long vdso_gettimeofday(struct hana_timeval* tv, void* tz) {
+    if (tv) {
+        uint64_t ns = vdso_now_ns(&vdso_page.data, true);
+        tv->tv_sec = (int64_t)(ns / 1000000000ULL);
+        tv->tv_usec = (int64_t)((ns % 1000000000ULL) / 1000);
+    }
+    if (tz) {
+        // struct timezone { int tz_minuteswest; int tz_dsttime; }: always UTC.
+        ((int*)tz)[0] = 0;
+        ((int*)tz)[1] = 0;
+    }
+    return 0;
+}
+
+VDSO_TEXT static long vdso_getpid(void) {
+    return __atomic_load_n(&vdso_page.data.pid, __ATOMIC_RELAXED);
+}
+
+VDSO_TEXT static long vdso_getcpu(unsigned* cpu, unsigned* node, void* cache) {
+    if (cpu) *cpu = __atomic_load_n(&vdso_page.data.cpu, __ATOMIC_RELAXED);
+    if (node) *node = 0;
+    return 0;
+}
+
+namespace hanacore { namespace userland {
+
+    void vdso_update_clock() {
+        struct hana_vdso_data* d = &vdso_page.data;
+        __atomic_store_n(&d->seq, d->seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        d->tsc_base = hanacore::arch::tsc_base();
+        d->tsc_mult = hanacore::arch::tsc_mult();
+        d->realtime_offset_ns = hanacore::arch::clock_realtime_offset_ns();
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&d->seq, d->seq + 1, __ATOMIC_RELAXED);
+    }
+
+    void vdso_init() {
+        struct hana_vdso* h = &vdso_page.hdr;
+        h->magic = HANA_VDSO_MAGIC;
+        h->version = HANA_VDSO_VERSION;
+        h->size = sizeof(struct hana_vdso);
+        h->data = &vdso_page.data;
+        h->clock_gettime = vdso_clock_gettime;
+        h->gettimeofday = vdso_gettimeofday;
+        h->getpid = vdso_getpid;
+        h->getcpu = vdso_getcpu;
+        vdso_update_clock();
+        log_ok("vDSO: data page at %p", (void*)&vdso_page);
+    }
+
+    const struct hana_vdso* vdso_base() {
+        return &vdso_page.hdr;
+    }
+
+    void vdso_set_current(int pid, uint32_t cpu) {
+        __atomic_store_n(&vdso_page.data.pid, pid, __ATOMIC_RELAXED);
+        __atomic_store_n(&vdso_page.data.cpu, cpu, __ATOMIC_RELAXED);
+    }
+
+}} // namespace hanacore::userland
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+#include "../api/hana_vdso.h"
+
+// Kernel side of the vDSO. The vDSO is one code page (.vdso.text) and one
+// data page (.vdso.data) placed in their own page-aligned sections of the
+// kernel image by linker.ld. There is no per-process address space yet, so
+// every task sees the same pages at their kernel-image addresses; once the
+// VMM builds user page tables these two sections are what gets mapped
+// user-readable (data) and user-executable (text).
+
+namespace hanacore { namespace userland {
+
+    // Fill the data page from the calibrated clock source. Call after
+    // tsc_init() and after the realtime offset is set.
+    void vdso_init();
+
+    // Re-publish the clock parameters (e.g. after the wall clock is set).
+    void vdso_update_clock();
+
+    // Address returned to user space by HANA_SYSCALL_VDSO.
+    const struct hana_vdso* vdso_base();
+
+    // Record the task now running on `cpu`. Called by the scheduler on every
+    // switch with the scheduler lock held. The page is global, which is only
+    // correct while a single CPU runs user code.
+    void vdso_set_current(int pid, uint32_t cpu);
+
+}} // namespace hanacore::userland
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stubs.hpp"
+#include "../../kernel/filesystem/vfs.hpp"
+#include "../../kernel/filesystem/hanafs.hpp"
+#include "../../kernel/filesystem/devfs.hpp"
+#include "../../kernel/filesystem/fat32.hpp"
+#include "../../kernel/api/hanaapi.h"
+#include "../../third_party/limine/limine.h"
+
+// Host-side filesystem benchmark: runs the real HanaFS, VFS and FAT32 code
+// against a RAM-backed ATA disk and reports ops/sec and kmalloc calls per
+// op for each workload.
+
+// fat32.cpp looks for boot modules; the host has none.
+volatile struct limine_hhdm_request limine_hhdm_request = {};
+volatile struct limine_module_request module_request = {};
+
+struct BenchConfig {
+    unsigned files;         // files created on HanaFS
+    unsigned fat32_files;   // files created on FAT32
+    unsigned rounds;        // passes of the stat, lookup and list storms
+    unsigned depth;         // directories above the deep-lookup leaf
+    unsigned appends;       // writes by the append workload
+    unsigned chunk;         // bytes per append
+    uint32_t disk_sectors;  // RAM disk size
+    bool persist;           // HanaFS writes itself to the disk on change
+    const char* image;      // FAT32 image to bench instead of a fresh one
+    const char* only;       // run just this workload
+};
+
+struct BenchClock {
+    uint64_t start_ns;
+    uint64_t start_allocs;
+};
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static BenchClock bench_start() {
+    return { now_ns(), stub_kmalloc_calls() };
+}
+
+static void bench_report(const char* fs, const char* name, const BenchClock& c, uint64_t ops, uint64_t failed) {
+    double secs = (double)(now_ns() - c.start_ns) / 1e9;
+    double allocs = ops ? (double)(stub_kmalloc_calls() - c.start_allocs) / (double)ops : 0.0;
+    printf("%-7s %-12s %10llu %10.4f %14.0f %10.2f",
+           fs, name, (unsigned long long)ops, secs, secs > 0 ? (double)ops / secs : 0.0, allocs);
+    if (failed) printf("   (%llu failed)", (unsigned long long)failed);
+    printf("\n");
+}
+
+static bool selected(const BenchConfig& cfg, const char* name) {
+    return !cfg.only || strcmp(cfg.only, name) == 0;
+}
+
+// FAT32 only takes 8.3 names, so every name fits that.
+static void file_name(char* out, size_t n, const char* dir, unsigned i) {
+    snprintf(out, n, "%s/F%07u.DAT", dir, i);
+}
+
+static void bench_create(const BenchConfig& cfg, const char* fs, const char* dir) {
+    char path[256];
+    uint64_t failed = 0;
+    BenchClock c = bench_start();
+    for (unsigned i = 0; i < cfg.files; ++i) {
+        file_name(path, sizeof(path), dir, i);
+        if (vfs_create_file(path) != 0) ++failed;
+    }
+    bench_report(fs, "create", c, cfg.files, failed);
+}
+
+// vfs_stat where the filesystem reports identities, vfs_lookup otherwise.
+static void bench_stat(const BenchConfig& cfg, const char* fs, const char* dir) {
+    char path[256];
+    struct hana_stat st;
+    file_name(path, sizeof(path), dir, 0);
+    bool has_stat = vfs_stat(path, &st) == 0;
+    uint64_t failed = 0;
+    BenchClock c = bench_start();
+    for (unsigned r = 0; r < cfg.rounds; ++r) {
+        for (unsigned i = 0; i < cfg.files; ++i) {
+            file_name(path, sizeof(path), dir, i);
+            int rc = has_stat ? vfs_stat(path, &st) : vfs_lookup(path);
+            if (rc < 0) ++failed;
+        }
+    }
+    bench_report(fs, has_stat ? "stat" : "stat(lookup)", c, (uint64_t)cfg.rounds * cfg.files, failed);
+}
+
+// Look up a leaf `depth` directories down, and a missing sibling of it.
+static void bench_deep_lookup(const BenchConfig& cfg, const char* fs, const char* dir) {
+    char path[1024];
+    size_t len = (size_t)snprintf(path, sizeof(path), "%s", dir);
+    for (unsigned d = 0; d < cfg.depth && len + 8 < sizeof(path) - 32; ++d) {
+        len += (size_t)snprintf(path + len, sizeof(path) - len, "/D%u", d);
+        vfs_make_dir(path);
+    }
+    char missing[1024];
+    snprintf(missing, sizeof(missing), "%s/NOPE.DAT", path);
+    snprintf(path + len, sizeof(path) - len, "/LEAF.DAT");
+    vfs_create_file(path);
+
+    uint64_t failed = 0;
+    uint64_t ops = (uint64_t)cfg.rounds * cfg.files;
+    BenchClock c = bench_start();
+    for (uint64_t i = 0; i < ops; i += 2) {
+        if (vfs_lookup(path) != VFS_TYPE_FILE) ++failed;
+        if (vfs_lookup(missing) >= 0) ++failed;
+    }
+    bench_report(fs, "deep-lookup", c, ops + (ops & 1), failed);
+}
+
+static void bench_append(const BenchConfig& cfg, const char* fs, const char* dir) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/APPEND.DAT", dir);
+    uint8_t* chunk = (uint8_t*)malloc(cfg.chunk ? cfg.chunk : 1);
+    if (!chunk) return;
+    memset(chunk, 0xA5, cfg.chunk);
+    uint64_t failed = 0;
+    BenchClock c = bench_start();
+    struct vfs_file* f = vfs_open(path, VFS_O_CREAT);
+    if (!f) {
+        bench_report(fs, "append", c, 0, cfg.appends);
+        free(chunk);
+        return;
+    }
+    uint64_t off = 0;
+    for (unsigned i = 0; i < cfg.appends; ++i) {
+        if (vfs_write_at(f, off, chunk, cfg.chunk) != (int64_t)cfg.chunk) { ++failed; continue; }
+        off += cfg.chunk;
+    }
+    if (vfs_fsync(f) != 0) ++failed;
+    vfs_close(f);
+    bench_report(fs, "append", c, cfg.appends, failed);
+    free(chunk);
+}
+
+static void bench_list(const BenchConfig& cfg, const char* fs, const char* dir) {
+    uint64_t entries = 0, failed = 0;
+    BenchClock c = bench_start();
+    for (unsigned r = 0; r < cfg.rounds; ++r) {
+        struct vfs_dir* d = vfs_opendir(dir);
+        if (!d) { ++failed; continue; }
+        while (vfs_readdir(d)) ++entries;
+        vfs_closedir(d);
+    }
+    bench_report(fs, "list", c, entries, failed);
+}
+
+static void run_workloads(const BenchConfig& cfg, const char* fs, const char* dir) {
+    if (vfs_make_dir(dir) != 0 && vfs_lookup(dir) != VFS_TYPE_DIR) {
+        printf("%-7s cannot create %s\n", fs, dir);
+        return;
+    }
+    if (selected(cfg, "create") || selected(cfg, "stat") || selected(cfg, "list"))
+        bench_create(cfg, fs, dir);
+    if (selected(cfg, "stat")) bench_stat(cfg, fs, dir);
+    if (selected(cfg, "deep-lookup")) bench_deep_lookup(cfg, fs, dir);
+    if (selected(cfg, "append")) bench_append(cfg, fs, dir);
+    if (selected(cfg, "list")) bench_list(cfg, fs, dir);
+}
+
+// The RAM disk holds the FAT32 volume: writes reach it through the ATA
+// stub and reads come straight from memory, as for a boot module image.
+static uint8_t* load_image(const char* path, size_t* size) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long n = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t* buf = n > 0 ? (uint8_t*)malloc((size_t)n) : NULL;
+    if (buf && fread(buf, 1, (size_t)n, fp) != (size_t)n) { free(buf); buf = NULL; }
+    fclose(fp);
+    *size = buf ? (size_t)n : 0;
+    return buf;
+}
+
+// A fresh volume has one-sector clusters and FAT32 directories do not grow
+// past their first cluster, so only a handful of files fit in one; bench a
+// bigger image with -i to go further.
+static void run_fat32(BenchConfig cfg, uint8_t* disk, size_t disk_size) {
+    cfg.files = cfg.fat32_files;
+    // HanaFS would persist itself over the volume.
+    ::hanafs_set_persist_enabled(0);
+    if (cfg.image) {
+        free(disk);
+        disk = load_image(cfg.image, &disk_size);
+        if (!disk) {
+            printf("fat32   cannot read %s\n", cfg.image);
+            return;
+        }
+        stub_ramdisk_attach(disk, (uint32_t)(disk_size / 512));
+    } else if (fat32_format_ata_master(0) != 0) {
+        printf("fat32   format failed\n");
+        return;
+    }
+    if (hanacore::fs::fat32_init_from_memory(disk, disk_size) != 0) {
+        printf("fat32   mount failed\n");
+        return;
+    }
+    run_workloads(cfg, "fat32", "/core/BENCH");
+}
+
+static void usage(const char* prog) {
+    printf("usage: %s [options]\n"
+           "  -n FILES     files created on HanaFS (default 256)\n"
+           "  -N FILES     files created on FAT32 (default 12)\n"
+           "  -r ROUNDS    passes of the stat, lookup and list storms (default 64)\n"
+           "  -d DEPTH     directory depth for deep-lookup (default 16)\n"
+           "  -a APPENDS   writes by the append workload (default 4096)\n"
+           "  -c BYTES     bytes per append (default 512)\n"
+           "  -m MIB       RAM disk size (default 64)\n"
+           "  -i IMAGE     bench this FAT32 image instead of a fresh volume\n"
+           "  -w NAME      run only create, stat, deep-lookup, append or list\n"
+           "  -f FS        run only hanafs or fat32\n"
+           "  --no-persist keep HanaFS from writing itself to disk on change\n",
+           prog);
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = { 256, 12, 64, 16, 4096, 512, 64u * 2048, true, NULL, NULL };
+    const char* only_fs = NULL;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(a, "--no-persist") == 0) { cfg.persist = false; continue; }
+        if (strcmp(a, "-h") == 0 || strcmp(a, "--help") == 0 || !v || a[0] != '-' || a[2]) {
+            usage(argv[0]);
+            return a[0] == '-' && (a[1] == 'h' || a[1] == '-') ? 0 : 1;
+        }
+        ++i;
+        switch (a[1]) {
+        case 'n': cfg.files = (unsigned)strtoul(v, NULL, 0); break;
+        case 'N': cfg.fat32_files = (unsigned)strtoul(v, NULL, 0); break;
+        case 'r': cfg.rounds = (unsigned)strtoul(v, NULL, 0); break;
+        case 'd': cfg.depth = (unsigned)strtoul(v, NULL, 0); break;
+        case 'a': cfg.appends = (unsigned)strtoul(v, NULL, 0); break;
+        case 'c': cfg.chunk = (unsigned)strtoul(v, NULL, 0); break;
+        case 'm': cfg.disk_sectors = (uint32_t)strtoul(v, NULL, 0) * 2048; break;
+        case 'i': cfg.image = v; break;
+        case 'w': cfg.only = v; break;
+        case 'f': only_fs = v; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    stub_log_quiet = true;
+    size_t disk_size = (size_t)cfg.disk_sectors * 512;
+    uint8_t* disk = (uint8_t*)calloc(1, disk_size ? disk_size : 512);
+    if (!disk) {
+        printf("cannot allocate a %zu byte RAM disk\n", disk_size);
+        return 1;
+    }
+    stub_ramdisk_attach(disk, cfg.disk_sectors);
+
+    hanacore::fs::init();
+    if (hanacore::fs::hanafs_init() != 0) {
+        printf("hanafs_init failed\n");
+        return 1;
+    }
+    hanacore::fs::devfs_init();
+    ::hanafs_set_persist_enabled(cfg.persist ? 1 : 0);
+
+    printf("%-7s %-12s %10s %10s %14s %10s\n", "fs", "workload", "ops", "seconds", "ops/sec", "allocs/op");
+    if (!only_fs || strcmp(only_fs, "hanafs") == 0) run_workloads(cfg, "hanafs", "/bench");
+    if (!only_fs || strcmp(only_fs, "fat32") == 0) run_fat32(cfg, disk, disk_size);
+    return 0;
+}
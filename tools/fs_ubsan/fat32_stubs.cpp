@@ -0,0 +1,20 @@
+#include <stdint.h>
+#include <stddef.h>
+
+// Minimal fat32 stubs that vfs may reference, for builds that leave
+// fat32.cpp out. These return failure or empty results so the host test
+// remains deterministic.
+namespace hanacore { namespace fs {
+    int fat32_init_from_module(const char*) { return -1; }
+    int fat32_init_from_memory(const void*, size_t) { return -1; }
+    int64_t fat32_read_file(const char*, void*, size_t) { return -1; }
+    void* fat32_get_file_alloc(const char*, size_t*) { return NULL; }
+    int fat32_list_dir(const char*, void (*)(const char*)) { return -1; }
+    void fat32_mount_all_letter_modules() {}
+    void fat32_list_mounts(void (*cb)(const char*)) { (void)cb; }
+    int fat32_create_file(const char*) { return -1; }
+    int fat32_unlink(const char*) { return -1; }
+    int fat32_make_dir(const char*) { return -1; }
+    int fat32_remove_dir(const char*) { return -1; }
+    int fat32_write_file(const char*, const void*, size_t) { return -1; }
+}}
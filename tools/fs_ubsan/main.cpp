@@ -8,8 +8,6 @@
 #include "../../kernel/filesystem/procfs.hpp"
 #include "../../kernel/mem/heap.hpp"
 
-extern "C" void print(const char* s) { printf("%s", s); }
-
 int main(int argc, char** argv) {
     (void)argc; (void)argv;
     printf("Starting filesystem UBSAN test harness\n");
@@ -3,25 +3,37 @@
 #include <stdarg.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#include "stubs.hpp"
+#include "../../kernel/mem/heap.hpp"
 
 // Provide minimal logger and memory implementations so filesystem code can
 // be linked into a host executable for UBSAN testing.
 
+bool stub_log_quiet = false;
+static uint64_t kmalloc_calls = 0;
+
 extern "C" void print(const char* s) {
     if (!s) return;
     fputs(s, stdout);
 }
 
 extern "C" void log_ok_v(const char* fmt, va_list ap) {
+    if (stub_log_quiet) return;
     vprintf(fmt, ap); printf("\n");
 }
 extern "C" void log_fail_v(const char* fmt, va_list ap) {
+    if (stub_log_quiet) return;
     vprintf(fmt, ap); printf("\n");
 }
 extern "C" void log_info_v(const char* fmt, va_list ap) {
+    if (stub_log_quiet) return;
     vprintf(fmt, ap); printf("\n");
 }
 extern "C" void log_debug_v(const char* fmt, va_list ap) {
+    if (stub_log_quiet) return;
     vprintf(fmt, ap); printf("\n");
 }
 
@@ -34,11 +46,14 @@ extern "C" void log_hex64(const char* label, uint64_t value) {
     printf("%s0x%016llX\n", label ? label : "", (unsigned long long)value);
 }
 
-// Minimal memory allocation wrappers matching kernel API (namespaces)
+// Minimal memory allocation wrappers matching kernel API. heap.hpp
+// declares them inside extern "C", so these are the plain kmalloc/kfree
+// symbols the kernel sources link against.
 namespace hanacore { namespace mem {
     void heap_init(size_t size) { (void)size; /* noop for host */ }
     void* kmalloc(size_t size) {
         if (size == 0) return NULL;
+        ++kmalloc_calls;
         void* p = malloc(size);
         return p;
     }
@@ -47,28 +62,62 @@ namespace hanacore { namespace mem {
     }
 }}
 
-// Stubs for ATA helpers used by HanaFS/FAT helpers. Return failure so code
-// paths that rely on ATA won't unexpectedly succeed in host test.
-extern "C" int ata_read_sector(uint32_t lba, void* buf) { (void)lba; (void)buf; return -1; }
-extern "C" int ata_write_sector(uint32_t lba, const void* buf) { (void)lba; (void)buf; return -1; }
-extern "C" int ata_read_sector_drive(uint32_t drive, uint32_t lba, void* buf) { (void)drive; (void)lba; (void)buf; return -1; }
-extern "C" int32_t ata_get_sector_count_drive(int drive) { (void)drive; return 0; }
+uint64_t stub_kmalloc_calls(void) { return kmalloc_calls; }
+
+// ATA master backed by host memory. Without a disk attached every call
+// fails, so code paths that rely on ATA won't unexpectedly succeed.
+static uint8_t* ramdisk = NULL;
+static uint32_t ramdisk_sectors = 0;
+
+void stub_ramdisk_attach(uint8_t* mem, uint32_t sectors) {
+    ramdisk = mem;
+    ramdisk_sectors = mem ? sectors : 0;
+}
+
+extern "C" int ata_read_sector(uint32_t lba, void* buf) {
+    if (lba >= ramdisk_sectors) return -1;
+    memcpy(buf, ramdisk + (size_t)lba * 512, 512);
+    return 0;
+}
+extern "C" int ata_write_sector(uint32_t lba, const void* buf) {
+    if (lba >= ramdisk_sectors) return -1;
+    memcpy(ramdisk + (size_t)lba * 512, buf, 512);
+    return 0;
+}
+extern "C" int ata_read_sector_drive(uint32_t drive, uint32_t lba, void* buf) {
+    return drive == 0 ? ata_read_sector(lba, buf) : -1;
+}
+extern "C" int ata_write_sector_drive(uint32_t drive, uint32_t lba, const void* buf) {
+    return drive == 0 ? ata_write_sector(lba, buf) : -1;
+}
+extern "C" int32_t ata_get_sector_count() { return (int32_t)ramdisk_sectors; }
+extern "C" int32_t ata_get_sector_count_drive(int drive) { return drive == 0 ? (int32_t)ramdisk_sectors : 0; }
+
+namespace hanacore { namespace arch {
+    uint64_t clock_realtime_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+}}
+
+// No scheduler on the host: read-ahead is never queued, yielding is a
+// no-op and the page cache lock has nobody to wait for.
+namespace hanacore { namespace fs {
+    bool readahead_submit(void (*)(void*, uint64_t, size_t), void*, uint64_t, size_t) { return false; }
+}}
+namespace hanacore { namespace scheduler {
+    void sched_yield() {}
+}}
+namespace hanacore { namespace sync {
+    struct Mutex;
+    void mutex_lock(Mutex*) {}
+    void mutex_unlock(Mutex*) {}
+}}
 
-// Provide minimal fat32 stubs that vfs may reference. These return failure
-// or empty results so the host test remains deterministic.
+// procfs reports scheduler and syscall state the host does not have.
 namespace hanacore { namespace fs {
-    int fat32_init_from_module(const char*) { return -1; }
-    int fat32_init_from_memory(const void*, size_t) { return -1; }
-    int64_t fat32_read_file(const char*, void*, size_t) { return -1; }
-    void* fat32_get_file_alloc(const char*, size_t*) { return NULL; }
-    int fat32_list_dir(const char*, void (*)(const char*)) { return -1; }
-    void fat32_mount_all_letter_modules() {}
-    void fat32_list_mounts(void (*cb)(const char*)) { (void)cb; }
-    int fat32_create_file(const char*) { return -1; }
-    int fat32_unlink(const char*) { return -1; }
-    int fat32_make_dir(const char*) { return -1; }
-    int fat32_remove_dir(const char*) { return -1; }
-    int fat32_write_file(const char*, const void*, size_t) { return -1; }
+    void procfs_init() {}
 }}
 
-// Minimal procfs/devfs callbacks are implemented in their CPP files; nothing else needed.
+// Minimal devfs callbacks are implemented in devfs.cpp; nothing else needed.
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Hooks into the host stubs shared by filesystem_ubsan and
+// filesystem_bench.
+
+// Back the ATA master with `sectors` 512-byte sectors at `mem`. Until
+// then every ATA call fails, as on a machine without a disk.
+void stub_ramdisk_attach(uint8_t* mem, uint32_t sectors);
+
+// kmalloc calls made so far.
+uint64_t stub_kmalloc_calls(void);
+
+// Drop log output (the benchmark would mostly measure printf).
+extern bool stub_log_quiet;